@@ -0,0 +1,14 @@
+//
+// allocation_counter.cc
+// Counts the allocations made through operator new, for benchmarks which report
+// allocations per iteration. The benchmarks link the replacement operator new of
+// the library's allocation tracking builds, src/coreload/dll/allocation_hooks.cc.
+//
+
+#include "allocation_tracker.h"
+#include "bench_utils.h"
+
+size_t bench_utils::get_allocation_count()
+{
+    return static_cast<size_t>(coreload::allocation_tracker_t::get_counts().allocations);
+}
@@ -0,0 +1,66 @@
+//
+// bench_utils.h
+// Helpers for benchmarks which read installed framework files.
+//
+
+#pragma once
+
+#include "pal.h"
+#include "utils.h"
+#include "fx_ver.h"
+
+namespace bench_utils
+{
+    using coreload::pal::string_t;
+
+    // The number of allocations made through operator new so far, see allocation_counter.cc
+    size_t get_allocation_count();
+
+    // The .NET Core installation to read frameworks from: DOTNET_ROOT, then the default location
+    inline string_t get_dotnet_root()
+    {
+        string_t dotnet_root;
+        if (!coreload::pal::getenv(_X("DOTNET_ROOT"), &dotnet_root))
+        {
+            coreload::pal::get_default_installation_dir(&dotnet_root);
+        }
+        return dotnet_root;
+    }
+
+    // Gets the deps file of the highest installed version of a shared framework, or an empty path
+    inline string_t find_framework_deps(const string_t& fx_name)
+    {
+        string_t fx_dir = get_dotnet_root();
+        if (fx_dir.empty())
+        {
+            return fx_dir;
+        }
+
+        coreload::append_path(&fx_dir, _X("shared"));
+        coreload::append_path(&fx_dir, fx_name.c_str());
+
+        std::vector<string_t> versions;
+        coreload::pal::readdir_onlydirectories(fx_dir, &versions);
+
+        string_t best_path;
+        coreload::fx_ver_t best_ver;
+        for (const auto& version : versions)
+        {
+            coreload::fx_ver_t ver;
+            if (!coreload::fx_ver_t::parse(version, &ver) || (!best_path.empty() && ver <= best_ver))
+            {
+                continue;
+            }
+
+            string_t path = fx_dir;
+            coreload::append_path(&path, version.c_str());
+            coreload::append_path(&path, (fx_name + _X(".deps.json")).c_str());
+            if (coreload::pal::file_exists(path))
+            {
+                best_ver = ver;
+                best_path = path;
+            }
+        }
+        return best_path;
+    }
+}
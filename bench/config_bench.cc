@@ -0,0 +1,248 @@
+//
+// config_bench.cc
+// Reading runtimeconfig.json and deps files as the host does, from files written
+// to a temp directory, and converting the property strings handed to the runtime.
+//
+
+#include <benchmark/benchmark.h>
+#include "bench_utils.h"
+#include "deps_format.h"
+#include "deps_image.h"
+#include "runtime_config.h"
+#include "test_utils.h"
+
+using coreload::deps_json_t;
+using coreload::pal::string_t;
+
+namespace
+{
+    // A runtimeconfig.json of an app on two frameworks, with a dev config adding
+    // the probe paths of a developer machine.
+    class config_layout_t
+    {
+    public:
+        config_layout_t()
+        {
+            m_root = test_utils::make_temp_directory(_X("config_bench"));
+            if (m_root.empty())
+            {
+                return;
+            }
+
+            std::string properties;
+            for (int i = 0; i < 30; ++i)
+            {
+                properties += (i == 0 ? "" : ",\n") + std::string("      \"Contoso.Feature") + std::to_string(i) + ".IsEnabled\": " + (i % 2 ? "true" : "false");
+            }
+
+            std::string config = "{\n  \"runtimeOptions\": {\n    \"tfm\": \"netcoreapp3.1\",\n"
+                "    \"frameworks\": [\n"
+                "      { \"name\": \"Microsoft.NETCore.App\", \"version\": \"3.1.0\" },\n"
+                "      { \"name\": \"Microsoft.AspNetCore.App\", \"version\": \"3.1.0\", \"rollForwardOnNoCandidateFx\": 1 }\n"
+                "    ],\n    \"configProperties\": {\n" + properties + "\n    }\n  }\n}\n";
+            std::string dev_config = "{\n  \"runtimeOptions\": {\n    \"additionalProbingPaths\": [\n"
+                "      \"/home/user/.dotnet/store/|arch|/|tfm|\",\n      \"/home/user/.nuget/packages\",\n"
+                "      \"/usr/share/dotnet/sdk/NuGetFallbackFolder\"\n    ]\n  }\n}\n";
+
+            m_path = test_utils::path_combine(m_root, _X("app.runtimeconfig.json"));
+            m_dev_path = test_utils::path_combine(m_root, _X("app.runtimeconfig.dev.json"));
+            m_valid = test_utils::write_file(m_path, config) && test_utils::write_file(m_dev_path, dev_config);
+        }
+
+        ~config_layout_t()
+        {
+            test_utils::remove_directory_tree(m_root);
+        }
+
+        bool is_valid() const { return m_valid; }
+        const string_t& get_path() const { return m_path; }
+        const string_t& get_dev_path() const { return m_dev_path; }
+
+    private:
+        string_t m_root;
+        string_t m_path;
+        string_t m_dev_path;
+        bool m_valid = false;
+    };
+
+    // The deps file of the installed Microsoft.NETCore.App, if any, and a synthetic
+    // one of a similar size.
+    class deps_layout_t
+    {
+    public:
+        deps_layout_t()
+        {
+            m_root = test_utils::make_temp_directory(_X("config_bench"));
+            if (m_root.empty())
+            {
+                return;
+            }
+
+            string_t installed = bench_utils::find_framework_deps(_X("Microsoft.NETCore.App"));
+            if (!installed.empty())
+            {
+                std::vector<char> contents;
+                string_t path = test_utils::path_combine(m_root, _X("installed.deps.json"));
+                if (coreload::read_file(installed, &contents) &&
+                    test_utils::write_file(path, std::string(contents.begin(), contents.end())))
+                {
+                    m_files.emplace_back("installed", path);
+                }
+            }
+
+            string_t synthetic_dir = test_utils::path_combine(m_root, _X("synthetic"));
+            if (test_utils::write_framework(synthetic_dir, "Microsoft.NETCore.App", "3.1.0", 160, true))
+            {
+                m_files.emplace_back("synthetic", test_utils::path_combine(synthetic_dir, _X("Microsoft.NETCore.App.deps.json")));
+            }
+        }
+
+        ~deps_layout_t()
+        {
+            test_utils::remove_directory_tree(m_root);
+        }
+
+        const std::vector<std::pair<std::string, string_t>>& get_files() const { return m_files; }
+
+    private:
+        string_t m_root;
+        std::vector<std::pair<std::string, string_t>> m_files;
+    };
+
+    const config_layout_t& get_config_layout()
+    {
+        static const config_layout_t layout;
+        return layout;
+    }
+
+    const deps_layout_t& get_deps_layout()
+    {
+        static const deps_layout_t layout;
+        return layout;
+    }
+
+    void BM_RuntimeConfigParse(benchmark::State& state)
+    {
+        const config_layout_t& layout = get_config_layout();
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the runtime config");
+            return;
+        }
+
+        for (auto _ : state)
+        {
+            coreload::runtime_config_t config;
+            config.parse(layout.get_path(), layout.get_dev_path(), coreload::fx_reference_t(), coreload::fx_reference_t());
+            if (!config.is_valid())
+            {
+                state.SkipWithError("the runtime config is not valid");
+                return;
+            }
+        }
+    }
+
+    enum class deps_load_t
+    {
+        stream,
+        dom,
+        image
+    };
+
+    // Loads a framework deps file with the streaming parser, the DOM parser, or
+    // from a precompiled image next to it.
+    void BM_DepsJsonLoad(benchmark::State& state, const string_t* path, deps_load_t load)
+    {
+        string_t image_path = coreload::deps_image::get_sibling_path(*path);
+        if (load == deps_load_t::image)
+        {
+            deps_json_t deps;
+            deps.parse(false, *path);
+            if (!deps.is_valid() || !deps.save_image(image_path))
+            {
+                state.SkipWithError("could not save the image");
+                return;
+            }
+        }
+
+        for (auto _ : state)
+        {
+            deps_json_t deps;
+            deps.set_parse_mode(load == deps_load_t::dom ? deps_json_t::parse_mode_t::dom : deps_json_t::parse_mode_t::stream);
+            deps.parse(false, *path);
+            if (!deps.is_valid())
+            {
+                state.SkipWithError("the deps file is not valid");
+                break;
+            }
+        }
+
+        if (load == deps_load_t::image)
+        {
+            coreload::pal::remove_file(image_path);
+        }
+
+        std::vector<char> contents;
+        coreload::read_file(*path, &contents);
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * contents.size());
+    }
+
+    // The TPA property of a start with the given number of assemblies
+    string_t make_tpa(int count)
+    {
+        string_t tpa;
+        for (int i = 0; i < count; ++i)
+        {
+            tpa += _X("/usr/share/dotnet/shared/Microsoft.NETCore.App/3.1.0/System.Synthetic.Assembly") +
+                coreload::pal::to_string(i) + _X(".dll") + PATH_SEPARATOR;
+        }
+        return tpa;
+    }
+
+    void BM_PalToClrString(benchmark::State& state)
+    {
+        const string_t tpa = make_tpa(static_cast<int>(state.range(0)));
+        std::vector<char> clr;
+        for (auto _ : state)
+        {
+            coreload::pal::pal_clrstring(tpa, &clr);
+            benchmark::DoNotOptimize(clr.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * tpa.size());
+    }
+
+    void BM_ClrToPalString(benchmark::State& state)
+    {
+        std::vector<char> clr;
+        coreload::pal::pal_clrstring(make_tpa(static_cast<int>(state.range(0))), &clr);
+        string_t pal;
+        for (auto _ : state)
+        {
+            coreload::pal::clr_palstring(clr.data(), &pal);
+            benchmark::DoNotOptimize(pal.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (clr.size() - 1));
+    }
+
+    int register_benchmarks()
+    {
+        const std::pair<deps_load_t, const char*> loads[] = {
+            { deps_load_t::stream, "stream" }, { deps_load_t::dom, "dom" }, { deps_load_t::image, "image" } };
+
+        for (const auto& file : get_deps_layout().get_files())
+        {
+            for (const auto& load : loads)
+            {
+                benchmark::RegisterBenchmark(("deps_json_load/" + file.first + "/" + load.second).c_str(),
+                    BM_DepsJsonLoad, &file.second, load.first)->Unit(benchmark::kMicrosecond);
+            }
+        }
+        return 0;
+    }
+
+    const int registered = register_benchmarks();
+
+    BENCHMARK(BM_RuntimeConfigParse)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_PalToClrString)->ArgName("assemblies")->Arg(200)->Arg(2000);
+    BENCHMARK(BM_ClrToPalString)->ArgName("assemblies")->Arg(200)->Arg(2000);
+}
@@ -0,0 +1,246 @@
+//
+// delegate_bench.cc
+// Creating the delegates of a plugin as it loads, one CreateAssemblyDelegate call
+// per method against a single CreateAssemblyDelegates call, on the coreclr_mock
+// stand-in and on the installed runtime. The delegates are not cached yet in any
+// of the runs, so each measures the calls into the runtime.
+//
+
+#include <benchmark/benchmark.h>
+#include "bench_utils.h"
+#include "coreload.h"
+#include "mock_runtime.h"
+
+using coreload::pal::string_t;
+
+namespace
+{
+    struct method_name_t
+    {
+        std::string assembly;
+        std::string type;
+        std::string method;
+    };
+
+    template <size_t N>
+    void copy_host_string(coreload::pal::char_t (&destination)[N], const string_t& source)
+    {
+        std::copy(source.begin(), source.begin() + std::min(source.size(), N - 1), destination);
+        destination[std::min(source.size(), N - 1)] = _X('\0');
+    }
+
+    std::vector<delegate_request> make_requests(const std::vector<method_name_t>& methods)
+    {
+        std::vector<delegate_request> requests;
+        for (const auto& method : methods)
+        {
+            requests.push_back({ method.assembly.c_str(), method.type.c_str(), method.method.c_str(), nullptr });
+        }
+        return requests;
+    }
+
+    // The method names are taken one by one or all at once
+    bool create_delegates(const std::vector<delegate_request>& requests, bool batch, std::vector<void*>* delegates)
+    {
+        delegates->resize(requests.size());
+        if (batch)
+        {
+            return CreateAssemblyDelegates(requests.data(), requests.size(), delegates->data()) == coreload::StatusCode::Success;
+        }
+
+        bool created = true;
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            created &= CreateAssemblyDelegate(requests[i].assembly_name, requests[i].type_name, requests[i].method_name, &(*delegates)[i]) == coreload::StatusCode::Success;
+        }
+        return created;
+    }
+
+    // Methods of a plugin on the mock, spread over a few types of which each
+    // has as many methods as needed
+    void BM_CreateDelegatesMock(benchmark::State& state)
+    {
+        const bool batch = state.range(0) != 0;
+        std::vector<method_name_t> methods;
+        for (int64_t i = 0; i < state.range(1); ++i)
+        {
+            methods.push_back({ "Calculator", "Calculator.Generated", "Method" + std::to_string(i) });
+        }
+        const std::vector<delegate_request> requests = make_requests(methods);
+
+        test_utils::mock_runtime_layout_t layout(10);
+        core_host_arguments arguments = core_host_arguments();
+        copy_host_string(arguments.assembly_file_path, layout.get_app_path());
+        copy_host_string(arguments.core_root_path, layout.get_dotnet_root());
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the mock runtime layout");
+            return;
+        }
+
+        std::vector<void*> delegates;
+        for (auto _ : state)
+        {
+            // A new runtime, without the delegates of the last iteration
+            state.PauseTiming();
+            const int exit_code = StartCoreCLR(&arguments);
+            state.ResumeTiming();
+            if (exit_code != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the mock runtime did not start");
+                break;
+            }
+
+            const bool created = create_delegates(requests, batch, &delegates);
+
+            state.PauseTiming();
+            UnloadRuntime();
+            state.ResumeTiming();
+            if (!created)
+            {
+                state.SkipWithError("the delegates were not created");
+                break;
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(1));
+    }
+
+    // Static methods of the installed System.Private.CoreLib and System.Console,
+    // none of them overloaded
+    std::vector<method_name_t> get_installed_methods()
+    {
+        const struct
+        {
+            const char* assembly;
+            const char* type;
+            const char* methods;
+        } types[] = {
+            { "System.Private.CoreLib", "System.Math",
+                "Acos Acosh Asin Asinh Atan Atanh Atan2 Cbrt Cos Cosh Exp FusedMultiplyAdd Log2 Log10 Pow Sin Sinh Sqrt "
+                "Tan Tanh BitDecrement BitIncrement CopySign IEEERemainder ILogB MaxMagnitude MinMagnitude ScaleB" },
+            { "System.Private.CoreLib", "System.MathF",
+                "Acos Acosh Asin Asinh Atan Atanh Atan2 Cbrt Ceiling Cos Cosh Exp Floor FusedMultiplyAdd Log2 Log10 Pow "
+                "Sin Sinh Sqrt Tan Tanh Abs BitDecrement BitIncrement CopySign IEEERemainder ILogB Max MaxMagnitude Min "
+                "MinMagnitude Sign Truncate ScaleB" },
+            { "System.Private.CoreLib", "System.Environment",
+                "get_CurrentManagedThreadId Exit get_ExitCode set_ExitCode get_TickCount get_TickCount64 get_ProcessorCount "
+                "get_HasShutdownStarted get_ProcessId get_Is64BitProcess get_Is64BitOperatingSystem get_SystemPageSize "
+                "get_UserInteractive get_WorkingSet" },
+            { "System.Private.CoreLib", "System.Threading.Thread",
+                "SpinWait Yield ResetAbort BeginCriticalRegion EndCriticalRegion BeginThreadAffinity EndThreadAffinity "
+                "GetDomainID MemoryBarrier GetCurrentProcessorId" },
+            { "System.Console", "System.Console",
+                "get_KeyAvailable get_IsInputRedirected get_IsOutputRedirected get_IsErrorRedirected get_CursorSize "
+                "set_CursorSize get_NumberLock get_CapsLock ResetColor get_BufferWidth set_BufferWidth get_BufferHeight "
+                "set_BufferHeight SetBufferSize get_WindowLeft set_WindowLeft get_WindowTop set_WindowTop get_WindowWidth "
+                "set_WindowWidth get_WindowHeight set_WindowHeight SetWindowPosition SetWindowSize get_LargestWindowWidth "
+                "get_LargestWindowHeight get_CursorVisible set_CursorVisible get_CursorLeft set_CursorLeft get_CursorTop "
+                "set_CursorTop Clear SetCursorPosition get_TreatControlCAsInput set_TreatControlCAsInput Read" } };
+
+        std::vector<method_name_t> methods;
+        for (const auto& type : types)
+        {
+            std::istringstream names(type.methods);
+            std::string name;
+            while (names >> name)
+            {
+                methods.push_back({ type.assembly, type.type, name });
+            }
+        }
+        return methods;
+    }
+
+    // The runtime cannot be started twice in a process, so a single iteration
+    // creates half of the methods one by one and the other half at once.
+    void BM_CreateDelegatesInstalled(benchmark::State& state)
+    {
+        static bool started = false;
+        if (started)
+        {
+            state.SkipWithError("the installed runtime was already started in this process");
+            return;
+        }
+
+        const string_t root = test_utils::make_temp_directory(_X("delegate_bench"));
+        const string_t app_path = test_utils::path_combine(root, _X("app.dll"));
+        core_host_arguments arguments = core_host_arguments();
+        copy_host_string(arguments.assembly_file_path, app_path);
+        copy_host_string(arguments.core_root_path, bench_utils::get_dotnet_root());
+
+        // Runtimes whose deps file lists the runtime library, which the host needs
+        int exit_code = coreload::StatusCode::FrameworkMissingFailure;
+        for (const char* version : { "5.0.0", "3.1.0" })
+        {
+            const std::string runtime_config = std::string("{ \"runtimeOptions\": { \"framework\": { \"name\": \"Microsoft.NETCore.App\", \"version\": \"") + version + "\" } } }";
+            if (!test_utils::write_file(app_path, "app") ||
+                !test_utils::write_file(test_utils::path_combine(root, _X("app.runtimeconfig.json")), runtime_config))
+            {
+                break;
+            }
+
+            // Resolution failures come before the runtime starts, so the next version can be tried
+            exit_code = StartCoreCLR(&arguments);
+            if (exit_code != coreload::StatusCode::FrameworkMissingFailure && exit_code != coreload::StatusCode::CoreClrResolveFailure)
+            {
+                break;
+            }
+        }
+        started = exit_code == coreload::StatusCode::Success;
+        test_utils::remove_directory_tree(root);
+        if (!started)
+        {
+            state.SkipWithError("no installed runtime could be started");
+            return;
+        }
+
+        // The first method of each type loads its assembly and type, then the others
+        // alternate between the two halves
+        std::vector<method_name_t> first_methods, each_methods, batch_methods;
+        const std::vector<method_name_t> methods = get_installed_methods();
+        for (size_t i = 0; i < methods.size(); ++i)
+        {
+            if (i == 0 || methods[i].type != methods[i - 1].type)
+            {
+                first_methods.push_back(methods[i]);
+            }
+            else
+            {
+                (each_methods.size() <= batch_methods.size() ? each_methods : batch_methods).push_back(methods[i]);
+            }
+        }
+        const std::vector<delegate_request> each_requests = make_requests(each_methods);
+        const std::vector<delegate_request> batch_requests = make_requests(batch_methods);
+
+        std::vector<void*> first_delegates, each_delegates, batch_delegates;
+        create_delegates(make_requests(first_methods), true, &first_delegates);
+        double each_ns = 0;
+        double batch_ns = 0;
+        for (auto _ : state)
+        {
+            uint64_t start = coreload::startup_metrics_t::now_ns();
+            create_delegates(each_requests, false, &each_delegates);
+            each_ns = static_cast<double>(coreload::startup_metrics_t::now_ns() - start);
+
+            start = coreload::startup_metrics_t::now_ns();
+            create_delegates(batch_requests, true, &batch_delegates);
+            batch_ns = static_cast<double>(coreload::startup_metrics_t::now_ns() - start);
+        }
+        UnloadRuntime();
+
+        // Some of the methods may be missing from older runtimes
+        const auto is_created = [](void* delegate) { return delegate != nullptr; };
+        state.counters["created"] = static_cast<double>(
+            std::count_if(first_delegates.begin(), first_delegates.end(), is_created) +
+            std::count_if(each_delegates.begin(), each_delegates.end(), is_created) +
+            std::count_if(batch_delegates.begin(), batch_delegates.end(), is_created));
+        state.counters["each_us_per_delegate"] = each_ns / 1000.0 / each_requests.size();
+        state.counters["batch_us_per_delegate"] = batch_ns / 1000.0 / batch_requests.size();
+    }
+
+    BENCHMARK(BM_CreateDelegatesMock)
+        ->ArgNames({ "batch", "delegates" })
+        ->ArgsProduct({ { 0, 1 }, { 50, 200 } })
+        ->Iterations(200)
+        ->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_CreateDelegatesInstalled)->Iterations(1)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,174 @@
+//
+// host_bench.cc
+// The host end to end on the coreclr_mock stand-in: StartCoreCLR through to
+// UnloadRuntime by the size of the framework, the part of it StartCoreCLRAsync
+// leaves on its caller's thread, and CreateAssemblyDelegate and
+// ExecuteAssemblyFunction on a started runtime, whose delegates are cached after
+// the first call. The mock costs next to nothing, so the times are the host's.
+//
+
+#include <benchmark/benchmark.h>
+#include "coreload.h"
+#include "mock_runtime.h"
+
+using coreload::pal::string_t;
+
+namespace
+{
+    template <size_t N>
+    void copy_host_string(coreload::pal::char_t (&destination)[N], const string_t& source)
+    {
+        std::copy(source.begin(), source.begin() + std::min(source.size(), N - 1), destination);
+        destination[std::min(source.size(), N - 1)] = _X('\0');
+    }
+
+    core_host_arguments make_arguments(const test_utils::mock_runtime_layout_t& layout)
+    {
+        core_host_arguments arguments = core_host_arguments();
+        copy_host_string(arguments.assembly_file_path, layout.get_app_path());
+        copy_host_string(arguments.core_root_path, layout.get_dotnet_root());
+        return arguments;
+    }
+
+    void BM_StartCoreCLR(benchmark::State& state)
+    {
+        test_utils::mock_runtime_layout_t layout(static_cast<int>(state.range(0)));
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the mock runtime layout");
+            return;
+        }
+
+        const core_host_arguments arguments = make_arguments(layout);
+        for (auto _ : state)
+        {
+            if (StartCoreCLR(&arguments) != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the mock runtime did not start");
+                return;
+            }
+            UnloadRuntime();
+        }
+    }
+
+    // The time StartCoreCLRAsync holds up its caller, with the start itself untimed
+    void BM_StartCoreCLRAsync(benchmark::State& state)
+    {
+        test_utils::mock_runtime_layout_t layout(static_cast<int>(state.range(0)));
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the mock runtime layout");
+            return;
+        }
+
+        const core_host_arguments arguments = make_arguments(layout);
+        for (auto _ : state)
+        {
+            void* handle = nullptr;
+            if (StartCoreCLRAsync(&arguments, nullptr, nullptr, &handle) != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the mock runtime start did not begin");
+                return;
+            }
+
+            state.PauseTiming();
+            int completed = 0;
+            int exit_code = 0;
+            WaitStartCoreCLR(handle, START_CORECLR_INFINITE, &completed, &exit_code);
+            CloseStartCoreCLR(handle);
+            UnloadRuntime();
+            state.ResumeTiming();
+            if (exit_code != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the mock runtime did not start");
+                return;
+            }
+        }
+    }
+
+    void BM_CreateAssemblyDelegate(benchmark::State& state)
+    {
+        test_utils::mock_runtime_layout_t layout;
+        const core_host_arguments arguments = make_arguments(layout);
+        if (!layout.is_valid() || StartCoreCLR(&arguments) != coreload::StatusCode::Success)
+        {
+            state.SkipWithError("the mock runtime did not start");
+            return;
+        }
+
+        for (auto _ : state)
+        {
+            void* delegate = nullptr;
+            if (CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Add", &delegate) != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the delegate was not created");
+                break;
+            }
+            benchmark::DoNotOptimize(delegate);
+        }
+        UnloadRuntime();
+    }
+
+    assembly_function_call make_function_call()
+    {
+        assembly_function_call call = assembly_function_call();
+        copy_host_string(call.assembly_name, _X("Calculator"));
+        copy_host_string(call.class_name, _X("Calculator.Calculator"));
+        copy_host_string(call.function_name, _X("Load"));
+        return call;
+    }
+
+    // Validates and converts the names, then finds the delegate in the cache
+    void BM_ExecuteAssemblyFunction(benchmark::State& state)
+    {
+        test_utils::mock_runtime_layout_t layout;
+        const core_host_arguments arguments = make_arguments(layout);
+        if (!layout.is_valid() || StartCoreCLR(&arguments) != coreload::StatusCode::Success)
+        {
+            state.SkipWithError("the mock runtime did not start");
+            return;
+        }
+
+        const assembly_function_call call = make_function_call();
+        for (auto _ : state)
+        {
+            if (ExecuteAssemblyFunction(&call) != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the function was not executed");
+                break;
+            }
+        }
+        UnloadRuntime();
+    }
+
+    // Calls the delegate of a handle, with no lookup
+    void BM_ExecuteAssemblyFunctionHandle(benchmark::State& state)
+    {
+        test_utils::mock_runtime_layout_t layout;
+        const core_host_arguments arguments = make_arguments(layout);
+        const assembly_function_call call = make_function_call();
+        void* handle = nullptr;
+        if (!layout.is_valid() || StartCoreCLR(&arguments) != coreload::StatusCode::Success ||
+            GetAssemblyFunctionHandle(&call, &handle) != coreload::StatusCode::Success)
+        {
+            state.SkipWithError("the mock runtime did not start");
+            return;
+        }
+
+        for (auto _ : state)
+        {
+            if (ExecuteAssemblyFunctionHandle(handle, call.arguments) != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the function was not executed");
+                break;
+            }
+        }
+        UnloadRuntime();
+    }
+
+    BENCHMARK(BM_StartCoreCLR)->ArgName("libraries")->Arg(10)->Arg(160)->Arg(1000)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_StartCoreCLRAsync)->ArgName("libraries")->Arg(160)->Iterations(200)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_CreateAssemblyDelegate);
+    BENCHMARK(BM_ExecuteAssemblyFunction);
+    BENCHMARK(BM_ExecuteAssemblyFunctionHandle);
+}
@@ -0,0 +1,197 @@
+//
+// json_bench.cc
+// JSON parsing throughput over shared framework deps files, in MB/s.
+//
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <sstream>
+#include "bench_utils.h"
+#include "cpprest/json.h"
+#include "cpprest/details/json_scan.h"
+
+using web::json::details::scan_isa;
+
+namespace
+{
+    struct deps_input_t
+    {
+        std::string name;
+        std::vector<char> contents;
+    };
+
+    // A deps file shaped like a framework's, measured with the installed ones so that
+    // results compare across machines, including those without .NET.
+    std::vector<char> make_synthetic_deps()
+    {
+        std::string json = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v8.0/linux-x64\" },\n  \"targets\": {\n"
+            "    \".NETCoreApp,Version=v8.0/linux-x64\": {\n      \"Microsoft.NETCore.App.Runtime.linux-x64/8.0.0\": {\n"
+            "        \"runtime\": {\n";
+        for (int i = 0; i < 1000; ++i)
+        {
+            std::string file = "System.Synthetic.Assembly" + std::to_string(i) + ".dll";
+            json += "          \"runtimes/linux-x64/lib/net8.0/" + file + "\": {\n"
+                "            \"assemblyVersion\": \"8.0.0.0\",\n            \"fileVersion\": \"8.0.2024.12345\"\n          }";
+            json += (i == 999) ? "\n" : ",\n";
+        }
+        json += "        }\n      }\n    }\n  },\n  \"libraries\": {\n"
+            "    \"Microsoft.NETCore.App.Runtime.linux-x64/8.0.0\": {\n      \"type\": \"package\",\n"
+            "      \"serviceable\": true,\n      \"sha512\": \"\",\n"
+            "      \"path\": \"microsoft.netcore.app.runtime.linux-x64/8.0.0\",\n"
+            "      \"hashPath\": \"microsoft.netcore.app.runtime.linux-x64.8.0.0.nupkg.sha512\"\n    }\n  }\n}\n";
+        return std::vector<char>(json.begin(), json.end());
+    }
+
+    std::vector<deps_input_t> load_inputs()
+    {
+        std::vector<deps_input_t> inputs;
+        const std::pair<const coreload::pal::char_t*, const char*> frameworks[] = {
+            { _X("Microsoft.NETCore.App"), "Microsoft.NETCore.App" },
+            { _X("Microsoft.AspNetCore.App"), "Microsoft.AspNetCore.App" } };
+        for (const auto& framework : frameworks)
+        {
+            deps_input_t input;
+            coreload::pal::string_t path = bench_utils::find_framework_deps(framework.first);
+            if (!path.empty() && coreload::read_file(path, &input.contents))
+            {
+                input.name = framework.second;
+                inputs.push_back(std::move(input));
+            }
+        }
+
+        inputs.push_back(deps_input_t{ "Synthetic", make_synthetic_deps() });
+        return inputs;
+    }
+
+    void skip_bom(const std::vector<char>& contents, const char** begin, const char** end)
+    {
+        *begin = contents.data();
+        *end = contents.data() + contents.size();
+        coreload::skip_utf8_bom(begin, *end);
+    }
+
+    void BM_ParseStream(benchmark::State& state, const deps_input_t* input)
+    {
+        const char* begin;
+        const char* end;
+        skip_bom(input->contents, &begin, &end);
+        std::string text(begin, end);
+
+        for (auto _ : state)
+        {
+            std::istringstream stream(text);
+            benchmark::DoNotOptimize(web::json::value::parse(stream));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * text.size());
+    }
+
+    void BM_ParseBuffer(benchmark::State& state, const deps_input_t* input, scan_isa isa)
+    {
+        if (isa > web::json::details::supported_scan_isa())
+        {
+            state.SkipWithError("instruction set not supported");
+            return;
+        }
+
+        const char* begin;
+        const char* end;
+        skip_bom(input->contents, &begin, &end);
+
+        scan_isa previous = web::json::details::get_scan_isa();
+        web::json::details::set_scan_isa(isa);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(web::json::value::parse(begin, end));
+        }
+        web::json::details::set_scan_isa(previous);
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (end - begin));
+    }
+
+    void BM_ParseDocument(benchmark::State& state, const deps_input_t* input)
+    {
+        const char* begin;
+        const char* end;
+        skip_bom(input->contents, &begin, &end);
+
+        web::json::document::memory_stats stats = web::json::document::memory_stats();
+        for (auto _ : state)
+        {
+            auto document = web::json::document::parse(begin, end);
+            stats = document.get_memory_stats();
+            benchmark::DoNotOptimize(document.root());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (end - begin));
+        state.counters["arena_allocations"] = static_cast<double>(stats.allocations);
+        state.counters["arena_bytes_allocated"] = static_cast<double>(stats.bytes_allocated);
+        state.counters["arena_bytes_reserved"] = static_cast<double>(stats.bytes_reserved);
+    }
+
+    void BM_ScanWhitespaceAndStrings(benchmark::State& state, const deps_input_t* input, scan_isa isa)
+    {
+        if (isa > web::json::details::supported_scan_isa())
+        {
+            state.SkipWithError("instruction set not supported");
+            return;
+        }
+
+        const char* begin;
+        const char* end;
+        skip_bom(input->contents, &begin, &end);
+
+        // Alternate the two scanners the way the parser does, without building values.
+        scan_isa previous = web::json::details::get_scan_isa();
+        web::json::details::set_scan_isa(isa);
+        for (auto _ : state)
+        {
+            size_t newlines = 0;
+            const char* line_start = begin;
+            const char* pos = begin;
+            while (pos != end)
+            {
+                pos = web::json::details::scan_whitespace(pos, end, &newlines, &line_start);
+                if (pos != end && *pos == '"')
+                {
+                    pos = web::json::details::scan_string(pos + 1, end);
+                }
+                if (pos != end)
+                {
+                    ++pos;
+                }
+            }
+            benchmark::DoNotOptimize(newlines);
+        }
+        web::json::details::set_scan_isa(previous);
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (end - begin));
+    }
+
+    const std::vector<deps_input_t>& get_inputs()
+    {
+        static const std::vector<deps_input_t> inputs = load_inputs();
+        return inputs;
+    }
+
+    int register_benchmarks()
+    {
+        const std::pair<scan_isa, const char*> isas[] = {
+            { scan_isa::scalar, "scalar" }, { scan_isa::sse2, "sse2" }, { scan_isa::avx2, "avx2" } };
+
+        for (const auto& input : get_inputs())
+        {
+            benchmark::RegisterBenchmark(("json_parse_stream/" + input.name).c_str(), BM_ParseStream, &input);
+            for (const auto& isa : isas)
+            {
+                benchmark::RegisterBenchmark(("json_parse_buffer/" + input.name + "/" + isa.second).c_str(),
+                    BM_ParseBuffer, &input, isa.first);
+            }
+            benchmark::RegisterBenchmark(("json_parse_document/" + input.name).c_str(), BM_ParseDocument, &input);
+            for (const auto& isa : isas)
+            {
+                benchmark::RegisterBenchmark(("json_scan/" + input.name + "/" + isa.second).c_str(),
+                    BM_ScanWhitespaceAndStrings, &input, isa.first);
+            }
+        }
+        return 0;
+    }
+
+    const int registered = register_benchmarks();
+}
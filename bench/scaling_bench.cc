@@ -0,0 +1,150 @@
+//
+// scaling_bench.cc
+// fx_muxer_t::initialize_clr on the coreclr_mock stand-in over generated layouts
+// (see layout_generator.h), sweeping one dimension at a time from a baseline: the
+// number of chained frameworks, of installed versions of each, of libraries in
+// each framework's deps file, of packages the app takes from the package cache and
+// of other packages in that cache. The last run is a worst case production host.
+//
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <tuple>
+#include "fx_muxer.h"
+#include "status_code.h"
+#include "layout_generator.h"
+#include "startup_metrics.h"
+
+using coreload::pal::string_t;
+
+namespace
+{
+    struct generated_layout_t
+    {
+        string_t root;
+        test_utils::layout_paths_t paths;
+        bool valid;
+    };
+
+    // Layouts are kept for the whole run, since Google Benchmark calls each
+    // benchmark several times and the largest take seconds to write.
+    class layout_cache_t
+    {
+    public:
+        ~layout_cache_t()
+        {
+            for (const auto& layout : m_layouts)
+            {
+                test_utils::remove_directory_tree(layout.second.root);
+            }
+        }
+
+        const generated_layout_t& get(const test_utils::layout_spec_t& spec)
+        {
+            const auto key = std::make_tuple(spec.framework_count, spec.versions_per_framework,
+                spec.libraries_per_framework, spec.app_package_count, spec.cache_package_count);
+            auto existing = m_layouts.find(key);
+            if (existing != m_layouts.end())
+            {
+                return existing->second;
+            }
+
+            generated_layout_t& layout = m_layouts[key];
+            layout.root = test_utils::make_temp_directory(_X("scaling_bench"));
+#if defined(CORECLR_MOCK_PATH)
+            layout.valid = !layout.root.empty() && test_utils::write_layout(layout.root, spec, _X(CORECLR_MOCK_PATH), &layout.paths);
+#else
+            layout.valid = false;
+#endif
+            return layout;
+        }
+
+    private:
+        std::map<std::tuple<int, int, int, int, int>, generated_layout_t> m_layouts;
+    };
+
+    layout_cache_t& get_layouts()
+    {
+        static layout_cache_t layouts;
+        return layouts;
+    }
+
+    void BM_InitializeClr(benchmark::State& state)
+    {
+        test_utils::layout_spec_t spec;
+        spec.framework_count = static_cast<int>(state.range(0));
+        spec.versions_per_framework = static_cast<int>(state.range(1));
+        spec.libraries_per_framework = static_cast<int>(state.range(2));
+        spec.app_package_count = static_cast<int>(state.range(3));
+        spec.cache_package_count = static_cast<int>(state.range(4));
+
+        const generated_layout_t& layout = get_layouts().get(spec);
+        if (!layout.valid)
+        {
+            state.SkipWithError("could not write the layout");
+            return;
+        }
+
+        coreload::startup_metrics_t metrics;
+        for (auto _ : state)
+        {
+            coreload::host_startup_info_t startup_info;
+            startup_info.dotnet_root = layout.paths.dotnet_root;
+            coreload::arguments_t arguments;
+            arguments.managed_application = layout.paths.app_path;
+            arguments.app_root = coreload::get_directory(arguments.managed_application);
+
+            metrics.start();
+            coreload::coreclr::domain_id_t domain_id;
+            coreload::coreclr::host_handle_t host_handle;
+            int exit_code;
+            {
+                coreload::startup_metrics_scope_t scope(&metrics);
+                exit_code = coreload::fx_muxer_t::initialize_clr(arguments, startup_info, coreload::host_mode_t::muxer, domain_id, host_handle);
+            }
+            metrics.stop();
+            if (exit_code != coreload::StatusCode::Success)
+            {
+                state.SkipWithError("the mock runtime did not start");
+                return;
+            }
+
+            int latched_exit_code = 0;
+            coreload::coreclr::shutdown(host_handle, domain_id, &latched_exit_code);
+            coreload::coreclr::unload();
+        }
+
+        const auto snapshot = metrics.get_snapshot();
+        state.counters["files_checked"] = static_cast<double>(snapshot.files_checked);
+        state.counters["directories_read"] = static_cast<double>(snapshot.directories_read);
+        state.counters["tpa_entries"] = static_cast<double>(snapshot.tpa_entries);
+    }
+
+    void sweep_layouts(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({ "frameworks", "versions", "libraries", "app_packages", "cache_packages" });
+
+        // The baseline, an app of a few dozen packages on one framework
+        const std::vector<int64_t> baseline = { 1, 1, 160, 50, 0 };
+        const std::vector<std::vector<int64_t>> sweeps = {
+            { 2, 3, 5 },
+            { 3, 10 },
+            { 1000, 3000 },
+            { 500 },
+            { 1000, 10000, 100000 } };
+
+        benchmark->Args(baseline);
+        for (size_t dimension = 0; dimension < sweeps.size(); ++dimension)
+        {
+            for (int64_t value : sweeps[dimension])
+            {
+                std::vector<int64_t> args = baseline;
+                args[dimension] = value;
+                benchmark->Args(args);
+            }
+        }
+        benchmark->Args({ 5, 10, 3000, 500, 100000 });
+    }
+
+    BENCHMARK(BM_InitializeClr)->Apply(sweep_layouts)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,392 @@
+//
+// startup_bench.cc
+// Wall clock time of reading the deps files of an app on three shared frameworks
+// and of probing their assets, by the number of resolver threads, and of probing
+// the packages of an app in NuGet style probe directories. Also the allocations
+// made by a startup, with and without evaluating the trace arguments.
+//
+
+#include <benchmark/benchmark.h>
+#include "allocation_tracker.h"
+#include "bench_utils.h"
+#include "deps_resolver.h"
+#include "test_utils.h"
+#include "trace.h"
+
+using coreload::fx_definition_t;
+using coreload::pal::string_t;
+
+namespace
+{
+    struct framework_t
+    {
+        string_t name;
+        string_t dir;
+        string_t version;
+    };
+
+    // An ASP.NET Core app on an internal framework: the installed Microsoft.NETCore.App
+    // and Microsoft.AspNetCore.App of the same version, or synthetic ones of a similar
+    // size, with the internal framework and the app written to a temp directory.
+    class startup_layout_t
+    {
+    public:
+        startup_layout_t()
+        {
+            m_root = test_utils::make_temp_directory(_X("startup_bench"));
+            if (m_root.empty())
+            {
+                return;
+            }
+
+            string_t version;
+            string_t shared = bench_utils::get_dotnet_root();
+            coreload::append_path(&shared, _X("shared"));
+            if (find_common_version(shared, &version))
+            {
+                m_description = "installed";
+            }
+            else
+            {
+                shared = test_utils::path_combine(m_root, _X("shared"));
+                version = _X("3.1.0");
+                m_description = "synthetic";
+                if (!test_utils::write_framework(fx_dir(shared, _X("Microsoft.NETCore.App"), version), "Microsoft.NETCore.App", "3.1.0", 160, true) ||
+                    !test_utils::write_framework(fx_dir(shared, _X("Microsoft.AspNetCore.App"), version), "Microsoft.AspNetCore.App", "3.1.0", 140, false))
+                {
+                    return;
+                }
+            }
+
+            string_t internal_dir = fx_dir(test_utils::path_combine(m_root, _X("shared")), _X("Contoso.Internal.App"), version);
+            std::vector<char> internal_version;
+            coreload::pal::pal_utf8string(version, &internal_version);
+            if (!test_utils::write_framework(internal_dir, "Contoso.Internal.App", internal_version.data(), 100, false))
+            {
+                return;
+            }
+
+            // The frameworks from the highest level down to the root framework
+            m_frameworks.push_back(framework_t{ _X("Contoso.Internal.App"), internal_dir, version });
+            m_frameworks.push_back(framework_t{ _X("Microsoft.AspNetCore.App"), fx_dir(shared, _X("Microsoft.AspNetCore.App"), version), version });
+            m_frameworks.push_back(framework_t{ _X("Microsoft.NETCore.App"), fx_dir(shared, _X("Microsoft.NETCore.App"), version), version });
+
+            // Laid out like a root framework, with the native assets for this platform next to the app
+            m_app_dir = test_utils::path_combine(m_root, _X("app"));
+            test_utils::write_framework(m_app_dir, "app", "1.0.0", 20, true);
+        }
+
+        ~startup_layout_t()
+        {
+            test_utils::remove_directory_tree(m_root);
+        }
+
+        bool is_valid() const { return !m_frameworks.empty(); }
+        const std::string& get_description() const { return m_description; }
+
+        void make_init(coreload::hostpolicy_init_t* init, coreload::arguments_t* args) const
+        {
+            init->is_framework_dependent = true;
+            init->fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t()));
+            for (const auto& fx : m_frameworks)
+            {
+                init->fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t(fx.name, fx.dir, fx.version, fx.version)));
+            }
+
+            args->app_root = m_app_dir;
+            args->deps_path = test_utils::path_combine(m_app_dir, _X("app.deps.json"));
+            args->managed_application = test_utils::path_combine(m_app_dir, _X("app.dll"));
+        }
+
+    private:
+        static string_t fx_dir(const string_t& shared, const string_t& name, const string_t& version)
+        {
+            return test_utils::path_combine(test_utils::path_combine(shared, name), version);
+        }
+
+        // The highest version installed for both frameworks
+        static bool find_common_version(const string_t& shared, string_t* version)
+        {
+            std::vector<string_t> versions;
+            coreload::pal::readdir_onlydirectories(test_utils::path_combine(shared, _X("Microsoft.NETCore.App")), &versions);
+
+            coreload::fx_ver_t best;
+            for (const auto& candidate : versions)
+            {
+                coreload::fx_ver_t ver;
+                if (!coreload::fx_ver_t::parse(candidate, &ver) || (!version->empty() && ver <= best))
+                {
+                    continue;
+                }
+
+                if (coreload::pal::file_exists(test_utils::path_combine(fx_dir(shared, _X("Microsoft.NETCore.App"), candidate), _X("Microsoft.NETCore.App.deps.json"))) &&
+                    coreload::pal::file_exists(test_utils::path_combine(fx_dir(shared, _X("Microsoft.AspNetCore.App"), candidate), _X("Microsoft.AspNetCore.App.deps.json"))))
+                {
+                    best = ver;
+                    *version = candidate;
+                }
+            }
+            return !version->empty();
+        }
+
+        string_t m_root;
+        string_t m_app_dir;
+        std::vector<framework_t> m_frameworks;
+        std::string m_description;
+    };
+
+    const startup_layout_t& get_layout()
+    {
+        static const startup_layout_t layout;
+        return layout;
+    }
+
+    void BM_ReadFrameworkDeps(benchmark::State& state)
+    {
+        const startup_layout_t& layout = get_layout();
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the frameworks");
+            return;
+        }
+
+        test_utils::env_scope env(_X("COREHOST_THREADS"), coreload::pal::to_string(static_cast<int>(state.range(0))));
+        for (auto _ : state)
+        {
+            coreload::hostpolicy_init_t init;
+            coreload::arguments_t args;
+            layout.make_init(&init, &args);
+
+            coreload::deps_resolver_t resolver(init, args);
+            string_t errors;
+            if (!resolver.valid(&errors))
+            {
+                state.SkipWithError("the deps files are not valid");
+                return;
+            }
+        }
+        state.SetLabel(layout.get_description());
+    }
+
+    void BM_ProbeAssets(benchmark::State& state)
+    {
+        const startup_layout_t& layout = get_layout();
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the frameworks");
+            return;
+        }
+
+        test_utils::env_scope env(_X("COREHOST_THREADS"), coreload::pal::to_string(static_cast<int>(state.range(0))));
+        coreload::hostpolicy_init_t init;
+        coreload::arguments_t args;
+        layout.make_init(&init, &args);
+        coreload::deps_resolver_t resolver(init, args);
+
+        for (auto _ : state)
+        {
+            coreload::probe_paths_t probe_paths;
+            std::unordered_set<string_t> breadcrumb;
+            if (!resolver.resolve_probe_paths(&probe_paths, &breadcrumb))
+            {
+                state.SkipWithError("the assets could not be resolved");
+                return;
+            }
+        }
+        state.SetLabel(layout.get_description());
+    }
+
+    // Allocations of a startup: reading the deps files and probing their assets.
+    // With tracing off (0) the trace macros skip their arguments. With verbose
+    // tracing to a file (1) every argument is evaluated, as all of them were before
+    // the macros whether tracing was on or not; the difference is what the macros
+    // save. Writing the records uses malloc, which is not counted.
+    void BM_StartupAllocations(benchmark::State& state)
+    {
+        const startup_layout_t& layout = get_layout();
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the frameworks");
+            return;
+        }
+
+        const bool traced = state.range(0) != 0;
+        const string_t trace_dir = traced ? test_utils::make_temp_directory(_X("startup_bench_trace")) : string_t();
+        if (traced)
+        {
+            test_utils::env_scope trace_file(_X("COREHOST_TRACEFILE"), test_utils::path_combine(trace_dir, _X("trace.txt")));
+            test_utils::env_scope verbosity(_X("COREHOST_TRACE_VERBOSITY"), _X("4"));
+            test_utils::env_scope async(_X("COREHOST_TRACE_ASYNC"), _X("0"));
+            test_utils::env_scope binary(_X("COREHOST_TRACE_BINARY"), _X("0"));
+            if (trace_dir.empty() || !coreload::trace::enable())
+            {
+                state.SkipWithError("could not turn tracing on");
+                return;
+            }
+        }
+
+        test_utils::env_scope env(_X("COREHOST_THREADS"), _X("1"));
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        int64_t peak_live_bytes = 0;
+        for (auto _ : state)
+        {
+            coreload::allocation_tracker_t::reset_peak();
+            auto start = coreload::allocation_tracker_t::get_counts();
+
+            coreload::hostpolicy_init_t init;
+            coreload::arguments_t args;
+            layout.make_init(&init, &args);
+            coreload::deps_resolver_t resolver(init, args);
+
+            coreload::probe_paths_t probe_paths;
+            if (!resolver.resolve_probe_paths(&probe_paths, nullptr))
+            {
+                state.SkipWithError("the assets could not be resolved");
+                break;
+            }
+
+            auto end = coreload::allocation_tracker_t::get_counts();
+            allocations += end.allocations - start.allocations;
+            bytes += end.bytes - start.bytes;
+            peak_live_bytes = std::max(peak_live_bytes, end.peak_live_bytes - start.live_bytes);
+        }
+
+        if (traced)
+        {
+            coreload::trace::disable();
+            test_utils::remove_directory_tree(trace_dir);
+        }
+
+        state.counters["allocations"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+        state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+        state.counters["peak_live_bytes"] = static_cast<double>(peak_live_bytes);
+        state.SetLabel(layout.get_description());
+    }
+
+    // An app whose packages, with an assembly and three satellite assemblies each,
+    // are found in the last of several NuGet style probe directories, the others
+    // holding unrelated packages.
+    class package_layout_t
+    {
+    public:
+        static const int package_count = 200;
+        static const int other_package_count = 2000;
+
+        package_layout_t()
+        {
+            m_root = test_utils::make_temp_directory(_X("startup_bench_packages"));
+            if (m_root.empty())
+            {
+                return;
+            }
+
+            m_found_in = test_utils::path_combine(m_root, _X("found"));
+            std::string targets;
+            std::string libraries;
+            for (int i = 0; i < package_count; ++i)
+            {
+                std::string name = "Contoso.Package" + std::to_string(i);
+                std::string lower = "contoso.package" + std::to_string(i);
+                targets += ",\n      \"" + name + "/1.0.0\": {\n"
+                    "        \"runtime\": { \"lib/netstandard2.0/" + name + ".dll\": {} },\n"
+                    "        \"resources\": {\n";
+                for (const char* locale : { "de", "fr", "ja" })
+                {
+                    std::string resource = std::string("lib/netstandard2.0/") + locale + "/" + name + ".resources.dll";
+                    targets += std::string("          \"") + resource + "\": { \"locale\": \"" + locale + "\" }" + (*locale == 'j' ? "\n" : ",\n");
+                    if (!test_utils::write_file(test_utils::path_combine(m_found_in, test_utils::to_palstring(lower + "/1.0.0/" + resource)), "resource"))
+                    {
+                        return;
+                    }
+                }
+                targets += "        }\n      }";
+                libraries += ",\n    \"" + name + "/1.0.0\": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\", \"path\": \"" + lower + "/1.0.0\" }";
+                if (!test_utils::write_file(test_utils::path_combine(m_found_in, test_utils::to_palstring(lower + "/1.0.0/lib/netstandard2.0/" + name + ".dll")), "package"))
+                {
+                    return;
+                }
+            }
+
+            for (const auto* dir : { _X("other1"), _X("other2") })
+            {
+                string_t probe_dir = test_utils::path_combine(m_root, dir);
+                for (int i = 0; i < other_package_count; ++i)
+                {
+                    std::string lower = "fabrikam.package" + std::to_string(i);
+                    if (!test_utils::write_file(test_utils::path_combine(probe_dir, test_utils::to_palstring(lower + "/1.0.0/lib/netstandard2.0/" + lower + ".dll")), "package"))
+                    {
+                        return;
+                    }
+                }
+                m_probe_paths.push_back(probe_dir);
+            }
+            m_probe_paths.push_back(m_found_in);
+
+            m_app_dir = test_utils::path_combine(m_root, _X("app"));
+            std::string json = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\" },\n"
+                "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+                "      \"app/1.0.0\": { \"runtime\": { \"app.dll\": {} } }" + targets + "\n    }\n  },\n"
+                "  \"libraries\": {\n"
+                "    \"app/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" }" + libraries + "\n  }\n}\n";
+            m_valid = test_utils::write_file(test_utils::path_combine(m_app_dir, _X("app.deps.json")), json) &&
+                test_utils::write_file(test_utils::path_combine(m_app_dir, _X("app.dll")), "app");
+        }
+
+        ~package_layout_t()
+        {
+            test_utils::remove_directory_tree(m_root);
+        }
+
+        bool is_valid() const { return m_valid; }
+
+        void make_init(coreload::hostpolicy_init_t* init, coreload::arguments_t* args) const
+        {
+            init->is_framework_dependent = false;
+            init->fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t()));
+
+            args->app_root = m_app_dir;
+            args->deps_path = test_utils::path_combine(m_app_dir, _X("app.deps.json"));
+            args->managed_application = test_utils::path_combine(m_app_dir, _X("app.dll"));
+            args->probe_paths = m_probe_paths;
+        }
+
+    private:
+        string_t m_root;
+        string_t m_app_dir;
+        string_t m_found_in;
+        std::vector<string_t> m_probe_paths;
+        bool m_valid = false;
+    };
+
+    void BM_ProbePackageLayouts(benchmark::State& state)
+    {
+        static const package_layout_t layout;
+        if (!layout.is_valid())
+        {
+            state.SkipWithError("could not write the packages");
+            return;
+        }
+
+        test_utils::env_scope env(_X("COREHOST_THREADS"), coreload::pal::to_string(static_cast<int>(state.range(0))));
+        coreload::hostpolicy_init_t init;
+        coreload::arguments_t args;
+        layout.make_init(&init, &args);
+        coreload::deps_resolver_t resolver(init, args);
+
+        for (auto _ : state)
+        {
+            coreload::probe_paths_t probe_paths;
+            if (!resolver.resolve_probe_paths(&probe_paths, nullptr))
+            {
+                state.SkipWithError("the packages could not be resolved");
+                return;
+            }
+        }
+    }
+
+    BENCHMARK(BM_ReadFrameworkDeps)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ProbeAssets)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_StartupAllocations)->ArgName("traced")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ProbePackageLayouts)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+}
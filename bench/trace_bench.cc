@@ -0,0 +1,171 @@
+//
+// trace_bench.cc
+// Cost of a verbose trace call with tracing off, called directly and through
+// TRACE_VERBOSE, in time and allocations per call. Also the cost of writing
+// trace records to a file from the calling threads, through trace_sink_t and as
+// a binary capture.
+//
+
+#include <benchmark/benchmark.h>
+#include <cstdarg>
+#include <mutex>
+#include "bench_utils.h"
+#include "test_utils.h"
+#include "trace.h"
+#include "trace_capture.h"
+#include "trace_sink.h"
+#include "version.h"
+
+namespace
+{
+    // The trace of a replaced deps entry in deps_resolver_t::resolve_tpa_list
+    const coreload::pal::char_t* const replacing_format = _X("Replacing deps entry [%s, AssemblyVersion:%s, FileVersion:%s] with [%s, AssemblyVersion:%s, FileVersion:%s]");
+
+    struct replaced_entry_t
+    {
+        coreload::pal::string_t existing_path = _X("/usr/share/dotnet/shared/Microsoft.NETCore.App/3.1.32/System.Text.Json.dll");
+        coreload::version_t existing_assembly_version = coreload::version_t(4, 0, 1, 2);
+        coreload::version_t existing_file_version = coreload::version_t(4, 700, 22, 55902);
+        coreload::pal::string_t path = _X("/home/user/app/System.Text.Json.dll");
+        coreload::version_t assembly_version = coreload::version_t(6, 0, 0, 0);
+        coreload::version_t file_version = coreload::version_t(6, 0, 3624, 51421);
+    };
+
+    void BM_TraceVerboseCall(benchmark::State& state)
+    {
+        replaced_entry_t entry;
+        size_t start = bench_utils::get_allocation_count();
+        for (auto _ : state)
+        {
+            coreload::trace::verbose(replacing_format,
+                entry.existing_path.c_str(), entry.existing_assembly_version.as_str().c_str(), entry.existing_file_version.as_str().c_str(),
+                entry.path.c_str(), entry.assembly_version.as_str().c_str(), entry.file_version.as_str().c_str());
+        }
+        state.counters["allocations"] = benchmark::Counter(static_cast<double>(bench_utils::get_allocation_count() - start), benchmark::Counter::kAvgIterations);
+    }
+
+    void BM_TraceVerboseMacro(benchmark::State& state)
+    {
+        replaced_entry_t entry;
+        size_t start = bench_utils::get_allocation_count();
+        for (auto _ : state)
+        {
+            TRACE_VERBOSE(replacing_format,
+                entry.existing_path.c_str(), entry.existing_assembly_version.as_str().c_str(), entry.existing_file_version.as_str().c_str(),
+                entry.path.c_str(), entry.assembly_version.as_str().c_str(), entry.file_version.as_str().c_str());
+            benchmark::ClobberMemory();
+        }
+        state.counters["allocations"] = benchmark::Counter(static_cast<double>(bench_utils::get_allocation_count() - start), benchmark::Counter::kAvgIterations);
+    }
+
+    // A trace file shared by the threads of a benchmark
+    class trace_file_t
+    {
+    public:
+        trace_file_t()
+        {
+            m_root = test_utils::make_temp_directory(_X("trace_bench"));
+            if (!m_root.empty())
+            {
+                m_file = coreload::pal::file_open(test_utils::path_combine(m_root, _X("trace.txt")), _X("wb"));
+            }
+        }
+
+        ~trace_file_t()
+        {
+            if (m_file != nullptr)
+            {
+                fclose(m_file);
+            }
+            test_utils::remove_directory_tree(m_root);
+        }
+
+        FILE* get() const { return m_file; }
+
+    private:
+        coreload::pal::string_t m_root;
+        FILE* m_file = nullptr;
+    };
+
+    std::mutex g_sync_lock;
+    std::unique_ptr<trace_file_t> g_trace_file;
+    std::unique_ptr<coreload::trace_sink_t> g_trace_sink;
+    std::unique_ptr<coreload::trace_capture_writer_t> g_trace_capture;
+
+    // As trace::verbose writes without the sink
+    void write_sync(const coreload::pal::char_t* format, ...)
+    {
+        std::lock_guard<std::mutex> lock(g_sync_lock);
+        va_list args;
+        va_start(args, format);
+        coreload::pal::file_vprintf(g_trace_file->get(), format, args);
+        va_end(args);
+    }
+
+    void write_async(const coreload::pal::char_t* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        g_trace_sink->write(format, args);
+        va_end(args);
+    }
+
+    void write_capture(const coreload::pal::char_t* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        g_trace_capture->write(coreload::trace_capture::level_t::verbose, format, args);
+        va_end(args);
+    }
+
+    // Writes the "Replacing deps entry" record synchronously (0), through the sink (1)
+    // or to a capture (2)
+    void BM_TraceToFile(benchmark::State& state)
+    {
+        int mode = static_cast<int>(state.range(0));
+        if (state.thread_index() == 0)
+        {
+            g_trace_file.reset(new trace_file_t());
+            if (mode == 1 && g_trace_file->get() != nullptr)
+            {
+                g_trace_sink.reset(new coreload::trace_sink_t(g_trace_file->get()));
+            }
+            else if (mode == 2 && g_trace_file->get() != nullptr)
+            {
+                g_trace_capture.reset(new coreload::trace_capture_writer_t(g_trace_file->get()));
+            }
+        }
+
+        // Formatting the versions is left out, it costs the same either way
+        replaced_entry_t entry;
+        coreload::pal::string_t existing_assembly_version = entry.existing_assembly_version.as_str();
+        coreload::pal::string_t existing_file_version = entry.existing_file_version.as_str();
+        coreload::pal::string_t assembly_version = entry.assembly_version.as_str();
+        coreload::pal::string_t file_version = entry.file_version.as_str();
+
+        auto write = (mode == 1) ? write_async : (mode == 2) ? write_capture : write_sync;
+        for (auto _ : state)
+        {
+            if (g_trace_file->get() == nullptr)
+            {
+                state.SkipWithError("could not open the trace file");
+                break;
+            }
+
+            write(replacing_format,
+                entry.existing_path.c_str(), existing_assembly_version.c_str(), existing_file_version.c_str(),
+                entry.path.c_str(), assembly_version.c_str(), file_version.c_str());
+        }
+
+        if (state.thread_index() == 0)
+        {
+            g_trace_sink.reset();
+            g_trace_capture.reset();
+            g_trace_file.reset();
+        }
+    }
+
+    BENCHMARK(BM_TraceVerboseCall);
+    BENCHMARK(BM_TraceVerboseMacro);
+    BENCHMARK(BM_TraceToFile)->ArgName("mode")->Arg(0)->Arg(1)->Arg(2)->Threads(1)->Threads(4)->UseRealTime();
+}
@@ -0,0 +1,130 @@
+//
+// version_bench.cc
+// Parsing and comparing framework and assembly versions, and rolling a framework
+// reference forward over lists of installed versions of growing length.
+//
+
+#include <benchmark/benchmark.h>
+#include "fx_muxer.h"
+#include "version.h"
+
+using coreload::fx_ver_t;
+using coreload::pal::string_t;
+using coreload::roll_fwd_on_no_candidate_fx_option;
+
+namespace
+{
+    // Framework directory names as found under 'shared': production versions,
+    // previews with and without build metadata.
+    std::vector<string_t> make_fx_versions(size_t count)
+    {
+        std::vector<string_t> versions;
+        versions.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            string_t version = coreload::pal::to_string(static_cast<int>(2 + i % 7)) + _X(".") +
+                coreload::pal::to_string(static_cast<int>(i / 7 % 4)) + _X(".") +
+                coreload::pal::to_string(static_cast<int>(i / 28));
+            switch (i % 5)
+            {
+            case 3:
+                version += _X("-preview.") + coreload::pal::to_string(static_cast<int>(i % 9)) + _X(".24405.7");
+                break;
+            case 4:
+                version += _X("-rc.1+build.") + coreload::pal::to_string(static_cast<int>(i));
+                break;
+            }
+            versions.push_back(version);
+        }
+        return versions;
+    }
+
+    std::vector<fx_ver_t> parse_fx_versions(const std::vector<string_t>& versions)
+    {
+        std::vector<fx_ver_t> parsed;
+        parsed.reserve(versions.size());
+        for (const auto& version : versions)
+        {
+            fx_ver_t ver;
+            if (fx_ver_t::parse(version, &ver, false))
+            {
+                parsed.push_back(ver);
+            }
+        }
+        return parsed;
+    }
+
+    void BM_FxVerParse(benchmark::State& state)
+    {
+        const std::vector<string_t> versions = make_fx_versions(1000);
+        for (auto _ : state)
+        {
+            for (const auto& version : versions)
+            {
+                fx_ver_t ver;
+                benchmark::DoNotOptimize(fx_ver_t::parse(version, &ver, false));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * versions.size());
+    }
+
+    void BM_FxVerCompare(benchmark::State& state)
+    {
+        const std::vector<fx_ver_t> versions = parse_fx_versions(make_fx_versions(1000));
+        for (auto _ : state)
+        {
+            size_t less = 0;
+            for (size_t i = 1; i < versions.size(); ++i)
+            {
+                less += versions[i - 1] < versions[i] ? 1 : 0;
+            }
+            benchmark::DoNotOptimize(less);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (versions.size() - 1));
+    }
+
+    void BM_VersionParse(benchmark::State& state)
+    {
+        // Assembly and file versions as they appear in deps files
+        std::vector<string_t> versions;
+        for (int i = 0; i < 1000; ++i)
+        {
+            versions.push_back(_X("4.") + coreload::pal::to_string(i % 3) + _X(".") + coreload::pal::to_string(i % 20) + _X(".0"));
+            versions.push_back(_X("8.0.") + coreload::pal::to_string(2024 + i % 3) + _X(".") + coreload::pal::to_string(10000 + i));
+        }
+
+        for (auto _ : state)
+        {
+            for (const auto& version : versions)
+            {
+                coreload::version_t ver;
+                benchmark::DoNotOptimize(coreload::version_t::parse(version, &ver));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * versions.size());
+    }
+
+    // Rolls '3.0.0' forward: on no candidate with the given option, then to the
+    // latest patch.
+    void BM_ResolveFrameworkVersion(benchmark::State& state)
+    {
+        const std::vector<fx_ver_t> versions = parse_fx_versions(make_fx_versions(static_cast<size_t>(state.range(0))));
+        const auto roll_fwd_on_no_candidate_fx = static_cast<roll_fwd_on_no_candidate_fx_option>(state.range(1));
+        const string_t requested = _X("3.0.0");
+        fx_ver_t specified;
+        fx_ver_t::parse(requested, &specified, false);
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(coreload::fx_muxer_t::resolve_framework_version(
+                versions, requested, specified, true, roll_fwd_on_no_candidate_fx));
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * versions.size());
+    }
+
+    BENCHMARK(BM_FxVerParse);
+    BENCHMARK(BM_FxVerCompare);
+    BENCHMARK(BM_VersionParse);
+    BENCHMARK(BM_ResolveFrameworkVersion)->ArgNames({ "versions", "roll_fwd" })
+        ->ArgsProduct({ { 16, 256, 4096 }, { 0, 1, 2 } })->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,286 @@
+//
+// coreclr_mock.cc
+// The libcoreclr stand-in, see coreclr_mock.h.
+//
+
+#include "coreclr_mock.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+
+using coreload::pal::hresult_t;
+
+namespace
+{
+#if defined(_WIN32)
+    const char tpa_separator = ';';
+#else
+    const char tpa_separator = ':';
+#endif
+
+    // The methods of tests/dotnet/Calculator.cs
+    void STDMETHODCALLTYPE calculator_load(const void* remote_parameters)
+    {
+        (void)remote_parameters;
+    }
+
+    int STDMETHODCALLTYPE calculator_add(int a, int b) { return a + b; }
+    int STDMETHODCALLTYPE calculator_subtract(int a, int b) { return b - a; }
+    int STDMETHODCALLTYPE calculator_multiply(int a, int b) { return a * b; }
+    int STDMETHODCALLTYPE calculator_divide(int a, int b) { return a / b; }
+
+    struct method_t
+    {
+        const char* name;
+        void* function;
+    };
+
+    const char calculator_assembly[] = "Calculator";
+    const char calculator_type[] = "Calculator.Calculator";
+
+    // A type with a method of every name, all of them Load
+    const char generated_type[] = "Calculator.Generated";
+    const method_t calculator_methods[] = {
+        { "Load", reinterpret_cast<void*>(&calculator_load) },
+        { "Add", reinterpret_cast<void*>(&calculator_add) },
+        { "Subtract", reinterpret_cast<void*>(&calculator_subtract) },
+        { "Multiply", reinterpret_cast<void*>(&calculator_multiply) },
+        { "Divide", reinterpret_cast<void*>(&calculator_divide) },
+    };
+
+    std::string to_lower(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), [](char c) { return static_cast<char>(::tolower(static_cast<unsigned char>(c))); });
+        return value;
+    }
+
+    struct runtime_t
+    {
+        std::mutex lock;
+        bool initialized = false;
+        std::vector<std::pair<std::string, std::string>> properties;
+        std::unordered_set<std::string> tpa_assemblies;
+        coreclr_mock_calls calls = coreclr_mock_calls();
+    };
+
+    runtime_t& get_runtime()
+    {
+        static runtime_t runtime;
+        return runtime;
+    }
+
+    const unsigned int domain_id = 1;
+
+    const std::string* find_property(const runtime_t& runtime, const char* key)
+    {
+        for (const auto& property : runtime.properties)
+        {
+            if (property.first == key)
+            {
+                return &property.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // The simple names of the assemblies on a TPA list, "<dir>/<name>.dll", in lower case
+    std::unordered_set<std::string> get_tpa_assemblies(const std::string& tpa)
+    {
+        std::unordered_set<std::string> assemblies;
+        size_t start = 0;
+        while (start < tpa.size())
+        {
+            size_t end = tpa.find(tpa_separator, start);
+            if (end == std::string::npos)
+            {
+                end = tpa.size();
+            }
+
+            const std::string entry = tpa.substr(start, end - start);
+            const size_t name_start = entry.find_last_of("/\\") + 1;
+            if (entry.size() > name_start + 4)
+            {
+                assemblies.insert(to_lower(entry.substr(name_start, entry.size() - name_start - 4)));
+            }
+            start = end + 1;
+        }
+        return assemblies;
+    }
+
+    bool is_runtime(const runtime_t& runtime, void* host_handle, unsigned int id)
+    {
+        return runtime.initialized && host_handle == &runtime && id == domain_id;
+    }
+}
+
+SHARED_API hresult_t STDMETHODCALLTYPE coreclr_initialize(
+    const char* exe_path,
+    const char* app_domain_friendly_name,
+    int property_count,
+    const char** property_keys,
+    const char** property_values,
+    void** host_handle,
+    unsigned int* domain_id_out)
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    ++runtime.calls.initialize;
+
+    if (runtime.initialized)
+    {
+        return CORECLR_MOCK_E_INVALIDOPERATION;
+    }
+
+    if (exe_path == nullptr || app_domain_friendly_name == nullptr || property_count < 0 ||
+        (property_count > 0 && (property_keys == nullptr || property_values == nullptr)) ||
+        host_handle == nullptr || domain_id_out == nullptr)
+    {
+        return CORECLR_MOCK_E_INVALIDARG;
+    }
+
+    runtime.properties.clear();
+    for (int i = 0; i < property_count; ++i)
+    {
+        if (property_keys[i] == nullptr || property_values[i] == nullptr)
+        {
+            return CORECLR_MOCK_E_INVALIDARG;
+        }
+        runtime.properties.emplace_back(property_keys[i], property_values[i]);
+    }
+
+    // The runtime cannot load anything without its trusted platform assemblies
+    const std::string* tpa = find_property(runtime, "TRUSTED_PLATFORM_ASSEMBLIES");
+    if (tpa == nullptr)
+    {
+        return CORECLR_MOCK_E_INVALIDARG;
+    }
+    runtime.tpa_assemblies = get_tpa_assemblies(*tpa);
+
+    runtime.initialized = true;
+    *host_handle = &runtime;
+    *domain_id_out = domain_id;
+    return 0;
+}
+
+SHARED_API hresult_t STDMETHODCALLTYPE coreclr_shutdown_2(
+    void* host_handle,
+    unsigned int id,
+    int* latched_exit_code)
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    ++runtime.calls.shutdown;
+
+    if (!is_runtime(runtime, host_handle, id))
+    {
+        return CORECLR_MOCK_E_INVALIDOPERATION;
+    }
+
+    runtime.initialized = false;
+    if (latched_exit_code != nullptr)
+    {
+        *latched_exit_code = 0;
+    }
+    return 0;
+}
+
+SHARED_API hresult_t STDMETHODCALLTYPE coreclr_execute_assembly(
+    void* host_handle,
+    unsigned int id,
+    int argc,
+    const char** argv,
+    const char* managed_assembly_path,
+    unsigned int* exit_code)
+{
+    (void)argc;
+    (void)argv;
+
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    ++runtime.calls.execute_assembly;
+
+    if (!is_runtime(runtime, host_handle, id))
+    {
+        return CORECLR_MOCK_E_INVALIDOPERATION;
+    }
+
+    if (managed_assembly_path == nullptr || exit_code == nullptr)
+    {
+        return CORECLR_MOCK_E_INVALIDARG;
+    }
+
+    *exit_code = 0;
+    return 0;
+}
+
+SHARED_API hresult_t STDMETHODCALLTYPE coreclr_create_delegate(
+    void* host_handle,
+    unsigned int id,
+    const char* assembly_name,
+    const char* type_name,
+    const char* method_name,
+    void** delegate)
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    ++runtime.calls.create_delegate;
+
+    if (!is_runtime(runtime, host_handle, id))
+    {
+        return CORECLR_MOCK_E_INVALIDOPERATION;
+    }
+
+    if (assembly_name == nullptr || type_name == nullptr || method_name == nullptr || delegate == nullptr)
+    {
+        return CORECLR_MOCK_E_INVALIDARG;
+    }
+
+    if (::strcmp(assembly_name, calculator_assembly) != 0 ||
+        runtime.tpa_assemblies.count(to_lower(assembly_name)) == 0)
+    {
+        return CORECLR_MOCK_E_FILENOTFOUND;
+    }
+
+    if (::strcmp(type_name, generated_type) == 0)
+    {
+        *delegate = reinterpret_cast<void*>(&calculator_load);
+        return 0;
+    }
+
+    if (::strcmp(type_name, calculator_type) != 0)
+    {
+        return CORECLR_MOCK_E_TYPELOAD;
+    }
+
+    for (const auto& method : calculator_methods)
+    {
+        if (::strcmp(method_name, method.name) == 0)
+        {
+            *delegate = method.function;
+            return 0;
+        }
+    }
+    return CORECLR_MOCK_E_MISSINGMETHOD;
+}
+
+SHARED_API void STDMETHODCALLTYPE coreclr_mock_get_calls(coreclr_mock_calls* calls)
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    *calls = runtime.calls;
+}
+
+SHARED_API int STDMETHODCALLTYPE coreclr_mock_get_property_count()
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    return static_cast<int>(runtime.properties.size());
+}
+
+SHARED_API const char* STDMETHODCALLTYPE coreclr_mock_get_property(const char* key)
+{
+    runtime_t& runtime = get_runtime();
+    std::lock_guard<std::mutex> lock(runtime.lock);
+    const std::string* value = find_property(runtime, key);
+    return value == nullptr ? nullptr : value->c_str();
+}
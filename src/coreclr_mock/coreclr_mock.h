@@ -0,0 +1,53 @@
+//
+// coreclr_mock.h
+// A stand-in for libcoreclr which lets the host start and create delegates without
+// a .NET runtime, to test and benchmark the host on its own.
+//
+// The library exports the entry points coreclr.cc binds to, under the name of the
+// real runtime library, so it is used by copying it into a framework directory in
+// place of libcoreclr. coreclr_initialize records the properties it receives and
+// coreclr_create_delegate hands out native functions for the methods of the
+// Calculator test assembly (tests/dotnet/Calculator.cs), once the assembly is found
+// on the TPA list. Every method name of its Calculator.Generated type is a method,
+// for creating any number of delegates. The state is kept until the library is unloaded and can be read
+// back with the coreclr_mock_* exports.
+//
+
+#ifndef CORECLR_MOCK_H_
+#define CORECLR_MOCK_H_
+
+#include "pal.h"
+
+// Returned for calls made before coreclr_initialize or a second initialization
+#define CORECLR_MOCK_E_INVALIDOPERATION ((coreload::pal::hresult_t)0x80131022L)
+#define CORECLR_MOCK_E_INVALIDARG ((coreload::pal::hresult_t)0x80070057L)
+#define CORECLR_MOCK_E_FILENOTFOUND ((coreload::pal::hresult_t)0x80070002L)
+#define CORECLR_MOCK_E_TYPELOAD ((coreload::pal::hresult_t)0x80131522L)
+#define CORECLR_MOCK_E_MISSINGMETHOD ((coreload::pal::hresult_t)0x80131513L)
+
+// The number of calls made to each entry point since the library was loaded
+struct coreclr_mock_calls
+{
+    uint32_t initialize;
+    uint32_t shutdown;
+    uint32_t execute_assembly;
+    uint32_t create_delegate;
+};
+
+// The signatures of the coreclr_mock_* exports, for callers which look them up
+// in the library the host loaded.
+typedef void (STDMETHODCALLTYPE *coreclr_mock_get_calls_fn)(coreclr_mock_calls* calls);
+typedef int (STDMETHODCALLTYPE *coreclr_mock_get_property_count_fn)();
+typedef const char* (STDMETHODCALLTYPE *coreclr_mock_get_property_fn)(const char* key);
+
+// Gets the number of calls made to each entry point
+SHARED_API void STDMETHODCALLTYPE coreclr_mock_get_calls(coreclr_mock_calls* calls);
+
+// Gets the number of properties given to the last coreclr_initialize
+SHARED_API int STDMETHODCALLTYPE coreclr_mock_get_property_count();
+
+// Gets the value of a property given to the last coreclr_initialize, or null.
+// The value stays valid until the next coreclr_initialize.
+SHARED_API const char* STDMETHODCALLTYPE coreclr_mock_get_property(const char* key);
+
+#endif // CORECLR_MOCK_H_
@@ -21,7 +21,7 @@ namespace coreload {
 
         void print() const
         {
-            trace::verbose(_X("probe_config_t: probe=[%s] deps-dir-probe=[%d]"),
+            TRACE_VERBOSE(_X("probe_config_t: probe=[%s] deps-dir-probe=[%d]"),
                 probe_dir.c_str(), probe_publish_dir);
         }
 
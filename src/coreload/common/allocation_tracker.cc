@@ -0,0 +1,55 @@
+#include "allocation_tracker.h"
+#include <atomic>
+
+namespace coreload
+{
+    // Constant-initialized, operator new may run before any dynamic initializer
+    static std::atomic<bool> g_allocations_enabled(false);
+    static std::atomic<uint64_t> g_allocations(0);
+    static std::atomic<uint64_t> g_allocated_bytes(0);
+    static std::atomic<int64_t> g_live_bytes(0);
+    static std::atomic<int64_t> g_peak_live_bytes(0);
+
+    void allocation_tracker_t::on_allocate(size_t bytes)
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        int64_t live = g_live_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+        int64_t peak = g_peak_live_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !g_peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void allocation_tracker_t::on_free(size_t bytes)
+    {
+        g_live_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    void allocation_tracker_t::set_enabled()
+    {
+        g_allocations_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    bool allocation_tracker_t::is_enabled()
+    {
+        return g_allocations_enabled.load(std::memory_order_relaxed);
+    }
+
+    allocation_tracker_t::counts_t allocation_tracker_t::get_counts()
+    {
+        counts_t counts;
+        counts.allocations = g_allocations.load(std::memory_order_relaxed);
+        counts.bytes = g_allocated_bytes.load(std::memory_order_relaxed);
+        counts.live_bytes = g_live_bytes.load(std::memory_order_relaxed);
+        counts.peak_live_bytes = g_peak_live_bytes.load(std::memory_order_relaxed);
+        return counts;
+    }
+
+    void allocation_tracker_t::reset_peak()
+    {
+        g_peak_live_bytes.store(g_live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+} // namespace coreload
@@ -0,0 +1,48 @@
+#ifndef ALLOCATION_TRACKER_H_
+#define ALLOCATION_TRACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Process-wide heap allocation counters, fed by the replacement operator new
+    // and delete which builds configured with -DCORELOAD_ALLOCATION_TRACKING=ON
+    // link into the library. Without it nothing calls the hooks and the counters
+    // stay at zero.
+    //
+    // Block sizes are the usable sizes reported by the allocator, and blocks freed
+    // during a measurement may have been allocated before it, so live bytes are a
+    // net change rather than an absolute amount.
+    //
+    class allocation_tracker_t
+    {
+    public:
+        struct counts_t
+        {
+            uint64_t allocations;
+            uint64_t bytes;
+
+            // Bytes allocated and not freed yet, and the highest value since reset_peak
+            int64_t live_bytes;
+            int64_t peak_live_bytes;
+        };
+
+        // Called by the replacement operator new and delete
+        static void on_allocate(size_t bytes);
+        static void on_free(size_t bytes);
+
+        // Called once by the replacement when it is linked in
+        static void set_enabled();
+        static bool is_enabled();
+
+        static counts_t get_counts();
+
+        // Starts a new peak from the current live bytes
+        static void reset_peak();
+    };
+
+} // namespace coreload
+
+#endif // ALLOCATION_TRACKER_H_
@@ -0,0 +1,322 @@
+#include "dir_cache.h"
+#include "trace.h"
+#include "startup_inputs.h"
+#include <atomic>
+
+namespace coreload
+{
+    static std::atomic<dir_cache_t*> g_active_dir_cache(nullptr);
+
+    static bool is_dir_separator(pal::char_t c)
+    {
+#if defined(_WIN32)
+        return c == _X('\\') || c == _X('/');
+#else
+        return c == DIR_SEPARATOR;
+#endif
+    }
+
+    // File names are case-insensitive on Windows.
+    static pal::string_t to_key(const pal::string_t& value)
+    {
+#if defined(_WIN32)
+        return pal::to_lower(value);
+#else
+        return value;
+#endif
+    }
+
+    dir_cache_t::dir_cache_t()
+        : m_stats()
+    {
+    }
+
+    dir_cache_t* dir_cache_t::active()
+    {
+        return g_active_dir_cache.load(std::memory_order_acquire);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Split a rooted path into its parent directory and the last component.
+    //
+    // Returns false for any path the cache should not answer lexically.
+    //
+    bool dir_cache_t::split_path(const pal::string_t& path, pal::string_t* dir, pal::string_t* name)
+    {
+        if (path.empty() || !pal::is_path_rooted(path) || is_dir_separator(path.back()))
+        {
+            return false;
+        }
+
+#if defined(_WIN32)
+        // Extended length prefixes and 8.3 short names are resolved by the OS, not by listing.
+        if (path.compare(0, 2, _X("\\\\")) == 0 || path.find(_X('~')) != pal::string_t::npos)
+        {
+            return false;
+        }
+#endif
+
+        // Reject "." and ".." components; resolving them lexically is not safe with symlinks.
+        size_t start = 0;
+        size_t last_separator = pal::string_t::npos;
+        for (size_t i = 0; i <= path.size(); ++i)
+        {
+            if (i == path.size() || is_dir_separator(path[i]))
+            {
+                size_t length = i - start;
+                if ((length == 1 && path[start] == _X('.')) ||
+                    (length == 2 && path[start] == _X('.') && path[start + 1] == _X('.')))
+                {
+                    return false;
+                }
+
+                if (i != path.size())
+                {
+                    last_separator = i;
+                }
+                start = i + 1;
+            }
+        }
+
+        if (last_separator == pal::string_t::npos)
+        {
+            return false;
+        }
+
+#if defined(_WIN32)
+        // Windows ignores trailing dots and spaces in file names.
+        if (path.back() == _X('.') || path.back() == _X(' '))
+        {
+            return false;
+        }
+#endif
+
+        // Keep the separator for the root directory, so that "/foo" is listed in "/".
+        size_t dir_length = last_separator;
+        if (last_separator == 0 || (last_separator == 2 && path[1] == _X(':')))
+        {
+            dir_length++;
+        }
+
+        dir->assign(path, 0, dir_length);
+        name->assign(path, last_separator + 1, pal::string_t::npos);
+        return true;
+    }
+
+    const dir_cache_t::dir_listing_t* dir_cache_t::get_listing(const pal::string_t& dir)
+    {
+        pal::string_t key = to_key(dir);
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            auto iter = m_listings.find(key);
+            if (iter != m_listings.end())
+            {
+                return iter->second.get();
+            }
+        }
+
+        // List the directory without holding the lock. A missing directory
+        // yields an empty listing, which makes all of its children negative hits.
+        std::vector<pal::file_entry_t> files;
+        {
+            // Callers record what they depend on, all of the listing or a single entry.
+            startup_inputs_pause_t pause;
+            pal::readdir(dir, &files);
+        }
+
+        std::unique_ptr<dir_listing_t> listing(new dir_listing_t());
+        listing->reserve(files.size());
+        for (const auto& file : files)
+        {
+            listing->emplace(to_key(file.name), file.is_symlink);
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // Another thread may have listed the same directory meanwhile, keep the first one.
+        auto result = m_listings.emplace(key, std::move(listing));
+        if (result.second)
+        {
+            m_stats.directories_read++;
+        }
+        return result.first->second.get();
+    }
+
+    bool dir_cache_t::try_file_exists(const pal::string_t& path, bool* exists)
+    {
+        pal::string_t dir;
+        pal::string_t name;
+        if (!split_path(path, &dir, &name))
+        {
+            return false;
+        }
+
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_directory(dir);
+        }
+
+        const dir_listing_t* listing = get_listing(dir);
+        *exists = listing->count(to_key(name)) != 0;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stats.queries++;
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Compute the canonical path of a path accepted by split_path, memoizing the
+    // result for the path and each of its parent directories.
+    //
+    bool dir_cache_t::canonicalize(const pal::string_t& path, pal::string_t* canonical, bool skip_error_logging)
+    {
+        pal::string_t key = to_key(path);
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            auto iter = m_canonical_paths.find(key);
+            if (iter != m_canonical_paths.end())
+            {
+                canonical->assign(iter->second);
+                return !canonical->empty();
+            }
+        }
+
+        pal::string_t resolved;
+        pal::string_t dir;
+        pal::string_t name;
+        size_t realpath_calls = 0;
+
+        if (!split_path(path, &dir, &name))
+        {
+            // Root directories are left to the OS.
+            resolved = path;
+            realpath_calls++;
+            if (!pal::realpath(&resolved, skip_error_logging))
+            {
+                resolved.clear();
+            }
+        }
+        else if (canonicalize(dir, &resolved, skip_error_logging))
+        {
+            startup_inputs_t* inputs = startup_inputs_t::active();
+            if (inputs != nullptr)
+            {
+                inputs->add_component(path);
+            }
+
+            auto listing = get_listing(dir);
+            auto entry = listing->find(to_key(name));
+            if (entry == listing->end())
+            {
+                resolved.clear();
+            }
+            else if (entry->second)
+            {
+                // Symlinks are the only entries which need the file system to resolve.
+                resolved = path;
+                realpath_calls++;
+                if (!pal::realpath(&resolved, skip_error_logging))
+                {
+                    resolved.clear();
+                }
+            }
+            else
+            {
+                if (!resolved.empty() && resolved.back() != DIR_SEPARATOR)
+                {
+                    resolved.push_back(DIR_SEPARATOR);
+                }
+                resolved.append(name);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stats.realpath_calls += realpath_calls;
+        m_canonical_paths.emplace(key, resolved);
+
+        canonical->assign(resolved);
+        return !canonical->empty();
+    }
+
+    bool dir_cache_t::realpath(pal::string_t* path, bool skip_error_logging)
+    {
+        // Directories are often passed with a trailing separator, resolve them without it.
+        size_t length = path->size();
+        while (length > 1 && is_dir_separator((*path)[length - 1]))
+        {
+            length--;
+        }
+
+        pal::string_t trimmed(*path, 0, length);
+        pal::string_t dir;
+        pal::string_t name;
+        if (!split_path(trimmed, &dir, &name))
+        {
+            return pal::realpath(path, skip_error_logging);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stats.realpath_queries++;
+        }
+
+        pal::string_t resolved;
+        if (!canonicalize(trimmed, &resolved, skip_error_logging))
+        {
+            return false;
+        }
+
+#if defined(_WIN32)
+        // GetFullPathName keeps the trailing separator and long paths need the extended prefix.
+        if (length != path->size())
+        {
+            resolved.push_back(DIR_SEPARATOR);
+        }
+
+        if (resolved.size() >= MAX_PATH)
+        {
+            return pal::realpath(path, skip_error_logging);
+        }
+#endif
+
+        path->assign(resolved);
+        return true;
+    }
+
+    bool cached_realpath(pal::string_t* path, bool skip_error_logging)
+    {
+        dir_cache_t* cache = dir_cache_t::active();
+        if (cache != nullptr)
+        {
+            return cache->realpath(path, skip_error_logging);
+        }
+
+        return pal::realpath(path, skip_error_logging);
+    }
+
+    dir_cache_t::stats_t dir_cache_t::get_stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_stats;
+    }
+
+    dir_cache_scope_t::dir_cache_scope_t(dir_cache_t* cache)
+    {
+        m_previous = g_active_dir_cache.exchange(cache, std::memory_order_acq_rel);
+    }
+
+    dir_cache_scope_t::~dir_cache_scope_t()
+    {
+        dir_cache_t* cache = g_active_dir_cache.exchange(m_previous, std::memory_order_acq_rel);
+        if (cache != nullptr)
+        {
+            auto stats = cache->get_stats();
+            TRACE_VERBOSE(_X("Directory cache answered %zu existence and %zu realpath queries from %zu directory listings and %zu realpath calls, saving %zu file system calls"),
+                stats.queries, stats.realpath_queries, stats.directories_read, stats.realpath_calls, stats.syscalls_saved());
+        }
+    }
+
+} // namespace coreload
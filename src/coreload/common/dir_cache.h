@@ -0,0 +1,105 @@
+#ifndef DIR_CACHE_H_
+#define DIR_CACHE_H_
+
+#include "pal.h"
+#include <mutex>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Snapshot of directory listings used to answer file existence and realpath
+    // queries during a single resolution.
+    //
+    // Each directory is listed at most once; any later query for one of its
+    // children is answered from memory, which covers negative lookups as well as
+    // positive ones. Paths the cache cannot reason about lexically (relative paths,
+    // "." or ".." components) are not answered and the caller falls back to the
+    // file system.
+    //
+    // Canonical paths are memoized per directory: a child which is not a symlink
+    // resolves to the canonical path of its parent joined with its name, so only
+    // symlinks need to be resolved by the file system.
+    //
+    // The snapshot assumes the file system does not change while it is active.
+    //
+    class dir_cache_t
+    {
+    public:
+        struct stats_t
+        {
+            // Existence queries answered from the cache
+            size_t queries;
+
+            // Directories listed to fill the cache
+            size_t directories_read;
+
+            // Paths canonicalized through the cache
+            size_t realpath_queries;
+
+            // Paths which still had to be resolved by pal::realpath (roots and symlinks)
+            size_t realpath_calls;
+
+            // File system calls which would have been made without the cache
+            size_t syscalls_saved() const
+            {
+                size_t total = queries + realpath_queries;
+                size_t made = directories_read + realpath_calls;
+                return total > made ? total - made : 0;
+            }
+        };
+
+        dir_cache_t();
+
+        // Returns true if the query could be answered from the cache, in which case
+        // 'exists' receives the result.
+        bool try_file_exists(const pal::string_t& path, bool* exists);
+
+        // Same contract as pal::realpath, resolving through the memoized parent directories.
+        bool realpath(pal::string_t* path, bool skip_error_logging = false);
+
+        stats_t get_stats() const;
+
+        // The cache consulted by pal::file_exists and pal::directory_exists, if any.
+        static dir_cache_t* active();
+
+    private:
+        // Entry names, mapped to whether the entry is a symlink
+        typedef std::unordered_map<pal::string_t, bool> dir_listing_t;
+
+        static bool split_path(const pal::string_t& path, pal::string_t* dir, pal::string_t* name);
+
+        const dir_listing_t* get_listing(const pal::string_t& dir);
+        bool canonicalize(const pal::string_t& path, pal::string_t* canonical, bool skip_error_logging);
+
+        mutable std::mutex m_lock;
+        std::unordered_map<pal::string_t, std::unique_ptr<dir_listing_t>> m_listings;
+
+        // Canonical path for each resolved path, empty if it could not be resolved
+        std::unordered_map<pal::string_t, pal::string_t> m_canonical_paths;
+        stats_t m_stats;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Resolve a path like pal::realpath, using the active directory cache if there is one.
+    //
+    bool cached_realpath(pal::string_t* path, bool skip_error_logging = false);
+
+    // -----------------------------------------------------------------------------
+    // Makes a dir_cache_t the active cache for the lifetime of the scope.
+    //
+    class dir_cache_scope_t
+    {
+    public:
+        explicit dir_cache_scope_t(dir_cache_t* cache);
+        ~dir_cache_scope_t();
+
+    private:
+        dir_cache_scope_t(const dir_cache_scope_t&) = delete;
+        dir_cache_scope_t& operator=(const dir_cache_scope_t&) = delete;
+
+        dir_cache_t* m_previous;
+    };
+
+} // namespace coreload
+
+#endif // DIR_CACHE_H_
@@ -11,11 +11,13 @@
 #include <unordered_set>
 #include <memory>
 #include <algorithm>
+#include <cstdint>
 
 #if defined(_WIN32)
 
 #define NOMINMAX
 #include <Windows.h>
+#include <share.h>
 
 #define LIB_PREFIX
 #define MAKE_LIBNAME(NAME) (_X(NAME) _X(".dll"))
@@ -27,6 +29,30 @@
 #define FALLBACK_HOST_RID _X("win10")
 
 #else
+
+#include <cstdarg>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
+#include <strings.h>
+
+#define LIB_PREFIX _X("lib")
+#define MAKE_LIBNAME(NAME) (_X("lib") _X(NAME) _X(".so"))
+
+#define _X(s) s
+
+#define DIR_SEPARATOR '/'
+#define PATH_SEPARATOR ':'
+#define FALLBACK_HOST_RID _X("linux")
+
+#if !defined(MAX_PATH)
+#define MAX_PATH PATH_MAX
+#endif
+
+#if !defined(SUCCEEDED)
+#define SUCCEEDED(Status) ((Status) >= 0)
+#endif
+
 #endif
 
 #define LIBCLRJIT_NAME MAKE_LIBNAME("clrjit")
@@ -67,6 +93,8 @@ namespace coreload
         typedef FARPROC proc_t;
 
         inline string_t exe_suffix() { return _X(".exe"); }
+        inline unsigned long get_pid() { return ::GetCurrentProcessId(); }
+        inline unsigned long get_tid() { return ::GetCurrentThreadId(); }
 
         pal::string_t to_string(int value);
 
@@ -82,17 +110,64 @@ namespace coreload
 
         inline size_t strlen(const char_t* str) { return ::wcslen(str); }
         inline size_t strnlen(const char_t* str, size_t max_size) { return ::wcsnlen(str, max_size); }
-        inline errno_t file_open(const pal::string_t& path, const char_t* mode, FILE* stream) { return ::_wfopen_s(&stream, path.c_str(), mode); }
+        inline FILE* file_open(const pal::string_t& path, const char_t* mode) { return ::_wfsopen(path.c_str(), mode, _SH_DENYNO); }
         inline void file_vprintf(FILE* f, const char_t* format, va_list vl) { ::vfwprintf(f, format, vl); ::fputwc(_X('\n'), f); }
+        inline void file_puts(FILE* f, const char_t* text) { ::fputws(text, f); }
         inline void err_fputs(const char_t* message) { ::fputws(message, stderr); ::fputwc(_X('\n'), stderr); }
         inline void out_vprintf(const char_t* format, va_list vl) { ::vfwprintf(stdout, format, vl); ::fputwc(_X('\n'), stdout); }
         inline int str_vprintf(char_t* buffer, size_t count, size_t max_count, const char_t* format, va_list vl) { return ::_vsnwprintf_s(buffer, count, max_count, format, vl); }
+        inline int strlen_vprintf(const char_t* format, va_list vl) { return ::_vscwprintf(format, vl); }
+        bool pal_utf8string(const pal::string_t& str, std::vector<char>* out);
+        bool utf8_palstring(const std::string& str, pal::string_t* out);
+        bool pal_clrstring(const pal::string_t& str, std::vector<char>* out);
+        bool clr_palstring(const char* cstr, pal::string_t* out);
+#else
+#ifdef COREHOST_MAKE_DLL
+#define SHARED_API extern "C" __attribute__((__visibility__("default")))
+#else
+#define SHARED_API
+#endif
+
+        #define STDMETHODCALLTYPE
+
+        typedef char char_t;
+        typedef std::string string_t;
+        typedef std::stringstream stringstream_t;
+        typedef std::basic_ifstream<char> ifstream_t;
+        typedef std::istreambuf_iterator<ifstream_t::char_type> istreambuf_iterator_t;
+        typedef int hresult_t;
+        typedef void* dll_t;
+        typedef void* proc_t;
+
+        inline string_t exe_suffix() { return _X(""); }
+        inline unsigned long get_pid() { return static_cast<unsigned long>(::getpid()); }
+        unsigned long get_tid();
+
+        pal::string_t to_string(int value);
+
+        bool getcwd(pal::string_t* recv);
+
+        inline int cstrcasecmp(const char* str1, const char* str2) { return ::strcasecmp(str1, str2); }
+        inline int strcmp(const char_t* str1, const char_t* str2) { return ::strcmp(str1, str2); }
+        inline int strcasecmp(const char_t* str1, const char_t* str2) { return ::strcasecmp(str1, str2); }
+        inline int strncmp(const char_t* str1, const char_t* str2, int len) { return ::strncmp(str1, str2, len); }
+        inline int strncasecmp(const char_t* str1, const char_t* str2, int len) { return ::strncasecmp(str1, str2, len); }
+
+        pal::string_t to_lower(const pal::string_t& in);
+
+        inline size_t strlen(const char_t* str) { return ::strlen(str); }
+        inline size_t strnlen(const char_t* str, size_t max_size) { return ::strnlen(str, max_size); }
+        inline FILE* file_open(const pal::string_t& path, const char_t* mode) { return ::fopen(path.c_str(), mode); }
+        inline void file_vprintf(FILE* f, const char_t* format, va_list vl) { ::vfprintf(f, format, vl); ::fputc('\n', f); }
+        inline void file_puts(FILE* f, const char_t* text) { ::fputs(text, f); }
+        inline void err_fputs(const char_t* message) { ::fputs(message, stderr); ::fputc(_X('\n'), stderr); }
+        inline void out_vprintf(const char_t* format, va_list vl) { ::vfprintf(stdout, format, vl); ::fputc('\n', stdout); }
+        inline int str_vprintf(char_t* buffer, size_t count, size_t max_count, const char_t* format, va_list vl) { return ::vsnprintf(buffer, count, format, vl); }
+        inline int strlen_vprintf(const char_t* format, va_list vl) { return ::vsnprintf(nullptr, 0, format, vl); }
         bool pal_utf8string(const pal::string_t& str, std::vector<char>* out);
         bool utf8_palstring(const std::string& str, pal::string_t* out);
         bool pal_clrstring(const pal::string_t& str, std::vector<char>* out);
         bool clr_palstring(const char* cstr, pal::string_t* out);
-#else   
-        
 #endif
         pal::string_t get_timestamp();
 
@@ -115,9 +190,38 @@ namespace coreload
         inline bool directory_exists(const string_t& path) { return file_exists(path); }
         void readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list);
         void readdir(const string_t& path, std::vector<pal::string_t>* list);
+
+        // A directory entry, flagged when the entry itself is a symbolic link (or reparse point)
+        struct file_entry_t
+        {
+            string_t name;
+            bool is_symlink;
+        };
+        void readdir(const string_t& path, std::vector<file_entry_t>* list);
         void readdir_onlydirectories(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list);
         void readdir_onlydirectories(const string_t& path, std::vector<pal::string_t>* list);
 
+        // Size and last write time of a file, to tell whether a file derived from it is stale
+        struct file_stamp_t
+        {
+            uint64_t size;
+            int64_t mtime;
+        };
+#if defined(_WIN32)
+        const int64_t mtime_ticks_per_second = 10000000;
+#else
+        const int64_t mtime_ticks_per_second = 1000000000;
+#endif
+        bool get_file_stamp(const string_t& path, file_stamp_t* stamp);
+
+        // Map a whole file read-only; the mapping stays valid after the file is closed
+        bool map_file(const string_t& path, const void** data, size_t* size);
+        void unmap_file(const void* data, size_t size);
+
+        // Move a file over another one, replacing it
+        bool replace_file(const string_t& from, const string_t& to);
+        bool remove_file(const string_t& path);
+
         bool get_own_executable_path(string_t* recv);
         bool getenv(const char_t* name, string_t* recv);
         bool get_default_servicing_directory(string_t* recv);
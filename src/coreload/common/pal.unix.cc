@@ -0,0 +1,628 @@
+#include "pal.h"
+#include "trace.h"
+#include "utils.h"
+#include "dir_cache.h"
+#include "startup_inputs.h"
+#include "startup_metrics.h"
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <ctime>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace coreload
+{
+    pal::string_t pal::to_lower(const pal::string_t& in)
+    {
+        pal::string_t ret = in;
+        std::transform(ret.begin(), ret.end(), ret.begin(), ::tolower);
+        return ret;
+    }
+
+    unsigned long pal::get_tid()
+    {
+#if defined(__linux__)
+        return static_cast<unsigned long>(::syscall(SYS_gettid));
+#elif defined(__APPLE__)
+        uint64_t tid = 0;
+        ::pthread_threadid_np(nullptr, &tid);
+        return static_cast<unsigned long>(tid);
+#else
+        return static_cast<unsigned long>(reinterpret_cast<uintptr_t>(::pthread_self()));
+#endif
+    }
+
+    pal::string_t pal::to_string(int value)
+    {
+        return std::to_string(value);
+    }
+
+    pal::string_t pal::get_timestamp()
+    {
+        std::time_t t = std::time(0);
+        const std::size_t elems = 100;
+        char_t buf[elems];
+        struct tm tm_buf;
+        ::gmtime_r(&t, &tm_buf);
+        std::strftime(buf, elems, _X("%c GMT"), &tm_buf);
+
+        return pal::string_t(buf);
+    }
+
+    bool pal::touch_file(const pal::string_t& path)
+    {
+        int fd = ::open(path.c_str(), (O_CREAT | O_EXCL), (S_IRUSR | S_IRGRP | S_IROTH));
+        if (fd == -1)
+        {
+            trace::warning(_X("open(%s) failed in %s"), path.c_str(), _STRINGIFY(__FUNCTION__));
+            return false;
+        }
+        (void) ::close(fd);
+        return true;
+    }
+
+    bool pal::getcwd(pal::string_t* recv)
+    {
+        recv->clear();
+
+        pal::char_t* buf = ::getcwd(nullptr, 0);
+        if (buf == nullptr)
+        {
+            if (errno == ENOENT)
+            {
+                return false;
+            }
+
+            trace::error(_X("Failed to obtain working directory, errno: %d"), errno);
+            return false;
+        }
+
+        recv->assign(buf);
+        ::free(buf);
+        return true;
+    }
+
+    bool pal::load_library(const string_t* in_path, dll_t* dll)
+    {
+        *dll = ::dlopen(in_path->c_str(), RTLD_LAZY);
+        if (*dll == nullptr)
+        {
+            trace::error(_X("Failed to load %s, error: %s"), in_path->c_str(), ::dlerror());
+            return false;
+        }
+
+        TRACE_INFO(_X("Loaded library from %s"), in_path->c_str());
+        return true;
+    }
+
+    pal::proc_t pal::get_symbol(dll_t library, const char* name)
+    {
+        auto result = ::dlsym(library, name);
+        if (result == nullptr)
+        {
+            TRACE_INFO(_X("Probed for and did not find library symbol %s, error: %s"), name, ::dlerror());
+        }
+
+        return result;
+    }
+
+    void pal::unload_library(dll_t library)
+    {
+        if (::dlclose(library) != 0)
+        {
+            trace::warning(_X("Failed to unload library, error: %s"), ::dlerror());
+        }
+    }
+
+    bool pal::get_default_breadcrumb_store(string_t* recv)
+    {
+        recv->clear();
+
+        pal::string_t ext;
+        if (pal::getenv(_X("CORE_BREADCRUMBS"), &ext) && pal::realpath(&ext))
+        {
+            // We should have the path in ext.
+            TRACE_INFO(_X("Realpath CORE_BREADCRUMBS [%s]"), ext.c_str());
+        }
+
+        if (!pal::directory_exists(ext))
+        {
+            TRACE_INFO(_X("Directory core breadcrumbs [%s] was not specified or found"), ext.c_str());
+            ext.clear();
+            append_path(&ext, _X("opt"));
+            append_path(&ext, _X("corebreadcrumbs"));
+            if (!pal::directory_exists(ext))
+            {
+                TRACE_INFO(_X("Fallback directory core breadcrumbs at [%s] was not found"), ext.c_str());
+                return false;
+            }
+        }
+
+        if (::access(ext.c_str(), (R_OK | W_OK)) != 0)
+        {
+            TRACE_INFO(_X("Breadcrumb store [%s] is not ACL-ed with rw-"), ext.c_str());
+        }
+
+        recv->assign(ext);
+        return true;
+    }
+
+    bool pal::get_default_servicing_directory(string_t* recv)
+    {
+        recv->clear();
+
+        pal::string_t ext;
+        if (pal::getenv(_X("CORE_SERVICING"), &ext) && pal::realpath(&ext))
+        {
+            // We should have the path in ext.
+            TRACE_INFO(_X("Realpath CORE_SERVICING [%s]"), ext.c_str());
+        }
+
+        if (!pal::directory_exists(ext))
+        {
+            TRACE_INFO(_X("Directory core servicing at [%s] was not specified or found"), ext.c_str());
+            ext.clear();
+            append_path(&ext, _X("opt"));
+            append_path(&ext, _X("coreservicing"));
+            if (!pal::directory_exists(ext))
+            {
+                TRACE_INFO(_X("Fallback directory core servicing at [%s] was not found"), ext.c_str());
+                return false;
+            }
+        }
+
+        if (::access(ext.c_str(), R_OK) != 0)
+        {
+            TRACE_INFO(_X("Directory core servicing at [%s] was not specified or found"), ext.c_str());
+            return false;
+        }
+
+        recv->assign(ext);
+        TRACE_INFO(_X("Using core servicing at [%s]"), ext.c_str());
+        return true;
+    }
+
+    bool pal::get_global_dotnet_dirs(std::vector<pal::string_t>* recv)
+    {
+        // No support for global directories in Unix.
+        return false;
+    }
+
+    bool pal::get_default_installation_dir(pal::string_t* recv)
+    {
+        recv->assign(_X("/usr/share/dotnet"));
+        return true;
+    }
+
+    static
+        void trim_quotes(pal::string_t* value)
+    {
+        if (value->size() >= 2 && value->front() == '"' && value->back() == '"')
+        {
+            *value = value->substr(1, value->size() - 2);
+        }
+    }
+
+    // Reads the ID and VERSION_ID keys of /etc/os-release, for example "ubuntu" and "18.04".
+    static
+        bool get_os_release(pal::string_t* id, pal::string_t* version_id)
+    {
+        // The host RID depends on it, an OS upgrade must invalidate a startup cache.
+        const pal::char_t* path = _X("/etc/os-release");
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_file(path);
+        }
+
+        pal::ifstream_t file(path);
+        if (!file.good())
+        {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.compare(0, 3, "ID=") == 0)
+            {
+                id->assign(line.substr(3));
+                trim_quotes(id);
+            }
+            else if (line.compare(0, 11, "VERSION_ID=") == 0)
+            {
+                version_id->assign(line.substr(11));
+                trim_quotes(version_id);
+            }
+        }
+
+        return !id->empty();
+    }
+
+    pal::string_t pal::get_current_os_rid_platform()
+    {
+        pal::string_t ridOS;
+        pal::string_t id;
+        pal::string_t version_id;
+
+        if (!get_os_release(&id, &version_id))
+        {
+            return ridOS;
+        }
+
+        ridOS.append(id);
+
+        if (!version_id.empty())
+        {
+            // RHEL and Alpine only use the leading components of the version in their RIDs,
+            // for example rhel.7 and alpine.3.9.
+            size_t components = 0;
+            if (id == _X("rhel"))
+            {
+                components = 1;
+            }
+            else if (id == _X("alpine"))
+            {
+                components = 2;
+            }
+
+            size_t start = 0;
+            for (size_t i = 0; i < components; ++i)
+            {
+                size_t pos = version_id.find(_X('.'), start);
+                if (pos == pal::string_t::npos)
+                {
+                    break;
+                }
+
+                if (i + 1 == components)
+                {
+                    version_id.erase(pos);
+                }
+                start = pos + 1;
+            }
+
+            ridOS.append(_X("."));
+            ridOS.append(version_id);
+        }
+
+        return ridOS;
+    }
+
+    bool pal::is_path_rooted(const pal::string_t& path)
+    {
+        return !path.empty() && path[0] == '/';
+    }
+
+    // Returns true only if an env variable can be read successfully to be non-empty.
+    bool pal::getenv(const pal::char_t* name, pal::string_t* recv)
+    {
+        recv->clear();
+
+        auto result = ::getenv(name);
+        if (result != nullptr)
+        {
+            recv->assign(result);
+        }
+
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_env(name, *recv);
+        }
+
+        return (recv->length() > 0);
+    }
+
+    int pal::xtoi(const char_t* input)
+    {
+        return ::atoi(input);
+    }
+
+    bool pal::get_own_executable_path(pal::string_t* recv)
+    {
+        pal::string_t path = _X("/proc/self/exe");
+        if (!pal::realpath(&path))
+        {
+            return false;
+        }
+
+        recv->assign(path);
+        return true;
+    }
+
+    bool pal::pal_utf8string(const pal::string_t& str, std::vector<char>* out)
+    {
+        out->clear();
+        out->insert(out->end(), str.begin(), str.end());
+        out->push_back('\0');
+        return true;
+    }
+
+    bool pal::utf8_palstring(const std::string& str, pal::string_t* out)
+    {
+        out->assign(str);
+        return true;
+    }
+
+    bool pal::pal_clrstring(const pal::string_t& str, std::vector<char>* out)
+    {
+        return pal_utf8string(str, out);
+    }
+
+    bool pal::clr_palstring(const char* cstr, pal::string_t* out)
+    {
+        out->assign(cstr);
+        return true;
+    }
+
+    // Return if path is valid and file exists, return true and adjust path as appropriate.
+    bool pal::realpath(pal::string_t* path, bool skip_error_logging)
+    {
+        auto resolved = ::realpath(path->c_str(), nullptr);
+        if (resolved == nullptr)
+        {
+            if (errno == ENOENT)
+            {
+                return false;
+            }
+
+            if (!skip_error_logging)
+            {
+                trace::error(_X("realpath(%s) failed: %s"), path->c_str(), ::strerror(errno));
+            }
+            return false;
+        }
+
+        path->assign(resolved);
+        ::free(resolved);
+        return true;
+    }
+
+    bool pal::file_exists(const pal::string_t& path)
+    {
+        if (path.empty())
+        {
+            return false;
+        }
+
+        bool exists;
+        dir_cache_t* cache = dir_cache_t::active();
+        if (cache != nullptr && cache->try_file_exists(path, &exists))
+        {
+            return exists;
+        }
+
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_lookup(path);
+        }
+
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_file_check();
+        }
+
+        struct stat buffer;
+        return (::stat(path.c_str(), &buffer) == 0);
+    }
+
+    bool pal::get_file_stamp(const pal::string_t& path, pal::file_stamp_t* stamp)
+    {
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_file_check();
+        }
+
+        struct stat buffer;
+        if (::stat(path.c_str(), &buffer) != 0)
+        {
+            return false;
+        }
+
+        stamp->size = static_cast<uint64_t>(buffer.st_size);
+#if defined(__APPLE__)
+        stamp->mtime = static_cast<int64_t>(buffer.st_mtimespec.tv_sec) * 1000000000 + buffer.st_mtimespec.tv_nsec;
+#else
+        stamp->mtime = static_cast<int64_t>(buffer.st_mtim.tv_sec) * 1000000000 + buffer.st_mtim.tv_nsec;
+#endif
+        return true;
+    }
+
+    bool pal::map_file(const pal::string_t& path, const void** data, size_t* size)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return false;
+        }
+
+        struct stat buffer;
+        if (::fstat(fd, &buffer) != 0 || buffer.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* address = ::mmap(nullptr, static_cast<size_t>(buffer.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED)
+        {
+            return false;
+        }
+
+        *data = address;
+        *size = static_cast<size_t>(buffer.st_size);
+        return true;
+    }
+
+    void pal::unmap_file(const void* data, size_t size)
+    {
+        ::munmap(const_cast<void*>(data), size);
+    }
+
+    bool pal::replace_file(const pal::string_t& from, const pal::string_t& to)
+    {
+        return ::rename(from.c_str(), to.c_str()) == 0;
+    }
+
+    bool pal::remove_file(const pal::string_t& path)
+    {
+        return ::unlink(path.c_str()) == 0;
+    }
+
+    static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::file_entry_t>* list)
+    {
+        assert(list != nullptr);
+
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_directory(path);
+        }
+
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_directory_read();
+        }
+
+        std::vector<pal::file_entry_t>& files = *list;
+
+        auto dir = ::opendir(path.c_str());
+        if (dir == nullptr)
+        {
+            return;
+        }
+
+        struct dirent* entry = nullptr;
+        while ((entry = ::readdir(dir)) != nullptr)
+        {
+            if (::fnmatch(pattern.c_str(), entry->d_name, FNM_PATHNAME) != 0)
+            {
+                continue;
+            }
+
+            bool is_symlink = entry->d_type == DT_LNK;
+
+            // We are interested in files and directories only; d_type spares us a stat
+            // for each entry on file systems which report it.
+            switch (entry->d_type)
+            {
+            case DT_DIR:
+                break;
+
+            case DT_REG:
+                if (onlydirectories)
+                {
+                    continue;
+                }
+                break;
+
+            // Symlinks and file systems without d_type support need to be resolved.
+            case DT_LNK:
+            case DT_UNKNOWN:
+                {
+                    struct stat sb;
+                    if (entry->d_type == DT_UNKNOWN)
+                    {
+                        if (::fstatat(::dirfd(dir), entry->d_name, &sb, AT_SYMLINK_NOFOLLOW) == -1)
+                        {
+                            continue;
+                        }
+                        is_symlink = S_ISLNK(sb.st_mode);
+                    }
+
+                    if ((entry->d_type == DT_LNK || is_symlink) && ::fstatat(::dirfd(dir), entry->d_name, &sb, 0) == -1)
+                    {
+                        continue;
+                    }
+
+                    if (onlydirectories)
+                    {
+                        if (!S_ISDIR(sb.st_mode))
+                        {
+                            continue;
+                        }
+                    }
+                    else if (!S_ISREG(sb.st_mode) && !S_ISDIR(sb.st_mode))
+                    {
+                        continue;
+                    }
+                }
+                break;
+
+            default:
+                continue;
+            }
+
+            pal::string_t filepath(entry->d_name);
+            if (filepath != _X(".") && filepath != _X(".."))
+            {
+                files.push_back({ filepath, is_symlink });
+            }
+        }
+
+        ::closedir(dir);
+    }
+
+    static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+    {
+        std::vector<pal::file_entry_t> entries;
+        readdir(path, pattern, onlydirectories, &entries);
+
+        list->reserve(list->size() + entries.size());
+        for (auto& entry : entries)
+        {
+            list->push_back(std::move(entry.name));
+        }
+    }
+
+    void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
+    {
+        coreload::readdir(path, pattern, false, list);
+    }
+
+    void pal::readdir(const pal::string_t& path, std::vector<pal::string_t>* list)
+    {
+        coreload::readdir(path, _X("*"), false, list);
+    }
+
+    void pal::readdir(const pal::string_t& path, std::vector<pal::file_entry_t>* list)
+    {
+        coreload::readdir(path, _X("*"), false, list);
+    }
+
+    void pal::readdir_onlydirectories(const pal::string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
+    {
+        coreload::readdir(path, pattern, true, list);
+    }
+
+    void pal::readdir_onlydirectories(const pal::string_t& path, std::vector<pal::string_t>* list)
+    {
+        coreload::readdir(path, _X("*"), true, list);
+    }
+
+    bool pal::is_running_in_wow64()
+    {
+        return false;
+    }
+
+    bool pal::are_paths_equal_with_normalized_casing(const string_t& path1, const string_t& path2)
+    {
+        return path1 == path2;
+    }
+} // namespace coreload
@@ -1,6 +1,9 @@
 #include "pal.h"
 #include "trace.h"
 #include "utils.h"
+#include "dir_cache.h"
+#include "startup_inputs.h"
+#include "startup_metrics.h"
 #include "longfile.h"
 #include <cassert>
 #include <locale>
@@ -58,7 +61,7 @@ namespace coreload
         HANDLE hnd = ::CreateFileW(path.c_str(), 0, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
         if (hnd == INVALID_HANDLE_VALUE)
         {
-            trace::verbose(_X("Failed to leave breadcrumb, HRESULT: 0x%X"), HRESULT_FROM_WIN32(GetLastError()));
+            TRACE_VERBOSE(_X("Failed to leave breadcrumb, HRESULT: 0x%X"), HRESULT_FROM_WIN32(GetLastError()));
             return false;
         }
         ::CloseHandle(hnd);
@@ -132,7 +135,7 @@ namespace coreload
         {
             string_t buf;
             GetModuleFileNameWrapper(*dll, &buf);
-            trace::info(_X("Loaded library from %s"), buf.c_str());
+            TRACE_INFO(_X("Loaded library from %s"), buf.c_str());
         }
 
         return true;
@@ -143,7 +146,7 @@ namespace coreload
         auto result = ::GetProcAddress(library, name);
         if (result == nullptr)
         {
-            trace::info(_X("Probed for and did not resolve library symbol %s"), name);
+            TRACE_INFO(_X("Probed for and did not resolve library symbol %s"), name);
         }
 
         return result;
@@ -174,7 +177,7 @@ namespace coreload
         if (!get_file_path_from_env(_X("ProgramData"), &prog_dat))
         {
             // We should have the path in prog_dat.
-            trace::verbose(_X("Failed to read default breadcrumb store [%s]"), prog_dat.c_str());
+            TRACE_VERBOSE(_X("Failed to read default breadcrumb store [%s]"), prog_dat.c_str());
             return false;
         }
         recv->assign(prog_dat);
@@ -305,6 +308,7 @@ namespace coreload
     {
         recv->clear();
 
+        startup_inputs_t* inputs = startup_inputs_t::active();
         auto length = ::GetEnvironmentVariableW(name, nullptr, 0);
         if (length == 0)
         {
@@ -313,6 +317,10 @@ namespace coreload
             {
                 trace::error(_X("Failed to read environment variable [%s], HRESULT: 0x%X"), name, HRESULT_FROM_WIN32(GetLastError()));
             }
+            else if (inputs != nullptr)
+            {
+                inputs->add_env(name, *recv);
+            }
             return false;
         }
         auto buf = new char_t[length];
@@ -325,6 +333,11 @@ namespace coreload
         recv->assign(buf);
         delete[] buf;
 
+        if (inputs != nullptr)
+        {
+            inputs->add_env(name, *recv);
+        }
+
         return true;
     }
 
@@ -456,15 +469,127 @@ namespace coreload
             return false;
         }
 
+        bool exists;
+        dir_cache_t* cache = dir_cache_t::active();
+        if (cache != nullptr && cache->try_file_exists(path, &exists))
+        {
+            return exists;
+        }
+
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_lookup(path);
+        }
+
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_file_check();
+        }
+
         string_t tmp(path);
         return pal::realpath(&tmp, true);
     }
 
-    static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+    bool pal::get_file_stamp(const string_t& path, file_stamp_t* stamp)
+    {
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_file_check();
+        }
+
+        pal::string_t normalized_path(path);
+        if (LongFile::ShouldNormalize(normalized_path) && !pal::realpath(&normalized_path, true))
+        {
+            return false;
+        }
+
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!::GetFileAttributesExW(normalized_path.c_str(), GetFileExInfoStandard, &data))
+        {
+            return false;
+        }
+
+        stamp->size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        stamp->mtime = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime);
+        return true;
+    }
+
+    bool pal::map_file(const string_t& path, const void** data, size_t* size)
+    {
+        pal::string_t normalized_path(path);
+        if (LongFile::ShouldNormalize(normalized_path) && !pal::realpath(&normalized_path, true))
+        {
+            return false;
+        }
+
+        HANDLE file = ::CreateFileW(normalized_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if (!::GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || static_cast<uint64_t>(file_size.QuadPart) > SIZE_MAX)
+        {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        ::CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+
+        // The view keeps the mapping alive.
+        void* address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (address == nullptr)
+        {
+            return false;
+        }
+
+        *data = address;
+        *size = static_cast<size_t>(file_size.QuadPart);
+        return true;
+    }
+
+    void pal::unmap_file(const void* data, size_t size)
+    {
+        ::UnmapViewOfFile(data);
+    }
+
+    bool pal::replace_file(const string_t& from, const string_t& to)
+    {
+        return ::MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    bool pal::remove_file(const string_t& path)
+    {
+        return ::DeleteFileW(path.c_str()) != 0;
+    }
+
+    static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::file_entry_t>* list)
     {
         assert(list != nullptr);
 
-        std::vector<pal::string_t>& files = *list;
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_directory(path);
+        }
+
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_directory_read();
+        }
+
+        std::vector<pal::file_entry_t>& files = *list;
         pal::string_t normalized_path(path);
 
         if (LongFile::ShouldNormalize(normalized_path))
@@ -492,13 +617,25 @@ namespace coreload
                 pal::string_t filepath(data.cFileName);
                 if (filepath != _X(".") && filepath != _X(".."))
                 {
-                    files.push_back(filepath);
+                    files.push_back({ filepath, (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0 });
                 }
             }
         } while (::FindNextFileW(handle, &data));
         ::FindClose(handle);
     }
 
+    static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+    {
+        std::vector<pal::file_entry_t> entries;
+        readdir(path, pattern, onlydirectories, &entries);
+
+        list->reserve(list->size() + entries.size());
+        for (auto& entry : entries)
+        {
+            list->push_back(std::move(entry.name));
+        }
+    }
+
     void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
     {
         coreload::readdir(path, pattern, false, list);
@@ -509,6 +646,11 @@ namespace coreload
         coreload::readdir(path, _X("*"), false, list);
     }
 
+    void pal::readdir(const string_t& path, std::vector<pal::file_entry_t>* list)
+    {
+        coreload::readdir(path, _X("*"), false, list);
+    }
+
     void pal::readdir_onlydirectories(const pal::string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
     {
         coreload::readdir(path, pattern, true, list);
@@ -0,0 +1,152 @@
+#include "startup_inputs.h"
+#include "utils.h"
+#include <atomic>
+
+namespace coreload
+{
+    static std::atomic<startup_inputs_t*> g_active_startup_inputs(nullptr);
+    static thread_local int t_startup_inputs_paused = 0;
+
+    // Directories are queried with and without a trailing separator, record them without it.
+    static pal::string_t trim_separators(const pal::string_t& path)
+    {
+        size_t length = path.size();
+        while (length > 1 && path[length - 1] == DIR_SEPARATOR && !(length == 3 && path[1] == _X(':')))
+        {
+            length--;
+        }
+        return path.substr(0, length);
+    }
+
+    startup_inputs_t::startup_inputs_t()
+        : m_incomplete(false)
+    {
+    }
+
+    startup_inputs_t* startup_inputs_t::active()
+    {
+        if (t_startup_inputs_paused != 0)
+        {
+            return nullptr;
+        }
+        return g_active_startup_inputs.load(std::memory_order_acquire);
+    }
+
+    void startup_inputs_t::add(const pal::string_t& path, kind_t kind)
+    {
+        if (!pal::is_path_rooted(path))
+        {
+            // Relative to a current directory which may not be the same next time.
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_incomplete = true;
+            return;
+        }
+
+        pal::string_t key = trim_separators(path);
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            // A component is the weakest record of a path, anything else replaces it.
+            auto iter = m_inputs.find(key);
+            if (iter != m_inputs.end() && (kind == kind_t::component || iter->second.kind != kind_t::component))
+            {
+                return;
+            }
+        }
+
+        input_t input;
+        input.kind = kind;
+        input.exists = pal::get_file_stamp(key, &input.stamp);
+        if (!input.exists || kind == kind_t::component)
+        {
+            input.stamp = pal::file_stamp_t();
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto result = m_inputs.emplace(key, input);
+        if (!result.second && result.first->second.kind == kind_t::component)
+        {
+            result.first->second = input;
+        }
+    }
+
+    void startup_inputs_t::add_file(const pal::string_t& path)
+    {
+        add(path, kind_t::file);
+    }
+
+    void startup_inputs_t::add_directory(const pal::string_t& path)
+    {
+        add(path, kind_t::directory);
+    }
+
+    void startup_inputs_t::add_component(const pal::string_t& path)
+    {
+        add(path, kind_t::component);
+    }
+
+    void startup_inputs_t::add_lookup(const pal::string_t& path)
+    {
+        add(get_directory(path), kind_t::directory);
+    }
+
+    void startup_inputs_t::add_env(const pal::string_t& name, const pal::string_t& value)
+    {
+        // Keep the first value, which the resolution acted on.
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_env.emplace(name, value);
+    }
+
+    bool startup_inputs_t::is_complete() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return !m_incomplete;
+    }
+
+    startup_inputs_t::input_map_t startup_inputs_t::get_inputs() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // Entries of a recorded directory cannot go away without changing its stamp.
+        input_map_t inputs;
+        for (const auto& input : m_inputs)
+        {
+            if (input.second.kind == kind_t::component)
+            {
+                auto parent = m_inputs.find(trim_separators(get_directory(input.first)));
+                if (parent != m_inputs.end() && parent->second.kind == kind_t::directory && parent->second.exists)
+                {
+                    continue;
+                }
+            }
+            inputs.emplace_hint(inputs.end(), input);
+        }
+        return inputs;
+    }
+
+    startup_inputs_t::env_map_t startup_inputs_t::get_env() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_env;
+    }
+
+    startup_inputs_scope_t::startup_inputs_scope_t(startup_inputs_t* inputs)
+    {
+        m_previous = g_active_startup_inputs.exchange(inputs, std::memory_order_acq_rel);
+    }
+
+    startup_inputs_scope_t::~startup_inputs_scope_t()
+    {
+        g_active_startup_inputs.exchange(m_previous, std::memory_order_acq_rel);
+    }
+
+    startup_inputs_pause_t::startup_inputs_pause_t()
+    {
+        t_startup_inputs_paused++;
+    }
+
+    startup_inputs_pause_t::~startup_inputs_pause_t()
+    {
+        t_startup_inputs_paused--;
+    }
+
+} // namespace coreload
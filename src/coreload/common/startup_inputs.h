@@ -0,0 +1,113 @@
+#ifndef STARTUP_INPUTS_H_
+#define STARTUP_INPUTS_H_
+
+#include "pal.h"
+#include <map>
+#include <mutex>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Record of what a resolution read from the environment: the files it read,
+    // the directories it listed or looked into, and the environment variables it
+    // consulted.
+    //
+    // Files and directories are recorded with their stamp at the time they were
+    // first used. A directory's last write time changes when entries are added,
+    // removed or renamed, so the directories stand in for every existence query
+    // answered from them, positive or negative.
+    //
+    // Path components which were only canonicalized are recorded without a stamp:
+    // what else is in their parent does not matter, only that they still exist.
+    //
+    class startup_inputs_t
+    {
+    public:
+        enum class kind_t : uint32_t
+        {
+            file = 1,
+            directory = 2,
+            component = 3
+        };
+
+        struct input_t
+        {
+            kind_t kind;
+
+            // Missing inputs are recorded too, they must still be missing
+            bool exists;
+            pal::file_stamp_t stamp;
+        };
+
+        // Inputs by path, sorted so that they are written in a stable order
+        typedef std::map<pal::string_t, input_t> input_map_t;
+
+        // Environment variable values by name, empty if the variable was not set
+        typedef std::map<pal::string_t, pal::string_t> env_map_t;
+
+        startup_inputs_t();
+
+        void add_file(const pal::string_t& path);
+        void add_directory(const pal::string_t& path);
+
+        void add_component(const pal::string_t& path);
+
+        // Existence of 'path' was checked without listing its directory
+        void add_lookup(const pal::string_t& path);
+
+        void add_env(const pal::string_t& name, const pal::string_t& value);
+
+        // Returns false if an input could not be recorded by its full path, in
+        // which case the resolution cannot be validated later.
+        bool is_complete() const;
+
+        input_map_t get_inputs() const;
+        env_map_t get_env() const;
+
+        // The record consulted by pal::readdir, pal::file_exists and pal::getenv, if
+        // any and unless recording is paused on this thread.
+        static startup_inputs_t* active();
+
+    private:
+        void add(const pal::string_t& path, kind_t kind);
+
+        mutable std::mutex m_lock;
+        input_map_t m_inputs;
+        env_map_t m_env;
+        bool m_incomplete;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Makes a startup_inputs_t the active record for the lifetime of the scope.
+    //
+    class startup_inputs_scope_t
+    {
+    public:
+        explicit startup_inputs_scope_t(startup_inputs_t* inputs);
+        ~startup_inputs_scope_t();
+
+    private:
+        startup_inputs_scope_t(const startup_inputs_scope_t&) = delete;
+        startup_inputs_scope_t& operator=(const startup_inputs_scope_t&) = delete;
+
+        startup_inputs_t* m_previous;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Pauses recording on this thread for the lifetime of the scope, for file system
+    // calls whose callers record what they depend on themselves.
+    //
+    class startup_inputs_pause_t
+    {
+    public:
+        startup_inputs_pause_t();
+        ~startup_inputs_pause_t();
+
+    private:
+        startup_inputs_pause_t(const startup_inputs_pause_t&) = delete;
+        startup_inputs_pause_t& operator=(const startup_inputs_pause_t&) = delete;
+    };
+
+} // namespace coreload
+
+#endif // STARTUP_INPUTS_H_
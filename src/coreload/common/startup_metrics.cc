@@ -0,0 +1,208 @@
+#include "startup_metrics.h"
+#include "usdt.h"
+#include <algorithm>
+#include <chrono>
+
+namespace coreload
+{
+    static std::atomic<startup_metrics_t*> g_active_startup_metrics(nullptr);
+
+    static startup_metrics_t::allocations_t get_allocations_since(const allocation_tracker_t::counts_t& start, const allocation_tracker_t::counts_t& now, int64_t peak_live_bytes)
+    {
+        startup_metrics_t::allocations_t allocations;
+        allocations.allocations = now.allocations - start.allocations;
+        allocations.bytes = now.bytes - start.bytes;
+        allocations.peak_live_bytes = peak_live_bytes > start.live_bytes ? static_cast<uint64_t>(peak_live_bytes - start.live_bytes) : 0;
+        return allocations;
+    }
+
+    startup_metrics_t::startup_metrics_t()
+    {
+        start();
+
+        // Nothing has started yet
+        m_start_ns.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t startup_metrics_t::now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    const char* startup_metrics_t::phase_name(phase_t phase)
+    {
+        switch (phase)
+        {
+        case phase_t::runtime_config: return "runtime_config";
+        case phase_t::framework_resolution: return "framework_resolution";
+        case phase_t::deps_resolution: return "deps_resolution";
+        case phase_t::tpa_probe: return "tpa_probe";
+        case phase_t::coreclr_bind: return "coreclr_bind";
+        case phase_t::coreclr_initialize: return "coreclr_initialize";
+        default: return "unknown";
+        }
+    }
+
+    startup_metrics_t* startup_metrics_t::active()
+    {
+        return g_active_startup_metrics.load(std::memory_order_acquire);
+    }
+
+    void startup_metrics_t::start()
+    {
+        m_end_ns.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < static_cast<size_t>(phase_t::count); ++i)
+        {
+            m_phase_start_ns[i].store(0, std::memory_order_relaxed);
+            m_phase_end_ns[i].store(0, std::memory_order_relaxed);
+        }
+
+        m_files_checked.store(0, std::memory_order_relaxed);
+        m_directories_read.store(0, std::memory_order_relaxed);
+        m_json_bytes_parsed.store(0, std::memory_order_relaxed);
+        m_tpa_entries.store(0, std::memory_order_relaxed);
+        m_framework_resolve_retries.store(0, std::memory_order_relaxed);
+        m_startup_cache_hit.store(false, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(m_allocations_lock);
+            m_allocations = allocations_t();
+            for (size_t i = 0; i < static_cast<size_t>(phase_t::count); ++i)
+            {
+                m_phase_allocations[i] = allocations_t();
+            }
+
+            allocation_tracker_t::reset_peak();
+            m_start_allocations = allocation_tracker_t::get_counts();
+            m_peak_live_bytes = m_start_allocations.live_bytes;
+        }
+
+        m_start_ns.store(now_ns(), std::memory_order_release);
+    }
+
+    void startup_metrics_t::stop()
+    {
+        m_end_ns.store(now_ns(), std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(m_allocations_lock);
+        auto counts = allocation_tracker_t::get_counts();
+        m_allocations = get_allocations_since(m_start_allocations, counts, std::max(m_peak_live_bytes, counts.peak_live_bytes));
+    }
+
+    void startup_metrics_t::begin_phase(phase_t phase)
+    {
+        CORELOAD_PROBE2(phase_begin, static_cast<int>(phase), phase_name(phase));
+
+        {
+            // The peak of the start so far is kept aside while the phase measures its own
+            std::lock_guard<std::mutex> lock(m_allocations_lock);
+            auto counts = allocation_tracker_t::get_counts();
+            m_peak_live_bytes = std::max(m_peak_live_bytes, counts.peak_live_bytes);
+            allocation_tracker_t::reset_peak();
+            m_phase_start_allocations[static_cast<size_t>(phase)] = allocation_tracker_t::get_counts();
+        }
+
+        m_phase_start_ns[static_cast<size_t>(phase)].store(now_ns(), std::memory_order_release);
+    }
+
+    void startup_metrics_t::end_phase(phase_t phase)
+    {
+        m_phase_end_ns[static_cast<size_t>(phase)].store(now_ns(), std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(m_allocations_lock);
+            auto counts = allocation_tracker_t::get_counts();
+            m_phase_allocations[static_cast<size_t>(phase)] = get_allocations_since(m_phase_start_allocations[static_cast<size_t>(phase)], counts, counts.peak_live_bytes);
+        }
+
+        CORELOAD_PROBE2(phase_end, static_cast<int>(phase), phase_name(phase));
+    }
+
+    void startup_metrics_t::add_file_check()
+    {
+        m_files_checked.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void startup_metrics_t::add_directory_read()
+    {
+        m_directories_read.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void startup_metrics_t::add_json_bytes(size_t bytes)
+    {
+        m_json_bytes_parsed.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void startup_metrics_t::add_framework_resolve_retry()
+    {
+        m_framework_resolve_retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void startup_metrics_t::set_tpa_entries(size_t count)
+    {
+        m_tpa_entries.store(count, std::memory_order_relaxed);
+    }
+
+    void startup_metrics_t::set_startup_cache_hit()
+    {
+        m_startup_cache_hit.store(true, std::memory_order_relaxed);
+    }
+
+    startup_metrics_t::snapshot_t startup_metrics_t::get_snapshot()
+    {
+        snapshot_t snapshot;
+        snapshot.start_ns = m_start_ns.load(std::memory_order_acquire);
+        snapshot.end_ns = m_end_ns.load(std::memory_order_acquire);
+        for (size_t i = 0; i < static_cast<size_t>(phase_t::count); ++i)
+        {
+            snapshot.phases[i].start_ns = m_phase_start_ns[i].load(std::memory_order_acquire);
+            snapshot.phases[i].end_ns = m_phase_end_ns[i].load(std::memory_order_acquire);
+        }
+
+        snapshot.files_checked = m_files_checked.load(std::memory_order_relaxed);
+        snapshot.directories_read = m_directories_read.load(std::memory_order_relaxed);
+        snapshot.json_bytes_parsed = m_json_bytes_parsed.load(std::memory_order_relaxed);
+        snapshot.tpa_entries = m_tpa_entries.load(std::memory_order_relaxed);
+        snapshot.framework_resolve_retries = m_framework_resolve_retries.load(std::memory_order_relaxed);
+        snapshot.startup_cache_hit = m_startup_cache_hit.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_allocations_lock);
+        snapshot.allocations_tracked = allocation_tracker_t::is_enabled();
+        snapshot.allocations = m_allocations;
+        for (size_t i = 0; i < static_cast<size_t>(phase_t::count); ++i)
+        {
+            snapshot.phase_allocations[i] = m_phase_allocations[i];
+        }
+        return snapshot;
+    }
+
+    void startup_metrics_t::begin_active_phase(phase_t phase)
+    {
+        startup_metrics_t* metrics = active();
+        if (metrics != nullptr)
+        {
+            metrics->begin_phase(phase);
+        }
+    }
+
+    void startup_metrics_t::end_active_phase(phase_t phase)
+    {
+        startup_metrics_t* metrics = active();
+        if (metrics != nullptr)
+        {
+            metrics->end_phase(phase);
+        }
+    }
+
+    startup_metrics_scope_t::startup_metrics_scope_t(startup_metrics_t* metrics)
+    {
+        m_previous = g_active_startup_metrics.exchange(metrics, std::memory_order_acq_rel);
+    }
+
+    startup_metrics_scope_t::~startup_metrics_scope_t()
+    {
+        g_active_startup_metrics.exchange(m_previous, std::memory_order_acq_rel);
+    }
+
+} // namespace coreload
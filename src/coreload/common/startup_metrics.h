@@ -0,0 +1,149 @@
+#ifndef STARTUP_METRICS_H_
+#define STARTUP_METRICS_H_
+
+#include "pal.h"
+#include "allocation_tracker.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Timings and counters of a runtime start.
+    //
+    // Each phase of the start records the monotonic clock when it begins and ends,
+    // in nanoseconds. Phases which did not run, such as the resolution when the
+    // startup cache answered it, keep zero timestamps.
+    //
+    // The counters are updated by the file system calls of every thread while the
+    // metrics are active, which includes the threads probing concurrently.
+    //
+    // Builds with allocation tracking also count the heap allocations of the whole
+    // process during the start and each phase.
+    //
+    class startup_metrics_t
+    {
+    public:
+        enum class phase_t : uint32_t
+        {
+            runtime_config,
+            framework_resolution,
+            deps_resolution,
+            tpa_probe,
+            coreclr_bind,
+            coreclr_initialize,
+            count
+        };
+
+        struct phase_times_t
+        {
+            uint64_t start_ns;
+            uint64_t end_ns;
+        };
+
+        struct allocations_t
+        {
+            uint64_t allocations;
+            uint64_t bytes;
+
+            // Highest amount of bytes allocated and not freed, above what was live
+            // when the measurement began
+            uint64_t peak_live_bytes;
+        };
+
+        struct snapshot_t
+        {
+            uint64_t start_ns;
+            uint64_t end_ns;
+            phase_times_t phases[static_cast<size_t>(phase_t::count)];
+
+            // Zero unless allocations_tracked
+            bool allocations_tracked;
+            allocations_t allocations;
+            allocations_t phase_allocations[static_cast<size_t>(phase_t::count)];
+
+            uint64_t files_checked;
+            uint64_t directories_read;
+            uint64_t json_bytes_parsed;
+            uint64_t tpa_entries;
+            uint32_t framework_resolve_retries;
+            bool startup_cache_hit;
+        };
+
+        startup_metrics_t();
+
+        // Clears the metrics and records the start of a new runtime start.
+        void start();
+        void stop();
+
+        void begin_phase(phase_t phase);
+        void end_phase(phase_t phase);
+
+        void add_file_check();
+        void add_directory_read();
+        void add_json_bytes(size_t bytes);
+        void add_framework_resolve_retry();
+        void set_tpa_entries(size_t count);
+        void set_startup_cache_hit();
+
+        snapshot_t get_snapshot();
+
+        // The name of a phase, as the USDT probes report it
+        static const char* phase_name(phase_t phase);
+
+        // The monotonic clock the phases are timed with, in nanoseconds
+        static uint64_t now_ns();
+
+        // The metrics updated by pal::file_exists, pal::readdir and the runtime start,
+        // if any.
+        static startup_metrics_t* active();
+
+        // Record the boundaries of a phase in the active metrics, if any.
+        static void begin_active_phase(phase_t phase);
+        static void end_active_phase(phase_t phase);
+
+    private:
+        startup_metrics_t(const startup_metrics_t&) = delete;
+        startup_metrics_t& operator=(const startup_metrics_t&) = delete;
+
+        std::atomic<uint64_t> m_start_ns;
+        std::atomic<uint64_t> m_end_ns;
+        std::atomic<uint64_t> m_phase_start_ns[static_cast<size_t>(phase_t::count)];
+        std::atomic<uint64_t> m_phase_end_ns[static_cast<size_t>(phase_t::count)];
+
+        std::atomic<uint64_t> m_files_checked;
+        std::atomic<uint64_t> m_directories_read;
+        std::atomic<uint64_t> m_json_bytes_parsed;
+        std::atomic<uint64_t> m_tpa_entries;
+        std::atomic<uint32_t> m_framework_resolve_retries;
+        std::atomic<bool> m_startup_cache_hit;
+
+        // Allocation counts when the start and each phase began, and the results
+        std::mutex m_allocations_lock;
+        allocation_tracker_t::counts_t m_start_allocations;
+        allocation_tracker_t::counts_t m_phase_start_allocations[static_cast<size_t>(phase_t::count)];
+        int64_t m_peak_live_bytes;
+        allocations_t m_allocations;
+        allocations_t m_phase_allocations[static_cast<size_t>(phase_t::count)];
+    };
+
+    // -----------------------------------------------------------------------------
+    // Makes a startup_metrics_t the active metrics for the lifetime of the scope.
+    //
+    class startup_metrics_scope_t
+    {
+    public:
+        explicit startup_metrics_scope_t(startup_metrics_t* metrics);
+        ~startup_metrics_scope_t();
+
+    private:
+        startup_metrics_scope_t(const startup_metrics_scope_t&) = delete;
+        startup_metrics_scope_t& operator=(const startup_metrics_scope_t&) = delete;
+
+        startup_metrics_t* m_previous;
+    };
+
+} // namespace coreload
+
+#endif // STARTUP_METRICS_H_
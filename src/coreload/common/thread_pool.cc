@@ -0,0 +1,182 @@
+#include "thread_pool.h"
+#include "startup_inputs.h"
+#include "utils.h"
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace coreload
+{
+    static const size_t max_default_threads = 4;
+
+    thread_pool_t::thread_pool_t(size_t thread_count)
+        : m_thread_count(thread_count > 0 ? thread_count : 1)
+    {
+    }
+
+    size_t thread_pool_t::default_thread_count()
+    {
+        // The thread count does not change what a resolution reads, keep it out of
+        // the startup inputs.
+        startup_inputs_pause_t pause;
+
+        pal::string_t threads;
+        if (pal::getenv(_X("COREHOST_THREADS"), &threads))
+        {
+            int count = pal::xtoi(threads.c_str());
+            if (count > 0)
+            {
+                return static_cast<size_t>(count);
+            }
+            TRACE_VERBOSE(_X("Ignoring COREHOST_THREADS=[%s]"), threads.c_str());
+        }
+
+        size_t processors = std::thread::hardware_concurrency();
+        if (processors == 0)
+        {
+            return 1;
+        }
+        return processors < max_default_threads ? processors : max_default_threads;
+    }
+
+    namespace
+    {
+        // The part of a batch a thread runs, [next, end)
+        struct share_t
+        {
+            std::mutex lock;
+            size_t next;
+            size_t end;
+        };
+
+        bool claim(share_t* share, size_t* index)
+        {
+            std::lock_guard<std::mutex> lock(share->lock);
+            if (share->next == share->end)
+            {
+                return false;
+            }
+            *index = share->next++;
+            return true;
+        }
+
+        // Moves the back half of the first share with work left to the empty share of thread 'thief'
+        bool steal(share_t* shares, size_t count, size_t thief)
+        {
+            for (size_t i = 1; i < count; ++i)
+            {
+                share_t& victim = shares[(thief + i) % count];
+                size_t begin;
+                size_t end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.lock);
+                    size_t left = victim.end - victim.next;
+                    if (left == 0)
+                    {
+                        continue;
+                    }
+                    end = victim.end;
+                    begin = end - (left + 1) / 2;
+                    victim.end = begin;
+                }
+
+                std::lock_guard<std::mutex> lock(shares[thief].lock);
+                shares[thief].next = begin;
+                shares[thief].end = end;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    std::thread thread_pool_t::start_worker(std::function<void()> work)
+    {
+        return std::thread(std::move(work));
+    }
+
+    void thread_pool_t::run(const std::vector<task_t>& tasks)
+    {
+        run(tasks.size(), [&tasks](size_t i) { tasks[i](); });
+    }
+
+    void thread_pool_t::run(size_t count, const std::function<void(size_t)>& task)
+    {
+        if (m_thread_count == 1 || count <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        size_t thread_count = count < m_thread_count ? count : m_thread_count;
+        std::unique_ptr<share_t[]> shares(new share_t[thread_count]);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            shares[i].next = count * i / thread_count;
+            shares[i].end = count * (i + 1) / thread_count;
+        }
+
+        std::mutex error_lock;
+        std::exception_ptr error;
+        trace::error_writer_fn error_writer = trace::get_error_writer();
+
+        auto run_share = [&](size_t thread)
+        {
+            do
+            {
+                size_t index;
+                while (claim(&shares[thread], &index))
+                {
+                    try
+                    {
+                        task(index);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(error_lock);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            } while (steal(shares.get(), thread_count, thread));
+        };
+
+        // The shares of workers which could not be created are stolen by the others
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        try
+        {
+            for (size_t i = 1; i < thread_count; ++i)
+            {
+                workers.push_back(start_worker([&, i]()
+                {
+                    trace::set_error_writer(error_writer);
+                    run_share(i);
+                }));
+            }
+        }
+        catch (const std::system_error&)
+        {
+            TRACE_VERBOSE(_X("Running a batch on %d of %d threads, no more could be created"), static_cast<int>(workers.size() + 1), static_cast<int>(thread_count));
+        }
+
+        run_share(0);
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+} // namespace coreload
@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include "pal.h"
+#include "trace.h"
+#include <functional>
+#include <thread>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Small pool of threads for running independent steps of a resolution
+    // concurrently.
+    //
+    // The calling thread takes part in running a batch, so a pool of one thread
+    // runs it serially on the caller. Workers are started for a batch with more
+    // than one task and joined before run returns, so nothing outlives the batch.
+    //
+    // Each thread starts on its own contiguous share of the batch, and a thread
+    // which runs out of work steals half of what is left of another share.
+    // Tasks which take long, such as probes on a cold disk, do not hold up the
+    // tasks queued behind them.
+    //
+    // Workers which cannot be created leave their share to the threads which
+    // were, so a batch completes on the caller alone if need be.
+    //
+    // The number of threads defaults to the number of processors, at most 4, and
+    // can be set with COREHOST_THREADS.
+    //
+    class thread_pool_t
+    {
+    public:
+        typedef std::function<void()> task_t;
+
+        explicit thread_pool_t(size_t thread_count = default_thread_count());
+        virtual ~thread_pool_t() = default;
+
+        // Runs the tasks and returns once all of them completed. Workers write errors
+        // with the caller's error writer. If tasks threw, the first exception caught
+        // is rethrown on the caller after the others completed.
+        void run(const std::vector<task_t>& tasks);
+
+        // Same as run, with a task per index in [0, count).
+        void run(size_t count, const std::function<void(size_t)>& task);
+
+        size_t get_thread_count() const { return m_thread_count; }
+
+        static size_t default_thread_count();
+
+    protected:
+        // Starts a worker of a batch, throwing std::system_error if it cannot
+        virtual std::thread start_worker(std::function<void()> work);
+
+    private:
+        size_t m_thread_count;
+    };
+
+} // namespace coreload
+
+#endif // THREAD_POOL_H_
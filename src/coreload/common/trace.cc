@@ -1,4 +1,7 @@
 #include "trace.h"
+#include "trace_capture.h"
+#include "trace_sink.h"
+#include <cstdlib>
 #include <mutex>
 
 namespace coreload
@@ -15,6 +18,41 @@ namespace coreload
     static std::mutex g_trace_mutex;
     thread_local static trace::error_writer_fn g_error_writer = nullptr;
 
+    // With COREHOST_TRACE_ASYNC=1, trace records are written to the trace file by a
+    // background thread. The sink is stopped at exit, which writes what is left,
+    // but not deleted: threads still running may trace until the process is gone.
+    static trace_sink_t* g_trace_sink = nullptr;
+
+    static void stop_trace_sink()
+    {
+        if (g_trace_sink != nullptr)
+        {
+            g_trace_sink->stop();
+        }
+    }
+
+    // With COREHOST_TRACE_BINARY=1, records are written to the trace file as a
+    // capture, see trace_capture.h.
+    static trace_capture_writer_t* g_trace_capture = nullptr;
+
+    static void write_trace(trace_capture::level_t level, const pal::char_t* format, va_list args)
+    {
+        if (g_trace_capture != nullptr)
+        {
+            g_trace_capture->write(level, format, args);
+            return;
+        }
+
+        if (g_trace_sink != nullptr)
+        {
+            g_trace_sink->write(format, args);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        pal::file_vprintf(g_trace_file, format, args);
+    }
+
     //
     // Turn on tracing for the corehost based on "COREHOST_TRACE" & "COREHOST_TRACEFILE" env.
     //
@@ -47,11 +85,16 @@ namespace coreload
         {
             std::lock_guard<std::mutex> lock(g_trace_mutex);
 
+            // Captures are only written to a trace file
+            pal::string_t binary_str;
+            bool binary = pal::getenv(_X("COREHOST_TRACE_BINARY"), &binary_str) && pal::xtoi(binary_str.c_str()) > 0;
+
             g_trace_file = stderr;
+            g_trace_sink = nullptr;
+            g_trace_capture = nullptr;
             if (pal::getenv(_X("COREHOST_TRACEFILE"), &tracefile_str))
             {
-                FILE *tracefile = NULL;
-                pal::file_open(tracefile_str, _X("a"), tracefile);
+                FILE *tracefile = pal::file_open(tracefile_str, binary ? _X("ab") : _X("a"));
 
                 if (tracefile)
                 {
@@ -63,6 +106,17 @@ namespace coreload
                 }
             }
 
+            pal::string_t async_str;
+            if (binary && g_trace_file != stderr)
+            {
+                g_trace_capture = new trace_capture_writer_t(g_trace_file);
+            }
+            else if (pal::getenv(_X("COREHOST_TRACE_ASYNC"), &async_str) && pal::xtoi(async_str.c_str()) > 0)
+            {
+                g_trace_sink = new trace_sink_t(g_trace_file);
+                std::atexit(stop_trace_sink);
+            }
+
             pal::string_t trace_str;
             if (!pal::getenv(_X("COREHOST_TRACE_VERBOSITY"), &trace_str))
             {
@@ -84,20 +138,45 @@ namespace coreload
         return true;
     }
 
+    void trace::disable()
+    {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        g_trace_verbosity = 0;
+
+        // Sinks and captures are never deleted, threads may still hold them
+        if (g_trace_sink != nullptr)
+        {
+            g_trace_sink->stop();
+        }
+        else if (g_trace_capture == nullptr && g_trace_file != stderr)
+        {
+            fclose(g_trace_file);
+            g_trace_file = stderr;
+        }
+    }
+
     bool trace::is_enabled()
     {
         return g_trace_verbosity;
     }
 
+    bool trace::is_verbose_enabled()
+    {
+        return g_trace_verbosity > 3;
+    }
+
+    bool trace::is_info_enabled()
+    {
+        return g_trace_verbosity > 2;
+    }
+
     void trace::verbose(const pal::char_t* format, ...)
     {
         if (g_trace_verbosity > 3)
         {
-            std::lock_guard<std::mutex> lock(g_trace_mutex);
-
             va_list args;
             va_start(args, format);
-            pal::file_vprintf(g_trace_file, format, args);
+            write_trace(trace_capture::level_t::verbose, format, args);
             va_end(args);
         }
     }
@@ -106,11 +185,9 @@ namespace coreload
     {
         if (g_trace_verbosity > 2)
         {
-            std::lock_guard<std::mutex> lock(g_trace_mutex);
-
             va_list args;
             va_start(args, format);
-            pal::file_vprintf(g_trace_file, format, args);
+            write_trace(trace_capture::level_t::info, format, args);
             va_end(args);
         }
     }
@@ -129,10 +206,11 @@ namespace coreload
         va_list dup_args;
         va_copy(dup_args, args);
 
-        size_t length = _vscwprintf(format, dup_args);
-        int count = pal::str_vprintf(NULL, 0, length, format, args) + 1;
+        int length = pal::strlen_vprintf(format, args);
+        int count = length + 1;
         std::vector<pal::char_t> buffer(count);
         pal::str_vprintf(&buffer[0], count, length, format, dup_args);
+        va_end(dup_args);
 
         if (g_error_writer == nullptr)
         {
@@ -147,10 +225,24 @@ namespace coreload
         ::OutputDebugStringW(buffer.data());
 #endif
 
+        // The error writer and stderr get the error synchronously, the trace file
+        // along with the other records.
         if (g_trace_verbosity && ((g_trace_file != stderr) || g_error_writer != nullptr))
         {
-            pal::file_vprintf(g_trace_file, format, trace_args);
+            if (g_trace_capture != nullptr)
+            {
+                g_trace_capture->write(trace_capture::level_t::error, format, trace_args);
+            }
+            else if (g_trace_sink != nullptr)
+            {
+                g_trace_sink->write(format, trace_args);
+            }
+            else
+            {
+                pal::file_vprintf(g_trace_file, format, trace_args);
+            }
         }
+        va_end(trace_args);
         va_end(args);
     }
 
@@ -173,17 +265,20 @@ namespace coreload
     {
         if (g_trace_verbosity > 1)
         {
-            std::lock_guard<std::mutex> lock(g_trace_mutex);
-
             va_list args;
             va_start(args, format);
-            pal::file_vprintf(g_trace_file, format, args);
+            write_trace(trace_capture::level_t::warning, format, args);
             va_end(args);
         }
     }
 
     void trace::flush()
     {
+        if (g_trace_sink != nullptr)
+        {
+            g_trace_sink->flush();
+        }
+
         std::lock_guard<std::mutex> lock(g_trace_mutex);
 
         pal::file_flush(g_trace_file);
@@ -10,6 +10,14 @@ namespace coreload
         void setup();
         bool enable();
         bool is_enabled();
+
+        // Turns tracing off again, after which enable reads the environment anew
+        void disable();
+
+        // Whether verbose() and info() write anything
+        bool is_verbose_enabled();
+        bool is_info_enabled();
+
         void verbose(const pal::char_t* format, ...);
         void info(const pal::char_t* format, ...);
         void warning(const pal::char_t* format, ...);
@@ -33,4 +41,20 @@ namespace coreload
 
 } // namespace coreload
 
+// -----------------------------------------------------------------------------
+// Verbose and info tracing which only evaluates its arguments if the level is
+// enabled, so that formatting arguments such as version.as_str().c_str() cost
+// nothing with tracing off.
+//
+// Defining CORELOAD_STRIP_TRACE removes verbose and info tracing from the code.
+// The calls are still compiled, so that stripped builds keep them well formed.
+//
+#if defined(CORELOAD_STRIP_TRACE)
+#define TRACE_VERBOSE(...) do { if (false) { ::coreload::trace::verbose(__VA_ARGS__); } } while (0)
+#define TRACE_INFO(...) do { if (false) { ::coreload::trace::info(__VA_ARGS__); } } while (0)
+#else
+#define TRACE_VERBOSE(...) do { if (::coreload::trace::is_verbose_enabled()) { ::coreload::trace::verbose(__VA_ARGS__); } } while (0)
+#define TRACE_INFO(...) do { if (::coreload::trace::is_info_enabled()) { ::coreload::trace::info(__VA_ARGS__); } } while (0)
+#endif
+
 #endif // TRACE_H_
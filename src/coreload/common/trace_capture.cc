@@ -0,0 +1,626 @@
+#include "trace_capture.h"
+#include <atomic>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+
+namespace coreload
+{
+    namespace
+    {
+        const char capture_magic[] = { 'C', 'L', 'T', 'R', 'A', 'C', 'E', '1' };
+
+        const uint8_t site_record = 1;
+        const uint8_t event_record = 2;
+
+        // Offset of the site ID in an event record
+        const size_t event_site_offset = 1;
+
+        std::atomic<uint32_t> g_next_thread_id(1);
+        thread_local uint32_t t_thread_id = 0;
+
+        // A record being encoded. Appending is kept inline, records are encoded a
+        // field at a time.
+        class record_t
+        {
+        public:
+            record_t()
+                : m_size(0)
+                , m_capacity(0)
+            {
+            }
+
+            void clear() { m_size = 0; }
+            size_t size() const { return m_size; }
+            char* data() { return m_data.get(); }
+
+            void append(const void* bytes, size_t size)
+            {
+                if (m_capacity - m_size < size)
+                {
+                    grow(size);
+                }
+                memcpy(m_data.get() + m_size, bytes, size);
+                m_size += size;
+            }
+
+        private:
+            void grow(size_t size)
+            {
+                size_t capacity = m_capacity == 0 ? 256 : m_capacity;
+                while (capacity - m_size < size)
+                {
+                    capacity *= 2;
+                }
+
+                std::unique_ptr<char[]> data(new char[capacity]);
+                if (m_size > 0)
+                {
+                    memcpy(data.get(), m_data.get(), m_size);
+                }
+                m_data = std::move(data);
+                m_capacity = capacity;
+            }
+
+            std::unique_ptr<char[]> m_data;
+            size_t m_size;
+            size_t m_capacity;
+        };
+
+        // The event being encoded by this thread
+        thread_local record_t t_event;
+
+        uint32_t get_thread_id()
+        {
+            if (t_thread_id == 0)
+            {
+                t_thread_id = g_next_thread_id.fetch_add(1);
+            }
+            return t_thread_id;
+        }
+
+        enum class length_t
+        {
+            none,
+            hh,
+            h,
+            l,
+            ll,
+            z,
+            j,
+            t,
+            L,
+        };
+
+        inline const char* find_percent(const char* p) { return ::strchr(p, '%'); }
+        inline const wchar_t* find_percent(const wchar_t* p) { return ::wcschr(p, L'%'); }
+
+        // A conversion of a printf format: [begin, end), with the length modifier
+        // at [length_begin, conversion).
+        template <typename char_type>
+        struct spec_t
+        {
+            const char_type* begin;
+            const char_type* length_begin;
+            const char_type* end;
+            int star_count;
+            length_t length;
+            char_type conversion;
+        };
+
+        // Finds the next conversion at or after 'p'. Returns false if there is none,
+        // or if the format ends within it.
+        template <typename char_type>
+        bool next_spec(const char_type* p, spec_t<char_type>* spec)
+        {
+            p = find_percent(p);
+            if (p == nullptr)
+            {
+                return false;
+            }
+
+            spec->begin = p++;
+            spec->star_count = 0;
+            while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+            {
+                ++p;
+            }
+
+            for (int part = 0; part < 2; ++part)
+            {
+                if (part == 1)
+                {
+                    if (*p != '.')
+                    {
+                        break;
+                    }
+                    ++p;
+                }
+
+                if (*p == '*')
+                {
+                    spec->star_count++;
+                    ++p;
+                }
+                else
+                {
+                    while (*p >= '0' && *p <= '9')
+                    {
+                        ++p;
+                    }
+                }
+            }
+
+            spec->length_begin = p;
+            spec->length = length_t::none;
+            switch (*p)
+            {
+            case 'h':
+                spec->length = (p[1] == 'h') ? length_t::hh : length_t::h;
+                break;
+            case 'l':
+                spec->length = (p[1] == 'l') ? length_t::ll : length_t::l;
+                break;
+            case 'z': spec->length = length_t::z; break;
+            case 'j': spec->length = length_t::j; break;
+            case 't': spec->length = length_t::t; break;
+            case 'L': spec->length = length_t::L; break;
+            default: break;
+            }
+
+            if (spec->length == length_t::hh || spec->length == length_t::ll)
+            {
+                p += 2;
+            }
+            else if (spec->length != length_t::none)
+            {
+                p += 1;
+            }
+
+            if (*p == 0)
+            {
+                return false;
+            }
+
+            spec->conversion = *p;
+            spec->end = p + 1;
+            return true;
+        }
+
+        void put_bytes(record_t* out, const void* data, size_t size)
+        {
+            out->append(data, size);
+        }
+
+        template <typename T>
+        void put(record_t* out, T value)
+        {
+            put_bytes(out, &value, sizeof(value));
+        }
+
+        void put_string(record_t* out, const char* value, size_t length)
+        {
+            put(out, static_cast<uint32_t>(length));
+            put_bytes(out, value, length);
+        }
+
+        void put_string(record_t* out, const pal::char_t* value)
+        {
+#if defined(_WIN32)
+            std::vector<char> utf8;
+            pal::pal_utf8string(value, &utf8);
+            put_string(out, utf8.data(), utf8.empty() ? 0 : utf8.size() - 1);
+#else
+            put_string(out, value, pal::strlen(value));
+#endif
+        }
+
+        void put_arg(record_t* out, trace_capture::arg_type_t type, const void* value, size_t size)
+        {
+            put(out, static_cast<uint8_t>(type));
+            put_bytes(out, value, size);
+        }
+
+        void put_signed(record_t* out, int64_t value)
+        {
+            put_arg(out, trace_capture::arg_type_t::signed_int, &value, sizeof(value));
+        }
+
+        void put_unsigned(record_t* out, uint64_t value)
+        {
+            put_arg(out, trace_capture::arg_type_t::unsigned_int, &value, sizeof(value));
+        }
+
+        // Appends the arguments as the format describes them, up to the first
+        // conversion it does not know. Returns the number of arguments appended.
+        uint16_t encode_args(const pal::char_t* format, va_list args, record_t* out)
+        {
+            uint16_t count = 0;
+            spec_t<pal::char_t> spec;
+            for (const pal::char_t* p = format; next_spec(p, &spec); p = spec.end)
+            {
+                if (spec.conversion == '%')
+                {
+                    continue;
+                }
+
+                for (int i = 0; i < spec.star_count; ++i)
+                {
+                    put_signed(out, va_arg(args, int));
+                    count++;
+                }
+
+                switch (spec.conversion)
+                {
+                case 'd':
+                case 'i':
+                    switch (spec.length)
+                    {
+                    case length_t::l: put_signed(out, va_arg(args, long)); break;
+                    case length_t::ll: put_signed(out, va_arg(args, long long)); break;
+                    case length_t::z:
+                    case length_t::t: put_signed(out, va_arg(args, ptrdiff_t)); break;
+                    case length_t::j: put_signed(out, va_arg(args, intmax_t)); break;
+                    default: put_signed(out, va_arg(args, int)); break;
+                    }
+                    break;
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    switch (spec.length)
+                    {
+                    case length_t::l: put_unsigned(out, va_arg(args, unsigned long)); break;
+                    case length_t::ll: put_unsigned(out, va_arg(args, unsigned long long)); break;
+                    case length_t::z:
+                    case length_t::t: put_unsigned(out, va_arg(args, size_t)); break;
+                    case length_t::j: put_unsigned(out, va_arg(args, uintmax_t)); break;
+                    default: put_unsigned(out, va_arg(args, unsigned int)); break;
+                    }
+                    break;
+                case 'c':
+                    put_signed(out, va_arg(args, int));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                {
+                    double value = (spec.length == length_t::L) ? static_cast<double>(va_arg(args, long double)) : va_arg(args, double);
+                    put_arg(out, trace_capture::arg_type_t::floating, &value, sizeof(value));
+                    break;
+                }
+                case 's':
+                {
+                    const pal::char_t* value = va_arg(args, const pal::char_t*);
+                    put(out, static_cast<uint8_t>(trace_capture::arg_type_t::string));
+                    put_string(out, value != nullptr ? value : _X("(null)"));
+                    break;
+                }
+                case 'p':
+                {
+                    uint64_t value = reinterpret_cast<uintptr_t>(va_arg(args, void*));
+                    put_arg(out, trace_capture::arg_type_t::pointer, &value, sizeof(value));
+                    break;
+                }
+                default:
+                    return count;
+                }
+                count++;
+            }
+            return count;
+        }
+
+        class input_t
+        {
+        public:
+            input_t(const std::vector<char>& data)
+                : m_data(data)
+                , m_pos(0)
+            {
+            }
+
+            bool at_end() const { return m_pos == m_data.size(); }
+            size_t get_pos() const { return m_pos; }
+
+            bool get_bytes(void* value, size_t size)
+            {
+                if (m_data.size() - m_pos < size)
+                {
+                    return false;
+                }
+                memcpy(value, m_data.data() + m_pos, size);
+                m_pos += size;
+                return true;
+            }
+
+            template <typename T>
+            bool get(T* value)
+            {
+                return get_bytes(value, sizeof(*value));
+            }
+
+            bool get_string(std::string* value)
+            {
+                uint32_t length;
+                if (!get(&length) || m_data.size() - m_pos < length)
+                {
+                    return false;
+                }
+                value->assign(m_data.data() + m_pos, length);
+                m_pos += length;
+                return true;
+            }
+
+            bool skip_magic()
+            {
+                if (m_data.size() - m_pos < sizeof(capture_magic) || memcmp(m_data.data() + m_pos, capture_magic, sizeof(capture_magic)) != 0)
+                {
+                    return false;
+                }
+                m_pos += sizeof(capture_magic);
+                return true;
+            }
+
+        private:
+            const std::vector<char>& m_data;
+            size_t m_pos;
+        };
+
+        bool read_arg(input_t* input, trace_capture::arg_t* arg)
+        {
+            uint8_t type;
+            if (!input->get(&type))
+            {
+                return false;
+            }
+
+            arg->type = static_cast<trace_capture::arg_type_t>(type);
+            switch (arg->type)
+            {
+            case trace_capture::arg_type_t::signed_int:
+                return input->get(&arg->signed_value);
+            case trace_capture::arg_type_t::unsigned_int:
+            case trace_capture::arg_type_t::pointer:
+                return input->get(&arg->unsigned_value);
+            case trace_capture::arg_type_t::floating:
+                return input->get(&arg->floating_value);
+            case trace_capture::arg_type_t::string:
+                return input->get_string(&arg->string_value);
+            default:
+                return false;
+            }
+        }
+
+        template <typename... Args>
+        void append_formatted(std::string* out, const std::string& spec, Args... args)
+        {
+            int length = snprintf(nullptr, 0, spec.c_str(), args...);
+            if (length <= 0)
+            {
+                return;
+            }
+
+            size_t size = out->size();
+            out->resize(size + length + 1);
+            snprintf(&(*out)[size], length + 1, spec.c_str(), args...);
+            out->resize(size + length);
+        }
+
+        // Formats a value with the '*' width and precision of its conversion, if any
+        template <typename T>
+        void append_conversion(std::string* out, const std::string& spec, const int* stars, int star_count, T value)
+        {
+            switch (star_count)
+            {
+            case 0: append_formatted(out, spec, value); break;
+            case 1: append_formatted(out, spec, stars[0], value); break;
+            default: append_formatted(out, spec, stars[0], stars[1], value); break;
+            }
+        }
+    }
+
+    const char* trace_capture::level_name(level_t level)
+    {
+        switch (level)
+        {
+        case level_t::error: return "error";
+        case level_t::warning: return "warning";
+        case level_t::info: return "info";
+        case level_t::verbose: return "verbose";
+        default: return "unknown";
+        }
+    }
+
+    bool trace_capture::read(const std::vector<char>& data, std::vector<capture_t>* captures, std::vector<event_t>* events, std::string* error)
+    {
+        input_t input(data);
+        while (!input.at_end())
+        {
+            size_t record_pos = input.get_pos();
+            if (input.skip_magic())
+            {
+                capture_t capture;
+                if (!input.get(&capture.start_time_ns))
+                {
+                    *error = "truncated capture header at offset " + std::to_string(record_pos);
+                    return false;
+                }
+                captures->push_back(std::move(capture));
+                continue;
+            }
+
+            uint8_t kind;
+            input.get(&kind);
+            if (captures->empty() || (kind != site_record && kind != event_record))
+            {
+                *error = "not a trace capture record at offset " + std::to_string(record_pos);
+                return false;
+            }
+
+            if (kind == site_record)
+            {
+                uint32_t id;
+                uint8_t level;
+                site_t site;
+                if (!input.get(&id) || !input.get(&level) || !input.get_string(&site.format))
+                {
+                    *error = "truncated site record at offset " + std::to_string(record_pos);
+                    return false;
+                }
+                site.level = static_cast<level_t>(level);
+                captures->back().sites[id] = std::move(site);
+                continue;
+            }
+
+            event_t event;
+            uint16_t arg_count;
+            event.capture = captures->size() - 1;
+            if (!input.get(&event.site_id) || !input.get(&event.thread_id) || !input.get(&event.timestamp_ns) || !input.get(&arg_count))
+            {
+                *error = "truncated event record at offset " + std::to_string(record_pos);
+                return false;
+            }
+
+            event.args.resize(arg_count);
+            for (auto& arg : event.args)
+            {
+                if (!read_arg(&input, &arg))
+                {
+                    *error = "invalid event argument in the record at offset " + std::to_string(record_pos);
+                    return false;
+                }
+            }
+
+            if (captures->back().sites.count(event.site_id) == 0)
+            {
+                *error = "event of an unknown site at offset " + std::to_string(record_pos);
+                return false;
+            }
+            events->push_back(std::move(event));
+        }
+        return true;
+    }
+
+    std::string trace_capture::format_message(const site_t& site, const event_t& event)
+    {
+        std::string message;
+        const char* p = site.format.c_str();
+        size_t next_arg = 0;
+
+        spec_t<char> spec;
+        while (next_spec(p, &spec))
+        {
+            message.append(p, spec.begin);
+            p = spec.end;
+
+            if (spec.conversion == '%')
+            {
+                message.push_back('%');
+                continue;
+            }
+
+            int stars[2] = { 0, 0 };
+            bool valid = next_arg + spec.star_count < event.args.size();
+            for (int i = 0; valid && i < spec.star_count; ++i)
+            {
+                const arg_t& star = event.args[next_arg++];
+                valid = star.type == arg_type_t::signed_int;
+                stars[i] = static_cast<int>(star.signed_value);
+            }
+
+            // The conversion without its length modifier, which depends on the argument type
+            std::string base(spec.begin, spec.length_begin);
+            const arg_t* arg = valid ? &event.args[next_arg++] : nullptr;
+            switch (arg != nullptr ? arg->type : static_cast<arg_type_t>(0))
+            {
+            case arg_type_t::signed_int:
+                if (spec.conversion == 'c')
+                {
+                    append_conversion(&message, base + "c", stars, spec.star_count, static_cast<int>(arg->signed_value));
+                }
+                else
+                {
+                    append_conversion(&message, base + "ll" + spec.conversion, stars, spec.star_count, static_cast<long long>(arg->signed_value));
+                }
+                break;
+            case arg_type_t::unsigned_int:
+                append_conversion(&message, base + "ll" + spec.conversion, stars, spec.star_count, static_cast<unsigned long long>(arg->unsigned_value));
+                break;
+            case arg_type_t::floating:
+                append_conversion(&message, base + spec.conversion, stars, spec.star_count, arg->floating_value);
+                break;
+            case arg_type_t::string:
+                append_conversion(&message, base + "s", stars, spec.star_count, arg->string_value.c_str());
+                break;
+            case arg_type_t::pointer:
+                append_conversion(&message, base + "p", stars, spec.star_count, reinterpret_cast<void*>(static_cast<uintptr_t>(arg->unsigned_value)));
+                break;
+            default:
+                // Not captured, keep the rest of the format as it is
+                message.append(spec.begin);
+                return message;
+            }
+        }
+
+        message.append(p);
+        return message;
+    }
+
+    trace_capture_writer_t::trace_capture_writer_t(FILE* file)
+        : m_file(file)
+        , m_start(std::chrono::steady_clock::now())
+    {
+        uint64_t start_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+        record_t header;
+        put_bytes(&header, capture_magic, sizeof(capture_magic));
+        put(&header, start_time_ns);
+        std::fwrite(header.data(), 1, header.size(), m_file);
+    }
+
+    void trace_capture_writer_t::write(trace_capture::level_t level, const pal::char_t* format, va_list args)
+    {
+        uint64_t timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start).count());
+
+        // The site ID is filled in once known
+        record_t& event = t_event;
+        event.clear();
+        put(&event, event_record);
+        put(&event, static_cast<uint32_t>(0));
+        put(&event, get_thread_id());
+        put(&event, timestamp_ns);
+        size_t count_offset = event.size();
+        put(&event, static_cast<uint16_t>(0));
+
+        va_list dup_args;
+        va_copy(dup_args, args);
+        uint16_t count = encode_args(format, dup_args, &event);
+        va_end(dup_args);
+        memcpy(event.data() + count_offset, &count, sizeof(count));
+
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        auto site = m_site_ids.emplace(std::make_pair(format, level), static_cast<uint32_t>(m_site_ids.size() + 1));
+        uint32_t site_id = site.first->second;
+        if (site.second)
+        {
+            record_t record;
+            put(&record, site_record);
+            put(&record, site_id);
+            put(&record, static_cast<uint8_t>(level));
+            put_string(&record, format);
+            std::fwrite(record.data(), 1, record.size(), m_file);
+        }
+
+        memcpy(event.data() + event_site_offset, &site_id, sizeof(site_id));
+        std::fwrite(event.data(), 1, event.size(), m_file);
+    }
+
+} // namespace coreload
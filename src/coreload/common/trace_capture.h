@@ -0,0 +1,116 @@
+#ifndef TRACE_CAPTURE_H_
+#define TRACE_CAPTURE_H_
+
+#include "pal.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Binary trace captures, written instead of text traces with COREHOST_TRACE_BINARY=1
+    // and turned back into text by coreload-tracedump.
+    //
+    // Records hold the raw arguments of a trace call instead of the formatted
+    // message, so that tracing costs an encoding of the arguments rather than a
+    // printf. The arguments are read as the format describes them.
+    //
+    // A capture starts with the 8 bytes "CLTRACE1" followed by the wall clock time
+    // it started at, in nanoseconds since the epoch. Records follow, each starting
+    // with its kind:
+    //
+    //  site  (1) - site ID, level, format. Written before the first event of a trace
+    //              site, the ID is that of its format string and level for the
+    //              capture, as some formats are traced at more than one level.
+    //  event (2) - site ID, thread ID, nanoseconds since the capture started, then
+    //              the arguments, each a type and a value.
+    //
+    // Integers are in the byte order of the host, strings are UTF-8 prefixed with
+    // their length. Captures appended to the same file follow each other.
+    //
+    namespace trace_capture
+    {
+        enum class level_t : uint8_t
+        {
+            error = 1,
+            warning = 2,
+            info = 3,
+            verbose = 4,
+        };
+
+        enum class arg_type_t : uint8_t
+        {
+            signed_int = 1,
+            unsigned_int = 2,
+            floating = 3,
+            string = 4,
+            pointer = 5,
+        };
+
+        struct arg_t
+        {
+            arg_type_t type;
+            int64_t signed_value;
+            uint64_t unsigned_value;
+            double floating_value;
+            std::string string_value;
+        };
+
+        struct site_t
+        {
+            level_t level;
+            std::string format;
+        };
+
+        struct event_t
+        {
+            // Index of the capture in the file
+            size_t capture;
+            uint32_t site_id;
+            uint32_t thread_id;
+            uint64_t timestamp_ns;
+            std::vector<arg_t> args;
+        };
+
+        struct capture_t
+        {
+            uint64_t start_time_ns;
+
+            // Sites by ID
+            std::unordered_map<uint32_t, site_t> sites;
+        };
+
+        const char* level_name(level_t level);
+
+        // Reads the captures of a file. Returns false with a description in 'error'
+        // if the data is not a capture, in which case the events read so far are kept.
+        bool read(const std::vector<char>& data, std::vector<capture_t>* captures, std::vector<event_t>* events, std::string* error);
+
+        // The message of an event, as a text trace would have it
+        std::string format_message(const site_t& site, const event_t& event);
+    }
+
+    class trace_capture_writer_t
+    {
+    public:
+        // 'file' is open for writing in binary mode
+        explicit trace_capture_writer_t(FILE* file);
+
+        void write(trace_capture::level_t level, const pal::char_t* format, va_list args);
+
+    private:
+        FILE* m_file;
+        std::chrono::steady_clock::time_point m_start;
+
+        std::mutex m_lock;
+        std::map<std::pair<const pal::char_t*, trace_capture::level_t>, uint32_t> m_site_ids;
+    };
+
+} // namespace coreload
+
+#endif // TRACE_CAPTURE_H_
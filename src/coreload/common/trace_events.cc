@@ -0,0 +1,164 @@
+#include "trace_events.h"
+#include "startup_metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+
+namespace coreload
+{
+    static std::atomic<trace_events_t*> g_active_trace_events(nullptr);
+
+    static void append_json_string(const std::string& value, std::string* out)
+    {
+        out->push_back('"');
+        for (unsigned char c : value)
+        {
+            switch (c)
+            {
+            case '"': out->append("\\\""); break;
+            case '\\': out->append("\\\\"); break;
+            case '\n': out->append("\\n"); break;
+            case '\r': out->append("\\r"); break;
+            case '\t': out->append("\\t"); break;
+            default:
+                if (c < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out->append(escaped);
+                }
+                else
+                {
+                    out->push_back(static_cast<char>(c));
+                }
+                break;
+            }
+        }
+        out->push_back('"');
+    }
+
+    // Microseconds, the unit of the format, keeping the nanoseconds as decimals
+    static void append_microseconds(uint64_t ns, std::string* out)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%" PRIu64 ".%03u", ns / 1000, static_cast<unsigned>(ns % 1000));
+        out->append(buffer);
+    }
+
+    trace_events_t* trace_events_t::active()
+    {
+        return g_active_trace_events.load(std::memory_order_acquire);
+    }
+
+    void trace_events_t::add(const char* name, const pal::string_t& detail, uint64_t start_ns, uint64_t end_ns)
+    {
+        event_t event;
+        event.name = name;
+        std::vector<char> detail_utf8;
+        if (!detail.empty() && pal::pal_utf8string(detail, &detail_utf8))
+        {
+            event.detail.assign(detail_utf8.data());
+        }
+        event.thread_id = pal::get_tid();
+        event.start_ns = start_ns;
+        event.end_ns = end_ns;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_events.push_back(std::move(event));
+    }
+
+    std::vector<trace_events_t::event_t> trace_events_t::get_events() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_events;
+    }
+
+    bool trace_events_t::write(const pal::string_t& path) const
+    {
+        std::vector<event_t> events = get_events();
+
+        // Events are added as they end; the viewers nest events of a thread by
+        // their order, outer events first.
+        std::sort(events.begin(), events.end(), [](const event_t& a, const event_t& b)
+        {
+            return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.end_ns > b.end_ns;
+        });
+
+        const uint64_t origin_ns = events.empty() ? 0 : events.front().start_ns;
+        const unsigned long pid = pal::get_pid();
+
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        json.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":");
+        json.append(std::to_string(pid));
+        json.append(",\"tid\":0,\"args\":{\"name\":\"coreload\"}}");
+        for (const event_t& event : events)
+        {
+            json.append(",\n{\"name\":");
+            append_json_string(event.name, &json);
+            json.append(",\"cat\":\"coreload\",\"ph\":\"X\",\"ts\":");
+            append_microseconds(event.start_ns - origin_ns, &json);
+            json.append(",\"dur\":");
+            append_microseconds(event.end_ns - event.start_ns, &json);
+            json.append(",\"pid\":");
+            json.append(std::to_string(pid));
+            json.append(",\"tid\":");
+            json.append(std::to_string(event.thread_id));
+            if (!event.detail.empty())
+            {
+                json.append(",\"args\":{\"detail\":");
+                append_json_string(event.detail, &json);
+                json.push_back('}');
+            }
+            json.push_back('}');
+        }
+        json.append("\n]}\n");
+
+        FILE* file = pal::file_open(path, _X("wb"));
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+        return fclose(file) == 0 && written;
+    }
+
+    trace_events_scope_t::trace_events_scope_t(trace_events_t* events)
+    {
+        m_previous = g_active_trace_events.exchange(events, std::memory_order_acq_rel);
+    }
+
+    trace_events_scope_t::~trace_events_scope_t()
+    {
+        g_active_trace_events.exchange(m_previous, std::memory_order_acq_rel);
+    }
+
+    trace_duration_t::trace_duration_t(const char* name)
+        : m_events(trace_events_t::active())
+        , m_name(name)
+        , m_start_ns(0)
+    {
+        if (m_events != nullptr)
+        {
+            m_start_ns = startup_metrics_t::now_ns();
+        }
+    }
+
+    trace_duration_t::trace_duration_t(const char* name, const pal::string_t& detail)
+        : trace_duration_t(name)
+    {
+        if (m_events != nullptr)
+        {
+            m_detail = detail;
+        }
+    }
+
+    trace_duration_t::~trace_duration_t()
+    {
+        if (m_events != nullptr)
+        {
+            m_events->add(m_name, m_detail, m_start_ns, startup_metrics_t::now_ns());
+        }
+    }
+
+} // namespace coreload
@@ -0,0 +1,87 @@
+#ifndef TRACE_EVENTS_H_
+#define TRACE_EVENTS_H_
+
+#include "pal.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Timeline of a runtime start, written as Chrome trace-event JSON to the file
+    // named by COREHOST_TRACE_EVENTS. It opens in chrome://tracing or
+    // ui.perfetto.dev, with each thread of the start on its own track.
+    //
+    // Stages of the start are recorded as complete ("X") duration events, which the
+    // viewers nest by their times on each thread.
+    //
+    class trace_events_t
+    {
+    public:
+        struct event_t
+        {
+            const char* name;
+
+            // Shown as the "detail" argument of the event, a file or framework name
+            std::string detail;
+            unsigned long thread_id;
+            uint64_t start_ns;
+            uint64_t end_ns;
+        };
+
+        void add(const char* name, const pal::string_t& detail, uint64_t start_ns, uint64_t end_ns);
+
+        std::vector<event_t> get_events() const;
+
+        // Writes the events, replacing 'path'. Returns false if the file could not be written.
+        bool write(const pal::string_t& path) const;
+
+        // The events recorded by trace_duration_t, if any.
+        static trace_events_t* active();
+
+    private:
+        mutable std::mutex m_lock;
+        std::vector<event_t> m_events;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Makes a trace_events_t the active one for the lifetime of the scope.
+    //
+    class trace_events_scope_t
+    {
+    public:
+        explicit trace_events_scope_t(trace_events_t* events);
+        ~trace_events_scope_t();
+
+    private:
+        trace_events_scope_t(const trace_events_scope_t&) = delete;
+        trace_events_scope_t& operator=(const trace_events_scope_t&) = delete;
+
+        trace_events_t* m_previous;
+    };
+
+    // -----------------------------------------------------------------------------
+    // Records the lifetime of the scope as a duration event of the active events,
+    // if any. 'name' must outlive the events, a string literal.
+    //
+    class trace_duration_t
+    {
+    public:
+        explicit trace_duration_t(const char* name);
+        trace_duration_t(const char* name, const pal::string_t& detail);
+        ~trace_duration_t();
+
+    private:
+        trace_duration_t(const trace_duration_t&) = delete;
+        trace_duration_t& operator=(const trace_duration_t&) = delete;
+
+        trace_events_t* m_events;
+        const char* m_name;
+        pal::string_t m_detail;
+        uint64_t m_start_ns;
+    };
+
+} // namespace coreload
+
+#endif // TRACE_EVENTS_H_
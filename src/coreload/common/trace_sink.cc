@@ -0,0 +1,215 @@
+#include "trace_sink.h"
+#include <chrono>
+
+namespace coreload
+{
+    // The record being formatted by this thread, swapped with a ring slot once published
+    static thread_local pal::string_t t_record;
+
+    // How long the writer waits between writing batches of records, unless woken
+    // by a ring filling up, a flush or stop
+    static const std::chrono::milliseconds writer_interval(5);
+
+    trace_sink_t::trace_sink_t(FILE* file, size_t capacity)
+        : m_file(file)
+        , m_mask(0)
+        , m_enqueue_pos(0)
+        , m_dequeue_pos(0)
+        , m_flushed_pos(0)
+        , m_flush_requested(false)
+        , m_stopping(false)
+        , m_stopped(false)
+        , m_writer_done(false)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+
+        m_slots.reset(new slot_t[size]);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_mask = size - 1;
+
+        m_writer = std::thread([this]() { run_writer(); });
+    }
+
+    trace_sink_t::~trace_sink_t()
+    {
+        stop();
+    }
+
+    void trace_sink_t::write(const pal::char_t* format, va_list args)
+    {
+        if (m_stopped.load(std::memory_order_acquire))
+        {
+            pal::file_vprintf(m_file, format, args);
+            return;
+        }
+
+        va_list length_args;
+        va_copy(length_args, args);
+        va_list dup_args;
+        va_copy(dup_args, args);
+
+        // Format into the buffer as it is, which fits most records once it has grown
+        pal::string_t& record = t_record;
+        size_t capacity = record.capacity();
+        record.resize(capacity);
+        int length = pal::str_vprintf(&record[0], capacity + 1, capacity, format, args);
+        if (length < 0 || static_cast<size_t>(length) > capacity)
+        {
+            length = pal::strlen_vprintf(format, length_args);
+            if (length >= 0)
+            {
+                record.resize(length);
+                pal::str_vprintf(&record[0], length + 1, length, format, dup_args);
+            }
+        }
+        va_end(dup_args);
+        va_end(length_args);
+
+        if (length < 0)
+        {
+            return;
+        }
+
+        record.resize(length);
+        record.push_back(_X('\n'));
+        publish(&record);
+    }
+
+    void trace_sink_t::publish(pal::string_t* record)
+    {
+        slot_t* slot;
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot = &m_slots[pos & m_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (lap == 0)
+            {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (lap < 0)
+            {
+                // Full, the record of the previous lap was not written yet
+                wake_writer();
+                std::this_thread::yield();
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->text.swap(*record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        // Otherwise the writer takes the records at its next interval
+        if ((pos & (m_mask >> 1)) == 0)
+        {
+            wake_writer();
+        }
+    }
+
+    bool trace_sink_t::write_next()
+    {
+        slot_t& slot = m_slots[m_dequeue_pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != m_dequeue_pos + 1)
+        {
+            return false;
+        }
+
+        pal::file_puts(m_file, slot.text.c_str());
+        slot.sequence.store(m_dequeue_pos + m_mask + 1, std::memory_order_release);
+        m_dequeue_pos++;
+        return true;
+    }
+
+    void trace_sink_t::wake_writer()
+    {
+        std::lock_guard<std::mutex> lock(m_wake_lock);
+        m_wake.notify_one();
+    }
+
+    void trace_sink_t::run_writer()
+    {
+        for (;;)
+        {
+            bool stopping = m_stopping.load(std::memory_order_acquire);
+
+            size_t written = m_dequeue_pos;
+            while (write_next())
+            {
+            }
+
+            if (m_dequeue_pos != written || m_flush_requested.exchange(false))
+            {
+                pal::file_flush(m_file);
+                m_flushed_pos.store(m_dequeue_pos, std::memory_order_release);
+            }
+
+            if (stopping)
+            {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(m_wake_lock);
+            if (!m_stopping.load(std::memory_order_acquire) && !m_flush_requested.load(std::memory_order_acquire))
+            {
+                m_wake.wait_for(lock, writer_interval);
+            }
+        }
+
+        m_writer_done.store(true, std::memory_order_release);
+    }
+
+    void trace_sink_t::flush()
+    {
+        size_t target = m_enqueue_pos.load(std::memory_order_acquire);
+        while (m_flushed_pos.load(std::memory_order_acquire) < target && !m_writer_done.load(std::memory_order_acquire))
+        {
+            m_flush_requested.store(true, std::memory_order_release);
+            wake_writer();
+            std::this_thread::yield();
+        }
+    }
+
+    void trace_sink_t::stop()
+    {
+        if (m_stopping.exchange(true))
+        {
+            return;
+        }
+
+        wake_writer();
+#if defined(_WIN32)
+        // Threads are gone by the time the DLL is detached at process exit, and
+        // joining one while it is detached would wait on the loader lock.
+        for (int i = 0; i < 100 && !m_writer_done.load(std::memory_order_acquire); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        m_writer.detach();
+#else
+        m_writer.join();
+#endif
+
+        // Records published since the writer looked at the ring a last time
+        m_stopped.store(true, std::memory_order_release);
+        while (write_next())
+        {
+        }
+        pal::file_flush(m_file);
+    }
+
+} // namespace coreload
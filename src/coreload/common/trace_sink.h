@@ -0,0 +1,83 @@
+#ifndef TRACE_SINK_H_
+#define TRACE_SINK_H_
+
+#include "pal.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Trace records written to a file by a background thread.
+    //
+    // Each thread formats its records into a buffer of its own and publishes them
+    // into a bounded lock-free ring, with the writer thread as its only consumer.
+    // Publishing swaps the buffer with the one in the ring slot, so neither side
+    // allocates once the buffers have grown to the size of the records. A thread
+    // which finds the ring full waits for the writer instead of dropping records.
+    //
+    // The writer takes the records every few milliseconds, or once half of the
+    // ring is used, and flushes the file once per batch.
+    //
+    // Records reach the file in the order they were published.
+    //
+    class trace_sink_t
+    {
+    public:
+        static const size_t default_capacity = 1024;
+
+        // 'capacity' is rounded up to a power of 2
+        explicit trace_sink_t(FILE* file, size_t capacity = default_capacity);
+        ~trace_sink_t();
+
+        // Formats a record, a line of the file.
+        void write(const pal::char_t* format, va_list args);
+
+        // Returns once the records published before the call were written to the
+        // file and the file was flushed.
+        void flush();
+
+        // Writes the remaining records and stops the writer thread. Records written
+        // afterwards go to the file directly.
+        void stop();
+
+    private:
+        struct slot_t
+        {
+            // Position of the record in the slot, offset by one once it is published
+            std::atomic<size_t> sequence;
+            pal::string_t text;
+        };
+
+        void publish(pal::string_t* record);
+        bool write_next();
+        void wake_writer();
+        void run_writer();
+
+        FILE* m_file;
+        std::unique_ptr<slot_t[]> m_slots;
+        size_t m_mask;
+
+        // Producer side
+        std::atomic<size_t> m_enqueue_pos;
+
+        // Writer side: the next record to write and the records written and flushed
+        size_t m_dequeue_pos;
+        std::atomic<size_t> m_flushed_pos;
+
+        std::atomic<bool> m_flush_requested;
+        std::atomic<bool> m_stopping;
+        std::atomic<bool> m_stopped;
+        std::atomic<bool> m_writer_done;
+        std::mutex m_wake_lock;
+        std::condition_variable m_wake;
+        std::thread m_writer;
+    };
+
+} // namespace coreload
+
+#endif // TRACE_SINK_H_
@@ -0,0 +1,49 @@
+#ifndef USDT_H_
+#define USDT_H_
+
+// -----------------------------------------------------------------------------
+// USDT (statically defined) probes of the "coreload" provider, for perf, bpftrace
+// and SystemTap on Linux.
+//
+// A probe site is a single NOP until a tracer attaches to it, its arguments are
+// only read by the tracer. They are compiled in when <sys/sdt.h> is available
+// (systemtap-sdt-dev, systemtap-sdt-devel) unless CORELOAD_NO_USDT is defined,
+// and compile to nothing otherwise; the arguments are then not evaluated.
+//
+// The probes of a build are listed by `readelf -n libcoreload.so`, for example:
+//
+//   bpftrace -e 'usdt:./libcoreload.so:coreload:phase_end { printf("%s\n", str(arg1)); }'
+//
+//  startup_begin                                       StartCoreCLR began
+//  startup_end           (exit_code)                   StartCoreCLR returned
+//  phase_begin           (phase, phase_name)           a phase of startup_metrics_t began
+//  phase_end             (phase, phase_name)           and ended
+//  deps_json_load        (path, size, from_image)      a deps file was read, 'size' in bytes
+//  probe_deps_entry_hit  (library, asset, probe)       an asset was found by the probe at that index
+//  probe_deps_entry_miss (library, asset, probes)      an asset was not found by any probe
+//  create_delegate       (assembly, type, method, latency_ns, hresult)
+//                                                      the runtime created a delegate, on a delegate cache miss
+//
+
+#if !defined(CORELOAD_NO_USDT) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CORELOAD_HAS_USDT 1
+#endif
+#endif
+
+#if defined(CORELOAD_HAS_USDT)
+#define CORELOAD_PROBE0(name) DTRACE_PROBE(coreload, name)
+#define CORELOAD_PROBE1(name, a1) DTRACE_PROBE1(coreload, name, a1)
+#define CORELOAD_PROBE2(name, a1, a2) DTRACE_PROBE2(coreload, name, a1, a2)
+#define CORELOAD_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(coreload, name, a1, a2, a3)
+#define CORELOAD_PROBE5(name, a1, a2, a3, a4, a5) DTRACE_PROBE5(coreload, name, a1, a2, a3, a4, a5)
+#else
+#define CORELOAD_PROBE0(name) do { } while (0)
+#define CORELOAD_PROBE1(name, a1) do { } while (0)
+#define CORELOAD_PROBE2(name, a1, a2) do { } while (0)
+#define CORELOAD_PROBE3(name, a1, a2, a3) do { } while (0)
+#define CORELOAD_PROBE5(name, a1, a2, a3, a4, a5) do { } while (0)
+#endif
+
+#endif // USDT_H_
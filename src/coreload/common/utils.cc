@@ -1,5 +1,7 @@
 #include "utils.h"
 #include "trace.h"
+#include "startup_inputs.h"
+#include "cpprest/json.h"
 
 namespace coreload
 {
@@ -23,7 +25,7 @@ namespace coreload
     {
         pal::string_t test(candidate);
         append_path(&test, LIBCORECLR_NAME);
-        trace::verbose(_X("Checking if CoreCLR path exists=[%s]"), test.c_str());
+        TRACE_VERBOSE(_X("Checking if CoreCLR path exists=[%s]"), test.c_str());
         return pal::file_exists(test);
     }
 
@@ -239,7 +241,7 @@ namespace coreload
                 return false;
             }
 
-            trace::verbose(_X("Parsed known arg %s = %s"), arg.c_str(), argv[arg_i + 1]);
+            TRACE_VERBOSE(_X("Parsed known arg %s = %s"), arg.c_str(), argv[arg_i + 1]);
             (*opts)[arg_lower].push_back(argv[arg_i + 1]);
 
             // Increment for both the option and its value.
@@ -279,6 +281,67 @@ namespace coreload
         return true;
     }
 
+    bool skip_utf8_bom(const char** begin, const char* end)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(*begin);
+        if ((end - *begin) < 3 ||
+            (bytes[0] != 0xEF) ||
+            (bytes[1] != 0xBB) ||
+            (bytes[2] != 0xBF))
+        {
+            return false;
+        }
+
+        *begin += 3;
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Read the whole file into memory, so that it can be parsed from a contiguous
+    // buffer instead of through a stream.
+    //
+    bool read_file(const pal::string_t& path, std::vector<char>* contents)
+    {
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
+        {
+            inputs->add_file(path);
+        }
+
+        pal::ifstream_t file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            return false;
+        }
+
+        std::streamoff size = file.tellg();
+        if (size < 0)
+        {
+            return false;
+        }
+
+        contents->resize(static_cast<size_t>(size));
+        file.seekg(0, std::ios::beg);
+        if (size > 0 && !file.read(contents->data(), size))
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    void trace_json_memory(const pal::string_t& path, const web::json::document& document)
+    {
+        if (!trace::is_enabled())
+        {
+            return;
+        }
+
+        auto stats = document.get_memory_stats();
+        TRACE_VERBOSE(_X("Parsed [%s] into %zu bytes of JSON values in %zu allocations from a %zu byte arena, peak arena memory %zu bytes"),
+            path.c_str(), stats.bytes_allocated, stats.allocations, stats.bytes_reserved, stats.peak_bytes_reserved);
+    }
+
     bool get_env_shared_store_dirs(std::vector<pal::string_t>* dirs, const pal::string_t& arch, const pal::string_t& tfm)
     {
         pal::string_t path;
@@ -346,7 +409,7 @@ namespace coreload
                 recv->assign(file_path);
                 return true;
             }
-            trace::verbose(_X("Did not find [%s] directory [%s]"), env_key, file_path.c_str());
+            TRACE_VERBOSE(_X("Did not find [%s] directory [%s]"), env_key, file_path.c_str());
         }
 
         return false;
@@ -3,6 +3,14 @@
 
 #include "pal.h"
 
+namespace web
+{
+namespace json
+{
+    class document;
+}
+}
+
 namespace coreload
 {
     struct host_option
@@ -42,6 +50,9 @@ namespace coreload
         opt_map_t* opts,
         int* num_args);
     bool skip_utf8_bom(pal::ifstream_t* stream);
+    bool skip_utf8_bom(const char** begin, const char* end);
+    bool read_file(const pal::string_t& path, std::vector<char>* contents);
+    void trace_json_memory(const pal::string_t& path, const web::json::document& document);
     bool get_env_shared_store_dirs(std::vector<pal::string_t>* dirs, const pal::string_t& arch, const pal::string_t& tfm);
     bool get_global_shared_store_dirs(std::vector<pal::string_t>* dirs, const pal::string_t& arch, const pal::string_t& tfm);
     bool multilevel_lookup_enabled();
@@ -1,6 +1,7 @@
 #include <cassert>
 #include "coreclr.h"
 #include "utils.h"
+#include "trace_events.h"
 
 namespace coreload
 {
@@ -44,6 +45,8 @@ namespace coreload
     static coreclr_create_delegate_fn coreclr_create_delegate = nullptr;
     bool coreclr::bind(const pal::string_t& libcoreclr_path)
     {
+        trace_duration_t duration("coreclr::bind", libcoreclr_path);
+
         assert(g_coreclr == nullptr);
         pal::string_t coreclr_dll_path(libcoreclr_path);
         append_path(&coreclr_dll_path, LIBCORECLR_NAME);
@@ -66,6 +69,13 @@ namespace coreload
         assert(g_coreclr != nullptr && coreclr_initialize != nullptr);
 
         pal::unload_library(g_coreclr);
+
+        // The runtime can be bound again by the next start
+        g_coreclr = nullptr;
+        coreclr_initialize = nullptr;
+        coreclr_shutdown = nullptr;
+        coreclr_execute_assembly = nullptr;
+        coreclr_create_delegate = nullptr;
     }
 
     pal::hresult_t coreclr::initialize(
@@ -77,6 +87,8 @@ namespace coreload
         host_handle_t* host_handle,
         domain_id_t* domain_id)
     {
+        trace_duration_t duration("coreclr::initialize");
+
         assert(g_coreclr != nullptr && coreclr_initialize != nullptr);
 
         return coreclr_initialize(
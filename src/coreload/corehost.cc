@@ -2,18 +2,143 @@
 #include "status_code.h"
 #include "fx_muxer.h"
 #include "corehost.h"
+#include "trace_events.h"
+#include "usdt.h"
 
 namespace coreload
 {
     coreclr::domain_id_t corehost::m_domain_id = 0;
     coreclr::host_handle_t corehost::m_handle = nullptr;
+    startup_metrics_t corehost::m_startup_metrics;
+    delegate_cache_t corehost::m_delegates;
+    std::atomic<bool> corehost::m_starting(false);
+    std::mutex corehost::m_start_lock;
+    std::shared_ptr<startup_task_t> corehost::m_start_task;
+
+    static void trace_allocations(const char* name, const startup_metrics_t::allocations_t& allocations)
+    {
+        pal::string_t phase;
+        pal::utf8_palstring(name, &phase);
+        TRACE_INFO(_X("Allocations in %s: %llu, %llu bytes, peak %llu live bytes"), phase.c_str(),
+            static_cast<unsigned long long>(allocations.allocations),
+            static_cast<unsigned long long>(allocations.bytes),
+            static_cast<unsigned long long>(allocations.peak_live_bytes));
+    }
 
     int corehost::initialize_clr(
         arguments_t& arguments,
         const host_startup_info_t& host_info,
         host_mode_t mode)
     {
-        return fx_muxer_t::initialize_clr(arguments, host_info, mode, corehost::m_domain_id, corehost::m_handle);
+        wait_for_start();
+        return run_initialize_clr(arguments, host_info, mode);
+    }
+
+    int corehost::initialize_clr_async(
+        const arguments_t& arguments,
+        const host_startup_info_t& host_info,
+        host_mode_t mode,
+        startup_task_t::callback_fn callback,
+        void* context,
+        std::shared_ptr<startup_task_t>* task)
+    {
+        std::lock_guard<std::mutex> lock(m_start_lock);
+        if (m_starting.load(std::memory_order_acquire))
+        {
+            trace::error(_X("The runtime is already being started"));
+            return StatusCode::HostApiFailed;
+        }
+
+        // The runtime is ready for delegates, or failed to start, before anyone
+        // waiting on the task wakes up
+        auto start = [start_arguments = arguments, host_info, mode]() mutable
+        {
+            const int exit_code = run_initialize_clr(start_arguments, host_info, mode);
+            m_starting.store(false, std::memory_order_release);
+            return exit_code;
+        };
+
+        m_starting.store(true, std::memory_order_release);
+        *task = startup_task_t::run(start, callback, context);
+        if (*task == nullptr)
+        {
+            m_starting.store(false, std::memory_order_release);
+            return StatusCode::HostApiFailed;
+        }
+
+        m_start_task = *task;
+        return StatusCode::Success;
+    }
+
+    void corehost::wait_for_start()
+    {
+        if (!m_starting.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        std::shared_ptr<startup_task_t> task;
+        {
+            std::lock_guard<std::mutex> lock(m_start_lock);
+            task = m_start_task;
+        }
+
+        int exit_code;
+        if (task != nullptr)
+        {
+            task->wait(startup_task_t::infinite, &exit_code);
+        }
+    }
+
+    int corehost::run_initialize_clr(
+        arguments_t& arguments,
+        const host_startup_info_t& host_info,
+        host_mode_t mode)
+    {
+        // The timeline of the start goes to COREHOST_TRACE_EVENTS, if set
+        pal::string_t trace_events_path;
+        std::unique_ptr<trace_events_t> trace_events;
+        if (pal::getenv(_X("COREHOST_TRACE_EVENTS"), &trace_events_path))
+        {
+            trace_events.reset(new trace_events_t());
+        }
+
+        CORELOAD_PROBE0(startup_begin);
+        m_startup_metrics.start();
+        int exit_code;
+        {
+            startup_metrics_scope_t startup_metrics_scope(&m_startup_metrics);
+            trace_events_scope_t trace_events_scope(trace_events.get());
+            trace_duration_t duration("StartCoreCLR", arguments.managed_application);
+            exit_code = fx_muxer_t::initialize_clr(arguments, host_info, mode, corehost::m_domain_id, corehost::m_handle);
+        }
+        m_startup_metrics.stop();
+        CORELOAD_PROBE1(startup_end, exit_code);
+
+        if (allocation_tracker_t::is_enabled() && trace::is_info_enabled())
+        {
+            const auto metrics = m_startup_metrics.get_snapshot();
+            for (size_t i = 0; i < static_cast<size_t>(startup_metrics_t::phase_t::count); ++i)
+            {
+                if (metrics.phases[i].end_ns == 0)
+                {
+                    continue;
+                }
+                trace_allocations(startup_metrics_t::phase_name(static_cast<startup_metrics_t::phase_t>(i)), metrics.phase_allocations[i]);
+            }
+            trace_allocations("StartCoreCLR", metrics.allocations);
+        }
+
+        if (trace_events != nullptr && !trace_events->write(trace_events_path))
+        {
+            trace::warning(_X("Could not write the startup trace events to [%s]"), trace_events_path.c_str());
+        }
+        return exit_code;
+    }
+
+    startup_metrics_t::snapshot_t corehost::get_startup_metrics()
+    {
+        return m_startup_metrics.get_snapshot();
     }
 
     int corehost::create_delegate(
@@ -21,32 +146,127 @@ namespace coreload
         const char* type_name,
         const char* method_name,
         void** pfnDelegate)
+    {
+        assert(pfnDelegate != nullptr);
+
+        const delegate_cache_t::entry_t* entry = nullptr;
+        int exit_code = get_delegate_entry(assembly_name, type_name, method_name, &entry);
+        if (exit_code == StatusCode::Success)
+        {
+            *pfnDelegate = entry->delegate;
+        }
+        return exit_code;
+    }
+
+    int corehost::get_delegate_entry(
+        const char* assembly_name,
+        const char* type_name,
+        const char* method_name,
+        const delegate_cache_t::entry_t** entry)
     {
         assert(assembly_name != nullptr);
         assert(type_name != nullptr);
         assert(method_name != nullptr);
-        assert(pfnDelegate != nullptr);
+        assert(entry != nullptr);
+
+        *entry = m_delegates.find(assembly_name, type_name, method_name);
+        if (*entry != nullptr)
+        {
+            return StatusCode::Success;
+        }
 
-        auto hr = coreclr::create_delegate(
+        return create_runtime_delegate(assembly_name, type_name, method_name, entry);
+    }
+
+    int corehost::create_runtime_delegate(
+        const char* assembly_name,
+        const char* type_name,
+        const char* method_name,
+        const delegate_cache_t::entry_t** entry)
+    {
+        wait_for_start();
+
+        // Threads missing on the same method at once each create a delegate, and
+        // all of them get the entry of the first one added
+        void* delegate = nullptr;
+#if defined(CORELOAD_HAS_USDT)
+        const uint64_t start_ns = startup_metrics_t::now_ns();
+#endif
+        const pal::hresult_t hr = coreclr::create_delegate(
             corehost::m_handle,
             corehost::m_domain_id,
             assembly_name,
             type_name,
             method_name,
-            reinterpret_cast<VOID**>(pfnDelegate));
+            &delegate);
+#if defined(CORELOAD_HAS_USDT)
+        const uint64_t latency_ns = startup_metrics_t::now_ns() - start_ns;
+        CORELOAD_PROBE5(create_delegate, assembly_name, type_name, method_name, latency_ns, static_cast<int>(hr));
+#endif
         if (!SUCCEEDED(hr))
         {
             trace::error(_X("Failed to create delegate for managed library, HRESULT: 0x%X"), hr);
             return StatusCode::CoreClrExeFailure;
         }
 
+        *entry = m_delegates.insert(assembly_name, type_name, method_name, delegate);
+        return StatusCode::Success;
+    }
+
+    int corehost::create_delegates(
+        const delegate_name_t* names,
+        size_t count,
+        void** delegates,
+        int* statuses)
+    {
+        assert(count == 0 || (names != nullptr && delegates != nullptr && statuses != nullptr));
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const delegate_name_t& name = names[i];
+            delegates[i] = nullptr;
+            if (name.assembly == nullptr || name.type == nullptr || name.method == nullptr)
+            {
+                statuses[i] = StatusCode::InvalidArgFailure;
+                continue;
+            }
+
+            // Also finds the methods requested earlier in the batch
+            const delegate_cache_t::entry_t* entry = m_delegates.find(name.assembly, name.type, name.method);
+            if (entry != nullptr)
+            {
+                delegates[i] = entry->delegate;
+                statuses[i] = StatusCode::Success;
+                continue;
+            }
+
+            // A load failure can come from a type in the method's signature, so the
+            // other methods of the same assembly or type are still asked for
+            statuses[i] = create_runtime_delegate(name.assembly, name.type, name.method, &entry);
+            if (statuses[i] == StatusCode::Success)
+            {
+                delegates[i] = entry->delegate;
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (statuses[i] != StatusCode::Success)
+            {
+                return statuses[i];
+            }
+        }
         return StatusCode::Success;
     }
 
     int corehost::unload_runtime()
     {
+        wait_for_start();
         int exit_code = 0;
 
+        // The delegates do not outlive the runtime
+        m_delegates.clear();
+
         auto hr = coreclr::shutdown(corehost::m_handle, corehost::m_domain_id, (int*)&exit_code);
         if (!SUCCEEDED(hr))
         {
@@ -3,6 +3,10 @@
 
 #include "libhost.h"
 #include "coreclr.h"
+#include "delegate_cache.h"
+#include "startup_metrics.h"
+#include "startup_task.h"
+#include <atomic>
 
 namespace coreload
 {
@@ -16,13 +20,75 @@ namespace coreload
             const host_startup_info_t& host_info,
             host_mode_t mode);
 
+        // Starts the runtime like initialize_clr on a thread of its own. Delegates
+        // requested before it finishes wait for it, as do initialize_clr and
+        // unload_runtime. Fails if another start has not finished.
+        static int initialize_clr_async(
+            const arguments_t& arguments,
+            const host_startup_info_t& host_info,
+            host_mode_t mode,
+            startup_task_t::callback_fn callback,
+            void* context,
+            std::shared_ptr<startup_task_t>* task);
+
         static int create_delegate(
             const char* assembly,
             const char* type,
             const char* method_name,
             void** pfnDelegate);
 
+        // The cache entry of the delegate for a method, created by the runtime on
+        // the first request. The entry is valid until the runtime is unloaded.
+        static int get_delegate_entry(
+            const char* assembly,
+            const char* type,
+            const char* method_name,
+            const delegate_cache_t::entry_t** entry);
+
+        struct delegate_name_t
+        {
+            const char* assembly;
+            const char* type;
+            const char* method;
+        };
+
+        // Gets the delegates of 'count' methods, creating the ones not cached yet.
+        // 'statuses' receives the result for each method, and the first failure in
+        // their order is returned.
+        static int create_delegates(
+            const delegate_name_t* names,
+            size_t count,
+            void** delegates,
+            int* statuses);
+
         static int unload_runtime();
+
+        // Timings and counters of the last runtime start
+        static startup_metrics_t::snapshot_t get_startup_metrics();
+
+    private:
+        static int run_initialize_clr(
+            arguments_t& arguments,
+            const host_startup_info_t& host_info,
+            host_mode_t mode);
+
+        // Waits for a start made by initialize_clr_async to finish, if there is one
+        static void wait_for_start();
+
+        // Has the runtime create the delegate for a method and caches it
+        static int create_runtime_delegate(
+            const char* assembly,
+            const char* type,
+            const char* method_name,
+            const delegate_cache_t::entry_t** entry);
+
+        static startup_metrics_t m_startup_metrics;
+        static delegate_cache_t m_delegates;
+
+        // Set while a start made by initialize_clr_async is running
+        static std::atomic<bool> m_starting;
+        static std::mutex m_start_lock;
+        static std::shared_ptr<startup_task_t> m_start_task;
     };
 
 } // namespace coreload
@@ -0,0 +1,144 @@
+#include "delegate_cache.h"
+
+namespace coreload
+{
+    static const size_t initial_capacity = 16;
+
+    delegate_cache_t::table_t::table_t(size_t capacity)
+        : mask(capacity - 1)
+        , slots(new std::atomic<const entry_t*>[capacity])
+    {
+        assert((capacity & mask) == 0);
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    delegate_cache_t::delegate_cache_t()
+    {
+        m_tables.emplace_back(new table_t(initial_capacity));
+        m_table.store(m_tables.back().get(), std::memory_order_release);
+    }
+
+    size_t delegate_cache_t::hash(const char* assembly_name, const char* type_name, const char* method_name)
+    {
+        // FNV-1a over the names and their terminators, so that the boundaries count
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* name : { assembly_name, type_name, method_name })
+        {
+            const char* c = name;
+            do
+            {
+                hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+            } while (*c++ != '\0');
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    bool delegate_cache_t::matches(const entry_t& entry, size_t hash, const char* assembly_name, const char* type_name, const char* method_name)
+    {
+        return entry.hash == hash &&
+            entry.method_name == method_name &&
+            entry.type_name == type_name &&
+            entry.assembly_name == assembly_name;
+    }
+
+    void delegate_cache_t::place(table_t* table, const entry_t* entry)
+    {
+        size_t i = entry->hash & table->mask;
+        while (table->slots[i].load(std::memory_order_relaxed) != nullptr)
+        {
+            i = (i + 1) & table->mask;
+        }
+
+        // Publishes the entry, which readers load with acquire
+        table->slots[i].store(entry, std::memory_order_release);
+    }
+
+    const delegate_cache_t::entry_t* delegate_cache_t::find(const char* assembly_name, const char* type_name, const char* method_name) const
+    {
+        const size_t key = hash(assembly_name, type_name, method_name);
+        const table_t* table = m_table.load(std::memory_order_acquire);
+
+        // The table is at most half full, so the probe ends on an empty slot
+        for (size_t i = key & table->mask; ; i = (i + 1) & table->mask)
+        {
+            const entry_t* entry = table->slots[i].load(std::memory_order_acquire);
+            if (entry == nullptr)
+            {
+                return nullptr;
+            }
+            if (matches(*entry, key, assembly_name, type_name, method_name))
+            {
+                return entry;
+            }
+        }
+    }
+
+    const delegate_cache_t::entry_t* delegate_cache_t::insert(const char* assembly_name, const char* type_name, const char* method_name, void* delegate)
+    {
+        const size_t key = hash(assembly_name, type_name, method_name);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        table_t* table = m_table.load(std::memory_order_relaxed);
+        for (size_t i = key & table->mask; ; i = (i + 1) & table->mask)
+        {
+            const entry_t* entry = table->slots[i].load(std::memory_order_relaxed);
+            if (entry == nullptr)
+            {
+                break;
+            }
+            if (matches(*entry, key, assembly_name, type_name, method_name))
+            {
+                return entry;
+            }
+        }
+
+        std::unique_ptr<entry_t> entry(new entry_t());
+        entry->hash = key;
+        entry->assembly_name = assembly_name;
+        entry->type_name = type_name;
+        entry->method_name = method_name;
+        entry->delegate = delegate;
+
+        // Copies to a table twice as large once this one would be over half full.
+        // Readers still on the old table see it as it was, which only costs them
+        // a miss on the entries added since.
+        const size_t capacity = table->mask + 1;
+        if ((m_entries.size() + 1) * 2 > capacity)
+        {
+            std::unique_ptr<table_t> grown(new table_t(capacity * 2));
+            for (const auto& existing : m_entries)
+            {
+                place(grown.get(), existing.get());
+            }
+
+            table = grown.get();
+            m_tables.push_back(std::move(grown));
+            m_table.store(table, std::memory_order_release);
+        }
+
+        place(table, entry.get());
+        m_entries.push_back(std::move(entry));
+        return m_entries.back().get();
+    }
+
+    void delegate_cache_t::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        std::unique_ptr<table_t> table(new table_t(initial_capacity));
+        m_table.store(table.get(), std::memory_order_release);
+
+        m_tables.clear();
+        m_tables.push_back(std::move(table));
+        m_entries.clear();
+    }
+
+    size_t delegate_cache_t::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_entries.size();
+    }
+
+} // namespace coreload
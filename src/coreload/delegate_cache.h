@@ -0,0 +1,75 @@
+#ifndef DELEGATE_CACHE_H_
+#define DELEGATE_CACHE_H_
+
+#include "pal.h"
+#include <atomic>
+#include <mutex>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Delegates created by the runtime, keyed by the UTF-8 assembly, type and method
+    // names they were created for.
+    //
+    // Lookups take no lock: they read an open addressing table of entry pointers,
+    // which writers fill in place and only copy to a larger table when it is half
+    // full. The tables and entries a reader may still hold are kept until clear(),
+    // so an entry stays at the same address for the lifetime of the runtime and
+    // can be handed out as a handle.
+    //
+    // clear() frees the entries, and must not race with lookups or with the use of
+    // entries it returned.
+    //
+    class delegate_cache_t
+    {
+    public:
+        struct entry_t
+        {
+            size_t hash;
+            std::string assembly_name;
+            std::string type_name;
+            std::string method_name;
+            void* delegate;
+        };
+
+        delegate_cache_t();
+
+        // The entry for the names, or nullptr if no delegate was added for them
+        const entry_t* find(const char* assembly_name, const char* type_name, const char* method_name) const;
+
+        // Adds the delegate for the names and returns its entry. If another thread
+        // added one for the same names first, its entry is returned instead.
+        const entry_t* insert(const char* assembly_name, const char* type_name, const char* method_name, void* delegate);
+
+        void clear();
+
+        size_t size() const;
+
+    private:
+        struct table_t
+        {
+            explicit table_t(size_t capacity);
+
+            size_t mask;
+            std::unique_ptr<std::atomic<const entry_t*>[]> slots;
+        };
+
+        static size_t hash(const char* assembly_name, const char* type_name, const char* method_name);
+        static bool matches(const entry_t& entry, size_t hash, const char* assembly_name, const char* type_name, const char* method_name);
+
+        // Stores the entry in the first free slot of its probe sequence
+        static void place(table_t* table, const entry_t* entry);
+
+        std::atomic<table_t*> m_table;
+
+        // Held by writers only
+        mutable std::mutex m_lock;
+
+        // The current table and the ones it replaced
+        std::vector<std::unique_ptr<table_t>> m_tables;
+        std::vector<std::unique_ptr<entry_t>> m_entries;
+    };
+
+} // namespace coreload
+
+#endif // DELEGATE_CACHE_H_
@@ -36,12 +36,12 @@ namespace coreload
         const pal::char_t* query_type = look_in_base ? _X("Local") : _X("Relative");
         if (!exists)
         {
-            trace::verbose(_X("    %s path query did not exist %s"), query_type, candidate.c_str());
+            TRACE_VERBOSE(_X("    %s path query did not exist %s"), query_type, candidate.c_str());
             candidate.clear();
         }
         else
         {
-            trace::verbose(_X("    %s path query exists %s"), query_type, candidate.c_str());
+            TRACE_VERBOSE(_X("    %s path query exists %s"), query_type, candidate.c_str());
         }
         return exists;
     }
@@ -80,7 +80,7 @@ namespace coreload
 
             pal::string_t base_ietf_dir = base;
             append_path(&base_ietf_dir, ietf.c_str());
-            trace::verbose(_X("Detected a resource asset, will query dir/ietf-tag/resource base: %s asset: %s"), base_ietf_dir.c_str(), asset.name.c_str());
+            TRACE_VERBOSE(_X("Detected a resource asset, will query dir/ietf-tag/resource base: %s asset: %s"), base_ietf_dir.c_str(), asset.name.c_str());
             return to_path(base_ietf_dir, true, str);
         }
         return to_path(base, true, str);
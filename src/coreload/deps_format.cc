@@ -1,11 +1,17 @@
 #include "deps_entry.h"
 #include "deps_format.h"
+#include "deps_image.h"
+#include "startup_inputs.h"
+#include "startup_metrics.h"
+#include "trace_events.h"
+#include "usdt.h"
 #include "utils.h"
 #include "trace.h"
 #include <array>
 #include <iterator>
 #include <cassert>
 #include <functional>
+#include <algorithm>
 
 namespace coreload
 {
@@ -23,6 +29,31 @@ namespace coreload
         return entry;
     }
 
+    static void to_native_separators(pal::string_t* path)
+    {
+        if (path->length() > 0 && _X('/') != DIR_SEPARATOR)
+        {
+            replace_char(path, _X('/'), DIR_SEPARATOR);
+        }
+    }
+
+    static deps_asset_t make_asset(const pal::string_t& file, const pal::string_t& assembly_version_str, const pal::string_t& file_version_str)
+    {
+        version_t assembly_version, file_version;
+
+        if (assembly_version_str.length() > 0)
+        {
+            version_t::parse(assembly_version_str, &assembly_version);
+        }
+
+        if (file_version_str.length() > 0)
+        {
+            version_t::parse(file_version_str, &file_version);
+        }
+
+        return deps_asset_t(get_filename_without_ext(file), file, assembly_version, file_version);
+    }
+
     pal::string_t deps_json_t::get_optional_property(
         const json_object& properties,
         const pal::string_t& key) const
@@ -44,12 +75,7 @@ namespace coreload
         const pal::string_t& key) const
     {
         pal::string_t path = get_optional_property(properties, key);
-
-        if (path.length() > 0 && _X('/') != DIR_SEPARATOR)
-        {
-            replace_char(&path, _X('/'), DIR_SEPARATOR);
-        }
-
+        to_native_separators(&path);
         return path;
     }
 
@@ -57,78 +83,101 @@ namespace coreload
         const pal::string_t& deps_path,
         const json_value& json,
         const std::function<bool(const pal::string_t&)>& library_exists_fn,
-        const std::function<const vec_asset_t&(const pal::string_t&, int, bool*)>& get_assets_fn)
+        const get_assets_fn_t& get_assets_fn)
     {
         pal::string_t deps_file = get_filename(deps_path);
 
         const auto& libraries = json.at(_X("libraries")).as_object();
         for (const auto& library : libraries)
         {
-            trace::info(_X("Reconciling library %s"), library.first.c_str());
+            TRACE_INFO(_X("Reconciling library %s"), library.first.c_str());
 
             if (!library_exists_fn(library.first))
             {
-                trace::info(_X("Library %s does not exist"), library.first.c_str());
+                TRACE_INFO(_X("Library %s does not exist"), library.first.c_str());
                 continue;
             }
 
             const auto& properties = library.second.as_object();
 
-            const pal::string_t& hash = properties.at(_X("sha512")).as_string();
-            bool serviceable = properties.at(_X("serviceable")).as_bool();
+            library_properties_t library_properties;
+            library_properties.hash = properties.at(_X("sha512")).as_string();
+            library_properties.serviceable = properties.at(_X("serviceable")).as_bool();
+            library_properties.path = get_optional_path(properties, _X("path"));
+            library_properties.hash_path = get_optional_path(properties, _X("hashPath"));
+            library_properties.runtime_store_manifest_list = get_optional_path(properties, _X("runtimeStoreManifestName"));
 
-            pal::string_t library_path = get_optional_path(properties, _X("path"));
-            pal::string_t library_hash_path = get_optional_path(properties, _X("hashPath"));
-            pal::string_t runtime_store_manifest_list = get_optional_path(properties, _X("runtimeStoreManifestName"));
+            // The type is only required for libraries which have assets.
+            const auto& type = properties.find(_X("type"));
+            if (type != properties.end() && type->second.is_string())
+            {
+                library_properties.type = pal::to_lower(type->second.as_string());
+                library_properties.has_type = true;
+            }
 
-            for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+            add_library_entries(deps_file, library.first, library_properties, get_assets_fn);
+        }
+    }
+
+    void deps_json_t::add_library_entries(
+        const pal::string_t& deps_file,
+        const pal::string_t& library,
+        const library_properties_t& properties,
+        const get_assets_fn_t& get_assets_fn)
+    {
+        for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+        {
+            bool rid_specific = false;
+            for (const auto& asset : get_assets_fn(library, i, &rid_specific))
             {
-                bool rid_specific = false;
-                for (const auto& asset : get_assets_fn(library.first, i, &rid_specific))
+                if (!properties.has_type)
                 {
-                    bool ni_dll = false;
-                    auto asset_name = asset.name;
-                    if (ends_with(asset_name, _X(".ni"), false))
-                    {
-                        ni_dll = true;
-                        asset_name = strip_file_ext(asset_name);
-                    }
+                    pal::string_t message = _X("Library ") + library + _X(" does not have a type");
+                    throw web::json::json_exception(message.c_str());
+                }
 
-                    deps_entry_t entry;
-                    size_t pos = library.first.find(_X("/"));
-                    entry.library_name = library.first.substr(0, pos);
-                    entry.library_version = library.first.substr(pos + 1);
-                    entry.library_type = pal::to_lower(properties.at(_X("type")).as_string());
-                    entry.library_hash = hash;
-                    entry.library_path = library_path;
-                    entry.library_hash_path = library_hash_path;
-                    entry.runtime_store_manifest_list = runtime_store_manifest_list;
-                    entry.asset_type = (deps_entry_t::asset_types) i;
-                    entry.is_serviceable = serviceable;
-                    entry.is_rid_specific = rid_specific;
-                    entry.deps_file = deps_file;
-                    entry.asset = asset;
-                    entry.asset.name = asset_name;
-
-                    m_deps_entries[i].push_back(entry);
-
-                    if (ni_dll)
-                    {
-                        m_ni_entries[entry.asset.name] = m_deps_entries
-                            [deps_entry_t::asset_types::runtime].size() - 1;
-                    }
+                bool ni_dll = false;
+                auto asset_name = asset.name;
+                if (ends_with(asset_name, _X(".ni"), false))
+                {
+                    ni_dll = true;
+                    asset_name = strip_file_ext(asset_name);
+                }
 
-                    trace::info(_X("Parsed %s deps entry %d for asset name: %s from %s: %s, library version: %s, relpath: %s, assemblyVersion %s, fileVersion %s"),
-                        deps_entry_t::s_known_asset_types[i],
-                        m_deps_entries[i].size() - 1,
-                        entry.asset.name.c_str(),
-                        entry.library_type.c_str(),
-                        entry.library_name.c_str(),
-                        entry.library_version.c_str(),
-                        entry.asset.relative_path.c_str(),
-                        entry.asset.assembly_version.as_str().c_str(),
-                        entry.asset.file_version.as_str().c_str());
+                deps_entry_t entry;
+                size_t pos = library.find(_X("/"));
+                entry.library_name = library.substr(0, pos);
+                entry.library_version = library.substr(pos + 1);
+                entry.library_type = properties.type;
+                entry.library_hash = properties.hash;
+                entry.library_path = properties.path;
+                entry.library_hash_path = properties.hash_path;
+                entry.runtime_store_manifest_list = properties.runtime_store_manifest_list;
+                entry.asset_type = (deps_entry_t::asset_types) i;
+                entry.is_serviceable = properties.serviceable;
+                entry.is_rid_specific = rid_specific;
+                entry.deps_file = deps_file;
+                entry.asset = asset;
+                entry.asset.name = asset_name;
+
+                m_deps_entries[i].push_back(entry);
+
+                if (ni_dll)
+                {
+                    m_ni_entries[entry.asset.name] = m_deps_entries
+                        [deps_entry_t::asset_types::runtime].size() - 1;
                 }
+
+                TRACE_INFO(_X("Parsed %s deps entry %d for asset name: %s from %s: %s, library version: %s, relpath: %s, assemblyVersion %s, fileVersion %s"),
+                    deps_entry_t::s_known_asset_types[i],
+                    m_deps_entries[i].size() - 1,
+                    entry.asset.name.c_str(),
+                    entry.library_type.c_str(),
+                    entry.library_name.c_str(),
+                    entry.library_version.c_str(),
+                    entry.asset.relative_path.c_str(),
+                    entry.asset.assembly_version.as_str().c_str(),
+                    entry.asset.file_version.as_str().c_str());
             }
         }
     }
@@ -147,7 +196,7 @@ namespace coreload
             }
         }
 
-        trace::info(_X("HostRID is %s"), currentRid.empty() ? _X("not available") : currentRid.c_str());
+        TRACE_INFO(_X("HostRID is %s"), currentRid.empty() ? _X("not available") : currentRid.c_str());
 
         // If the current RID is not present in the RID fallback graph, then the platform
         // is unknown to us. At this point, we will fallback to using the base RIDs and attempt
@@ -158,16 +207,14 @@ namespace coreload
         {
             currentRid = pal::get_current_os_fallback_rid() + pal::string_t(_X("-")) + get_arch();
 
-            trace::info(_X("Falling back to base HostRID: %s"), currentRid.c_str());
+            TRACE_INFO(_X("Falling back to base HostRID: %s"), currentRid.c_str());
         }
 
         return currentRid;
     }
 
-    bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph)
+    bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
     {
-        pal::string_t host_rid = get_current_rid(rid_fallback_graph);
-
         for (auto& package : portable_assets->libs)
         {
             pal::string_t matched_rid = package.second.rid_assets.count(host_rid) ? host_rid : _X("");
@@ -199,7 +246,7 @@ namespace coreload
             {
                 if (iter->first != matched_rid)
                 {
-                    trace::verbose(_X("Chose %s, so removing rid (%s) specific assets for package %s"), matched_rid.c_str(), iter->first.c_str(), package.first.c_str());
+                    TRACE_VERBOSE(_X("Chose %s, so removing rid (%s) specific assets for package %s"), matched_rid.c_str(), iter->first.c_str(), package.first.c_str());
                     iter = package.second.rid_assets.erase(iter);
                 }
                 else
@@ -212,7 +259,7 @@ namespace coreload
     }
 
 
-    bool deps_json_t::process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, rid_specific_assets_t* p_assets)
+    bool deps_json_t::process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid, rid_specific_assets_t* p_assets)
     {
         rid_specific_assets_t& assets = *p_assets;
         for (const auto& package : json.at(_X("targets")).at(target_name).as_object())
@@ -233,25 +280,13 @@ namespace coreload
                     if (pal::strcasecmp(type.c_str(), deps_entry_t::s_known_asset_types[i]) == 0)
                     {
                         const auto& rid = file.second.at(_X("rid")).as_string();
-
-                        version_t assembly_version, file_version;
                         const auto& properties = file.second.as_object();
 
-                        pal::string_t assembly_version_str = get_optional_property(properties, _X("assemblyVersion"));
-                        if (assembly_version_str.length() > 0)
-                        {
-                            version_t::parse(assembly_version_str, &assembly_version);
-                        }
-
-                        pal::string_t file_version_str = get_optional_property(properties, _X("fileVersion"));
-                        if (file_version_str.length() > 0)
-                        {
-                            version_t::parse(file_version_str, &file_version);
-                        }
+                        deps_asset_t asset = make_asset(file.first,
+                            get_optional_property(properties, _X("assemblyVersion")),
+                            get_optional_property(properties, _X("fileVersion")));
 
-                        deps_asset_t asset(get_filename_without_ext(file.first), file.first, assembly_version, file_version);
-
-                        trace::info(_X("Adding runtimeTargets %s asset %s rid=%s assemblyVersion=%s fileVersion=%s from %s"),
+                        TRACE_INFO(_X("Adding runtimeTargets %s asset %s rid=%s assemblyVersion=%s fileVersion=%s from %s"),
                             deps_entry_t::s_known_asset_types[i],
                             asset.relative_path.c_str(),
                             rid.c_str(),
@@ -265,7 +300,7 @@ namespace coreload
             }
         }
 
-        if (!perform_rid_fallback(&assets, rid_fallback_graph))
+        if (!perform_rid_fallback(&assets, rid_fallback_graph, host_rid))
         {
             return false;
         }
@@ -287,23 +322,12 @@ namespace coreload
                     for (const auto& file : iter->second.as_object())
                     {
                         const auto& properties = file.second.as_object();
-                        version_t assembly_version, file_version;
-
-                        pal::string_t assembly_version_str = get_optional_property(properties, _X("assemblyVersion"));
-                        if (assembly_version_str.length() > 0)
-                        {
-                            version_t::parse(assembly_version_str, &assembly_version);
-                        }
-
-                        pal::string_t file_version_str = get_optional_property(properties, _X("fileVersion"));
-                        if (file_version_str.length() > 0)
-                        {
-                            version_t::parse(file_version_str, &file_version);
-                        }
 
-                        deps_asset_t asset(get_filename_without_ext(file.first), file.first, assembly_version, file_version);
+                        deps_asset_t asset = make_asset(file.first,
+                            get_optional_property(properties, _X("assemblyVersion")),
+                            get_optional_property(properties, _X("fileVersion")));
 
-                        trace::info(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
+                        TRACE_INFO(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
                             deps_entry_t::s_known_asset_types[i],
                             asset.relative_path.c_str(),
                             asset.assembly_version.as_str().c_str(),
@@ -318,9 +342,45 @@ namespace coreload
         return true;
     }
 
-    bool deps_json_t::load_framework_dependent(const pal::string_t& deps_path, const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph)
+    bool deps_json_t::library_exists(bool is_framework_dependent, const pal::string_t& package) const
     {
-        if (!process_runtime_targets(json, target_name, rid_fallback_graph, &m_rid_assets))
+        return (is_framework_dependent && m_rid_assets.libs.count(package)) || m_assets.libs.count(package);
+    }
+
+    const deps_json_t::vec_asset_t& deps_json_t::get_library_assets(bool is_framework_dependent, const pal::string_t& package, int type_index, bool* rid_specific)
+    {
+        *rid_specific = false;
+
+        if (!is_framework_dependent)
+        {
+            return m_assets.libs[package][type_index];
+        }
+
+        // Is there any rid specific assets for this type ("native" or "runtime" or "resources")
+        if (m_rid_assets.libs.count(package) && !m_rid_assets.libs[package].rid_assets.empty())
+        {
+            const auto& assets_by_type = m_rid_assets.libs[package].rid_assets.begin()->second[type_index];
+            if (!assets_by_type.empty())
+            {
+                *rid_specific = true;
+                return assets_by_type;
+            }
+
+            TRACE_VERBOSE(_X("There were no rid specific %s asset for %s"), deps_entry_t::s_known_asset_types[type_index], package.c_str());
+        }
+
+        if (m_assets.libs.count(package))
+        {
+            return m_assets.libs[package][type_index];
+        }
+
+        static const vec_asset_t empty;
+        return empty;
+    }
+
+    bool deps_json_t::load_framework_dependent(const pal::string_t& deps_path, const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
+    {
+        if (!process_runtime_targets(json, target_name, rid_fallback_graph, host_rid, &m_rid_assets))
         {
             return false;
         }
@@ -331,33 +391,11 @@ namespace coreload
         }
 
         auto package_exists = [&](const pal::string_t& package) -> bool {
-            return m_rid_assets.libs.count(package) || m_assets.libs.count(package);
+            return library_exists(true, package);
         };
 
-        const vec_asset_t empty;
         auto get_relpaths = [&](const pal::string_t& package, int type_index, bool* rid_specific) -> const vec_asset_t& {
-
-            *rid_specific = false;
-
-            // Is there any rid specific assets for this type ("native" or "runtime" or "resources")
-            if (m_rid_assets.libs.count(package) && !m_rid_assets.libs[package].rid_assets.empty())
-            {
-                const auto& assets_by_type = m_rid_assets.libs[package].rid_assets.begin()->second[type_index];
-                if (!assets_by_type.empty())
-                {
-                    *rid_specific = true;
-                    return assets_by_type;
-                }
-
-                trace::verbose(_X("There were no rid specific %s asset for %s"), deps_entry_t::s_known_asset_types[type_index], package.c_str());
-            }
-
-            if (m_assets.libs.count(package))
-            {
-                return m_assets.libs[package][type_index];
-            }
-
-            return empty;
+            return get_library_assets(true, package, type_index, rid_specific);
         };
 
         reconcile_libraries_with_targets(deps_path, json, package_exists, get_relpaths);
@@ -373,12 +411,11 @@ namespace coreload
         }
 
         auto package_exists = [&](const pal::string_t& package) -> bool {
-            return m_assets.libs.count(package);
+            return library_exists(false, package);
         };
 
         auto get_relpaths = [&](const pal::string_t& package, int type_index, bool* rid_specific) -> const vec_asset_t& {
-            *rid_specific = false;
-            return m_assets.libs[package][type_index];
+            return get_library_assets(false, package, type_index, rid_specific);
         };
 
         reconcile_libraries_with_targets(deps_path, json, package_exists, get_relpaths);
@@ -397,21 +434,26 @@ namespace coreload
             }
         }
 
+        trace_rid_fallback_graph();
+        return true;
+    }
+
+    void deps_json_t::trace_rid_fallback_graph() const
+    {
         if (trace::is_enabled())
         {
-            trace::verbose(_X("The rid fallback graph is: {"));
+            TRACE_VERBOSE(_X("The rid fallback graph is: {"));
             for (const auto& rid : m_rid_fallback_graph)
             {
-                trace::verbose(_X("%s => ["), rid.first.c_str());
+                TRACE_VERBOSE(_X("%s => ["), rid.first.c_str());
                 for (const auto& fallback : rid.second)
                 {
-                    trace::verbose(_X("%s, "), fallback.c_str());
+                    TRACE_VERBOSE(_X("%s, "), fallback.c_str());
                 }
-                trace::verbose(_X("]"));
+                TRACE_VERBOSE(_X("]"));
             }
-            trace::verbose(_X("}"));
+            TRACE_VERBOSE(_X("}"));
         }
-        return true;
     }
 
     bool deps_json_t::has_package(const pal::string_t& name, const pal::string_t& ver) const
@@ -420,60 +462,589 @@ namespace coreload
         pv.push_back(_X('/'));
         pv.append(ver);
 
-        auto iter = m_rid_assets.libs.find(pv);
-        if (iter != m_rid_assets.libs.end())
+        return m_packages.count(pv) != 0;
+    }
+
+    // Packages which have assets for the target, after rid fallback; see has_package.
+    void deps_json_t::collect_packages()
+    {
+        m_packages.clear();
+        for (const auto& package : m_rid_assets.libs)
         {
-            if (!iter->second.rid_assets.empty())
+            if (!package.second.rid_assets.empty())
             {
-                return true;
+                m_packages.insert(package.first);
             }
         }
 
-        return m_assets.libs.count(pv);
+        for (const auto& package : m_assets.libs)
+        {
+            m_packages.insert(package.first);
+        }
+    }
+
+    bool deps_json_t::load_dom(bool is_framework_dependent, const pal::string_t& deps_path, const char* begin, const char* end, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
+    {
+        const auto document = web::json::document::parse(begin, end);
+        trace_json_memory(deps_path, document);
+        const auto& json = document.root();
+
+        const auto& runtime_target = json.at(_X("runtimeTarget"));
+
+        const pal::string_t& name = runtime_target.is_string() ?
+            runtime_target.as_string() :
+            runtime_target.at(_X("name")).as_string();
+
+        TRACE_VERBOSE(_X("Loading deps file... %s as framework dependent=[%d]"), deps_path.c_str(), is_framework_dependent);
+
+        return (is_framework_dependent) ? load_framework_dependent(deps_path, json, name, rid_fallback_graph, host_rid) : load_self_contained(deps_path, json, name);
+    }
+
+    // -----------------------------------------------------------------------------
+    // Streaming parser
+    //
+    // Reads the deps file token by token and keeps only what the entries are made
+    // of. The results match the DOM parser, which visits object members sorted by
+    // key: assets and libraries are sorted the same way before they are added.
+    //
+    static void expect_token(web::json::reader& reader, web::json::reader::token_type type, const pal::char_t* message)
+    {
+        if (reader.type() != type)
+        {
+            throw web::json::json_exception(message);
+        }
+    }
+
+    // Reads a string property value, or flags it as an error if it is not a string.
+    static void read_string_property(web::json::reader& reader, pal::string_t* value, bool* valid)
+    {
+        if (reader.read() == web::json::reader::String)
+        {
+            value->assign(reader.as_string());
+            *valid = true;
+        }
+        else
+        {
+            reader.skip();
+            *valid = false;
+        }
+    }
+
+    template <typename T>
+    static void sort_by_key(std::vector<std::pair<pal::string_t, T>>* items)
+    {
+        std::stable_sort(items->begin(), items->end(),
+            [](const std::pair<pal::string_t, T>& a, const std::pair<pal::string_t, T>& b) { return a.first < b.first; });
+    }
+
+    void deps_json_t::read_assets(web::json::reader& reader, const pal::string_t& package, int type_index, deps_assets_t* p_assets)
+    {
+        reader.read();
+        expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+        std::vector<std::pair<pal::string_t, deps_asset_t>> files;
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            pal::string_t file = reader.as_string();
+
+            reader.read();
+            expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+            pal::string_t assembly_version_str;
+            pal::string_t file_version_str;
+            while (reader.read() == web::json::reader::PropertyName)
+            {
+                const auto& key = reader.as_string();
+                pal::string_t* value = (key == _X("assemblyVersion")) ? &assembly_version_str :
+                    (key == _X("fileVersion")) ? &file_version_str : nullptr;
+                if (value == nullptr)
+                {
+                    reader.skip();
+                    continue;
+                }
+
+                reader.read();
+                value->assign(reader.as_string());
+            }
+
+            deps_asset_t asset = make_asset(file, assembly_version_str, file_version_str);
+            files.emplace_back(std::move(file), std::move(asset));
+        }
+
+        sort_by_key(&files);
+
+        for (auto& file : files)
+        {
+            const deps_asset_t& asset = file.second;
+            TRACE_INFO(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
+                deps_entry_t::s_known_asset_types[type_index],
+                asset.relative_path.c_str(),
+                asset.assembly_version.as_str().c_str(),
+                asset.file_version.as_str().c_str(),
+                package.c_str());
+
+            p_assets->libs[package][type_index].push_back(std::move(file.second));
+        }
+    }
+
+    void deps_json_t::read_runtime_targets(web::json::reader& reader, const pal::string_t& package, rid_specific_assets_t* p_assets)
+    {
+        struct runtime_target_t
+        {
+            pal::string_t asset_type;
+            pal::string_t rid;
+            pal::string_t assembly_version;
+            pal::string_t file_version;
+            bool has_asset_type;
+            bool has_rid;
+            bool has_valid_versions;
+        };
+
+        reader.read();
+        expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+        std::vector<std::pair<pal::string_t, runtime_target_t>> files;
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            pal::string_t file = reader.as_string();
+
+            reader.read();
+            expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+            runtime_target_t target = { };
+            target.has_valid_versions = true;
+            while (reader.read() == web::json::reader::PropertyName)
+            {
+                const auto& key = reader.as_string();
+                bool valid = false;
+                if (key == _X("assetType"))
+                {
+                    read_string_property(reader, &target.asset_type, &target.has_asset_type);
+                }
+                else if (key == _X("rid"))
+                {
+                    read_string_property(reader, &target.rid, &target.has_rid);
+                }
+                else if (key == _X("assemblyVersion"))
+                {
+                    read_string_property(reader, &target.assembly_version, &valid);
+                    target.has_valid_versions &= valid;
+                }
+                else if (key == _X("fileVersion"))
+                {
+                    read_string_property(reader, &target.file_version, &valid);
+                    target.has_valid_versions &= valid;
+                }
+                else
+                {
+                    reader.skip();
+                }
+            }
+
+            files.emplace_back(std::move(file), std::move(target));
+        }
+
+        sort_by_key(&files);
+
+        for (const auto& file : files)
+        {
+            const runtime_target_t& target = file.second;
+            if (!target.has_asset_type)
+            {
+                throw web::json::json_exception(_X("Key not found"));
+            }
+
+            for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+            {
+                if (pal::strcasecmp(target.asset_type.c_str(), deps_entry_t::s_known_asset_types[i]) != 0)
+                {
+                    continue;
+                }
+
+                if (!target.has_rid || !target.has_valid_versions)
+                {
+                    throw web::json::json_exception(_X("not a string"));
+                }
+
+                deps_asset_t asset = make_asset(file.first, target.assembly_version, target.file_version);
+
+                TRACE_INFO(_X("Adding runtimeTargets %s asset %s rid=%s assemblyVersion=%s fileVersion=%s from %s"),
+                    deps_entry_t::s_known_asset_types[i],
+                    asset.relative_path.c_str(),
+                    target.rid.c_str(),
+                    asset.assembly_version.as_str().c_str(),
+                    asset.file_version.as_str().c_str(),
+                    package.c_str());
+
+                p_assets->libs[package].rid_assets[target.rid][i].push_back(std::move(asset));
+            }
+        }
+    }
+
+    void deps_json_t::read_target(web::json::reader& reader, const pal::string_t& target_name, bool read_runtime_targets, target_assets_t* p_target)
+    {
+        TRACE_VERBOSE(_X("Reading target %s"), target_name.c_str());
+
+        reader.read();
+        expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            pal::string_t package = reader.as_string();
+
+            reader.read();
+            expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+            while (reader.read() == web::json::reader::PropertyName)
+            {
+                const auto& key = reader.as_string();
+                if (read_runtime_targets && key == _X("runtimeTargets"))
+                {
+                    this->read_runtime_targets(reader, package, &p_target->rid_assets);
+                    continue;
+                }
+
+                bool known_type = false;
+                for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+                {
+                    if (key == deps_entry_t::s_known_asset_types[i])
+                    {
+                        read_assets(reader, package, i, &p_target->assets);
+                        known_type = true;
+                        break;
+                    }
+                }
+
+                if (!known_type)
+                {
+                    reader.skip();
+                }
+            }
+        }
+    }
+
+    void deps_json_t::read_library(web::json::reader& reader, library_record_t* p_library)
+    {
+        if (reader.read() != web::json::reader::BeginObject)
+        {
+            reader.skip();
+            p_library->error = _X("not an object");
+            return;
+        }
+
+        library_properties_t& properties = p_library->properties;
+        bool has_hash = false;
+        bool has_serviceable = false;
+        bool valid = true;
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            const auto& key = reader.as_string();
+            if (key == _X("sha512"))
+            {
+                read_string_property(reader, &properties.hash, &has_hash);
+            }
+            else if (key == _X("serviceable"))
+            {
+                has_serviceable = reader.read() == web::json::reader::Boolean;
+                if (has_serviceable)
+                {
+                    properties.serviceable = reader.as_bool();
+                }
+                else
+                {
+                    reader.skip();
+                }
+            }
+            else if (key == _X("type"))
+            {
+                read_string_property(reader, &properties.type, &properties.has_type);
+                properties.type = pal::to_lower(properties.type);
+            }
+            else if (key == _X("path") || key == _X("hashPath") || key == _X("runtimeStoreManifestName"))
+            {
+                pal::string_t* path = (key == _X("path")) ? &properties.path :
+                    (key == _X("hashPath")) ? &properties.hash_path : &properties.runtime_store_manifest_list;
+                bool is_string = false;
+                read_string_property(reader, path, &is_string);
+                to_native_separators(path);
+                valid &= is_string;
+            }
+            else
+            {
+                reader.skip();
+            }
+        }
+
+        if (!has_hash || !has_serviceable)
+        {
+            p_library->error = _X("Key not found");
+        }
+        else if (!valid)
+        {
+            p_library->error = _X("not a string");
+        }
+    }
+
+    void deps_json_t::read_rid_fallback_graph(web::json::reader& reader, rid_fallback_graph_t* p_graph)
+    {
+        reader.read();
+        expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            auto& vec = (*p_graph)[reader.as_string()];
+
+            reader.read();
+            expect_token(reader, web::json::reader::BeginArray, _X("not an array"));
+            while (reader.read() != web::json::reader::EndArray)
+            {
+                vec.push_back(reader.as_string());
+            }
+        }
+    }
+
+    bool deps_json_t::load_stream(bool is_framework_dependent, const pal::string_t& deps_path, const char* begin, const char* end, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
+    {
+        web::json::reader reader(begin, end);
+
+        reader.read();
+        expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+        pal::string_t target_name;
+        bool has_runtime_target = false;
+        bool has_target = false;
+        bool has_libraries = false;
+        std::vector<library_record_t> libraries;
+        rid_fallback_graph_t rid_fallback_graph_read;
+
+        // Targets which appear before "runtimeTarget" are kept until we know which one to use.
+        std::unordered_map<pal::string_t, target_assets_t> pending_targets;
+
+        while (reader.read() == web::json::reader::PropertyName)
+        {
+            const auto& key = reader.as_string();
+            if (key == _X("runtimeTarget"))
+            {
+                if (reader.read() == web::json::reader::String)
+                {
+                    target_name = reader.as_string();
+                    has_runtime_target = true;
+                    continue;
+                }
+
+                expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+                while (reader.read() == web::json::reader::PropertyName)
+                {
+                    if (reader.as_string() == _X("name"))
+                    {
+                        reader.read();
+                        target_name = reader.as_string();
+                        has_runtime_target = true;
+                    }
+                    else
+                    {
+                        reader.skip();
+                    }
+                }
+
+                if (!has_runtime_target)
+                {
+                    throw web::json::json_exception(_X("Key not found"));
+                }
+            }
+            else if (key == _X("targets"))
+            {
+                reader.read();
+                expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+                while (reader.read() == web::json::reader::PropertyName)
+                {
+                    pal::string_t name = reader.as_string();
+                    if (!has_runtime_target)
+                    {
+                        read_target(reader, name, is_framework_dependent, &pending_targets[name]);
+                    }
+                    else if (name == target_name && !has_target)
+                    {
+                        target_assets_t target;
+                        read_target(reader, name, is_framework_dependent, &target);
+                        m_assets = std::move(target.assets);
+                        m_rid_assets = std::move(target.rid_assets);
+                        has_target = true;
+                    }
+                    else
+                    {
+                        reader.skip();
+                    }
+                }
+            }
+            else if (key == _X("libraries"))
+            {
+                reader.read();
+                expect_token(reader, web::json::reader::BeginObject, _X("not an object"));
+
+                while (reader.read() == web::json::reader::PropertyName)
+                {
+                    libraries.emplace_back();
+                    libraries.back().name = reader.as_string();
+                    read_library(reader, &libraries.back());
+                }
+                has_libraries = true;
+            }
+            else if (key == _X("runtimes") && !is_framework_dependent)
+            {
+                read_rid_fallback_graph(reader, &rid_fallback_graph_read);
+            }
+            else
+            {
+                reader.skip();
+            }
+        }
+
+        // Reject anything after the root object.
+        reader.read();
+
+        if (!has_runtime_target)
+        {
+            throw web::json::json_exception(_X("Key not found"));
+        }
+
+        TRACE_VERBOSE(_X("Loading deps file... %s as framework dependent=[%d]"), deps_path.c_str(), is_framework_dependent);
+
+        if (!has_target)
+        {
+            auto iter = pending_targets.find(target_name);
+            if (iter == pending_targets.end())
+            {
+                throw web::json::json_exception(_X("Key not found"));
+            }
+
+            m_assets = std::move(iter->second.assets);
+            m_rid_assets = std::move(iter->second.rid_assets);
+        }
+
+        if (is_framework_dependent && !perform_rid_fallback(&m_rid_assets, rid_fallback_graph, host_rid))
+        {
+            return false;
+        }
+
+        if (!has_libraries)
+        {
+            throw web::json::json_exception(_X("Key not found"));
+        }
+
+        std::stable_sort(libraries.begin(), libraries.end(),
+            [](const library_record_t& a, const library_record_t& b) { return a.name < b.name; });
+
+        pal::string_t deps_file = get_filename(deps_path);
+        const get_assets_fn_t get_assets_fn = [&](const pal::string_t& package, int type_index, bool* rid_specific) -> const vec_asset_t& {
+            return get_library_assets(is_framework_dependent, package, type_index, rid_specific);
+        };
+
+        for (const auto& library : libraries)
+        {
+            TRACE_INFO(_X("Reconciling library %s"), library.name.c_str());
+
+            if (!library_exists(is_framework_dependent, library.name))
+            {
+                TRACE_INFO(_X("Library %s does not exist"), library.name.c_str());
+                continue;
+            }
+
+            if (!library.error.empty())
+            {
+                throw web::json::json_exception(library.error.c_str());
+            }
+
+            add_library_entries(deps_file, library.name, library.properties, get_assets_fn);
+        }
+
+        if (!is_framework_dependent)
+        {
+            m_rid_fallback_graph = std::move(rid_fallback_graph_read);
+            trace_rid_fallback_graph();
+        }
+
+        return true;
     }
 
     // -----------------------------------------------------------------------------
     // Load the deps file and parse its "entry" lines which contain the "fields" of
     // the entry. Populate an array of these entries.
     //
-    bool deps_json_t::load(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph)
+    bool deps_json_t::load(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
     {
+        trace_duration_t duration("deps_json_t::load", deps_path);
+
         m_deps_file = deps_path;
         m_file_exists = pal::file_exists(deps_path);
 
         // If file doesn't exist, then assume parsed.
         if (!m_file_exists)
         {
-            trace::verbose(_X("Could not locate the dependencies manifest file [%s]. Some libraries may fail to resolve."), deps_path.c_str());
+            TRACE_VERBOSE(_X("Could not locate the dependencies manifest file [%s]. Some libraries may fail to resolve."), deps_path.c_str());
             return true;
         }
 
-        // Somehow the file stream could not be opened. This is an error.
-        pal::ifstream_t file(deps_path);
-        if (!file.good())
+        // The parsed state depends on the deps file whether it is read or loaded from an image.
+        startup_inputs_t* inputs = startup_inputs_t::active();
+        if (inputs != nullptr)
         {
-            trace::error(_X("Could not open dependencies manifest file [%s]"), deps_path.c_str());
-            return false;
+            inputs->add_file(deps_path);
         }
 
-        if (skip_utf8_bom(&file))
+        // Precompiled deps files are a cache of the streaming parser's results.
+        std::vector<char> contents;
+        bool contents_read = false;
+        m_image_source = image_source_t();
+        bool use_images = m_parse_mode == parse_mode_t::stream && pal::get_file_stamp(deps_path, &m_image_source.stamp);
+        if (use_images)
         {
-            trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), deps_path.c_str());
+            m_image_source.inputs_hash = get_image_inputs_hash(is_framework_dependent, rid_fallback_graph, host_rid);
+
+            const pal::string_t image_paths[] = { deps_image::get_sibling_path(deps_path), deps_image::get_cache_path(deps_path) };
+            for (const auto& image_path : image_paths)
+            {
+                if (!image_path.empty() && load_image(image_path, &contents, &contents_read))
+                {
+                    CORELOAD_PROBE3(deps_json_load, deps_path.c_str(), m_image_source.stamp.size, 1);
+                    if (!is_framework_dependent)
+                    {
+                        trace_rid_fallback_graph();
+                    }
+                    return true;
+                }
+            }
         }
 
-        try
+        // Somehow the file could not be read. This is an error.
+        if (!contents_read && !read_file(deps_path, &contents))
         {
-            const auto json = json_value::parse(file);
+            trace::error(_X("Could not open dependencies manifest file [%s]"), deps_path.c_str());
+            return false;
+        }
 
-            const auto& runtime_target = json.at(_X("runtimeTarget"));
+        CORELOAD_PROBE3(deps_json_load, deps_path.c_str(), contents.size(), 0);
 
-            const pal::string_t& name = runtime_target.is_string() ?
-                runtime_target.as_string() :
-                runtime_target.at(_X("name")).as_string();
+        const char* begin = contents.data();
+        const char* end = begin + contents.size();
+        if (skip_utf8_bom(&begin, end))
+        {
+            TRACE_VERBOSE(_X("UTF-8 BOM skipped while reading [%s]"), deps_path.c_str());
+        }
 
-            trace::verbose(_X("Loading deps file... %s as framework dependent=[%d]"), deps_path.c_str(), is_framework_dependent);
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            metrics->add_json_bytes(end - begin);
+        }
 
-            return (is_framework_dependent) ? load_framework_dependent(deps_path, json, name, rid_fallback_graph) : load_self_contained(deps_path, json, name);
+        bool loaded;
+        try
+        {
+            loaded = (m_parse_mode == parse_mode_t::dom) ?
+                load_dom(is_framework_dependent, deps_path, begin, end, rid_fallback_graph, host_rid) :
+                load_stream(is_framework_dependent, deps_path, begin, end, rid_fallback_graph, host_rid);
         }
         catch (const std::exception& je)
         {
@@ -482,5 +1053,26 @@ namespace coreload
             trace::error(_X("A JSON parsing exception occurred in [%s]: %s"), deps_path.c_str(), jes.c_str());
             return false;
         }
+
+        if (!loaded)
+        {
+            return false;
+        }
+
+        collect_packages();
+
+        if (use_images)
+        {
+            m_image_source.hash = deps_image::hash_bytes(contents.data(), contents.size());
+            m_image_source.valid = true;
+
+            pal::string_t cache_path = deps_image::get_cache_path(deps_path);
+            if (!cache_path.empty())
+            {
+                save_image(cache_path);
+            }
+        }
+
+        return true;
     }
 } // namespace coreload
\ No newline at end of file
@@ -21,14 +21,50 @@ namespace coreload
         struct rid_assets_t { std::unordered_map<pal::string_t, assets_t> rid_assets; };
         struct rid_specific_assets_t { std::unordered_map<pal::string_t, rid_assets_t> libs; };
 
+        struct target_assets_t { deps_assets_t assets; rid_specific_assets_t rid_assets; };
+
         typedef std::unordered_map<pal::string_t, std::vector<pal::string_t>> str_to_vector_map_t;
+        typedef std::function<const vec_asset_t&(const pal::string_t&, int, bool*)> get_assets_fn_t;
+
+        // Library properties needed to create deps entries, see add_library_entries
+        struct library_properties_t
+        {
+            library_properties_t() : serviceable(false), has_type(false) { }
+
+            pal::string_t hash;
+            pal::string_t path;
+            pal::string_t hash_path;
+            pal::string_t runtime_store_manifest_list;
+            pal::string_t type;
+            bool serviceable;
+            bool has_type;
+        };
+
+        // A "libraries" entry read by the streaming parser. Errors are reported only
+        // if the library turns out to be referenced by the target, like the DOM does.
+        struct library_record_t
+        {
+            pal::string_t name;
+            library_properties_t properties;
+            pal::string_t error;
+        };
 
     public:
         typedef str_to_vector_map_t rid_fallback_graph_t;
 
+        // How the deps file is read. The streaming parser fills the entries while
+        // reading the file; the DOM parser builds a json::value for the whole file
+        // first and is kept as the reference implementation.
+        enum class parse_mode_t
+        {
+            stream,
+            dom
+        };
+
         deps_json_t()
             : m_valid(false)
             , m_file_exists(false)
+            , m_parse_mode(parse_mode_t::stream)
         {
         }
 
@@ -40,19 +76,30 @@ namespace coreload
         deps_json_t(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& graph)
             : deps_json_t()
         {
-            m_valid = load(is_framework_dependent, deps_path, graph);
+            parse(is_framework_dependent, deps_path, graph);
         }
 
         void parse(bool is_framework_dependent, const pal::string_t& deps_path)
         {
-            m_valid = load(is_framework_dependent, deps_path, m_rid_fallback_graph /* dummy */);
+            m_valid = load(is_framework_dependent, deps_path, m_rid_fallback_graph /* dummy */, pal::string_t());
         }
 
         void parse(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& graph)
         {
-            m_valid = load(is_framework_dependent, deps_path, graph);
+            parse(is_framework_dependent, deps_path, graph, is_framework_dependent ? get_current_rid(graph) : pal::string_t());
         }
 
+        // 'host_rid' is get_current_rid of the graph, which deps files parsed for the
+        // same resolution share.
+        void parse(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& graph, const pal::string_t& host_rid)
+        {
+            m_valid = load(is_framework_dependent, deps_path, graph, host_rid);
+        }
+
+        // The RID of the platform the host is running on, or the base RID of the
+        // platform if the graph does not know it.
+        static pal::string_t get_current_rid(const rid_fallback_graph_t& rid_fallback_graph);
+
         const std::vector<deps_entry_t>& get_entries(deps_entry_t::asset_types type) const
         {
             assert(type < deps_entry_t::asset_types::count);
@@ -83,24 +130,66 @@ namespace coreload
             return m_deps_file;
         }
 
+        // Takes effect on the next call to parse.
+        void set_parse_mode(parse_mode_t mode)
+        {
+            m_parse_mode = mode;
+        }
+
+        // Save the parsed state as a precompiled deps file (see deps_image.h), which
+        // later loads of the same deps file pick up instead of parsing it.
+        bool save_image(const pal::string_t& image_path) const;
+
     private:
+        // The deps file contents and parse inputs the parsed state was made from
+        struct image_source_t
+        {
+            image_source_t() : stamp(), hash(0), inputs_hash(0), valid(false) { }
+
+            pal::file_stamp_t stamp;
+            uint64_t hash;
+            uint64_t inputs_hash;
+            bool valid;
+        };
+
         bool load_self_contained(const pal::string_t& deps_path, const json_value& json, const pal::string_t& target_name);
-        bool load_framework_dependent(const pal::string_t& deps_path, const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph);
-        bool load(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph);
-        bool process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, rid_specific_assets_t* p_assets);
+        bool load_framework_dependent(const pal::string_t& deps_path, const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
+        bool load(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
+        bool load_dom(bool is_framework_dependent, const pal::string_t& deps_path, const char* begin, const char* end, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
+        bool load_stream(bool is_framework_dependent, const pal::string_t& deps_path, const char* begin, const char* end, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
+        bool load_image(const pal::string_t& image_path, std::vector<char>* contents, bool* contents_read);
+        bool load_image(const char* data, size_t size, std::vector<char>* contents, bool* contents_read, bool* refreshed, const pal::char_t** error);
+        uint64_t get_image_inputs_hash(bool is_framework_dependent, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
+        void collect_packages();
+        bool process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid, rid_specific_assets_t* p_assets);
         bool process_targets(const json_value& json, const pal::string_t& target_name, deps_assets_t* p_assets);
 
         void reconcile_libraries_with_targets(
             const pal::string_t& deps_path,
             const json_value& json,
             const std::function<bool(const pal::string_t&)>& library_exists_fn,
-            const std::function<const vec_asset_t&(const pal::string_t&, int, bool*)>& get_assets_fn);
+            const get_assets_fn_t& get_assets_fn);
+
+        bool library_exists(bool is_framework_dependent, const pal::string_t& package) const;
+        const vec_asset_t& get_library_assets(bool is_framework_dependent, const pal::string_t& package, int type_index, bool* rid_specific);
+
+        void add_library_entries(
+            const pal::string_t& deps_file,
+            const pal::string_t& library,
+            const library_properties_t& properties,
+            const get_assets_fn_t& get_assets_fn);
+
+        void read_target(web::json::reader& reader, const pal::string_t& target_name, bool read_runtime_targets, target_assets_t* p_target);
+        void read_assets(web::json::reader& reader, const pal::string_t& package, int type_index, deps_assets_t* p_assets);
+        void read_runtime_targets(web::json::reader& reader, const pal::string_t& package, rid_specific_assets_t* p_assets);
+        void read_library(web::json::reader& reader, library_record_t* p_library);
+        void read_rid_fallback_graph(web::json::reader& reader, rid_fallback_graph_t* p_graph);
+        void trace_rid_fallback_graph() const;
 
         pal::string_t get_optional_property(const json_object& properties, const pal::string_t& key) const;
         pal::string_t get_optional_path(const json_object& properties, const pal::string_t& key) const;
 
-        pal::string_t get_current_rid(const rid_fallback_graph_t& rid_fallback_graph);
-        bool perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph);
+        bool perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid);
 
         std::vector<deps_entry_t> m_deps_entries[deps_entry_t::asset_types::count];
 
@@ -108,9 +197,12 @@ namespace coreload
         rid_specific_assets_t m_rid_assets;
 
         std::unordered_map<pal::string_t, int> m_ni_entries;
+        std::unordered_set<pal::string_t> m_packages;
         rid_fallback_graph_t m_rid_fallback_graph;
+        image_source_t m_image_source;
         bool m_file_exists;
         bool m_valid;
+        parse_mode_t m_parse_mode;
 
         pal::string_t m_deps_file;
     };
@@ -0,0 +1,558 @@
+#include "deps_format.h"
+#include "deps_image.h"
+#include "utils.h"
+#include "trace.h"
+#include <cstring>
+
+namespace coreload
+{
+    uint64_t deps_image::hash_bytes(const void* data, size_t size, uint64_t hash)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    uint64_t deps_image::hash_string(const pal::string_t& value, uint64_t hash)
+    {
+        // Include the length so that consecutive strings cannot run into each other.
+        uint64_t length = value.length();
+        hash = hash_bytes(&length, sizeof(length), hash);
+        return hash_bytes(value.data(), value.length() * sizeof(pal::char_t), hash);
+    }
+
+    pal::string_t deps_image::get_sibling_path(const pal::string_t& deps_path)
+    {
+        pal::string_t image_path = deps_path;
+        if (ends_with(image_path, _X(".json"), false))
+        {
+            image_path.resize(image_path.length() - 5);
+        }
+        image_path.append(_X(".bin"));
+        return image_path;
+    }
+
+    pal::string_t deps_image::get_cache_path(const pal::string_t& deps_path)
+    {
+        pal::string_t cache_dir;
+        if (!pal::getenv(_X("COREHOST_DEPS_CACHE"), &cache_dir) || cache_dir.empty())
+        {
+            return pal::string_t();
+        }
+
+        // Deps files of different apps and frameworks share names, tell them apart by their path.
+        pal::char_t path_hash[17];
+        uint64_t hash = hash_string(deps_path);
+        for (int i = 15; i >= 0; --i)
+        {
+            path_hash[i] = _X("0123456789abcdef")[hash & 0xF];
+            hash >>= 4;
+        }
+        path_hash[16] = 0;
+
+        pal::string_t name = get_filename(get_sibling_path(deps_path));
+        name.insert(name.length() - 4, pal::string_t(_X(".")) + path_hash);
+
+        append_path(&cache_dir, name.c_str());
+        return cache_dir;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Hash the inputs which the parsed state depends on besides the deps file.
+    //
+    // Framework dependent deps files select rid specific assets for the host rid
+    // using the rid fallback graph of the root framework.
+    //
+    uint64_t deps_json_t::get_image_inputs_hash(bool is_framework_dependent, const rid_fallback_graph_t& rid_fallback_graph, const pal::string_t& host_rid)
+    {
+        uint64_t hash = deps_image::hash_seed;
+        uint32_t framework_dependent = is_framework_dependent ? 1 : 0;
+        hash = deps_image::hash_bytes(&framework_dependent, sizeof(framework_dependent), hash);
+        if (!is_framework_dependent)
+        {
+            return hash;
+        }
+
+        hash = deps_image::hash_string(host_rid, hash);
+
+        std::vector<const rid_fallback_graph_t::value_type*> rids;
+        rids.reserve(rid_fallback_graph.size());
+        for (const auto& rid : rid_fallback_graph)
+        {
+            rids.push_back(&rid);
+        }
+        std::sort(rids.begin(), rids.end(), [](const rid_fallback_graph_t::value_type* a, const rid_fallback_graph_t::value_type* b) {
+            return a->first < b->first;
+        });
+
+        for (const auto* rid : rids)
+        {
+            hash = deps_image::hash_string(rid->first, hash);
+            uint64_t count = rid->second.size();
+            hash = deps_image::hash_bytes(&count, sizeof(count), hash);
+            for (const auto& fallback : rid->second)
+            {
+                hash = deps_image::hash_string(fallback, hash);
+            }
+        }
+        return hash;
+    }
+
+    namespace
+    {
+        class string_table_t
+        {
+        public:
+            deps_image::string_ref_t add(const pal::string_t& value)
+            {
+                auto iter = m_refs.find(value);
+                if (iter != m_refs.end())
+                {
+                    return iter->second;
+                }
+
+                deps_image::string_ref_t ref;
+                ref.offset = static_cast<uint32_t>(m_chars.size());
+                ref.length = static_cast<uint32_t>(value.length());
+                m_chars.insert(m_chars.end(), value.begin(), value.end());
+                m_refs.emplace(value, ref);
+                return ref;
+            }
+
+            const std::vector<pal::char_t>& chars() const
+            {
+                return m_chars;
+            }
+
+        private:
+            std::unordered_map<pal::string_t, deps_image::string_ref_t> m_refs;
+            std::vector<pal::char_t> m_chars;
+        };
+
+        template <typename T>
+        uint64_t append_section(std::vector<char>* image, const T* items, size_t count)
+        {
+            // Keep every section 8 byte aligned.
+            image->resize((image->size() + 7) & ~static_cast<size_t>(7));
+            uint64_t offset = image->size();
+            const char* bytes = reinterpret_cast<const char*>(items);
+            image->insert(image->end(), bytes, bytes + count * sizeof(T));
+            return offset;
+        }
+
+        void to_image_version(const version_t& version, int32_t* out)
+        {
+            out[0] = version.get_major();
+            out[1] = version.get_minor();
+            out[2] = version.get_build();
+            out[3] = version.get_revision();
+        }
+
+        // A read-only view of the sections of a mapped image, which checks every
+        // position it is asked for against the bounds of the image.
+        class image_view_t
+        {
+        public:
+            image_view_t(const char* data, const deps_image::header_t& header)
+                : m_data(data)
+                , m_header(header)
+                , m_strings(reinterpret_cast<const pal::char_t*>(data + header.strings_offset))
+            {
+            }
+
+            template <typename T>
+            bool get_section(uint64_t offset, uint32_t count, const T** items) const
+            {
+                if (offset % alignof(T) != 0 || offset > m_header.image_size ||
+                    (m_header.image_size - offset) / sizeof(T) < count)
+                {
+                    return false;
+                }
+
+                *items = reinterpret_cast<const T*>(m_data + offset);
+                return true;
+            }
+
+            bool get_string(const deps_image::string_ref_t& ref, pal::string_t* value) const
+            {
+                if (ref.offset > m_header.string_chars || m_header.string_chars - ref.offset < ref.length)
+                {
+                    return false;
+                }
+
+                value->assign(m_strings + ref.offset, ref.length);
+                return true;
+            }
+
+        private:
+            const char* m_data;
+            const deps_image::header_t& m_header;
+            const pal::char_t* m_strings;
+        };
+    }
+
+    // -----------------------------------------------------------------------------
+    // Save the parsed state to a precompiled deps file, writing a temporary file
+    // first so that readers never see a partial image.
+    //
+    bool deps_json_t::save_image(const pal::string_t& image_path) const
+    {
+        if (!m_file_exists || !m_image_source.valid)
+        {
+            return false;
+        }
+
+        string_table_t strings;
+        std::vector<deps_image::entry_t> entries[deps_entry_t::asset_types::count];
+        for (int i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            entries[i].reserve(m_deps_entries[i].size());
+            for (const auto& entry : m_deps_entries[i])
+            {
+                deps_image::entry_t record;
+                record.library_type = strings.add(entry.library_type);
+                record.library_name = strings.add(entry.library_name);
+                record.library_version = strings.add(entry.library_version);
+                record.library_hash = strings.add(entry.library_hash);
+                record.library_path = strings.add(entry.library_path);
+                record.library_hash_path = strings.add(entry.library_hash_path);
+                record.runtime_store_manifest_list = strings.add(entry.runtime_store_manifest_list);
+                record.asset_name = strings.add(entry.asset.name);
+                record.asset_relative_path = strings.add(entry.asset.relative_path);
+                to_image_version(entry.asset.assembly_version, record.assembly_version);
+                to_image_version(entry.asset.file_version, record.file_version);
+                record.flags = (entry.is_serviceable ? deps_image::serviceable : 0) |
+                    (entry.is_rid_specific ? deps_image::rid_specific : 0);
+                entries[i].push_back(record);
+            }
+        }
+
+        std::vector<deps_image::ni_entry_t> ni_entries;
+        for (const auto& ni : m_ni_entries)
+        {
+            deps_image::ni_entry_t record;
+            record.asset_name = strings.add(ni.first);
+            record.index = static_cast<uint32_t>(ni.second);
+            ni_entries.push_back(record);
+        }
+
+        std::vector<deps_image::rid_t> rids;
+        std::vector<deps_image::string_ref_t> rid_fallbacks;
+        for (const auto& rid : m_rid_fallback_graph)
+        {
+            deps_image::rid_t record;
+            record.rid = strings.add(rid.first);
+            record.first_fallback = static_cast<uint32_t>(rid_fallbacks.size());
+            record.fallback_count = static_cast<uint32_t>(rid.second.size());
+            for (const auto& fallback : rid.second)
+            {
+                rid_fallbacks.push_back(strings.add(fallback));
+            }
+            rids.push_back(record);
+        }
+
+        std::vector<deps_image::string_ref_t> packages;
+        for (const auto& package : m_packages)
+        {
+            packages.push_back(strings.add(package));
+        }
+
+        deps_image::header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, deps_image::magic, sizeof(header.magic));
+        header.format_version = deps_image::format_version;
+        header.char_size = sizeof(pal::char_t);
+        header.source_size = m_image_source.stamp.size;
+        header.source_mtime = m_image_source.stamp.mtime;
+        header.source_hash = m_image_source.hash;
+        header.inputs_hash = m_image_source.inputs_hash;
+        header.ni_count = static_cast<uint32_t>(ni_entries.size());
+        header.rid_count = static_cast<uint32_t>(rids.size());
+        header.rid_fallback_count = static_cast<uint32_t>(rid_fallbacks.size());
+        header.package_count = static_cast<uint32_t>(packages.size());
+        header.string_chars = static_cast<uint32_t>(strings.chars().size());
+
+        std::vector<char> image(sizeof(header));
+        for (int i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            header.entry_counts[i] = static_cast<uint32_t>(entries[i].size());
+            header.entries_offset[i] = append_section(&image, entries[i].data(), entries[i].size());
+        }
+        header.ni_offset = append_section(&image, ni_entries.data(), ni_entries.size());
+        header.rids_offset = append_section(&image, rids.data(), rids.size());
+        header.rid_fallbacks_offset = append_section(&image, rid_fallbacks.data(), rid_fallbacks.size());
+        header.packages_offset = append_section(&image, packages.data(), packages.size());
+        header.strings_offset = append_section(&image, strings.chars().data(), strings.chars().size());
+        header.image_size = image.size();
+        memcpy(image.data(), &header, sizeof(header));
+
+        pal::string_t temp_path = image_path + _X(".") + pal::to_string(static_cast<int>(pal::get_pid())) + _X(".tmp");
+        {
+            std::ofstream file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file.write(image.data(), image.size()) || !file.flush())
+            {
+                TRACE_VERBOSE(_X("Could not write the precompiled deps file [%s]"), temp_path.c_str());
+                file.close();
+                pal::remove_file(temp_path);
+                return false;
+            }
+        }
+
+        // A deps file written shortly before the image may still change without its write
+        // time changing, with coarse file system timestamps. Leave the time out of the
+        // image then, so that loading it compares the contents until the file is older.
+        pal::file_stamp_t image_stamp;
+        if (!pal::get_file_stamp(temp_path, &image_stamp) ||
+            image_stamp.mtime - m_image_source.stamp.mtime < 2 * pal::mtime_ticks_per_second)
+        {
+            header.source_mtime = 0;
+            std::fstream file(temp_path, std::ios::in | std::ios::out | std::ios::binary);
+            if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.flush())
+            {
+                file.close();
+                pal::remove_file(temp_path);
+                return false;
+            }
+        }
+
+        if (!pal::replace_file(temp_path, image_path))
+        {
+            TRACE_VERBOSE(_X("Could not replace the precompiled deps file [%s]"), image_path.c_str());
+            pal::remove_file(temp_path);
+            return false;
+        }
+
+        TRACE_VERBOSE(_X("Saved the precompiled deps file [%s] for [%s]"), image_path.c_str(), m_deps_file.c_str());
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Load the parsed state from a precompiled deps file, if it was made from the
+    // current contents of the deps file and with the same inputs.
+    //
+    // The deps file is only read, into 'contents', when its size and last write
+    // time are not enough to tell that the image is up to date.
+    //
+    bool deps_json_t::load_image(const pal::string_t& image_path, std::vector<char>* contents, bool* contents_read)
+    {
+        if (!pal::file_exists(image_path))
+        {
+            return false;
+        }
+
+        const void* data;
+        size_t size;
+        if (!pal::map_file(image_path, &data, &size))
+        {
+            TRACE_VERBOSE(_X("Could not map the precompiled deps file [%s]"), image_path.c_str());
+            return false;
+        }
+
+        const pal::char_t* error = nullptr;
+        bool refreshed = false;
+        bool loaded = load_image(static_cast<const char*>(data), size, contents, contents_read, &refreshed, &error);
+        pal::unmap_file(data, size);
+
+        if (!loaded)
+        {
+            TRACE_VERBOSE(_X("Ignoring the precompiled deps file [%s]: %s"), image_path.c_str(), error);
+            return false;
+        }
+
+        TRACE_VERBOSE(_X("Loaded %zu deps entries from the precompiled deps file [%s]"),
+            m_deps_entries[0].size() + m_deps_entries[1].size() + m_deps_entries[2].size(), image_path.c_str());
+
+        // The deps file was touched without changing, record its new write time.
+        if (refreshed)
+        {
+            save_image(image_path);
+        }
+        return true;
+    }
+
+    bool deps_json_t::load_image(const char* data, size_t size, std::vector<char>* contents, bool* contents_read, bool* refreshed, const pal::char_t** error)
+    {
+        deps_image::header_t header;
+        if (size < sizeof(header))
+        {
+            *error = _X("truncated");
+            return false;
+        }
+
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, deps_image::magic, sizeof(header.magic)) != 0 ||
+            header.format_version != deps_image::format_version ||
+            header.char_size != sizeof(pal::char_t))
+        {
+            *error = _X("unknown format");
+            return false;
+        }
+
+        if (header.image_size != size)
+        {
+            *error = _X("truncated");
+            return false;
+        }
+
+        if (header.inputs_hash != m_image_source.inputs_hash)
+        {
+            *error = _X("made for another rid or rid fallback graph");
+            return false;
+        }
+
+        if (header.source_size != m_image_source.stamp.size)
+        {
+            *error = _X("the deps file changed");
+            return false;
+        }
+
+        if (header.source_mtime != m_image_source.stamp.mtime)
+        {
+            if (!*contents_read)
+            {
+                *contents_read = true;
+                if (!read_file(m_deps_file, contents))
+                {
+                    contents->clear();
+                    *error = _X("the deps file could not be read");
+                    return false;
+                }
+            }
+
+            if (deps_image::hash_bytes(contents->data(), contents->size()) != header.source_hash)
+            {
+                *error = _X("the deps file changed");
+                return false;
+            }
+            *refreshed = true;
+        }
+
+        *error = _X("corrupt");
+        if (header.strings_offset % alignof(pal::char_t) != 0 || header.strings_offset > size ||
+            (size - header.strings_offset) / sizeof(pal::char_t) < header.string_chars)
+        {
+            return false;
+        }
+
+        image_view_t view(data, header);
+        pal::string_t deps_file = get_filename(m_deps_file);
+        std::vector<deps_entry_t> deps_entries[deps_entry_t::asset_types::count];
+        for (int i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            const deps_image::entry_t* records;
+            if (!view.get_section(header.entries_offset[i], header.entry_counts[i], &records))
+            {
+                return false;
+            }
+
+            deps_entries[i].resize(header.entry_counts[i]);
+            for (uint32_t j = 0; j < header.entry_counts[i]; ++j)
+            {
+                const deps_image::entry_t& record = records[j];
+                deps_entry_t& entry = deps_entries[i][j];
+                if (!view.get_string(record.library_type, &entry.library_type) ||
+                    !view.get_string(record.library_name, &entry.library_name) ||
+                    !view.get_string(record.library_version, &entry.library_version) ||
+                    !view.get_string(record.library_hash, &entry.library_hash) ||
+                    !view.get_string(record.library_path, &entry.library_path) ||
+                    !view.get_string(record.library_hash_path, &entry.library_hash_path) ||
+                    !view.get_string(record.runtime_store_manifest_list, &entry.runtime_store_manifest_list) ||
+                    !view.get_string(record.asset_name, &entry.asset.name) ||
+                    !view.get_string(record.asset_relative_path, &entry.asset.relative_path))
+                {
+                    return false;
+                }
+
+                entry.asset.assembly_version = version_t(record.assembly_version[0], record.assembly_version[1], record.assembly_version[2], record.assembly_version[3]);
+                entry.asset.file_version = version_t(record.file_version[0], record.file_version[1], record.file_version[2], record.file_version[3]);
+                entry.asset_type = static_cast<deps_entry_t::asset_types>(i);
+                entry.is_serviceable = (record.flags & deps_image::serviceable) != 0;
+                entry.is_rid_specific = (record.flags & deps_image::rid_specific) != 0;
+                entry.deps_file = deps_file;
+            }
+        }
+
+        const deps_image::ni_entry_t* ni_records;
+        if (!view.get_section(header.ni_offset, header.ni_count, &ni_records))
+        {
+            return false;
+        }
+
+        std::unordered_map<pal::string_t, int> ni_entries;
+        for (uint32_t i = 0; i < header.ni_count; ++i)
+        {
+            pal::string_t name;
+            if (!view.get_string(ni_records[i].asset_name, &name) ||
+                ni_records[i].index >= deps_entries[deps_entry_t::asset_types::runtime].size())
+            {
+                return false;
+            }
+            ni_entries[name] = static_cast<int>(ni_records[i].index);
+        }
+
+        const deps_image::rid_t* rid_records;
+        const deps_image::string_ref_t* rid_fallbacks;
+        if (!view.get_section(header.rids_offset, header.rid_count, &rid_records) ||
+            !view.get_section(header.rid_fallbacks_offset, header.rid_fallback_count, &rid_fallbacks))
+        {
+            return false;
+        }
+
+        rid_fallback_graph_t rid_fallback_graph;
+        for (uint32_t i = 0; i < header.rid_count; ++i)
+        {
+            const deps_image::rid_t& record = rid_records[i];
+            pal::string_t rid;
+            if (!view.get_string(record.rid, &rid) ||
+                record.first_fallback > header.rid_fallback_count ||
+                header.rid_fallback_count - record.first_fallback < record.fallback_count)
+            {
+                return false;
+            }
+
+            auto& fallbacks = rid_fallback_graph[rid];
+            fallbacks.resize(record.fallback_count);
+            for (uint32_t j = 0; j < record.fallback_count; ++j)
+            {
+                if (!view.get_string(rid_fallbacks[record.first_fallback + j], &fallbacks[j]))
+                {
+                    return false;
+                }
+            }
+        }
+
+        const deps_image::string_ref_t* package_records;
+        if (!view.get_section(header.packages_offset, header.package_count, &package_records))
+        {
+            return false;
+        }
+
+        std::unordered_set<pal::string_t> packages;
+        packages.reserve(header.package_count);
+        for (uint32_t i = 0; i < header.package_count; ++i)
+        {
+            pal::string_t package;
+            if (!view.get_string(package_records[i], &package))
+            {
+                return false;
+            }
+            packages.insert(std::move(package));
+        }
+
+        for (int i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            m_deps_entries[i] = std::move(deps_entries[i]);
+        }
+        m_ni_entries = std::move(ni_entries);
+        m_rid_fallback_graph = std::move(rid_fallback_graph);
+        m_packages = std::move(packages);
+
+        m_image_source.hash = header.source_hash;
+        m_image_source.valid = true;
+        return true;
+    }
+} // namespace coreload
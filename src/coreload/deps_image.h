@@ -0,0 +1,109 @@
+#ifndef DEPS_IMAGE_H_
+#define DEPS_IMAGE_H_
+
+#include "pal.h"
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Layout of a precompiled deps file (.deps.bin), the parsed state of a
+    // deps_json_t saved so that it can be loaded without parsing JSON.
+    //
+    // The header is followed by fixed size records which refer to strings by
+    // their position in a string table of pal::char_t, stored last. Images are
+    // only read by the host which wrote them: they are in native byte order and
+    // the header records the character size.
+    //
+    namespace deps_image
+    {
+        const char magic[8] = { 'D', 'E', 'P', 'S', 'B', 'I', 'N', '\0' };
+        const uint32_t format_version = 1;
+
+        // Position and length of a string in the string table, in characters
+        struct string_ref_t
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct header_t
+        {
+            char magic[8];
+            uint32_t format_version;
+            uint32_t char_size;
+            uint64_t image_size;
+
+            // The deps file the image was made from
+            uint64_t source_size;
+            int64_t source_mtime;
+            uint64_t source_hash;
+
+            // Everything else the parsed state depends on, see deps_json_t::get_image_inputs_hash
+            uint64_t inputs_hash;
+
+            uint32_t entry_counts[3];
+            uint32_t ni_count;
+            uint32_t rid_count;
+            uint32_t rid_fallback_count;
+            uint32_t package_count;
+            uint32_t string_chars;
+
+            uint64_t entries_offset[3];
+            uint64_t ni_offset;
+            uint64_t rids_offset;
+            uint64_t rid_fallbacks_offset;
+            uint64_t packages_offset;
+            uint64_t strings_offset;
+        };
+
+        enum entry_flags_t : uint32_t
+        {
+            serviceable = 0x1,
+            rid_specific = 0x2
+        };
+
+        struct entry_t
+        {
+            string_ref_t library_type;
+            string_ref_t library_name;
+            string_ref_t library_version;
+            string_ref_t library_hash;
+            string_ref_t library_path;
+            string_ref_t library_hash_path;
+            string_ref_t runtime_store_manifest_list;
+            string_ref_t asset_name;
+            string_ref_t asset_relative_path;
+            int32_t assembly_version[4];
+            int32_t file_version[4];
+            uint32_t flags;
+        };
+
+        struct ni_entry_t
+        {
+            string_ref_t asset_name;
+            uint32_t index;
+        };
+
+        // A rid and its fallbacks, a range of the rid fallbacks array
+        struct rid_t
+        {
+            string_ref_t rid;
+            uint32_t first_fallback;
+            uint32_t fallback_count;
+        };
+
+        // FNV-1a, to detect changes to a deps file and to its parse inputs
+        const uint64_t hash_seed = 14695981039346656037ULL;
+        uint64_t hash_bytes(const void* data, size_t size, uint64_t hash = hash_seed);
+        uint64_t hash_string(const pal::string_t& value, uint64_t hash = hash_seed);
+
+        // The image next to the deps file: "app.deps.json" has "app.deps.bin"
+        pal::string_t get_sibling_path(const pal::string_t& deps_path);
+
+        // The image in the cache directory set with COREHOST_DEPS_CACHE, or an empty path
+        pal::string_t get_cache_path(const pal::string_t& deps_path);
+    }
+
+} // namespace coreload
+
+#endif // DEPS_IMAGE_H_
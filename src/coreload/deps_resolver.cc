@@ -8,6 +8,9 @@
 #include "utils.h"
 #include "fx_ver.h"
 #include "libhost.h"
+#include "dir_cache.h"
+#include "trace_events.h"
+#include "usdt.h"
 
 const coreload::pal::string_t MissingAssemblyMessage = _X(
     "%s:\n"
@@ -35,14 +38,14 @@ namespace coreload
     {
         // Resolve sym links.
         pal::string_t real = path;
-        pal::realpath(&real);
+        cached_realpath(&real);
 
         if (existing->count(real))
         {
             return;
         }
 
-        trace::verbose(_X("Adding to %s path: %s"), deps_entry_t::s_known_asset_types[asset_type], real.c_str());
+        TRACE_VERBOSE(_X("Adding to %s path: %s"), deps_entry_t::s_known_asset_types[asset_type], real.c_str());
 
         if (starts_with(real, svc_dir, false))
         {
@@ -88,7 +91,7 @@ namespace coreload
         name_to_resolved_asset_map_t::iterator existing = items->find(resolved_asset.asset.name);
         if (existing == items->end())
         {
-            trace::verbose(_X("Adding tpa entry: %s, AssemblyVersion: %s, FileVersion: %s"),
+            TRACE_VERBOSE(_X("Adding tpa entry: %s, AssemblyVersion: %s, FileVersion: %s"),
                 resolved_asset.resolved_path.c_str(),
                 resolved_asset.asset.assembly_version.as_str().c_str(),
                 resolved_asset.asset.file_version.as_str().c_str());
@@ -107,7 +110,7 @@ namespace coreload
         name_to_resolved_asset_map_t* items)
     {
         version_t empty;
-        trace::verbose(_X("Adding files from %s dir %s"), dir_name.c_str(), dir.c_str());
+        TRACE_VERBOSE(_X("Adding files from %s dir %s"), dir_name.c_str(), dir.c_str());
 
         // Managed extensions in priority order, pick DLL over EXE and NI over IL.
         const pal::string_t managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
@@ -138,7 +141,7 @@ namespace coreload
                 // Already added entry for this asset, by priority order skip this ext
                 if (items->count(file_name))
                 {
-                    trace::verbose(_X("Skipping %s because the %s already exists in %s assemblies"),
+                    TRACE_VERBOSE(_X("Skipping %s because the %s already exists in %s assemblies"),
                         file.c_str(),
                         items->find(file_name)->second.asset.relative_path.c_str(),
                         dir_name.c_str());
@@ -154,7 +157,7 @@ namespace coreload
                 }
                 file_path.append(file);
 
-                trace::verbose(_X("Adding %s to %s assembly set from %s"),
+                TRACE_VERBOSE(_X("Adding %s to %s assembly set from %s"),
                     file_name.c_str(),
                     dir_name.c_str(),
                     file_path.c_str());
@@ -252,7 +255,7 @@ namespace coreload
 
         if (trace::is_enabled())
         {
-            trace::verbose(_X("-- Listing probe configurations..."));
+            TRACE_VERBOSE(_X("-- Listing probe configurations..."));
             for (const auto& pc : m_probes)
             {
                 pc.print();
@@ -276,19 +279,23 @@ namespace coreload
     {
         candidate->clear();
 
-        for (const auto& config : m_probes)
+        const probe_index_t::matches_t* matches = nullptr;
+        bool indexed = m_probe_index.find(entry, &matches);
+
+        for (size_t probe = 0; probe < m_probes.size(); ++probe)
         {
-            trace::verbose(_X("  Considering entry [%s/%s/%s], probe dir [%s], probe fx level:%d, entry fx level:%d"),
+            const auto& config = m_probes[probe];
+            TRACE_VERBOSE(_X("  Considering entry [%s/%s/%s], probe dir [%s], probe fx level:%d, entry fx level:%d"),
                 entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str(), config.probe_dir.c_str(), config.fx_level, fx_level);
 
             if (config.only_serviceable_assets && !entry.is_serviceable)
             {
-                trace::verbose(_X("    Skipping... not serviceable asset"));
+                TRACE_VERBOSE(_X("    Skipping... not serviceable asset"));
                 continue;
             }
             if (config.only_runtime_assets && entry.asset_type != deps_entry_t::asset_types::runtime)
             {
-                trace::verbose(_X("    Skipping... not runtime asset"));
+                TRACE_VERBOSE(_X("    Skipping... not runtime asset"));
                 continue;
             }
             pal::string_t probe_dir = config.probe_dir;
@@ -308,12 +315,13 @@ namespace coreload
                     // No need to check further for the exact asset relative sub path.
                     if (config.probe_deps_json->has_package(entry.library_name, entry.library_version) && entry.to_dir_path(probe_dir, candidate))
                     {
-                        trace::verbose(_X("    Probed deps json and matched '%s'"), candidate->c_str());
+                        TRACE_VERBOSE(_X("    Probed deps json and matched '%s'"), candidate->c_str());
+                        CORELOAD_PROBE3(probe_deps_entry_hit, entry.library_name.c_str(), entry.asset.relative_path.c_str(), probe);
                         return true;
                     }
                 }
 
-                trace::verbose(_X("    Skipping... not found in deps json."));
+                TRACE_VERBOSE(_X("    Skipping... not found in deps json."));
             }
             else if (config.is_app())
             {
@@ -326,7 +334,8 @@ namespace coreload
                     {
                         if (entry.to_rel_path(deps_dir, candidate))
                         {
-                            trace::verbose(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                            TRACE_VERBOSE(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                            CORELOAD_PROBE3(probe_deps_entry_hit, entry.library_name.c_str(), entry.asset.relative_path.c_str(), probe);
                             return true;
                         }
                     }
@@ -335,23 +344,40 @@ namespace coreload
                         // Non-rid assets, lookup in the published dir.
                         if (entry.to_dir_path(deps_dir, candidate))
                         {
-                            trace::verbose(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                            TRACE_VERBOSE(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                            CORELOAD_PROBE3(probe_deps_entry_hit, entry.library_name.c_str(), entry.asset.relative_path.c_str(), probe);
                             return true;
                         }
                     }
                 }
 
-                trace::verbose(_X("    Skipping... not found in deps dir '%s'"), deps_dir.c_str());
+                TRACE_VERBOSE(_X("    Skipping... not found in deps dir '%s'"), deps_dir.c_str());
+            }
+            else if (indexed)
+            {
+                for (const auto& match : *matches)
+                {
+                    if (match.first == probe)
+                    {
+                        candidate->assign(match.second);
+                        TRACE_VERBOSE(_X("    Probed package dir index and matched '%s'"), candidate->c_str());
+                        CORELOAD_PROBE3(probe_deps_entry_hit, entry.library_name.c_str(), entry.asset.relative_path.c_str(), probe);
+                        return true;
+                    }
+                }
             }
             else if (entry.to_full_path(probe_dir, candidate))
             {
-                trace::verbose(_X("    Probed package dir and matched '%s'"), candidate->c_str());
+                TRACE_VERBOSE(_X("    Probed package dir and matched '%s'"), candidate->c_str());
+                CORELOAD_PROBE3(probe_deps_entry_hit, entry.library_name.c_str(), entry.asset.relative_path.c_str(), probe);
                 return true;
             }
 
-            trace::verbose(_X("    Skipping... not found in probe dir '%s'"), probe_dir.c_str());
+            TRACE_VERBOSE(_X("    Skipping... not found in probe dir '%s'"), probe_dir.c_str());
             // continue to try next probe config
         }
+
+        CORELOAD_PROBE3(probe_deps_entry_miss, entry.library_name.c_str(), entry.asset.relative_path.c_str(), m_probes.size());
         return false;
     }
 
@@ -364,12 +390,12 @@ namespace coreload
             // Treat missing resource assemblies as informational.
             continueResolving = true;
 
-            trace::info(MissingAssemblyMessage.c_str(), _X("Info"),
+            TRACE_INFO(MissingAssemblyMessage.c_str(), _X("Info"),
                 entry.deps_file.c_str(), entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
 
             if (showManifestListMessage)
             {
-                trace::info(ManifestListMessage.c_str(), entry.runtime_store_manifest_list.c_str());
+                TRACE_INFO(ManifestListMessage.c_str(), entry.runtime_store_manifest_list.c_str());
             }
         }
         else if (continueResolving)
@@ -403,11 +429,58 @@ namespace coreload
         pal::string_t* output,
         std::unordered_set<pal::string_t>* breadcrumb)
     {
+        trace_duration_t duration("resolve_tpa_list");
+
         const std::vector<deps_entry_t> empty(0);
         name_to_resolved_asset_map_t items;
 
-        auto process_entry = [&](const pal::string_t& deps_dir, const deps_entry_t& entry, int fx_level) -> bool
+        // The entries in the order they are merged: the app's, the additional deps files' and
+        // the frameworks' from the highest level down.
+        struct tpa_entry_t
+        {
+            const pal::string_t* deps_dir;
+            const deps_entry_t* entry;
+            int fx_level;
+            bool found;
+            pal::string_t resolved_path;
+        };
+
+        std::vector<tpa_entry_t> entries;
+        auto add_entries = [&](const pal::string_t& deps_dir, const std::vector<deps_entry_t>& deps_entries, int fx_level)
+        {
+            for (const auto& entry : deps_entries)
+            {
+                entries.push_back(tpa_entry_t{ &deps_dir, &entry, fx_level, false, pal::string_t() });
+            }
+        };
+
+        add_entries(m_app_dir, get_deps().get_entries(deps_entry_t::asset_types::runtime), 0);
+        size_t app_entry_count = entries.size();
+        for (const auto& additional_deps : m_additional_deps)
+        {
+            add_entries(m_app_dir, additional_deps->get_entries(deps_entry_t::asset_types::runtime), 0);
+        }
+        for (int i = 1; i < m_fx_definitions.size(); ++i)
+        {
+            add_entries(m_fx_definitions[i]->get_dir(), m_is_framework_dependent ? m_fx_definitions[i]->get_deps().get_entries(deps_entry_t::asset_types::runtime) : empty, i);
+        }
+
+        // Probing an entry depends only on the entry and the probe configurations, so all the
+        // entries are probed up front, concurrently. Which of the candidates are used depends
+        // on the entries merged before, so the merge below stays in order.
+        m_thread_pool.run(entries.size(), [&entries, this](size_t i)
         {
+            tpa_entry_t& probed = entries[i];
+            if (!ends_with(probed.entry->asset.relative_path, _X("/_._"), false))
+            {
+                probed.found = probe_deps_entry(*probed.entry, *probed.deps_dir, probed.fx_level, &probed.resolved_path);
+            }
+        });
+
+        auto process_entry = [&](const tpa_entry_t& probed) -> bool
+        {
+            const deps_entry_t& entry = *probed.entry;
+            int fx_level = probed.fx_level;
             if (breadcrumb != nullptr && entry.is_serviceable)
             {
                 breadcrumb->insert(entry.library_name + _X(",") + entry.library_version);
@@ -420,14 +493,14 @@ namespace coreload
                 return true;
             }
 
-            trace::info(_X("Processing TPA for deps entry [%s, %s, %s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
+            TRACE_INFO(_X("Processing TPA for deps entry [%s, %s, %s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
 
-            pal::string_t resolved_path;
+            const pal::string_t& resolved_path = probed.resolved_path;
 
             name_to_resolved_asset_map_t::iterator existing = items.find(entry.asset.name);
             if (existing == items.end())
             {
-                if (probe_deps_entry(entry, deps_dir, fx_level, &resolved_path))
+                if (probed.found)
                 {
                     deps_resolved_asset_t resolved_asset(entry.asset, resolved_path);
                     add_tpa_asset(resolved_asset, &items);
@@ -462,12 +535,12 @@ namespace coreload
                 if (entry.asset.assembly_version > existing_entry->asset.assembly_version ||
                     (entry.asset.assembly_version == existing_entry->asset.assembly_version && entry.asset.file_version >= existing_entry->asset.file_version))
                 {
-                    if (probe_deps_entry(entry, deps_dir, fx_level, &resolved_path))
+                    if (probed.found)
                     {
                         // If the path is the same, then no need to replace
                         if (resolved_path != existing_entry->resolved_path)
                         {
-                            trace::verbose(_X("Replacing deps entry [%s, AssemblyVersion:%s, FileVersion:%s] with [%s, AssemblyVersion:%s, FileVersion:%s]"),
+                            TRACE_VERBOSE(_X("Replacing deps entry [%s, AssemblyVersion:%s, FileVersion:%s] with [%s, AssemblyVersion:%s, FileVersion:%s]"),
                                 existing_entry->resolved_path.c_str(), existing_entry->asset.assembly_version.as_str().c_str(), existing_entry->asset.file_version.as_str().c_str(),
                                 resolved_path.c_str(), entry.asset.assembly_version.as_str().c_str(), entry.asset.file_version.as_str().c_str());
 
@@ -499,14 +572,22 @@ namespace coreload
         deps_resolved_asset_t resolved_asset(asset, m_managed_app);
         add_tpa_asset(resolved_asset, &items);
 
-        // Add the app's entries
-        const auto& deps_entries = get_deps().get_entries(deps_entry_t::asset_types::runtime);
-        for (const auto& entry : deps_entries)
+        auto process_entries = [&](size_t begin, size_t end) -> bool
         {
-            if (!process_entry(m_app_dir, entry, 0))
+            for (size_t i = begin; i < end; ++i)
             {
-                return false;
+                if (!process_entry(entries[i]))
+                {
+                    return false;
+                }
             }
+            return true;
+        };
+
+        // Add the app's entries
+        if (!process_entries(0, app_entry_count))
+        {
+            return false;
         }
 
         // If the deps file wasn't present or has missing entries, then
@@ -518,38 +599,20 @@ namespace coreload
         }
 
         // If additional deps files were specified that need to be treated as part of the
-        // application, then add them to the mix as well.
-        for (const auto& additional_deps : m_additional_deps)
-        {
-            auto additional_deps_entries = additional_deps->get_entries(deps_entry_t::asset_types::runtime);
-            for (auto entry : additional_deps_entries)
-            {
-                if (!process_entry(m_app_dir, entry, 0))
-                {
-                    return false;
-                }
-            }
-        }
-
-        // Probe FX deps entries after app assemblies are added.
-        for (int i = 1; i < m_fx_definitions.size(); ++i)
+        // application, then add them to the mix as well. Probe FX deps entries after app
+        // assemblies are added.
+        if (!process_entries(app_entry_count, entries.size()))
         {
-            const auto& deps_entries = m_is_framework_dependent ? m_fx_definitions[i]->get_deps().get_entries(deps_entry_t::asset_types::runtime) : empty;
-            for (const auto& entry : deps_entries)
-            {
-                if (!process_entry(m_fx_definitions[i]->get_dir(), entry, i))
-                {
-                    return false;
-                }
-            }
+            return false;
         }
 
         // Convert the paths into a string and return it 
         for (const auto& item : items)
         {
             // Workaround for CoreFX not being able to resolve sym links.
+            // Assets share a handful of directories, so resolve them through the directory cache.
             pal::string_t real_asset_path = item.second.resolved_path;
-            pal::realpath(&real_asset_path);
+            cached_realpath(&real_asset_path);
             output->append(real_asset_path);
             output->push_back(PATH_SEPARATOR);
         }
@@ -610,7 +673,7 @@ namespace coreload
             {
                 if (pal::file_exists(additional_deps_path))
                 {
-                    trace::verbose(_X("Using specified additional deps.json: '%s'"),
+                    TRACE_VERBOSE(_X("Using specified additional deps.json: '%s'"),
                         additional_deps_path.c_str());
 
                     m_additional_deps_files.push_back(additional_deps_path);
@@ -633,7 +696,7 @@ namespace coreload
                     pal::string_t additional_deps_path_fx = additional_deps_path;
                     append_path(&additional_deps_path_fx, _X("shared"));
                     append_path(&additional_deps_path_fx, m_fx_definitions[i]->get_name().c_str());
-                    trace::verbose(_X("Searching for most compatible deps directory in [%s]"), additional_deps_path_fx.c_str());
+                    TRACE_VERBOSE(_X("Searching for most compatible deps directory in [%s]"), additional_deps_path_fx.c_str());
                     std::vector<pal::string_t> deps_dirs;
                     pal::readdir_onlydirectories(additional_deps_path_fx, &deps_dirs);
 
@@ -654,11 +717,11 @@ namespace coreload
 
                     if (most_compatible_deps_folder_version == fx_ver_t(-1, -1, -1))
                     {
-                        trace::verbose(_X("No additional deps directory less than or equal to [%s] found with same major and minor version."), framework_found_version.as_str().c_str());
+                        TRACE_VERBOSE(_X("No additional deps directory less than or equal to [%s] found with same major and minor version."), framework_found_version.as_str().c_str());
                     }
                     else
                     {
-                        trace::verbose(_X("Found additional deps directory [%s]"), most_compatible_deps_folder_version.as_str().c_str());
+                        TRACE_VERBOSE(_X("Found additional deps directory [%s]"), most_compatible_deps_folder_version.as_str().c_str());
 
                         append_path(&additional_deps_path_fx, most_compatible_deps_folder_version.as_str().c_str());
 
@@ -671,7 +734,7 @@ namespace coreload
                             append_path(&json_full_path, json_file.c_str());
                             m_additional_deps_files.push_back(json_full_path);
 
-                            trace::verbose(_X("Using specified additional deps.json: '%s'"),
+                            TRACE_VERBOSE(_X("Using specified additional deps.json: '%s'"),
                                 json_full_path.c_str());
                         }
                     }
@@ -679,11 +742,10 @@ namespace coreload
             }
         }
 
-        auto rids = get_root_framework(m_fx_definitions).get_deps().get_rid_fallback_graph();
-        for (pal::string_t json_file : m_additional_deps_files)
+        // Parsed along with the framework deps files, once the rid graph is known
+        for (size_t i = 0; i < m_additional_deps_files.size(); ++i)
         {
-            m_additional_deps.push_back(std::unique_ptr<deps_json_t>(
-                new deps_json_t(true, json_file, rids)));
+            m_additional_deps.push_back(std::unique_ptr<deps_json_t>(new deps_json_t()));
         }
     }
 
@@ -695,6 +757,8 @@ namespace coreload
         pal::string_t* output,
         std::unordered_set<pal::string_t>* breadcrumb)
     {
+        trace_duration_t duration("resolve_probe_dirs", deps_entry_t::s_known_asset_types[asset_type]);
+
         bool is_resources = asset_type == deps_entry_t::asset_types::resources;
         assert(is_resources || asset_type == deps_entry_t::asset_types::native);
 
@@ -714,7 +778,7 @@ namespace coreload
         std::unordered_set<pal::string_t> items;
 
         pal::string_t core_servicing = m_core_servicing;
-        pal::realpath(&core_servicing, true);
+        cached_realpath(&core_servicing, true);
 
         // Filter out non-serviced assets so the paths can be added after servicing paths.
         pal::string_t non_serviced;
@@ -742,7 +806,7 @@ namespace coreload
                 return true;
             }
 
-            trace::verbose(_X("Processing native/culture for deps entry [%s, %s, %s]"),
+            TRACE_VERBOSE(_X("Processing native/culture for deps entry [%s, %s, %s]"),
                 entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
 
             if (probe_deps_entry(entry, deps_dir, fx_level, &candidate))
@@ -832,6 +896,30 @@ namespace coreload
     //
     bool deps_resolver_t::resolve_probe_paths(probe_paths_t* probe_paths, std::unordered_set<pal::string_t>* breadcrumb)
     {
+        // Look up every entry in the package layout probes up front
+        std::vector<const deps_entry_t*> entries;
+        for (int type = 0; type < deps_entry_t::asset_types::count; ++type)
+        {
+            auto add_entries = [&entries](const std::vector<deps_entry_t>& deps_entries)
+            {
+                for (const auto& entry : deps_entries)
+                {
+                    entries.push_back(&entry);
+                }
+            };
+
+            auto asset_type = static_cast<deps_entry_t::asset_types>(type);
+            for (const auto& fx : m_fx_definitions)
+            {
+                add_entries(fx->get_deps().get_entries(asset_type));
+            }
+            for (const auto& additional_deps : m_additional_deps)
+            {
+                add_entries(additional_deps->get_entries(asset_type));
+            }
+        }
+        m_probe_index.build(m_probes, entries, &m_thread_pool);
+
         if (!resolve_tpa_list(&probe_paths->tpa, breadcrumb))
         {
             return false;
@@ -10,6 +10,8 @@
 #include "deps_entry.h"
 #include "runtime_config.h"
 #include "libhost.h"
+#include "probe_index.h"
+#include "thread_pool.h"
 
 namespace coreload
 {
@@ -52,28 +54,43 @@ namespace coreload
                 if (i == 0)
                 {
                     m_fx_definitions[i]->set_deps_file(args.deps_path);
-                    trace::verbose(_X("Using %s deps file"), m_fx_definitions[i]->get_deps_file().c_str());
+                    TRACE_VERBOSE(_X("Using %s deps file"), m_fx_definitions[i]->get_deps_file().c_str());
                 }
                 else
                 {
                     pal::string_t fx_deps_file = get_fx_deps(m_fx_definitions[i]->get_dir(), m_fx_definitions[i]->get_name());
                     m_fx_definitions[i]->set_deps_file(fx_deps_file);
-                    trace::verbose(_X("Using Fx %s deps file"), fx_deps_file.c_str());
-                }
-
-                if (i == root_framework)
-                {
-                    m_fx_definitions[i]->parse_deps();
-                }
-                else
-                {
-                    // The rid graph is obtained from the root framework
-                    m_fx_definitions[i]->parse_deps(m_fx_definitions[root_framework]->get_deps().get_rid_fallback_graph());
+                    TRACE_VERBOSE(_X("Using Fx %s deps file"), fx_deps_file.c_str());
                 }
             }
 
+            m_fx_definitions[root_framework]->parse_deps();
+
             resolve_additional_deps(init);
 
+            // The rid graph is obtained from the root framework, the other deps files
+            // only depend on it and on the host rid, and are parsed concurrently.
+            const auto& rid_fallback_graph = m_fx_definitions[root_framework]->get_deps().get_rid_fallback_graph();
+            pal::string_t host_rid;
+            if (root_framework > 0 || !m_additional_deps_files.empty())
+            {
+                host_rid = deps_json_t::get_current_rid(rid_fallback_graph);
+            }
+
+            std::vector<thread_pool_t::task_t> parses;
+            for (int i = root_framework - 1; i >= 0; --i)
+            {
+                fx_definition_t* fx = m_fx_definitions[i].get();
+                parses.push_back([fx, &rid_fallback_graph, &host_rid]() { fx->parse_deps(rid_fallback_graph, host_rid); });
+            }
+            for (size_t i = 0; i < m_additional_deps_files.size(); ++i)
+            {
+                deps_json_t* deps = m_additional_deps[i].get();
+                const pal::string_t* json_file = &m_additional_deps_files[i];
+                parses.push_back([deps, json_file, &rid_fallback_graph, &host_rid]() { deps->parse(true, *json_file, rid_fallback_graph, host_rid); });
+            }
+            m_thread_pool.run(parses);
+
             setup_additional_probes(args.probe_paths);
             setup_probe_config(init, args);
         }
@@ -227,11 +244,17 @@ namespace coreload
         // Various probe configurations.
         std::vector<probe_config_t> m_probes;
 
+        // Where the entries are found in the package layout probes
+        probe_index_t m_probe_index;
+
         // Fallback probe dir
         std::vector<pal::string_t> m_additional_probes;
 
         // Is the deps file for an app using shared frameworks?
         bool m_is_framework_dependent;
+
+        // Runs the independent parts of the resolution
+        thread_pool_t m_thread_pool;
     };
 
 } // namespace coreload
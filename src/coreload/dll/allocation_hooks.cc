@@ -0,0 +1,117 @@
+//
+// allocation_hooks.cc
+// Replacement of the global operator new and delete which feeds the allocation
+// tracker, linked in by builds configured with -DCORELOAD_ALLOCATION_TRACKING=ON.
+//
+
+#include "allocation_tracker.h"
+#include <cstdlib>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace
+{
+    size_t usable_size(void* p)
+    {
+#if defined(_WIN32)
+        return _msize(p);
+#elif defined(__APPLE__)
+        return malloc_size(p);
+#else
+        return malloc_usable_size(p);
+#endif
+    }
+
+    void* allocate(size_t size) noexcept
+    {
+        void* p = std::malloc(size == 0 ? 1 : size);
+        if (p != nullptr)
+        {
+            coreload::allocation_tracker_t::on_allocate(usable_size(p));
+        }
+        return p;
+    }
+
+    void* allocate_or_throw(size_t size)
+    {
+        void* p = allocate(size);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void release(void* p) noexcept
+    {
+        if (p != nullptr)
+        {
+            coreload::allocation_tracker_t::on_free(usable_size(p));
+            std::free(p);
+        }
+    }
+
+    struct allocation_hooks_t
+    {
+        allocation_hooks_t()
+        {
+            coreload::allocation_tracker_t::set_enabled();
+        }
+    } g_allocation_hooks;
+}
+
+void* operator new(size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
@@ -26,42 +26,114 @@ bool inline IsValidCoreHostArgument(
     return ValidateArgument(argument, max_size) == coreload::StatusCode::Success;
 }
 
-// Start the .NET Core runtime in the current application
-int StartCoreCLRInternal(
-    const coreload::pal::char_t*  assembly_path,
-    const coreload::pal::char_t*  core_root,
-    const unsigned char verbose_log)
+// Get the host arguments for starting the .NET Core runtime
+void GetHostArguments(
+    const core_host_arguments* arguments,
+    coreload::arguments_t* host_arguments,
+    coreload::host_startup_info_t* startup_info)
 {
-    if (verbose_log)
+    if (arguments->verbose)
     {
         coreload::trace::enable();
     }
-    coreload::host_startup_info_t startup_info;
-    coreload::arguments_t arguments;
-  
-    startup_info.dotnet_root = core_root;
 
-    arguments.managed_application = assembly_path;
-    arguments.app_root = coreload::get_directory(arguments.managed_application);
+    startup_info->dotnet_root = arguments->core_root_path;
 
-    return coreload::corehost::initialize_clr(
-        arguments,
-        startup_info,
-        coreload::host_mode_t::muxer);
+    host_arguments->managed_application = arguments->assembly_file_path;
+    host_arguments->app_root = coreload::get_directory(host_arguments->managed_application);
+}
+
+bool IsValidStartArgument(const core_host_arguments* arguments)
+{
+    return arguments != nullptr
+        && IsValidCoreHostArgument(arguments->assembly_file_path, MAX_PATH)
+        && IsValidCoreHostArgument(arguments->core_root_path, MAX_PATH);
 }
 
 // Host the .NET Core runtime in the current application
 SHARED_API int StartCoreCLR(
     const core_host_arguments* arguments)
 {
-    if (arguments == nullptr 
-        || !IsValidCoreHostArgument(arguments->assembly_file_path, MAX_PATH)
-        || !IsValidCoreHostArgument(arguments->core_root_path, MAX_PATH))
+    if (!IsValidStartArgument(arguments))
     {
         return coreload::StatusCode::InvalidArgFailure;
     }
 
-    return StartCoreCLRInternal(arguments->assembly_file_path, arguments->core_root_path, arguments->verbose);
+    coreload::host_startup_info_t startup_info;
+    coreload::arguments_t host_arguments;
+    GetHostArguments(arguments, &host_arguments, &startup_info);
+
+    return coreload::corehost::initialize_clr(
+        host_arguments,
+        startup_info,
+        coreload::host_mode_t::muxer);
+}
+
+// Host the .NET Core runtime in the current application from a thread of its own
+SHARED_API int StartCoreCLRAsync(
+    const core_host_arguments* arguments,
+    start_coreclr_callback     callback,
+    void*                      context,
+    void**                     handle)
+{
+    if (!IsValidStartArgument(arguments) || handle == nullptr)
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    coreload::host_startup_info_t startup_info;
+    coreload::arguments_t host_arguments;
+    GetHostArguments(arguments, &host_arguments, &startup_info);
+
+    std::shared_ptr<coreload::startup_task_t> task;
+    int exit_code = coreload::corehost::initialize_clr_async(
+        host_arguments,
+        startup_info,
+        coreload::host_mode_t::muxer,
+        callback,
+        context,
+        &task);
+
+    *handle = SUCCEEDED(exit_code) ? new std::shared_ptr<coreload::startup_task_t>(task) : nullptr;
+    return exit_code;
+}
+
+// Check whether a runtime start has finished
+SHARED_API int PollStartCoreCLR(
+    void* handle,
+    int*  completed,
+    int*  exit_code)
+{
+    return WaitStartCoreCLR(handle, 0, completed, exit_code);
+}
+
+// Wait for a runtime start to finish
+SHARED_API int WaitStartCoreCLR(
+    void*    handle,
+    uint32_t timeout_ms,
+    int*     completed,
+    int*     exit_code)
+{
+    if (handle == nullptr || completed == nullptr || exit_code == nullptr)
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    const auto& task = *static_cast<std::shared_ptr<coreload::startup_task_t>*>(handle);
+    *completed = (timeout_ms == 0 ? task->try_get_result(exit_code) : task->wait(timeout_ms, exit_code)) ? 1 : 0;
+    return coreload::StatusCode::Success;
+}
+
+// Release a handle from StartCoreCLRAsync
+SHARED_API int CloseStartCoreCLR(void* handle)
+{
+    if (handle == nullptr)
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    delete static_cast<std::shared_ptr<coreload::startup_task_t>*>(handle);
+    return coreload::StatusCode::Success;
 }
 
 // Create a native function delegate for a function inside a .NET assembly
@@ -79,46 +151,66 @@ SHARED_API int CreateAssemblyDelegate(
     );
 }
 
-// Execute a method from a class located inside a .NET assembly
-int ExecuteAssemblyClassFunction(
-    const char* assembly,
-    const char* type,
-    const char* entry,
-    const unsigned char* arguments)
+// Create the native function delegates of several functions inside .NET assemblies
+SHARED_API int CreateAssemblyDelegates(
+    const delegate_request* requests,
+    size_t                  count,
+    void**                  delegates)
 {
-    int exit_code = coreload::StatusCode::HostApiFailed;
-    typedef void (STDMETHODCALLTYPE load_plugin_fn)(const void *load_plugin_arguments);
-    load_plugin_fn* load_plugin_delegate = nullptr;
-
-    if (SUCCEEDED(exit_code = CreateAssemblyDelegate(assembly, type, entry, reinterpret_cast<PVOID*>(&load_plugin_delegate))))
+    if (count != 0 && (requests == nullptr || delegates == nullptr))
     {
-        remote_entry_info entry_info = { 0 };
-        entry_info.host_process_id = GetCurrentProcessId();
+        return coreload::StatusCode::InvalidArgFailure;
+    }
 
-        const auto remote_arguments = reinterpret_cast<const core_load_arguments*>(arguments);
-        if (remote_arguments != nullptr)
-        {
-            // Construct and pass the remote user parameters to the .NET delegate
-            entry_info.arguments.user_data_size = remote_arguments->user_data_size;
-            entry_info.arguments.user_data = remote_arguments->user_data_size ? remote_arguments->user_data : nullptr;
+    std::vector<coreload::corehost::delegate_name_t> names(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        names[i] = { requests[i].assembly_name, requests[i].type_name, requests[i].method_name };
+    }
 
-            load_plugin_delegate(&entry_info);
-        }
-        else
+    std::vector<int> statuses(count);
+    int exit_code = coreload::corehost::create_delegates(names.data(), count, delegates, statuses.data());
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (requests[i].status != nullptr)
         {
-            // No arguments were supplied to pass to the delegate function
-            load_plugin_delegate(nullptr);
+            *requests[i].status = statuses[i];
         }
     }
+    return exit_code;
+}
+
+// Call a delegate created for a method taking a remote_entry_info
+void InvokeLoadPluginDelegate(
+    void* delegate,
+    const unsigned char* arguments)
+{
+    typedef void (STDMETHODCALLTYPE load_plugin_fn)(const void *load_plugin_arguments);
+    load_plugin_fn* load_plugin_delegate = reinterpret_cast<load_plugin_fn*>(delegate);
+
+    remote_entry_info entry_info = { 0 };
+    entry_info.host_process_id = coreload::pal::get_pid();
+
+    const auto remote_arguments = reinterpret_cast<const core_load_arguments*>(arguments);
+    if (remote_arguments != nullptr)
+    {
+        // Construct and pass the remote user parameters to the .NET delegate
+        entry_info.arguments.user_data_size = remote_arguments->user_data_size;
+        entry_info.arguments.user_data = remote_arguments->user_data_size ? remote_arguments->user_data : nullptr;
+
+        load_plugin_delegate(&entry_info);
+    }
     else
     {
-        exit_code = coreload::StatusCode::InvalidArgFailure;
+        // No arguments were supplied to pass to the delegate function
+        load_plugin_delegate(nullptr);
     }
-    return exit_code;
 }
 
-// Execute a function located in a .NET assembly by creating a native delegate
-SHARED_API int ExecuteAssemblyFunction(const assembly_function_call* arguments) 
+// Get the delegate cache entry for a function named by host strings
+int GetAssemblyFunctionEntry(
+    const assembly_function_call* arguments,
+    const coreload::delegate_cache_t::entry_t** entry)
 {
     if (arguments == nullptr 
         || !IsValidCoreHostArgument(arguments->assembly_name, max_function_name_size)
@@ -128,12 +220,60 @@ SHARED_API int ExecuteAssemblyFunction(const assembly_function_call* arguments)
         return coreload::StatusCode::InvalidArgFailure;
     }
 
+#if defined(_WIN32)
     std::vector<char> assembly_name, class_name, function_name;
     coreload::pal::pal_clrstring(arguments->assembly_name, &assembly_name);
     coreload::pal::pal_clrstring(arguments->class_name, &class_name);
     coreload::pal::pal_clrstring(arguments->function_name, &function_name);
 
-    return ExecuteAssemblyClassFunction(assembly_name.data(), class_name.data(), function_name.data(), arguments->arguments);
+    int exit_code = coreload::corehost::get_delegate_entry(assembly_name.data(), class_name.data(), function_name.data(), entry);
+#else
+    // Host strings are UTF-8 already
+    int exit_code = coreload::corehost::get_delegate_entry(arguments->assembly_name, arguments->class_name, arguments->function_name, entry);
+#endif
+    return SUCCEEDED(exit_code) ? exit_code : coreload::StatusCode::InvalidArgFailure;
+}
+
+// Execute a function located in a .NET assembly by creating a native delegate
+SHARED_API int ExecuteAssemblyFunction(const assembly_function_call* arguments) 
+{
+    const coreload::delegate_cache_t::entry_t* entry = nullptr;
+    int exit_code = GetAssemblyFunctionEntry(arguments, &entry);
+    if (SUCCEEDED(exit_code))
+    {
+        InvokeLoadPluginDelegate(entry->delegate, arguments->arguments);
+    }
+    return exit_code;
+}
+
+// Get a handle to the delegate of a function located in a .NET assembly
+SHARED_API int GetAssemblyFunctionHandle(
+    const assembly_function_call* arguments,
+    void** handle)
+{
+    if (handle == nullptr)
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    const coreload::delegate_cache_t::entry_t* entry = nullptr;
+    int exit_code = GetAssemblyFunctionEntry(arguments, &entry);
+    *handle = SUCCEEDED(exit_code) ? const_cast<coreload::delegate_cache_t::entry_t*>(entry) : nullptr;
+    return exit_code;
+}
+
+// Execute a function by the handle to its delegate
+SHARED_API int ExecuteAssemblyFunctionHandle(
+    void* handle,
+    const unsigned char* arguments)
+{
+    if (handle == nullptr)
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    InvokeLoadPluginDelegate(static_cast<const coreload::delegate_cache_t::entry_t*>(handle)->delegate, arguments);
+    return coreload::StatusCode::Success;
 }
 
 // Shutdown the .NET Core runtime
@@ -142,6 +282,62 @@ SHARED_API int UnloadRuntime()
     return coreload::corehost::unload_runtime();
 }
 
+// Get the phase timings and counters of the last runtime start
+SHARED_API int GetHostStartupMetrics(host_startup_metrics* metrics)
+{
+    if (metrics == nullptr || metrics->size < offsetof(host_startup_metrics, runtime_config))
+    {
+        return coreload::StatusCode::InvalidArgFailure;
+    }
+
+    const auto snapshot = coreload::corehost::get_startup_metrics();
+    const auto& phases = snapshot.phases;
+    typedef coreload::startup_metrics_t::phase_t phase_t;
+    auto phase = [&phases](phase_t phase) -> host_startup_phase
+    {
+        const auto& times = phases[static_cast<size_t>(phase)];
+        return { times.start_ns, times.end_ns };
+    };
+    auto allocations = [](const coreload::startup_metrics_t::allocations_t& counts) -> host_startup_allocations
+    {
+        return { counts.allocations, counts.bytes, counts.peak_live_bytes };
+    };
+    auto phase_allocations = [&snapshot, &allocations](phase_t phase)
+    {
+        return allocations(snapshot.phase_allocations[static_cast<size_t>(phase)]);
+    };
+
+    host_startup_metrics result = { 0 };
+    result.size = metrics->size;
+    result.startup_cache_hit = snapshot.startup_cache_hit ? 1 : 0;
+    result.start_time = snapshot.start_ns;
+    result.end_time = snapshot.end_ns;
+    result.runtime_config = phase(phase_t::runtime_config);
+    result.framework_resolution = phase(phase_t::framework_resolution);
+    result.deps_resolution = phase(phase_t::deps_resolution);
+    result.tpa_probe = phase(phase_t::tpa_probe);
+    result.coreclr_bind = phase(phase_t::coreclr_bind);
+    result.coreclr_initialize = phase(phase_t::coreclr_initialize);
+    result.files_checked = snapshot.files_checked;
+    result.directories_read = snapshot.directories_read;
+    result.json_bytes_parsed = snapshot.json_bytes_parsed;
+    result.tpa_entries = snapshot.tpa_entries;
+    result.framework_resolve_retries = snapshot.framework_resolve_retries;
+    result.allocations_tracked = snapshot.allocations_tracked ? 1 : 0;
+    result.allocations = allocations(snapshot.allocations);
+    result.runtime_config_allocations = phase_allocations(phase_t::runtime_config);
+    result.framework_resolution_allocations = phase_allocations(phase_t::framework_resolution);
+    result.deps_resolution_allocations = phase_allocations(phase_t::deps_resolution);
+    result.tpa_probe_allocations = phase_allocations(phase_t::tpa_probe);
+    result.coreclr_bind_allocations = phase_allocations(phase_t::coreclr_bind);
+    result.coreclr_initialize_allocations = phase_allocations(phase_t::coreclr_initialize);
+
+    // Callers built against an older, smaller structure get its fields only
+    memcpy(metrics, &result, std::min(static_cast<size_t>(metrics->size), sizeof(result)));
+    return coreload::StatusCode::Success;
+}
+
+#if defined(_WIN32)
 BOOL APIENTRY DllMain(
     HMODULE hModule,
     DWORD   ul_reason_for_call,
@@ -158,3 +354,4 @@ BOOL APIENTRY DllMain(
     }
     return TRUE;
 }
+#endif
@@ -31,6 +31,15 @@ struct assembly_function_call
     unsigned char           arguments[assembly_function_arguments_size];
 };
 
+// A method to create a native function delegate for with CreateAssemblyDelegates
+struct delegate_request
+{
+    const char* assembly_name;
+    const char* type_name;
+    const char* method_name;
+    int*        status;         // Optional, receives the result for this method
+};
+
 struct core_load_arguments
 {
     const unsigned char* user_data;
@@ -43,6 +52,62 @@ struct remote_entry_info
     core_load_arguments arguments;
 };
 
+// Monotonic clock readings, in nanoseconds, at the start and end of a phase of
+// StartCoreCLR. A phase which did not run has a zero start, one which failed a zero end.
+struct host_startup_phase
+{
+    uint64_t start_time;
+    uint64_t end_time;
+};
+
+// Heap allocations of the whole process during a phase of StartCoreCLR, with the
+// highest amount of allocated bytes not freed yet above what was live when it began.
+struct host_startup_allocations
+{
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t peak_live_bytes;
+};
+
+// Timings and counters of the last call to StartCoreCLR. 'size' is set by the caller
+// to the size of the structure it was compiled with, fields past it are not written.
+struct host_startup_metrics
+{
+    uint32_t            size;
+    uint32_t            startup_cache_hit;
+    uint64_t            start_time;
+    uint64_t            end_time;
+    host_startup_phase  runtime_config;
+    host_startup_phase  framework_resolution;
+    host_startup_phase  deps_resolution;
+    host_startup_phase  tpa_probe;
+    host_startup_phase  coreclr_bind;
+    host_startup_phase  coreclr_initialize;
+    uint64_t            files_checked;
+    uint64_t            directories_read;
+    uint64_t            json_bytes_parsed;
+    uint64_t            tpa_entries;
+    uint32_t            framework_resolve_retries;
+    uint32_t            reserved;
+
+    // Zero unless the library was built with -DCORELOAD_ALLOCATION_TRACKING=ON
+    uint32_t                    allocations_tracked;
+    uint32_t                    reserved2;
+    host_startup_allocations    allocations;
+    host_startup_allocations    runtime_config_allocations;
+    host_startup_allocations    framework_resolution_allocations;
+    host_startup_allocations    deps_resolution_allocations;
+    host_startup_allocations    tpa_probe_allocations;
+    host_startup_allocations    coreclr_bind_allocations;
+    host_startup_allocations    coreclr_initialize_allocations;
+};
+
+// Called once a start made with StartCoreCLRAsync finished, on the thread it ran on
+typedef void (STDMETHODCALLTYPE *start_coreclr_callback)(int exit_code, void* context);
+
+// Timeout of WaitStartCoreCLR which waits for as long as the start takes
+#define START_CORECLR_INFINITE                  0xFFFFFFFF
+
 // DLL exports used for starting, executing in, and stopping the .NET Core runtime
 
 // Create a native function delegate for a function inside a .NET assembly
@@ -53,13 +118,70 @@ SHARED_API int CreateAssemblyDelegate(
     void**      pfnDelegate
 );
 
+// Create the native function delegates of several functions inside .NET assemblies.
+// 'delegates' receives one for each request, or nullptr for those which failed, and
+// the result of the first which failed is returned.
+SHARED_API int CreateAssemblyDelegates(
+    const delegate_request* requests,
+    size_t                  count,
+    void**                  delegates
+);
+
 // Execute a function located in a .NET assembly by creating a native delegate
 SHARED_API int ExecuteAssemblyFunction(const assembly_function_call* arguments);
 
+// Get a handle to the delegate of a function located in a .NET assembly, for
+// executing it without looking it up again. The handle is valid until UnloadRuntime.
+SHARED_API int GetAssemblyFunctionHandle(
+    const assembly_function_call* arguments,
+    void**                        handle
+);
+
+// Execute a function by a handle from GetAssemblyFunctionHandle, passing it
+// arguments as in assembly_function_call
+SHARED_API int ExecuteAssemblyFunctionHandle(
+    void*                handle,
+    const unsigned char* arguments
+);
+
 // Host the .NET Core runtime in the current application
 SHARED_API int StartCoreCLR(const core_host_arguments* arguments);
 
+// Host the .NET Core runtime in the current application, starting it on a thread of
+// its own. 'handle' receives a handle for polling or waiting on the start, to be
+// released with CloseStartCoreCLR, and the optional 'callback' is called once it
+// finishes. Delegates requested before then wait for the runtime to be ready.
+SHARED_API int StartCoreCLRAsync(
+    const core_host_arguments* arguments,
+    start_coreclr_callback     callback,
+    void*                      context,
+    void**                     handle
+);
+
+// Check whether a runtime start has finished. 'completed' is set to 1 if it has,
+// with its result in 'exit_code', or to 0.
+SHARED_API int PollStartCoreCLR(
+    void* handle,
+    int*  completed,
+    int*  exit_code
+);
+
+// Wait up to 'timeout_ms' milliseconds, or START_CORECLR_INFINITE, for a runtime
+// start to finish, setting 'completed' and 'exit_code' as PollStartCoreCLR does
+SHARED_API int WaitStartCoreCLR(
+    void*    handle,
+    uint32_t timeout_ms,
+    int*     completed,
+    int*     exit_code
+);
+
+// Release a handle from StartCoreCLRAsync, which does not stop the start
+SHARED_API int CloseStartCoreCLR(void* handle);
+
 // Stop the .NET Core host in the current application
 SHARED_API int UnloadRuntime();
 
+// Get the phase timings and counters of the last runtime start
+SHARED_API int GetHostStartupMetrics(host_startup_metrics* metrics);
+
 #endif // CORELOAD_DLL_H_
\ No newline at end of file
@@ -4,7 +4,9 @@
 
 // If you wish to build your application for a previous Windows platform, include WinSDKVer.h and
 // set the _WIN32_WINNT macro to the platform you wish to support before including SDKDDKVer.h.
+#if defined(_WIN32)
 #include <SDKDDKVer.h>
+#endif
 
 #ifndef CORELOAD_STRINGIFY
 #define CORELOAD_STRINGIFY(x)    CORELOAD_STRINGIFY_(x)
@@ -73,7 +73,7 @@ namespace coreload
 
                     if (pal::directory_exists(fx_dir))
                     {
-                        trace::verbose(_X("Gathering FX locations in [%s]"), fx_dir.c_str());
+                        TRACE_VERBOSE(_X("Gathering FX locations in [%s]"), fx_dir.c_str());
 
                         std::vector<pal::string_t> versions;
                         pal::readdir_onlydirectories(fx_dir, &versions);
@@ -83,7 +83,7 @@ namespace coreload
                             fx_ver_t parsed;
                             if (fx_ver_t::parse(ver, &parsed, false))
                             {
-                                trace::verbose(_X("Found FX version [%s]"), ver.c_str());
+                                TRACE_VERBOSE(_X("Found FX version [%s]"), ver.c_str());
 
                                 framework_info info(fx_name, fx_dir, parsed);
                                 framework_infos->push_back(info);
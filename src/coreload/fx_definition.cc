@@ -32,8 +32,8 @@ namespace coreload
         m_deps.parse(false, m_deps_file);
     }
 
-    void fx_definition_t::parse_deps(const deps_json_t::rid_fallback_graph_t& graph)
+    void fx_definition_t::parse_deps(const deps_json_t::rid_fallback_graph_t& graph, const pal::string_t& host_rid)
     {
-        m_deps.parse(true, m_deps_file, graph);
+        m_deps.parse(true, m_deps_file, graph, host_rid);
     }
 } // namespace coreload
\ No newline at end of file
@@ -28,7 +28,7 @@ namespace coreload
         void set_deps_file(const pal::string_t value) { m_deps_file = value; }
         const deps_json_t& get_deps() const { return m_deps; }
         void parse_deps();
-        void parse_deps(const deps_json_t::rid_fallback_graph_t& graph);
+        void parse_deps(const deps_json_t::rid_fallback_graph_t& graph, const pal::string_t& host_rid);
 
     private:
         pal::string_t m_name;
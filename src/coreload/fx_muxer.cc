@@ -5,6 +5,10 @@
 #include "fx_muxer.h"
 #include "deps_resolver.h"
 #include "coreclr.h"
+#include "dir_cache.h"
+#include "startup_cache.h"
+#include "startup_metrics.h"
+#include "trace_events.h"
 
 namespace coreload
 {
@@ -14,31 +18,34 @@ namespace coreload
     */
     pal::string_t resolve_hostpolicy_version_from_deps(const pal::string_t& deps_json)
     {
-        trace::verbose(_X("--- Resolving %s version from deps json [%s]"), LIBHOSTPOLICY_NAME, deps_json.c_str());
+        TRACE_VERBOSE(_X("--- Resolving %s version from deps json [%s]"), LIBHOSTPOLICY_NAME, deps_json.c_str());
 
         pal::string_t retval;
         if (!pal::file_exists(deps_json))
         {
-            trace::verbose(_X("Dependency manifest [%s] does not exist"), deps_json.c_str());
+            TRACE_VERBOSE(_X("Dependency manifest [%s] does not exist"), deps_json.c_str());
             return retval;
         }
 
-        pal::ifstream_t file(deps_json);
-        if (!file.good())
+        std::vector<char> contents;
+        if (!read_file(deps_json, &contents))
         {
-            trace::verbose(_X("Dependency manifest [%s] could not be opened"), deps_json.c_str());
+            TRACE_VERBOSE(_X("Dependency manifest [%s] could not be opened"), deps_json.c_str());
             return retval;
         }
 
-        if (skip_utf8_bom(&file))
+        const char* begin = contents.data();
+        const char* end = begin + contents.size();
+        if (skip_utf8_bom(&begin, end))
         {
-            trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), deps_json.c_str());
+            TRACE_VERBOSE(_X("UTF-8 BOM skipped while reading [%s]"), deps_json.c_str());
         }
 
         try
         {
-            const auto root = json_value::parse(file);
-            const auto& json = root.as_object();
+            const auto document = web::json::document::parse(begin, end);
+            trace_json_memory(deps_json, document);
+            const auto& json = document.root().as_object();
             const auto& libraries = json.at(_X("libraries")).as_object();
 
             // Look up the root package instead of the "runtime" package because we can't do a full rid resolution.
@@ -60,7 +67,7 @@ namespace coreload
             (void)pal::utf8_palstring(je.what(), &jes);
             trace::error(_X("A JSON parsing exception occurred in [%s]: %s"), deps_json.c_str(), jes.c_str());
         }
-        trace::verbose(_X("Resolved version %s from dependency manifest file [%s]"), retval.c_str(), deps_json.c_str());
+        TRACE_VERBOSE(_X("Resolved version %s from dependency manifest file [%s]"), retval.c_str(), deps_json.c_str());
         return retval;
     }
 
@@ -119,7 +126,7 @@ namespace coreload
         bool patch_roll_fwd,
         roll_fwd_on_no_candidate_fx_option roll_fwd_on_no_candidate_fx)
     {
-        trace::verbose(_X("Attempting FX roll forward starting from [%s]"), fx_ver.c_str());
+        TRACE_VERBOSE(_X("Attempting FX roll forward starting from [%s]"), fx_ver.c_str());
 
         fx_ver_t most_compatible = specified;
         if (!specified.is_prerelease())
@@ -129,7 +136,7 @@ namespace coreload
                 fx_ver_t next_lowest(-1, -1, -1);
 
                 // Look for the least production version
-                trace::verbose(_X("'Roll forward on no candidate fx' enabled with value [%d]. Looking for the least production greater than or equal to [%s]"),
+                TRACE_VERBOSE(_X("'Roll forward on no candidate fx' enabled with value [%d]. Looking for the least production greater than or equal to [%s]"),
                     roll_fwd_on_no_candidate_fx, fx_ver.c_str());
 
                 for (const auto& ver : version_list)
@@ -151,7 +158,7 @@ namespace coreload
                 if (next_lowest == fx_ver_t(-1, -1, -1))
                 {
                     // Look for the least preview version
-                    trace::verbose(_X("No production greater than or equal to [%s] found. Looking for the least preview greater than [%s]"),
+                    TRACE_VERBOSE(_X("No production greater than or equal to [%s] found. Looking for the least preview greater than [%s]"),
                         fx_ver.c_str(), fx_ver.c_str());
 
                     for (const auto& ver : version_list)
@@ -173,21 +180,21 @@ namespace coreload
 
                 if (next_lowest == fx_ver_t(-1, -1, -1))
                 {
-                    trace::verbose(_X("No preview greater than or equal to [%s] found."), fx_ver.c_str());
+                    TRACE_VERBOSE(_X("No preview greater than or equal to [%s] found."), fx_ver.c_str());
                 }
                 else
                 {
-                    trace::verbose(_X("Found version [%s]"), next_lowest.as_str().c_str());
+                    TRACE_VERBOSE(_X("Found version [%s]"), next_lowest.as_str().c_str());
                     most_compatible = next_lowest;
                 }
             }
 
             if (patch_roll_fwd)
             {
-                trace::verbose(_X("Applying patch roll forward from [%s]"), most_compatible.as_str().c_str());
+                TRACE_VERBOSE(_X("Applying patch roll forward from [%s]"), most_compatible.as_str().c_str());
                 for (const auto& ver : version_list)
                 {
-                    trace::verbose(_X("Inspecting version... [%s]"), ver.as_str().c_str());
+                    TRACE_VERBOSE(_X("Inspecting version... [%s]"), ver.as_str().c_str());
 
                     if (most_compatible.is_prerelease() == ver.is_prerelease() && // prevent production from rolling forward to preview on patch
                         ver.get_major() == most_compatible.get_major() &&
@@ -203,7 +210,7 @@ namespace coreload
         {
             for (const auto& ver : version_list)
             {
-                trace::verbose(_X("Inspecting version... [%s]"), ver.as_str().c_str());
+                TRACE_VERBOSE(_X("Inspecting version... [%s]"), ver.as_str().c_str());
 
                 //both production and prerelease.
                 if (ver.is_prerelease() && // prevent roll forward to production.
@@ -227,12 +234,14 @@ namespace coreload
         const pal::string_t& dotnet_dir
     )
     {
+        trace_duration_t duration("resolve_fx", fx_ref.get_fx_name());
+
         assert(!fx_ref.get_fx_name().empty());
         assert(!fx_ref.get_fx_version().empty());
         assert(fx_ref.get_patch_roll_fwd() != nullptr);
         assert(fx_ref.get_roll_fwd_on_no_candidate_fx() != nullptr);
 
-        trace::verbose(_X("--- Resolving FX directory, name '%s' version '%s'"),
+        TRACE_VERBOSE(_X("--- Resolving FX directory, name '%s' version '%s'"),
             fx_ref.get_fx_name().c_str(), fx_ref.get_fx_version().c_str());
 
         const auto fx_ver = fx_ref.get_fx_version();
@@ -277,7 +286,7 @@ namespace coreload
         for (pal::string_t dir : hive_dir)
         {
             auto fx_dir = dir;
-            trace::verbose(_X("Searching FX directory in [%s]"), fx_dir.c_str());
+            TRACE_VERBOSE(_X("Searching FX directory in [%s]"), fx_dir.c_str());
 
             append_path(&fx_dir, _X("shared"));
             append_path(&fx_dir, fx_ref.get_fx_name().c_str());
@@ -301,7 +310,7 @@ namespace coreload
 
             if (!do_roll_forward)
             {
-                trace::verbose(_X("Did not roll forward because patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d, use_exact_version=%d chose [%s]"),
+                TRACE_VERBOSE(_X("Did not roll forward because patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d, use_exact_version=%d chose [%s]"),
                     *(fx_ref.get_patch_roll_fwd()), *(fx_ref.get_roll_fwd_on_no_candidate_fx()), fx_ref.get_use_exact_version(), fx_ver.c_str());
 
                 append_path(&fx_dir, fx_ver.c_str());
@@ -345,7 +354,7 @@ namespace coreload
 
                     if (resolved_ver != selected_ver)
                     {
-                        trace::verbose(_X("Changing Selected FX version from [%s] to [%s]"), selected_fx_dir.c_str(), fx_dir.c_str());
+                        TRACE_VERBOSE(_X("Changing Selected FX version from [%s] to [%s]"), selected_fx_dir.c_str(), fx_dir.c_str());
                         selected_ver = resolved_ver;
                         selected_fx_dir = fx_dir;
                         selected_fx_version = resolved_ver_str;
@@ -360,7 +369,7 @@ namespace coreload
             return nullptr;
         }
 
-        trace::verbose(_X("Chose FX version [%s]"), selected_fx_dir.c_str());
+        TRACE_VERBOSE(_X("Chose FX version [%s]"), selected_fx_dir.c_str());
 
         return new fx_definition_t(fx_ref.get_fx_name(), selected_fx_dir, oldest_requested_version, selected_fx_version);
     }
@@ -399,12 +408,12 @@ namespace coreload
                 }
                 else
                 {
-                    trace::verbose(_X("Ignoring host interpreted additional probing path %s as it does not exist."), probe_path.c_str());
+                    TRACE_VERBOSE(_X("Ignoring host interpreted additional probing path %s as it does not exist."), probe_path.c_str());
                 }
             }
             else
             {
-                trace::verbose(_X("Ignoring additional probing path %s as it does not exist."), probe_path.c_str());
+                TRACE_VERBOSE(_X("Ignoring additional probing path %s as it does not exist."), probe_path.c_str());
             }
         }
     }
@@ -416,9 +425,11 @@ namespace coreload
         const fx_reference_t& override_settings
     )
     {
+        trace_duration_t duration("read_config", app_candidate);
+
         pal::string_t config_file, dev_config_file;
         // First, attempt to load the runtime config using the app path.
-        trace::verbose(_X("App runtimeconfig.json from [%s]"), app_candidate.c_str());
+        TRACE_VERBOSE(_X("App runtimeconfig.json from [%s]"), app_candidate.c_str());
         get_runtime_config_paths_from_app(app_candidate, &config_file, &dev_config_file);
 
         // If the application.runtime.config doesn't exist, try using the global config.
@@ -429,7 +440,7 @@ namespace coreload
                 trace::error(_X("The specified runtimeconfig.json [%s] does not exist"), runtime_config.c_str());
                 return StatusCode::InvalidConfigFile;
             }
-            trace::verbose(_X("Specified runtimeconfig.json from [%s]"), runtime_config.c_str());
+            TRACE_VERBOSE(_X("Specified runtimeconfig.json from [%s]"), runtime_config.c_str());
             get_runtime_config_paths_from_arg(runtime_config, &config_file, &dev_config_file);
         }
 
@@ -485,7 +496,7 @@ namespace coreload
         }
 
         // Check if hostpolicy exists in "expected" directory.
-        trace::verbose(_X("The expected %s directory is [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
+        TRACE_VERBOSE(_X("The expected %s directory is [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
         if (library_exists_in_dir(expected, LIBHOSTPOLICY_NAME, nullptr))
         {
             impl_dir->assign(expected);
@@ -724,6 +735,39 @@ namespace coreload
             return StatusCode::InvalidArgFailure;
         }
 
+        // Starting the same app again resolves to the same runtime as long as nothing the
+        // resolution read has changed; reuse the result then.
+        const startup_cache_t::key_t startup_key = { arguments.managed_application, arguments.app_root, arguments.deps_path, host_info.dotnet_root, mode };
+        const pal::string_t startup_cache_path = startup_cache_t::get_path(startup_key);
+        if (!startup_cache_path.empty())
+        {
+            startup_cache_t startup_cache;
+            if (startup_cache.load(startup_cache_path, startup_key))
+            {
+                std::vector<const char*> property_keys;
+                std::vector<const char*> property_values;
+                for (size_t i = 0; i < startup_cache.property_keys.size(); ++i)
+                {
+                    property_keys.push_back(startup_cache.property_keys[i].c_str());
+                    property_values.push_back(startup_cache.property_values[i].c_str());
+                }
+
+                startup_metrics_t* metrics = startup_metrics_t::active();
+                if (metrics != nullptr)
+                {
+                    metrics->set_startup_cache_hit();
+                }
+
+                return initialize_coreclr(arguments, startup_cache.clr_path, startup_cache.clr_dir, property_keys, property_values, domain_id, host_handle);
+            }
+        }
+
+        // Record what the resolution reads, for the next start to validate the cache against.
+        startup_inputs_t startup_inputs;
+        startup_inputs_scope_t startup_inputs_scope(startup_cache_path.empty() ? nullptr : &startup_inputs);
+
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::runtime_config);
+
         pal::string_t runtime_config = host_info.dotnet_root;
         append_path(&runtime_config, _X("dotnet.runtimeconfig.json"));
 
@@ -756,6 +800,9 @@ namespace coreload
             return rc;
         }
 
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::runtime_config);
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::framework_resolution);
+
         auto app_config = app->get_runtime_config();
         const bool is_framework_dependent = app_config.get_is_framework_dependent();
 
@@ -797,6 +844,14 @@ namespace coreload
                 {
                     fx_definitions.resize(1); // Erase any existing frameworks for re-try
                     rc = read_framework(host_info, override_settings, app_config, newest_references, oldest_references, fx_definitions);
+                    if (rc == FrameworkCompatRetry)
+                    {
+                        startup_metrics_t* metrics = startup_metrics_t::active();
+                        if (metrics != nullptr)
+                        {
+                            metrics->add_framework_resolve_retry();
+                        }
+                    }
                 } while (rc == FrameworkCompatRetry && retry_count++ < Max_Framework_Resolve_Retries);
 
                 assert(retry_count < Max_Framework_Resolve_Retries);
@@ -807,6 +862,10 @@ namespace coreload
                 }
             }
         }
+
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::framework_resolution);
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::deps_resolution);
+
         // Append specified probe paths first and then config file probe paths into realpaths.
         std::vector<pal::string_t> probe_realpaths;
 
@@ -827,7 +886,7 @@ namespace coreload
             }
         }
 
-        trace::verbose(_X("Executing as a %s app as per config file [%s]"),
+        TRACE_VERBOSE(_X("Executing as a %s app as per config file [%s]"),
             (is_framework_dependent ? _X("framework-dependent") : _X("self-contained")), app_config.get_path().c_str());
 
         pal::string_t impl_dir;
@@ -855,6 +914,11 @@ namespace coreload
             arguments.deps_path = get_deps_from_app_binary(arguments.managed_application);
         }
 
+        // Probing asks for the same directories over and over, answer those queries
+        // from a snapshot of each directory for the rest of the resolution.
+        dir_cache_t dir_cache;
+        dir_cache_scope_t dir_cache_scope(&dir_cache);
+
         deps_resolver_t resolver(g_init, arguments);
 
         pal::string_t resolver_errors;
@@ -863,17 +927,21 @@ namespace coreload
             trace::error(_X("Error initializing the dependency resolver: %s"), resolver_errors.c_str());
             return StatusCode::ResolverInitFailure;
         }
+
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::deps_resolution);
         // Setup breadcrumbs. Breadcrumbs are not enabled for API calls because they do not execute
         // the app and may be re-entry
         probe_paths_t probe_paths;
-    
+
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::tpa_probe);
         if (!resolver.resolve_probe_paths(&probe_paths, nullptr))
         {
             return StatusCode::ResolverResolveFailure;
         }
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::tpa_probe);
 
         pal::string_t clr_path = probe_paths.coreclr;
-        if (clr_path.empty() || !pal::realpath(&clr_path))
+        if (clr_path.empty() || !cached_realpath(&clr_path))
         {
             trace::error(_X("Could not resolve CoreCLR path. For more details, enable tracing by setting COREHOST_TRACE environment variable to 1"));;
             return StatusCode::CoreClrResolveFailure;
@@ -900,9 +968,9 @@ namespace coreload
         {
             trace::warning(_X("Could not resolve CLRJit path"));
         }
-        else if (pal::realpath(&clrjit_path))
+        else if (cached_realpath(&clrjit_path))
         {
-            trace::verbose(_X("The resolved JIT path is '%s'"), clrjit_path.c_str());
+            TRACE_VERBOSE(_X("The resolved JIT path is '%s'"), clrjit_path.c_str());
         }
         else
         {
@@ -1009,7 +1077,6 @@ namespace coreload
             property_values.push_back(g_init.cfg_values[i].data());
         }
 
-        size_t property_size = property_keys.size();
         assert(property_keys.size() == property_values.size());
 
         unsigned int exit_code = 1;
@@ -1032,13 +1099,48 @@ namespace coreload
             return exit_code;
         }
 
+        exit_code = initialize_coreclr(arguments, clr_path, clr_dir, property_keys, property_values, domain_id, host_handle);
+        if (exit_code == StatusCode::Success && !startup_cache_path.empty())
+        {
+            startup_cache_t startup_cache;
+            startup_cache.clr_path = clr_path;
+            startup_cache.clr_dir = clr_dir;
+            startup_cache.property_keys.assign(property_keys.begin(), property_keys.end());
+            startup_cache.property_values.assign(property_values.begin(), property_values.end());
+            startup_cache.save(startup_cache_path, startup_key, startup_inputs);
+        }
+        return exit_code;
+    }
+
+    int fx_muxer_t::initialize_coreclr(
+        const arguments_t& arguments,
+        const pal::string_t& clr_path,
+        const pal::string_t& clr_dir,
+        const std::vector<const char*>& property_keys,
+        const std::vector<const char*>& property_values,
+        coreclr::domain_id_t& domain_id,
+        coreclr::host_handle_t& host_handle)
+    {
+        size_t property_size = property_keys.size();
+        assert(property_keys.size() == property_values.size());
+
+        startup_metrics_t* metrics = startup_metrics_t::active();
+        if (metrics != nullptr)
+        {
+            // The TPA list is in the first property, each path followed by a separator
+            const char* tpa = property_size > 0 ? property_values[0] : "";
+            metrics->set_tpa_entries(std::count(tpa, tpa + strlen(tpa), PATH_SEPARATOR));
+        }
+
         // Bind CoreCLR
-        trace::verbose(_X("CoreCLR path = '%s', CoreCLR dir = '%s'"), clr_path.c_str(), clr_dir.c_str());
+        TRACE_VERBOSE(_X("CoreCLR path = '%s', CoreCLR dir = '%s'"), clr_path.c_str(), clr_dir.c_str());
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::coreclr_bind);
         if (!coreclr::bind(clr_dir))
         {
             trace::error(_X("Failed to bind to CoreCLR at '%s'"), clr_path.c_str());
             return StatusCode::CoreClrBindFailure;
         }
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::coreclr_bind);
         
         // Verbose logging
         if (trace::is_enabled())
@@ -1048,7 +1150,7 @@ namespace coreload
                 pal::string_t key, val;
                 pal::clr_palstring(property_keys[i], &key);
                 pal::clr_palstring(property_values[i], &val);
-                trace::verbose(_X("Property %s = %s"), key.c_str(), val.c_str());
+                TRACE_VERBOSE(_X("Property %s = %s"), key.c_str(), val.c_str());
             }
         }
 
@@ -1056,11 +1158,12 @@ namespace coreload
         pal::pal_clrstring(arguments.host_path, &managed_application_path);
 
         // Initialize CoreCLR
+        startup_metrics_t::begin_active_phase(startup_metrics_t::phase_t::coreclr_initialize);
         auto hr = coreclr::initialize(
             managed_application_path.data(),
             "clrhost",
-            property_keys.data(),
-            property_values.data(),
+            const_cast<const char**>(property_keys.data()),
+            const_cast<const char**>(property_values.data()),
             property_size,
             &host_handle,
             &domain_id);
@@ -1068,7 +1171,8 @@ namespace coreload
         {
             trace::error(_X("Failed to initialize CoreCLR, HRESULT: 0x%X"), hr);
             return StatusCode::CoreClrInitFailure;
-        }  
+        }
+        startup_metrics_t::end_active_phase(startup_metrics_t::phase_t::coreclr_initialize);
         return StatusCode::Success;
     }
 } // namespace coreload
\ No newline at end of file
@@ -31,7 +31,25 @@ namespace coreload
             coreclr::domain_id_t& domain_id,
             coreclr::host_handle_t& host_handle);
 
+        // The version a framework reference rolls forward to among the installed
+        // versions, or 'specified' when none is compatible
+        static fx_ver_t resolve_framework_version(
+            const std::vector<fx_ver_t>& version_list,
+            const pal::string_t& fx_ver,
+            const fx_ver_t& specified,
+            bool patch_roll_fwd,
+            roll_fwd_on_no_candidate_fx_option roll_fwd_on_no_candidate_fx);
+
     private:
+        static int initialize_coreclr(
+            const arguments_t& arguments,
+            const pal::string_t& clr_path,
+            const pal::string_t& clr_dir,
+            const std::vector<const char*>& property_keys,
+            const std::vector<const char*>& property_values,
+            coreclr::domain_id_t& domain_id,
+            coreclr::host_handle_t& host_handle);
+
         static bool resolve_hostpolicy_dir(
             host_mode_t mode,
             const pal::string_t& dotnet_root,
@@ -42,12 +60,6 @@ namespace coreload
             const std::vector<pal::string_t>& probe_realpaths,
             pal::string_t* impl_dir);
 
-        static fx_ver_t resolve_framework_version(
-            const std::vector<fx_ver_t>& version_list,
-            const pal::string_t& fx_ver,
-            const fx_ver_t& specified,
-            bool patch_roll_fwd,
-            roll_fwd_on_no_candidate_fx_option roll_fwd_on_no_candidate_fx);
         static int read_framework(
             const host_startup_info_t& host_info,
             const fx_reference_t& override_settings,
@@ -31,7 +31,7 @@ namespace coreload
             assert(lower.get_patch_roll_fwd() != nullptr);
             assert(lower.get_roll_fwd_on_no_candidate_fx() != nullptr);
 
-            trace::verbose(_X("--- The specified framework '%s', version '%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d is compatible with the previously referenced version '%s'."),
+            TRACE_VERBOSE(_X("--- The specified framework '%s', version '%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d is compatible with the previously referenced version '%s'."),
                 lower.get_fx_name().c_str(),
                 lower.get_fx_version().c_str(),
                 *lower.get_patch_roll_fwd(),
@@ -49,7 +49,7 @@ namespace coreload
             assert(fx_new.get_patch_roll_fwd() != nullptr);
             assert(fx_new.get_roll_fwd_on_no_candidate_fx() != nullptr);
 
-            trace::verbose(_X("--- Restarting all framework resolution because the previously resolved framework '%s', version '%s' must be re-resolved with the new version '%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d ."),
+            TRACE_VERBOSE(_X("--- Restarting all framework resolution because the previously resolved framework '%s', version '%s' must be re-resolved with the new version '%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d ."),
                 fx_existing.get_fx_name().c_str(),
                 fx_existing.get_fx_version().c_str(),
                 fx_new.get_fx_version().c_str(),
@@ -65,7 +65,7 @@ namespace coreload
     {
         if (trace::is_enabled())
         {
-            trace::verbose(_X("--- Summary of all frameworks:"));
+            TRACE_VERBOSE(_X("--- Summary of all frameworks:"));
 
             bool is_app = true;
             for (const auto& fx : fx_definitions)
@@ -82,7 +82,7 @@ namespace coreload
                     assert(newest_ref->second.get_patch_roll_fwd() != nullptr);
                     assert(newest_ref->second.get_roll_fwd_on_no_candidate_fx() != nullptr);
 
-                    trace::verbose(_X("     framework:'%s', lowest requested version='%s', found version='%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d, folder=%s"),
+                    TRACE_VERBOSE(_X("     framework:'%s', lowest requested version='%s', found version='%s', patch_roll_fwd=%d, roll_fwd_on_no_candidate_fx=%d, folder=%s"),
                         fx->get_name().c_str(),
                         fx->get_requested_version().c_str(),
                         fx->get_found_version().c_str(),
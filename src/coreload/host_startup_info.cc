@@ -44,9 +44,9 @@ namespace coreload
         append_path(&app_path, app_name.c_str());
         app_path.append(_X(".dll"));
 
-        trace::info(_X("Host path: [%s]"), host_path.c_str());
-        trace::info(_X("Dotnet path: [%s]"), dotnet_root.c_str());
-        trace::info(_X("App path: [%s]"), app_path.c_str());
+        TRACE_INFO(_X("Host path: [%s]"), host_path.c_str());
+        TRACE_INFO(_X("Dotnet path: [%s]"), dotnet_root.c_str());
+        TRACE_INFO(_X("App path: [%s]"), app_path.c_str());
         return 0;
     }
 
@@ -71,7 +71,7 @@ namespace coreload
             host_path->assign(argv[0]);
             if (!host_path->empty())
             {
-                trace::info(_X("Attempting to use argv[0] as path [%s]"), host_path->c_str());
+                TRACE_INFO(_X("Attempting to use argv[0] as path [%s]"), host_path->c_str());
                 if (!get_path_from_argv(host_path))
                 {
                     trace::warning(_X("Failed to resolve argv[0] as path [%s]. Using location of current executable instead."), host_path->c_str());
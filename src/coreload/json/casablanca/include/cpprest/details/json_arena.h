@@ -0,0 +1,167 @@
+/***
+* ==++==
+*
+* Copyright (c) Microsoft Corporation. All rights reserved.
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* ==--==
+* =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*
+* Arena allocation for JSON values: a bump allocator which the values created on a thread
+* allocate their nodes and element storage from while an arena scope is active.
+*
+* =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+****/
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include "cpprest/details/basic_types.h"
+
+namespace web
+{
+namespace json
+{
+namespace details
+{
+    /// <summary>
+    /// A bump allocator. Memory is only released when the arena is destroyed.
+    /// </summary>
+    class arena
+    {
+    public:
+        struct stats
+        {
+            size_t allocations;
+            size_t bytes_allocated;
+            size_t bytes_reserved;
+        };
+
+        /// <summary>
+        /// Creates an arena.
+        /// </summary>
+        /// <param name="size_hint">The expected number of bytes to allocate, used to size the first block.</param>
+        _ASYNCRTIMP explicit arena(size_t size_hint = 0);
+        _ASYNCRTIMP ~arena();
+
+        _ASYNCRTIMP void* allocate(size_t size, size_t alignment);
+
+        const stats& get_stats() const { return m_stats; }
+
+        /// <summary>
+        /// Gets the most memory held by all arenas in the process at the same time.
+        /// </summary>
+        _ASYNCRTIMP static size_t __cdecl peak_bytes_reserved();
+
+    private:
+        arena(const arena&);
+        arena& operator=(const arena&);
+
+        struct block;
+
+        void* allocate_block(size_t size, size_t alignment);
+
+        block* m_blocks;
+        char* m_position;
+        char* m_end;
+        size_t m_next_block_size;
+        stats m_stats;
+    };
+
+    /// <summary>
+    /// Gets the arena the values created on this thread allocate from, or null for the heap.
+    /// </summary>
+    _ASYNCRTIMP arena* __cdecl current_arena();
+
+    /// <summary>
+    /// Makes an arena the current one for this thread for the lifetime of the scope.
+    /// </summary>
+    class arena_scope
+    {
+    public:
+        _ASYNCRTIMP explicit arena_scope(arena* a);
+        _ASYNCRTIMP ~arena_scope();
+
+    private:
+        arena_scope(const arena_scope&);
+        arena_scope& operator=(const arena_scope&);
+
+        arena* m_previous;
+    };
+
+    _ASYNCRTIMP void* __cdecl arena_allocate(arena* a, size_t size, size_t alignment);
+
+    /// <summary>
+    /// Allocator for the element storage of JSON objects and arrays. It allocates from the arena
+    /// which was current when the container was created; copies of a container use the arena
+    /// current at the time of the copy, so values copied out of an arena own their memory.
+    /// </summary>
+    template <typename T>
+    class arena_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        template <typename U> struct rebind { typedef arena_allocator<U> other; };
+
+        arena_allocator() : m_arena(current_arena()) { }
+
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& other) : m_arena(other.get_arena()) { }
+
+        T* allocate(size_t count)
+        {
+            if (m_arena == nullptr)
+            {
+                return static_cast<T*>(::operator new(count * sizeof(T)));
+            }
+            return static_cast<T*>(arena_allocate(m_arena, count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t)
+        {
+            if (m_arena == nullptr)
+            {
+                ::operator delete(ptr);
+            }
+        }
+
+        arena_allocator select_on_container_copy_construction() const
+        {
+            return arena_allocator();
+        }
+
+        arena* get_arena() const { return m_arena; }
+
+    private:
+        arena* m_arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b)
+    {
+        return a.get_arena() == b.get_arena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b)
+    {
+        return a.get_arena() != b.get_arena();
+    }
+}
+}
+}
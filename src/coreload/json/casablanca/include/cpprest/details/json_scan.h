@@ -0,0 +1,78 @@
+/***
+* ==++==
+*
+* Copyright (c) Microsoft Corporation. All rights reserved.
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* ==--==
+* =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*
+* JSON scanning primitives used by the buffer parser: finds the end of plain string
+* runs and whitespace runs in UTF-8 text, several bytes at a time when the processor
+* supports it.
+*
+* =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+****/
+
+#pragma once
+
+#include <cstddef>
+#include "cpprest/details/basic_types.h"
+
+namespace web
+{
+namespace json
+{
+namespace details
+{
+    /// <summary>
+    /// Instruction sets the scanner can use, from the least to the most capable.
+    /// </summary>
+    enum class scan_isa
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    /// <summary>
+    /// Gets the most capable instruction set supported by the processor and the OS.
+    /// </summary>
+    _ASYNCRTIMP scan_isa __cdecl supported_scan_isa();
+
+    /// <summary>
+    /// Gets the instruction set the scanner currently uses.
+    /// </summary>
+    _ASYNCRTIMP scan_isa __cdecl get_scan_isa();
+
+    /// <summary>
+    /// Selects the instruction set the scanner uses, limited to the supported one.
+    /// The default is the supported one; this is meant for tests and benchmarks.
+    /// </summary>
+    _ASYNCRTIMP void __cdecl set_scan_isa(scan_isa isa);
+
+    /// <summary>
+    /// Finds the end of a run of characters which can be copied verbatim into a string literal.
+    /// </summary>
+    /// <returns>The first quote, backslash or control character in [begin, end), or end.</returns>
+    _ASYNCRTIMP const char* __cdecl scan_string(const char* begin, const char* end);
+
+    /// <summary>
+    /// Finds the end of a run of whitespace.
+    /// </summary>
+    /// <param name="newlines">Receives the number of line feeds in the run.</param>
+    /// <param name="line_start">Receives the position following the last line feed, if there was one.</param>
+    /// <returns>The first character in [begin, end) which is not whitespace, or end.</returns>
+    _ASYNCRTIMP const char* __cdecl scan_whitespace(const char* begin, const char* end, size_t* newlines, const char** line_start);
+}
+}
+}
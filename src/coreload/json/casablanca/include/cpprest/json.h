@@ -34,6 +34,7 @@
 #include <unordered_map>
 #include <cstdint>
 #include "cpprest/details/basic_types.h"
+#include "cpprest/details/json_arena.h"
 #include "cpprest/asyncrt_utils.h"
 
 namespace web
@@ -51,6 +52,7 @@ namespace json
         class _String;
         class _Object;
         class _Array;
+        class _Reader;
         template <typename CharType> class JSON_Parser;
     }
 
@@ -437,6 +439,15 @@ public:
         /// <returns>The JSON value object created from the input stream.</returns>
         _ASYNCRTIMP static value __cdecl parse(utility::istream_t &input);
 
+        /// <summary>
+        /// Parses a JSON value from a contiguous buffer of UTF-8 text, such as a file read
+        /// into memory. This is faster than parsing the same text from a stream.
+        /// </summary>
+        /// <param name="begin">The first character of the text.</param>
+        /// <param name="end">One past the last character of the text.</param>
+        /// <returns>The JSON value object created from the input text.</returns>
+        _ASYNCRTIMP static value __cdecl parse(const char* begin, const char* end);
+
         /// <summary>
         /// Parses a JSON value from the contents of an input stream using the native platform character width.
         /// </summary>
@@ -746,12 +757,150 @@ public:
         const json_error_category_impl& json_error_category();
     }
 
+    /// <summary>
+    /// A forward-only pull parser which reads a UTF-8 JSON document one token at a time,
+    /// without building <c>json::value</c> objects for it.
+    /// </summary>
+    /// <remarks>
+    /// Object members are reported in document order, unlike <c>json::value::parse</c> which
+    /// sorts them unless <c>keep_object_element_order</c> is set. A reader must be used on
+    /// the thread which created it.
+    /// </remarks>
+    class reader
+    {
+    public:
+        /// <summary>
+        /// The kinds of tokens reported by the reader.
+        /// </summary>
+        enum token_type
+        {
+            Null,
+            Boolean,
+            Number,
+            String,
+            PropertyName,
+            BeginObject,
+            EndObject,
+            BeginArray,
+            EndArray,
+            EndOfInput
+        };
+
+        /// <summary>
+        /// Constructs a reader over a UTF-8 input stream, positioned before the first token.
+        /// </summary>
+        /// <param name="stream">The stream to read from; it must outlive the reader.</param>
+        _ASYNCRTIMP explicit reader(std::istream& stream);
+
+        /// <summary>
+        /// Constructs a reader over a contiguous buffer of UTF-8 text, positioned before the first token.
+        /// </summary>
+        /// <param name="begin">The first character of the text; the buffer must outlive the reader.</param>
+        /// <param name="end">One past the last character of the text.</param>
+        _ASYNCRTIMP reader(const char* begin, const char* end);
+
+        _ASYNCRTIMP ~reader();
+
+        /// <summary>
+        /// Advances to the next token.
+        /// </summary>
+        /// <returns>The type of the new current token.</returns>
+        /// <remarks>Throws a <c>json_exception</c> if the input is not well-formed JSON.</remarks>
+        _ASYNCRTIMP token_type read();
+
+        /// <summary>
+        /// Skips the value which starts at the current token, including all of its nested values.
+        /// If the current token is a property name, its value is skipped.
+        /// </summary>
+        _ASYNCRTIMP void skip();
+
+        /// <summary>
+        /// Gets the type of the current token.
+        /// </summary>
+        token_type type() const { return m_type; }
+
+        /// <summary>
+        /// Gets the text of the current <c>String</c> or <c>PropertyName</c> token.
+        /// </summary>
+        _ASYNCRTIMP const utility::string_t& as_string() const;
+
+        /// <summary>
+        /// Gets the value of the current <c>Boolean</c> token.
+        /// </summary>
+        _ASYNCRTIMP bool as_bool() const;
+
+        /// <summary>
+        /// Gets the value of the current <c>Number</c> token.
+        /// </summary>
+        _ASYNCRTIMP double as_double() const;
+
+    private:
+        reader(const reader&);
+        reader& operator=(const reader&);
+
+        std::unique_ptr<details::_Reader> m_impl;
+        token_type m_type;
+    };
+
+    /// <summary>
+    /// A parsed JSON document whose values are allocated from an arena owned by the document,
+    /// so that parsing makes few allocations and destroying the document releases them at once.
+    /// </summary>
+    /// <remarks>
+    /// The root is only accessible as a constant; copies of it or of its members are allocated
+    /// separately and may outlive the document. Strings and object keys keep their own storage.
+    /// </remarks>
+    class document
+    {
+    public:
+        /// <summary>
+        /// Memory used by the values of a document.
+        /// </summary>
+        struct memory_stats
+        {
+            size_t allocations;
+            size_t bytes_allocated;
+            size_t bytes_reserved;
+
+            /// <summary>
+            /// The most memory held by the arenas of all documents in the process at the same time.
+            /// </summary>
+            size_t peak_bytes_reserved;
+        };
+
+        /// <summary>
+        /// Parses a contiguous buffer of UTF-8 text into a document.
+        /// </summary>
+        /// <remarks>Throws a <c>json_exception</c> if the text is not well-formed JSON.</remarks>
+        _ASYNCRTIMP static document __cdecl parse(const char* begin, const char* end);
+
+        _ASYNCRTIMP document(document&& other) CPPREST_NOEXCEPT;
+        _ASYNCRTIMP document& operator=(document&& other) CPPREST_NOEXCEPT;
+        _ASYNCRTIMP ~document();
+
+        /// <summary>
+        /// Gets the root value of the document.
+        /// </summary>
+        const value& root() const { return m_root; }
+
+        _ASYNCRTIMP memory_stats get_memory_stats() const;
+
+    private:
+        document(std::unique_ptr<details::arena> arena, value root);
+        document(const document&);
+        document& operator=(const document&);
+
+        // Declared first so that the values are destroyed before their memory.
+        std::unique_ptr<details::arena> m_arena;
+        value m_root;
+    };
+
     /// <summary>
     /// A JSON array represented as a C++ class.
     /// </summary>
     class array
     {
-        typedef std::vector<json::value> storage_type;
+        typedef std::vector<json::value, details::arena_allocator<json::value>> storage_type;
 
     public:
         typedef storage_type::iterator iterator;
@@ -763,7 +912,8 @@ public:
     private:
         array() : m_elements() { }
         array(size_type size) : m_elements(size) { }
-        array(storage_type elements) : m_elements(std::move(elements)) { }
+        array(std::vector<json::value> elements)
+            : m_elements(std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end())) { }
 
     public:
         /// <summary>
@@ -961,7 +1111,8 @@ public:
     /// </summary>
     class object
     {
-        typedef std::vector<std::pair<utility::string_t, json::value>> storage_type;
+        typedef std::vector<std::pair<utility::string_t, json::value>,
+            details::arena_allocator<std::pair<utility::string_t, json::value>>> storage_type;
 
     public:
         typedef storage_type::iterator iterator;
@@ -972,7 +1123,8 @@ public:
 
     private:
         object(bool keep_order = false) : m_elements(), m_keep_order(keep_order) { }
-        object(storage_type elements, bool keep_order = false) : m_elements(std::move(elements)), m_keep_order(keep_order)
+        object(std::vector<std::pair<utility::string_t, json::value>> elements, bool keep_order = false)
+            : m_elements(std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end())), m_keep_order(keep_order)
         {
             if (!keep_order) {
                 sort(m_elements.begin(), m_elements.end(), compare_pairs);
@@ -1468,9 +1620,44 @@ public:
 
             virtual ~_Value() {}
 
+            // Values allocate from the current arena, if any. The owner is kept in front of
+            // the value so that deleting it only returns heap memory.
+            static void* operator new(size_t size)
+            {
+                arena* owner = current_arena();
+                void* memory = owner != nullptr
+                    ? arena_allocate(owner, sizeof(header) + size, alignof(header))
+                    : ::operator new(sizeof(header) + size);
+
+                header* h = static_cast<header*>(memory);
+                h->owner = owner;
+                return h + 1;
+            }
+
+            static void operator delete(void* ptr)
+            {
+                if (ptr == nullptr)
+                {
+                    return;
+                }
+
+                header* h = static_cast<header*>(ptr) - 1;
+                if (h->owner == nullptr)
+                {
+                    ::operator delete(h);
+                }
+            }
+
         protected:
             _Value() {}
 
+            union header
+            {
+                arena* owner;
+                double align_double;
+                int64_t align_int64;
+            };
+
             virtual void format(std::basic_string<char>& stream) const
             {
                 stream.append("null");
@@ -1663,7 +1850,7 @@ public:
         public:
 
             _Object(bool keep_order) : m_object(keep_order) { }
-            _Object(object::storage_type fields, bool keep_order) : m_object(std::move(fields), keep_order) { }
+            _Object(std::vector<std::pair<utility::string_t, json::value>> fields, bool keep_order) : m_object(std::move(fields), keep_order) { }
 
             virtual std::unique_ptr<_Value> _copy_value()
             {
@@ -1774,7 +1961,7 @@ public:
         public:
             _Array() {}
             _Array(array::size_type size) : m_array(size) {}
-            _Array(array::storage_type elements) : m_array(std::move(elements)) { }
+            _Array(std::vector<json::value> elements) : m_array(std::move(elements)) { }
 
             virtual std::unique_ptr<_Value> _copy_value()
             {
@@ -0,0 +1,163 @@
+/***
+* ==++==
+*
+* Copyright (c) Microsoft Corporation. All rights reserved.
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* ==--==
+* =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*
+* HTTP Library: JSON arena allocation
+*
+* =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+****/
+
+#include "stdafx.h"
+#include "cpprest/details/json_arena.h"
+#include <atomic>
+
+namespace web {
+namespace json
+{
+namespace details
+{
+
+namespace
+{
+    const size_t min_block_size = 4096;
+    const size_t max_block_size = 1024 * 1024;
+
+    thread_local arena* t_current_arena = nullptr;
+
+    std::atomic<size_t> g_bytes_reserved(0);
+    std::atomic<size_t> g_peak_bytes_reserved(0);
+
+    void add_reserved(size_t size)
+    {
+        size_t reserved = g_bytes_reserved.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = g_peak_bytes_reserved.load(std::memory_order_relaxed);
+        while (reserved > peak && !g_peak_bytes_reserved.compare_exchange_weak(peak, reserved, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    char* align_up(char* ptr, size_t alignment)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<char*>((value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+}
+
+struct arena::block
+{
+    block* next;
+    size_t size;
+};
+
+arena::arena(size_t size_hint)
+    : m_blocks(nullptr)
+    , m_position(nullptr)
+    , m_end(nullptr)
+    , m_next_block_size(size_hint < min_block_size ? min_block_size : size_hint)
+    , m_stats()
+{
+}
+
+arena::~arena()
+{
+    while (m_blocks != nullptr)
+    {
+        block* next = m_blocks->next;
+        ::operator delete(m_blocks);
+        m_blocks = next;
+    }
+
+    g_bytes_reserved.fetch_sub(m_stats.bytes_reserved, std::memory_order_relaxed);
+}
+
+void* arena::allocate(size_t size, size_t alignment)
+{
+    m_stats.allocations++;
+    m_stats.bytes_allocated += size;
+
+    char* result = align_up(m_position, alignment);
+    if (m_position == nullptr || result + size > m_end)
+    {
+        return allocate_block(size, alignment);
+    }
+
+    m_position = result + size;
+    return result;
+}
+
+// Starts a new block which fits the allocation. Blocks double in size up to a limit, so that a
+// document of any size takes few blocks without reserving much more than it needs.
+void* arena::allocate_block(size_t size, size_t alignment)
+{
+    size_t header_size = (sizeof(block) + alignment - 1) & ~(alignment - 1);
+    size_t block_size = m_next_block_size;
+    if (block_size < header_size + size)
+    {
+        block_size = header_size + size;
+    }
+    else if (m_next_block_size < max_block_size)
+    {
+        m_next_block_size *= 2;
+    }
+
+    block* b = static_cast<block*>(::operator new(block_size));
+    b->next = m_blocks;
+    b->size = block_size;
+    m_blocks = b;
+
+    m_stats.bytes_reserved += block_size;
+    add_reserved(block_size);
+
+    char* result = reinterpret_cast<char*>(b) + header_size;
+    char* block_end = reinterpret_cast<char*>(b) + block_size;
+
+    // An oversized allocation keeps the remainder of the previous block for what follows.
+    if (block_end - (result + size) >= m_end - m_position)
+    {
+        m_position = result + size;
+        m_end = block_end;
+    }
+    return result;
+}
+
+size_t __cdecl arena::peak_bytes_reserved()
+{
+    return g_peak_bytes_reserved.load(std::memory_order_relaxed);
+}
+
+arena* __cdecl current_arena()
+{
+    return t_current_arena;
+}
+
+arena_scope::arena_scope(arena* a)
+    : m_previous(t_current_arena)
+{
+    t_current_arena = a;
+}
+
+arena_scope::~arena_scope()
+{
+    t_current_arena = m_previous;
+}
+
+void* __cdecl arena_allocate(arena* a, size_t size, size_t alignment)
+{
+    return a->allocate(size, alignment);
+}
+
+}}}
@@ -24,6 +24,7 @@
 ****/
 
 #include "stdafx.h"
+#include "cpprest/details/json_scan.h"
 #include <cstdlib>
 
 #if defined(_MSC_VER)
@@ -83,6 +84,8 @@ public:
           m_currentParsingDepth(0)
     { }
 
+    virtual ~JSON_Parser() { }
+
     struct Location
     {
         size_t m_line;
@@ -154,11 +157,12 @@ protected:
 
     virtual bool CompleteComment(Token &token);
     virtual bool CompleteStringLiteral(Token &token);
+    virtual bool CompleteNumberLiteral(CharType first, Token &token);
+    virtual int_type EatWhitespace();
     bool handle_unescape_char(Token &token);
 
 private:
 
-    bool CompleteNumberLiteral(CharType first, Token &token);
     bool ParseInt64(CharType first, uint64_t& value);
     bool CompleteKeywordTrue(Token &token);
     bool CompleteKeywordFalse(Token &token);
@@ -169,8 +173,6 @@ private:
 
     JSON_Parser& operator=(const JSON_Parser&);
 
-    int_type EatWhitespace();
-
     void CreateToken(typename JSON_Parser<CharType>::Token& tk, typename Token::Kind kind, Location &start)
     {
         tk.kind = kind;
@@ -227,6 +229,10 @@ private:
     typename std::basic_streambuf<CharType, std::char_traits<CharType>>* m_streambuf;
 };
 
+//
+// Parses a contiguous buffer. Whitespace, string literals and integers are scanned
+// with pointer loops, instead of one virtual NextCharacter() call per character.
+//
 template <typename CharType>
 class JSON_StringParser : public JSON_Parser<CharType>
 {
@@ -238,6 +244,13 @@ public:
         m_endpos = m_position+string.size();
     }
 
+    JSON_StringParser(const CharType* begin, const CharType* end)
+        : m_position(begin),
+          m_startpos(begin),
+          m_endpos(end)
+    {
+    }
+
 protected:
 
     virtual typename JSON_Parser<CharType>::int_type NextCharacter();
@@ -245,6 +258,8 @@ protected:
 
     virtual bool CompleteComment(typename JSON_Parser<CharType>::Token &token);
     virtual bool CompleteStringLiteral(typename JSON_Parser<CharType>::Token &token);
+    virtual bool CompleteNumberLiteral(CharType first, typename JSON_Parser<CharType>::Token &token);
+    virtual typename JSON_Parser<CharType>::int_type EatWhitespace();
 
 private:
     bool finish_parsing_string_with_unescape_char(typename JSON_Parser<CharType>::Token &token);
@@ -324,6 +339,75 @@ typename JSON_Parser<CharType>::int_type JSON_Parser<CharType>::EatWhitespace()
    return ch;
 }
 
+// Same answer as iswspace in the "C" locale the parser runs in, without the call for ASCII.
+template <typename CharType>
+inline bool is_json_space(CharType ch)
+{
+    if (ch == ' ' || (ch >= '\t' && ch <= '\r'))
+    {
+        return true;
+    }
+
+    return sizeof(CharType) > 1 && static_cast<uint32_t>(ch) > 0x7F && iswspace(static_cast<wint_t>(ch));
+}
+
+// Narrow text is scanned by the vectorized scanners in json_scan.cpp.
+template <typename CharType>
+inline const CharType* scan_whitespace_run(const CharType* begin, const CharType* end, size_t* newlines, const CharType** line_start)
+{
+    while (begin != end && is_json_space(*begin))
+    {
+        if (*begin == '\n')
+        {
+            *newlines += 1;
+            *line_start = begin + 1;
+        }
+        ++begin;
+    }
+    return begin;
+}
+
+inline const char* scan_whitespace_run(const char* begin, const char* end, size_t* newlines, const char** line_start)
+{
+    return scan_whitespace(begin, end, newlines, line_start);
+}
+
+template <typename CharType>
+inline const CharType* scan_string_run(const CharType* begin, const CharType* end)
+{
+    while (begin != end && *begin != '"' && *begin != '\\' && !(*begin >= CharType(0x0) && *begin < CharType(0x20)))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+inline const char* scan_string_run(const char* begin, const char* end)
+{
+    return scan_string(begin, end);
+}
+
+template <typename CharType>
+typename JSON_Parser<CharType>::int_type JSON_StringParser<CharType>::EatWhitespace()
+{
+    size_t newlines = 0;
+    const CharType* line_start = nullptr;
+    const CharType* position = scan_whitespace_run(m_position, m_endpos, &newlines, &line_start);
+
+    if (newlines != 0)
+    {
+        this->m_currentLine += newlines;
+        this->m_currentColumn = position - line_start;
+    }
+    else
+    {
+        this->m_currentColumn += position - m_position;
+    }
+
+    m_position = position;
+    return JSON_StringParser<CharType>::NextCharacter();
+}
+
 template <typename CharType>
 bool JSON_Parser<CharType>::CompleteKeywordTrue(Token &token)
 {
@@ -587,6 +671,68 @@ bool JSON_Parser<CharType>::CompleteNumberLiteral(CharType first, Token &token)
     return true;
 }
 
+template <typename CharType>
+bool JSON_StringParser<CharType>::CompleteNumberLiteral(CharType first, typename JSON_Parser<CharType>::Token &token)
+{
+    // Integers are scanned in place; anything with a fraction or an exponent, or
+    // which overflows 64 bits, is left to the general implementation.
+    const CharType* position = m_position;
+    const bool minus_sign = first == '-';
+    if (minus_sign)
+    {
+        if (position == m_endpos)
+            return false;
+        first = *position++;
+    }
+
+    if (first < '0' || first > '9')
+        return false;
+
+    uint64_t val64 = first - '0';
+    const CharType* digits = position;
+    while (position != m_endpos && *position >= '0' && *position <= '9')
+    {
+        unsigned int next_digit = (unsigned int)(*position - '0');
+        if (val64 > (ULLONG_MAX / 10) || (val64 == ULLONG_MAX/10 && next_digit > ULLONG_MAX%10))
+            return JSON_Parser<CharType>::CompleteNumberLiteral(minus_sign ? '-' : first, token);
+
+        val64 = val64 * 10 + next_digit;
+        ++position;
+    }
+
+    //Check for two (or more) zeros at the beginning
+    if (first == '0' && position != digits)
+        return false;
+
+    if (position != m_endpos && (*position == '.' || *position == 'E' || *position == 'e'))
+        return JSON_Parser<CharType>::CompleteNumberLiteral(minus_sign ? '-' : first, token);
+
+    this->m_currentColumn += position - m_position;
+    m_position = position;
+
+    if (minus_sign)
+    {
+        if (val64 > static_cast<uint64_t>(1) << 63 )
+        {
+            // It is negative and cannot be represented in int64, so we resort to double
+            token.double_val = 0 - static_cast<double>(val64);
+            token.signed_number = true;
+            token.kind = JSON_Parser<CharType>::Token::TKN_NumberLiteral;
+            return true;
+        }
+
+        token.int64_val = 0 - static_cast<int64_t>(val64);
+        token.kind = JSON_Parser<CharType>::Token::TKN_IntegerLiteral;
+        token.signed_number = true;
+        return true;
+    }
+
+    token.uint64_val = val64;
+    token.kind = JSON_Parser<CharType>::Token::TKN_IntegerLiteral;
+    token.signed_number = false;
+    return true;
+}
+
 template <typename CharType>
 bool JSON_Parser<CharType>::CompleteComment(Token &token)
 {
@@ -825,43 +971,34 @@ template <typename CharType>
 bool JSON_StringParser<CharType>::CompleteStringLiteral(typename JSON_Parser<CharType>::Token &token)
 {
     // This function is specialized for the string parser, since we can be slightly more
-    // efficient in copying data from the input to the token: do a string::append rather than
-    // one character at a time.
+    // efficient in copying data from the input to the token: find the end of each run of
+    // plain characters with the scanner and append the run at once, so a string without
+    // escapes is a single copy.
 
-    auto start = m_position;
     token.has_unescape_symbol = false;
 
-    auto ch = JSON_StringParser<CharType>::NextCharacter();
-
-    while (ch != '"')
+    while (true)
     {
-        if (ch == eof<CharType>())
-            return false;
+        const CharType* start = m_position;
+        const CharType* position = scan_string_run(start, m_endpos);
 
-        if (ch == '\\')
-        {
-            const size_t numChars = m_position - start - 1;
-            token.string_val.append(start, numChars);
-
-            if (!JSON_StringParser<CharType>::handle_unescape_char(token))
-            {
-                return false;
-            }
+        token.string_val.append(start, position - start);
+        this->m_currentColumn += position - start;
+        m_position = position;
 
-            // Reset start position and continue.
-            start = m_position;
+        auto ch = JSON_StringParser<CharType>::NextCharacter();
+        if (ch == '"')
+        {
+            break;
         }
-        else if (ch >= CharType(0x0) && ch < CharType(0x20))
+
+        // Anything else than an escape sequence here is EOF or a control character.
+        if (ch != '\\' || !JSON_StringParser<CharType>::handle_unescape_char(token))
         {
             return false;
         }
-
-        ch = JSON_StringParser<CharType>::NextCharacter();
     }
 
-    const size_t numChars = m_position - start - 1;
-    token.string_val.append(start, numChars);
-
     token.kind = JSON_Parser<CharType>::Token::TKN_StringLiteral;
 
     return true;
@@ -1285,6 +1422,80 @@ web::json::value web::json::value::parse(const utility::string_t& str, std::erro
     return returnObject;
 }
 
+web::json::value web::json::value::parse(const char* begin, const char* end)
+{
+    web::json::details::JSON_StringParser<char> parser(begin, end);
+    web::json::details::JSON_Parser<char>::Token tkn;
+
+    parser.GetNextToken(tkn);
+    if (tkn.m_error)
+    {
+        web::json::details::CreateException(tkn, utility::conversions::to_string_t(tkn.m_error.message()));
+    }
+
+    auto value = parser.ParseValue(tkn);
+    if (tkn.m_error)
+    {
+        web::json::details::CreateException(tkn, utility::conversions::to_string_t(tkn.m_error.message()));
+    }
+    else if (tkn.kind != web::json::details::JSON_Parser<char>::Token::TKN_EOF)
+    {
+        web::json::details::CreateException(tkn, _XPLATSTR("Left-over characters in stream after parsing a JSON value"));
+    }
+    return value;
+}
+
+web::json::document::document(std::unique_ptr<details::arena> arena, value root)
+    : m_arena(std::move(arena))
+    , m_root(std::move(root))
+{
+}
+
+web::json::document::document(document&& other) CPPREST_NOEXCEPT
+    : m_arena(std::move(other.m_arena))
+    , m_root(std::move(other.m_root))
+{
+}
+
+web::json::document& web::json::document::operator=(document&& other) CPPREST_NOEXCEPT
+{
+    // Moving a value may swap it with the target, so swap the arenas as well: the previous
+    // values are then released by 'other' together with the arena they live in.
+    m_root = std::move(other.m_root);
+    m_arena.swap(other.m_arena);
+    return *this;
+}
+
+web::json::document::~document()
+{
+}
+
+web::json::document web::json::document::parse(const char* begin, const char* end)
+{
+    // The values of a deps or runtimeconfig file take two to four times the size of its text.
+    std::unique_ptr<details::arena> arena(new details::arena(2 * static_cast<size_t>(end - begin)));
+
+    web::json::value root;
+    {
+        details::arena_scope scope(arena.get());
+        root = web::json::value::parse(begin, end);
+    }
+    return document(std::move(arena), std::move(root));
+}
+
+web::json::document::memory_stats web::json::document::get_memory_stats() const
+{
+    memory_stats stats = memory_stats();
+    if (m_arena)
+    {
+        stats.allocations = m_arena->get_stats().allocations;
+        stats.bytes_allocated = m_arena->get_stats().bytes_allocated;
+        stats.bytes_reserved = m_arena->get_stats().bytes_reserved;
+    }
+    stats.peak_bytes_reserved = details::arena::peak_bytes_reserved();
+    return stats;
+}
+
 web::json::value web::json::value::parse(utility::istream_t &stream)
 {
     return _parse_stream(stream);
@@ -1306,3 +1517,274 @@ web::json::value web::json::value::parse(std::istream& stream, std::error_code&
     return _parse_narrow_stream(stream, error);
 }
 #endif
+
+namespace web {
+namespace json
+{
+namespace details
+{
+
+//
+// Pull parsing
+//
+// Tracks the enclosing objects and arrays so that read() can validate the token
+// sequence itself, rather than leaving it to the recursive descent in _ParseValue.
+//
+class _Reader
+{
+public:
+    typedef JSON_Parser<char>::Token Token;
+
+    _Reader(JSON_Parser<char>* parser)
+        : m_parser(parser),
+          m_after_value(false),
+          m_after_comma(false),
+          m_expect_value(false),
+          m_done(false),
+          m_boolean(false),
+          m_number(0)
+    { }
+
+    reader::token_type Read()
+    {
+        m_parser->GetNextToken(m_token);
+        CheckError();
+
+        if (m_scopes.empty())
+        {
+            if (!m_done)
+            {
+                return BeginValue();
+            }
+
+            if (m_token.kind != Token::TKN_EOF)
+            {
+                CreateException(m_token, _XPLATSTR("Left-over characters in stream after parsing a JSON value"));
+            }
+            return reader::EndOfInput;
+        }
+
+        const bool in_object = m_scopes.back() == '{';
+
+        if (m_expect_value)
+        {
+            m_expect_value = false;
+            return BeginValue();
+        }
+
+        if (m_after_value)
+        {
+            if (m_token.kind == Token::TKN_Comma)
+            {
+                m_after_value = false;
+                m_after_comma = true;
+                m_parser->GetNextToken(m_token);
+                CheckError();
+            }
+            else
+            {
+                return EndContainer(in_object);
+            }
+        }
+        else if (!m_after_comma)
+        {
+            // First token after the opening brace or bracket may close an empty container.
+            if ((in_object && m_token.kind == Token::TKN_CloseBrace) ||
+                (!in_object && m_token.kind == Token::TKN_CloseBracket))
+            {
+                return EndContainer(in_object);
+            }
+        }
+
+        m_after_comma = false;
+        if (!in_object)
+        {
+            return BeginValue();
+        }
+
+        if (m_token.kind != Token::TKN_StringLiteral)
+        {
+            SetErrorCode(m_token, json_error::malformed_object_literal);
+            CheckError();
+        }
+        m_string = utility::conversions::to_string_t(std::move(m_token.string_val));
+
+        m_parser->GetNextToken(m_token);
+        CheckError();
+        if (m_token.kind != Token::TKN_Colon)
+        {
+            SetErrorCode(m_token, json_error::malformed_object_literal);
+            CheckError();
+        }
+
+        m_expect_value = true;
+        return reader::PropertyName;
+    }
+
+    const utility::string_t& String() const { return m_string; }
+    bool Boolean() const { return m_boolean; }
+    double Number() const { return m_number; }
+
+private:
+    void CheckError()
+    {
+        if (m_token.m_error)
+        {
+            CreateException(m_token, utility::conversions::to_string_t(m_token.m_error.message()));
+        }
+    }
+
+    reader::token_type CompleteValue(reader::token_type type)
+    {
+        m_after_value = true;
+        m_done = m_scopes.empty();
+        return type;
+    }
+
+    reader::token_type BeginValue()
+    {
+        switch (m_token.kind)
+        {
+        case Token::TKN_OpenBrace:
+            m_scopes.push_back('{');
+            m_after_value = false;
+            return reader::BeginObject;
+        case Token::TKN_OpenBracket:
+            m_scopes.push_back('[');
+            m_after_value = false;
+            return reader::BeginArray;
+        case Token::TKN_StringLiteral:
+            m_string = utility::conversions::to_string_t(std::move(m_token.string_val));
+            return CompleteValue(reader::String);
+        case Token::TKN_IntegerLiteral:
+            m_number = m_token.signed_number ? static_cast<double>(m_token.int64_val) : static_cast<double>(m_token.uint64_val);
+            return CompleteValue(reader::Number);
+        case Token::TKN_NumberLiteral:
+            m_number = m_token.double_val;
+            return CompleteValue(reader::Number);
+        case Token::TKN_BooleanLiteral:
+            m_boolean = m_token.boolean_val;
+            return CompleteValue(reader::Boolean);
+        case Token::TKN_NullLiteral:
+            return CompleteValue(reader::Null);
+        default:
+            SetErrorCode(m_token, json_error::malformed_token);
+            CheckError();
+            return reader::EndOfInput;
+        }
+    }
+
+    reader::token_type EndContainer(bool in_object)
+    {
+        if (in_object && m_token.kind != Token::TKN_CloseBrace)
+        {
+            SetErrorCode(m_token, json_error::malformed_object_literal);
+            CheckError();
+        }
+        if (!in_object && m_token.kind != Token::TKN_CloseBracket)
+        {
+            SetErrorCode(m_token, json_error::malformed_array_literal);
+            CheckError();
+        }
+
+        m_scopes.pop_back();
+        return CompleteValue(in_object ? reader::EndObject : reader::EndArray);
+    }
+
+#ifndef _WIN32
+    utility::details::scoped_c_thread_locale m_locale;
+#endif
+    std::unique_ptr<JSON_Parser<char>> m_parser;
+    Token m_token;
+    std::vector<char> m_scopes;
+    bool m_after_value;
+    bool m_after_comma;
+    bool m_expect_value;
+    bool m_done;
+
+    utility::string_t m_string;
+    bool m_boolean;
+    double m_number;
+};
+
+}}}
+
+web::json::reader::reader(std::istream& stream)
+    : m_impl(new web::json::details::_Reader(new web::json::details::JSON_StreamParser<char>(stream))),
+      m_type(Null)
+{
+}
+
+web::json::reader::reader(const char* begin, const char* end)
+    : m_impl(new web::json::details::_Reader(new web::json::details::JSON_StringParser<char>(begin, end))),
+      m_type(Null)
+{
+}
+
+web::json::reader::~reader()
+{
+}
+
+web::json::reader::token_type web::json::reader::read()
+{
+    m_type = m_impl->Read();
+    return m_type;
+}
+
+void web::json::reader::skip()
+{
+    if (m_type == PropertyName)
+    {
+        read();
+    }
+
+    if (m_type != BeginObject && m_type != BeginArray)
+    {
+        return;
+    }
+
+    size_t depth = 1;
+    while (depth != 0)
+    {
+        switch (read())
+        {
+        case BeginObject:
+        case BeginArray:
+            depth++;
+            break;
+        case EndObject:
+        case EndArray:
+            depth--;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+const utility::string_t& web::json::reader::as_string() const
+{
+    if (m_type != String && m_type != PropertyName)
+    {
+        throw json_exception(_XPLATSTR("not a string"));
+    }
+    return m_impl->String();
+}
+
+bool web::json::reader::as_bool() const
+{
+    if (m_type != Boolean)
+    {
+        throw json_exception(_XPLATSTR("not a boolean"));
+    }
+    return m_impl->Boolean();
+}
+
+double web::json::reader::as_double() const
+{
+    if (m_type != Number)
+    {
+        throw json_exception(_XPLATSTR("not a number"));
+    }
+    return m_impl->Number();
+}
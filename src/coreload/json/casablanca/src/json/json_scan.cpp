@@ -0,0 +1,345 @@
+/***
+* ==++==
+*
+* Copyright (c) Microsoft Corporation. All rights reserved.
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* ==--==
+* =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+*
+* HTTP Library: JSON scanning
+*
+* Each scanner classifies a block of 16 (SSE2) or 32 (AVX2) bytes into bit masks and
+* uses the lowest set bit to find the end of the run. The AVX2 versions are compiled
+* for that instruction set only and selected at run time.
+*
+* =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+****/
+
+#include "stdafx.h"
+#include "cpprest/details/json_scan.h"
+#include <atomic>
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || (defined(__i386__) && defined(__SSE2__))
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define JSON_SCAN_TARGET_AVX2
+#else
+#define JSON_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace web {
+namespace json
+{
+namespace details
+{
+
+namespace
+{
+    const int isa_unknown = -1;
+    std::atomic<int> g_scan_isa(isa_unknown);
+
+    inline bool is_string_special(unsigned char ch)
+    {
+        return ch == '"' || ch == '\\' || ch < 0x20;
+    }
+
+    inline bool is_whitespace(unsigned char ch)
+    {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+
+    const char* scan_string_scalar(const char* begin, const char* end)
+    {
+        while (begin != end && !is_string_special(static_cast<unsigned char>(*begin)))
+        {
+            ++begin;
+        }
+        return begin;
+    }
+
+    const char* scan_whitespace_scalar(const char* begin, const char* end, size_t* newlines, const char** line_start)
+    {
+        while (begin != end && is_whitespace(static_cast<unsigned char>(*begin)))
+        {
+            if (*begin == '\n')
+            {
+                *newlines += 1;
+                *line_start = begin + 1;
+            }
+            ++begin;
+        }
+        return begin;
+    }
+
+#if defined(JSON_SCAN_X86)
+    inline unsigned int lowest_bit(uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    inline unsigned int highest_bit(uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse(&index, mask);
+        return index;
+#else
+        return 31 - __builtin_clz(mask);
+#endif
+    }
+
+    // POPCNT is not implied by SSE2 or AVX2, so count without it.
+    inline unsigned int bit_count(uint32_t mask)
+    {
+        mask = mask - ((mask >> 1) & 0x55555555);
+        mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+        return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+    }
+
+    // Accounts for the line feeds in 'newline_mask' of the block at 'block'.
+    inline void count_newlines(const char* block, uint32_t newline_mask, size_t* newlines, const char** line_start)
+    {
+        if (newline_mask != 0)
+        {
+            *newlines += bit_count(newline_mask);
+            *line_start = block + highest_bit(newline_mask) + 1;
+        }
+    }
+
+    const char* scan_string_sse2(const char* begin, const char* end)
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control_max = _mm_set1_epi8(0x1F);
+        const __m128i zero = _mm_setzero_si128();
+
+        while (end - begin >= 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                _mm_cmpeq_epi8(_mm_subs_epu8(block, control_max), zero));
+
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+            if (mask != 0)
+            {
+                return begin + lowest_bit(mask);
+            }
+            begin += 16;
+        }
+
+        return scan_string_scalar(begin, end);
+    }
+
+    const char* scan_whitespace_sse2(const char* begin, const char* end, size_t* newlines, const char** line_start)
+    {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i range = _mm_set1_epi8('\r' - '\t');
+        const __m128i line_feed = _mm_set1_epi8('\n');
+        const __m128i zero = _mm_setzero_si128();
+
+        while (end - begin >= 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            __m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(block, space),
+                _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(block, tab), range), zero));
+
+            uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(whitespace)) & 0xFFFF;
+            uint32_t newline_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, line_feed)));
+            if (other != 0)
+            {
+                unsigned int length = lowest_bit(other);
+                count_newlines(begin, newline_mask & ((1u << length) - 1), newlines, line_start);
+                return begin + length;
+            }
+
+            count_newlines(begin, newline_mask, newlines, line_start);
+            begin += 16;
+        }
+
+        return scan_whitespace_scalar(begin, end, newlines, line_start);
+    }
+
+    JSON_SCAN_TARGET_AVX2
+    const char* scan_string_avx2(const char* begin, const char* end)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i control_max = _mm256_set1_epi8(0x1F);
+        const __m256i zero = _mm256_setzero_si256();
+
+        while (end - begin >= 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+                _mm256_cmpeq_epi8(_mm256_subs_epu8(block, control_max), zero));
+
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+            if (mask != 0)
+            {
+                return begin + lowest_bit(mask);
+            }
+            begin += 32;
+        }
+
+        return scan_string_sse2(begin, end);
+    }
+
+    JSON_SCAN_TARGET_AVX2
+    const char* scan_whitespace_avx2(const char* begin, const char* end, size_t* newlines, const char** line_start)
+    {
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i range = _mm256_set1_epi8('\r' - '\t');
+        const __m256i line_feed = _mm256_set1_epi8('\n');
+        const __m256i zero = _mm256_setzero_si256();
+
+        while (end - begin >= 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            __m256i whitespace = _mm256_or_si256(_mm256_cmpeq_epi8(block, space),
+                _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_sub_epi8(block, tab), range), zero));
+
+            uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(whitespace));
+            uint32_t newline_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, line_feed)));
+            if (other != 0)
+            {
+                unsigned int length = lowest_bit(other);
+                count_newlines(begin, newline_mask & ((1u << length) - 1), newlines, line_start);
+                return begin + length;
+            }
+
+            count_newlines(begin, newline_mask, newlines, line_start);
+            begin += 32;
+        }
+
+        return scan_whitespace_sse2(begin, end, newlines, line_start);
+    }
+
+    bool cpu_supports_avx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // The OS must save the YMM registers (OSXSAVE, AVX and XCR0 bits 1 and 2).
+        __cpuid(info, 1);
+        const int osxsave_avx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+#endif
+
+    scan_isa current_isa()
+    {
+        int isa = g_scan_isa.load(std::memory_order_relaxed);
+        if (isa == isa_unknown)
+        {
+            isa = static_cast<int>(supported_scan_isa());
+            g_scan_isa.store(isa, std::memory_order_relaxed);
+        }
+        return static_cast<scan_isa>(isa);
+    }
+}
+
+scan_isa __cdecl supported_scan_isa()
+{
+#if defined(JSON_SCAN_X86)
+    static const scan_isa supported = cpu_supports_avx2() ? scan_isa::avx2 : scan_isa::sse2;
+    return supported;
+#else
+    return scan_isa::scalar;
+#endif
+}
+
+scan_isa __cdecl get_scan_isa()
+{
+    return current_isa();
+}
+
+void __cdecl set_scan_isa(scan_isa isa)
+{
+    if (isa > supported_scan_isa())
+    {
+        isa = supported_scan_isa();
+    }
+    g_scan_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+}
+
+const char* __cdecl scan_string(const char* begin, const char* end)
+{
+#if defined(JSON_SCAN_X86)
+    switch (current_isa())
+    {
+    case scan_isa::avx2:
+        return scan_string_avx2(begin, end);
+    case scan_isa::sse2:
+        return scan_string_sse2(begin, end);
+    default:
+        break;
+    }
+#endif
+    return scan_string_scalar(begin, end);
+}
+
+const char* __cdecl scan_whitespace(const char* begin, const char* end, size_t* newlines, const char** line_start)
+{
+    // Most whitespace runs are a line feed and a few spaces of indentation, which
+    // are not worth a vector load; only switch to blocks for longer runs.
+    const char* short_end = (end - begin > 8) ? begin + 8 : end;
+    begin = scan_whitespace_scalar(begin, short_end, newlines, line_start);
+    if (begin != short_end)
+    {
+        return begin;
+    }
+
+#if defined(JSON_SCAN_X86)
+    switch (current_isa())
+    {
+    case scan_isa::avx2:
+        return scan_whitespace_avx2(begin, end, newlines, line_start);
+    case scan_isa::sse2:
+        return scan_whitespace_sse2(begin, end, newlines, line_start);
+    default:
+        break;
+    }
+#endif
+    return scan_whitespace_scalar(begin, end, newlines, line_start);
+}
+
+}}}
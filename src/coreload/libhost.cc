@@ -27,7 +27,7 @@ namespace coreload
         append_path(&json_path, json_name.c_str());
         append_path(&dev_json_path, dev_json_name.c_str());
 
-        trace::verbose(_X("Runtime config is cfg=%s dev=%s"), json_path.c_str(), dev_json_path.c_str());
+        TRACE_VERBOSE(_X("Runtime config is cfg=%s dev=%s"), json_path.c_str(), dev_json_path.c_str());
 
         dev_cfg->assign(dev_json_path);
         cfg->assign(json_path);
@@ -45,7 +45,7 @@ namespace coreload
         append_path(&dev_json_path, dev_json_name.c_str());
         dev_cfg->assign(dev_json_path);
 
-        trace::verbose(_X("Runtime config is cfg=%s dev=%s"), json_path.c_str(), dev_json_path.c_str());
+        TRACE_VERBOSE(_X("Runtime config is cfg=%s dev=%s"), json_path.c_str(), dev_json_path.c_str());
     }
 
     host_mode_t detect_operating_mode(const host_startup_info_t& host_info)
@@ -59,7 +59,7 @@ namespace coreload
             append_path(&deps_in_dotnet_root, deps_filename.c_str());
             bool deps_exists = pal::file_exists(deps_in_dotnet_root);
 
-            trace::info(_X("Detecting mode... CoreCLR present in dotnet root [%d] and checking if [%s] file present=[%d]"),
+            TRACE_INFO(_X("Detecting mode... CoreCLR present in dotnet root [%d] and checking if [%s] file present=[%d]"),
                 host_info.dotnet_root.c_str(), deps_filename.c_str(), deps_exists);
 
             // Name of runtimeconfig file; since no path is included here the check is in the current working directory
@@ -84,7 +84,7 @@ namespace coreload
         if (trace::is_enabled())
         {
             pal::string_t start_str = start_ver.as_str();
-            trace::verbose(_X("Reading patch roll forward candidates in dir [%s] for version [%s]"), path.c_str(), start_str.c_str());
+            TRACE_VERBOSE(_X("Reading patch roll forward candidates in dir [%s] for version [%s]"), path.c_str(), start_str.c_str());
         }
 
         pal::string_t maj_min_star = start_ver.patch_glob();
@@ -96,7 +96,7 @@ namespace coreload
         fx_ver_t ver(-1, -1, -1);
         for (const auto& str : list)
         {
-            trace::verbose(_X("Considering patch roll forward candidate version [%s]"), str.c_str());
+            TRACE_VERBOSE(_X("Considering patch roll forward candidate version [%s]"), str.c_str());
             if (fx_ver_t::parse(str, &ver, true))
             {
                 max_ver = std::max(ver, max_ver);
@@ -107,7 +107,7 @@ namespace coreload
         if (trace::is_enabled())
         {
             pal::string_t start_str = start_ver.as_str();
-            trace::verbose(_X("Patch roll forwarded [%s] -> [%s] in [%s]"), start_str.c_str(), max_str->c_str(), path.c_str());
+            TRACE_VERBOSE(_X("Patch roll forwarded [%s] -> [%s] in [%s]"), start_str.c_str(), max_str->c_str(), path.c_str());
         }
     }
 
@@ -118,7 +118,7 @@ namespace coreload
         if (trace::is_enabled())
         {
             pal::string_t start_str = start_ver.as_str();
-            trace::verbose(_X("Reading prerelease roll forward candidates in dir [%s] for version [%s]"), path.c_str(), start_str.c_str());
+            TRACE_VERBOSE(_X("Reading prerelease roll forward candidates in dir [%s] for version [%s]"), path.c_str(), start_str.c_str());
         }
 
         pal::string_t maj_min_pat_star = start_ver.prerelease_glob();
@@ -130,7 +130,7 @@ namespace coreload
         fx_ver_t ver(-1, -1, -1);
         for (const auto& str : list)
         {
-            trace::verbose(_X("Considering prerelease roll forward candidate version [%s]"), str.c_str());
+            TRACE_VERBOSE(_X("Considering prerelease roll forward candidate version [%s]"), str.c_str());
             if (fx_ver_t::parse(str, &ver, false)
                 && ver.is_prerelease()) // Pre-release can roll forward to only pre-release
             {
@@ -142,7 +142,7 @@ namespace coreload
         if (trace::is_enabled())
         {
             pal::string_t start_str = start_ver.as_str();
-            trace::verbose(_X("Prerelease roll forwarded [%s] -> [%s] in [%s]"), start_str.c_str(), max_str->c_str(), path.c_str());
+            TRACE_VERBOSE(_X("Prerelease roll forwarded [%s] -> [%s] in [%s]"), start_str.c_str(), max_str->c_str(), path.c_str());
         }
     }
 } // namespace coreload
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "probe_index.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace coreload
+{
+    namespace
+    {
+        // The package directory relative to a probe directory, as in deps_entry_t::to_full_path
+        pal::string_t get_package_dir(const deps_entry_t& entry)
+        {
+            if (!entry.library_path.empty())
+            {
+                return entry.library_path;
+            }
+
+            pal::string_t dir = entry.library_name;
+            append_path(&dir, entry.library_version.c_str());
+            return dir;
+        }
+
+        // Entries of the same asset may come from deps files which place the package
+        // differently, so the package directory is part of the key.
+        pal::string_t get_key(const deps_entry_t& entry, const pal::string_t& package_dir)
+        {
+            pal::string_t key;
+            key.reserve(entry.library_name.length() + entry.library_version.length() + package_dir.length() + entry.asset.relative_path.length() + 3);
+            key.append(entry.library_name);
+            key.push_back(_X('/'));
+            key.append(entry.library_version);
+            key.push_back(_X('/'));
+
+            // Paths cannot hold a NUL, which keeps the package directory apart from the asset
+            key.append(package_dir);
+            key.push_back(_X('\0'));
+            key.append(entry.asset.relative_path);
+            return key;
+        }
+    }
+
+    probe_index_t::probe_index_t()
+        : m_built(false)
+    {
+    }
+
+    void probe_index_t::build(const std::vector<probe_config_t>& probes, const std::vector<const deps_entry_t*>& entries, thread_pool_t* pool)
+    {
+        m_matches.clear();
+
+        std::vector<size_t> layout_probes;
+        for (size_t i = 0; i < probes.size(); ++i)
+        {
+            if (is_package_layout(probes[i]) && !probes[i].probe_dir.empty())
+            {
+                layout_probes.push_back(i);
+            }
+        }
+
+        // Nothing to look up, probing never gets to a package layout
+        if (layout_probes.empty())
+        {
+            m_built = false;
+            return;
+        }
+
+        // The distinct entries, grouped by package directory
+        std::vector<pal::string_t> keys;
+        std::vector<const deps_entry_t*> unique_entries;
+        std::unordered_map<pal::string_t, size_t> key_slots;
+        std::vector<pal::string_t> package_dirs;
+        std::vector<std::vector<size_t>> package_entries;
+        std::unordered_map<pal::string_t, size_t> package_slots;
+        for (const deps_entry_t* entry : entries)
+        {
+            pal::string_t package_dir = get_package_dir(*entry);
+            pal::string_t key = get_key(*entry, package_dir);
+            if (!key_slots.emplace(key, keys.size()).second)
+            {
+                continue;
+            }
+
+            auto package = package_slots.emplace(package_dir, package_dirs.size());
+            if (package.second)
+            {
+                package_dirs.push_back(std::move(package_dir));
+                package_entries.emplace_back();
+            }
+            package_entries[package.first->second].push_back(keys.size());
+
+            keys.push_back(std::move(key));
+            unique_entries.push_back(entry);
+        }
+
+        std::vector<matches_t> matches(keys.size());
+        pool->run(package_dirs.size(), [&](size_t package)
+        {
+            // The asset query of a package with a single entry answers as much as
+            // a query of its directory would.
+            const std::vector<size_t>& slots = package_entries[package];
+            bool query_dir = slots.size() > 1;
+            for (size_t probe : layout_probes)
+            {
+                pal::string_t dir = probes[probe].probe_dir;
+                append_path(&dir, package_dirs[package].c_str());
+                if (query_dir && !pal::directory_exists(dir))
+                {
+                    continue;
+                }
+
+                pal::string_t candidate;
+                for (size_t slot : slots)
+                {
+                    if (unique_entries[slot]->to_rel_path(dir, &candidate))
+                    {
+                        matches[slot].emplace_back(probe, candidate);
+                    }
+                }
+            }
+        });
+
+        size_t found = 0;
+        m_matches.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            found += matches[i].empty() ? 0 : 1;
+            m_matches.emplace(std::move(keys[i]), std::move(matches[i]));
+        }
+        m_built = true;
+
+        TRACE_VERBOSE(_X("Indexed %zu deps entries of %zu packages in %zu package layout probes, %zu found"),
+            m_matches.size(), package_dirs.size(), layout_probes.size(), found);
+    }
+
+    bool probe_index_t::find(const deps_entry_t& entry, const matches_t** matches) const
+    {
+        if (!m_built)
+        {
+            return false;
+        }
+
+        auto iter = m_matches.find(get_key(entry, get_package_dir(entry)));
+        if (iter == m_matches.end())
+        {
+            return false;
+        }
+
+        *matches = &iter->second;
+        return true;
+    }
+
+} // namespace coreload
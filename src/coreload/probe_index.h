@@ -0,0 +1,49 @@
+#ifndef PROBE_INDEX_H_
+#define PROBE_INDEX_H_
+
+#include <unordered_map>
+#include <vector>
+#include "pal.h"
+#include "arguments.h"
+#include "deps_entry.h"
+#include "thread_pool.h"
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Where the deps entries of a resolution are found in the package layout
+    // probes (the servicing, shared store and additional probe directories).
+    //
+    // Built once per resolution: the entries are grouped by package directory and
+    // each package directory is checked once per probe, so a probe directory
+    // which lacks the package costs a single query however many assets the package
+    // has. Probing an entry then takes a single lookup instead of a path query per
+    // probe. The probe order and the probe filters are left to the caller.
+    //
+    class probe_index_t
+    {
+    public:
+        // Probe position in the probe configurations and the path found in it
+        typedef std::vector<std::pair<size_t, pal::string_t>> matches_t;
+
+        probe_index_t();
+
+        void build(const std::vector<probe_config_t>& probes, const std::vector<const deps_entry_t*>& entries, thread_pool_t* pool);
+
+        // Returns false if the entry was not indexed, otherwise 'matches' receives the
+        // package layout probes which contain it, in probe order.
+        bool find(const deps_entry_t& entry, const matches_t** matches) const;
+
+        static bool is_package_layout(const probe_config_t& config)
+        {
+            return !config.is_fx() && !config.is_app();
+        }
+
+    private:
+        std::unordered_map<pal::string_t, matches_t> m_matches;
+        bool m_built;
+    };
+
+} // namespace coreload
+
+#endif // PROBE_INDEX_H_
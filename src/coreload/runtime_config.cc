@@ -3,6 +3,7 @@
 #include "utils.h"
 #include "cpprest/json.h"
 #include "runtime_config.h"
+#include "startup_metrics.h"
 #include "fx_reference.h"
 #include <cassert>
 
@@ -43,7 +44,7 @@ namespace coreload
         // Parse the file
         m_valid = ensure_parsed();
 
-        trace::verbose(_X("Runtime config [%s] is valid=[%d]"), path.c_str(), m_valid);
+        TRACE_VERBOSE(_X("Runtime config [%s] is valid=[%d]"), path.c_str(), m_valid);
     }
 
     bool runtime_config_t::parse_opts(const json_value& opts)
@@ -173,7 +174,7 @@ namespace coreload
 
     bool runtime_config_t::ensure_dev_config_parsed()
     {
-        trace::verbose(_X("Attempting to read dev runtime config: %s"), m_dev_path.c_str());
+        TRACE_VERBOSE(_X("Attempting to read dev runtime config: %s"), m_dev_path.c_str());
 
         pal::string_t retval;
         if (!pal::file_exists(m_dev_path))
@@ -182,22 +183,31 @@ namespace coreload
             return true;
         }
 
-        pal::ifstream_t file(m_dev_path);
-        if (!file.good())
+        std::vector<char> contents;
+        if (!read_file(m_dev_path, &contents))
         {
-            trace::verbose(_X("File stream not good %s"), m_dev_path.c_str());
+            TRACE_VERBOSE(_X("File stream not good %s"), m_dev_path.c_str());
             return false;
         }
 
-        if (skip_utf8_bom(&file))
+        const char* begin = contents.data();
+        const char* end = begin + contents.size();
+        if (skip_utf8_bom(&begin, end))
         {
-            trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), m_dev_path.c_str());
+            TRACE_VERBOSE(_X("UTF-8 BOM skipped while reading [%s]"), m_dev_path.c_str());
         }
 
         try
         {
-            const auto root = json_value::parse(file);
-            const auto& json = root.as_object();
+            startup_metrics_t* metrics = startup_metrics_t::active();
+            if (metrics != nullptr)
+            {
+                metrics->add_json_bytes(end - begin);
+            }
+
+            const auto document = web::json::document::parse(begin, end);
+            trace_json_memory(m_dev_path, document);
+            const auto& json = document.root().as_object();
             const auto iter = json.find(_X("runtimeOptions"));
             if (iter != json.end())
             {
@@ -215,7 +225,7 @@ namespace coreload
         return true;
     }
 
-    bool runtime_config_t::read_framework_array(web::json::array frameworks_json)
+    bool runtime_config_t::read_framework_array(const web::json::array& frameworks_json)
     {
         bool rc = true;
 
@@ -232,7 +242,7 @@ namespace coreload
 
             if (fx_out.get_fx_name().length() == 0)
             {
-                trace::verbose(_X("No framework name specified."));
+                TRACE_VERBOSE(_X("No framework name specified."));
                 rc = false;
                 break;
             }
@@ -243,7 +253,7 @@ namespace coreload
                 [&](const fx_reference_t& item) { return fx_out.get_fx_name() == item.get_fx_name(); })
                 != m_frameworks.end())
             {
-                trace::verbose(_X("Framework %s already specified."), fx_out.get_fx_name().c_str());
+                TRACE_VERBOSE(_X("Framework %s already specified."), fx_out.get_fx_name().c_str());
                 rc = false;
                 break;
             }
@@ -256,10 +266,10 @@ namespace coreload
 
     bool runtime_config_t::ensure_parsed()
     {
-        trace::verbose(_X("Attempting to read runtime config: %s"), m_path.c_str());
+        TRACE_VERBOSE(_X("Attempting to read runtime config: %s"), m_path.c_str());
         if (!ensure_dev_config_parsed())
         {
-            trace::verbose(_X("Did not successfully parse the runtimeconfig.dev.json"));
+            TRACE_VERBOSE(_X("Did not successfully parse the runtimeconfig.dev.json"));
         }
 
         pal::string_t retval;
@@ -269,23 +279,32 @@ namespace coreload
             return true;
         }
 
-        pal::ifstream_t file(m_path);
-        if (!file.good())
+        std::vector<char> contents;
+        if (!read_file(m_path, &contents))
         {
-            trace::verbose(_X("File stream not good %s"), m_path.c_str());
+            TRACE_VERBOSE(_X("File stream not good %s"), m_path.c_str());
             return false;
         }
 
-        if (skip_utf8_bom(&file))
+        const char* begin = contents.data();
+        const char* end = begin + contents.size();
+        if (skip_utf8_bom(&begin, end))
         {
-            trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), m_path.c_str());
+            TRACE_VERBOSE(_X("UTF-8 BOM skipped while reading [%s]"), m_path.c_str());
         }
 
         bool rc = true;
         try
         {
-            const auto root = json_value::parse(file);
-            const auto& json = root.as_object();
+            startup_metrics_t* metrics = startup_metrics_t::active();
+            if (metrics != nullptr)
+            {
+                metrics->add_json_bytes(end - begin);
+            }
+
+            const auto document = web::json::document::parse(begin, end);
+            trace_json_memory(m_path, document);
+            const auto& json = document.root().as_object();
             const auto iter = json.find(_X("runtimeOptions"));
             if (iter != json.end())
             {
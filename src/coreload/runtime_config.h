@@ -102,7 +102,7 @@ namespace coreload
 
     private:
         bool parse_framework(const json_object& fx_obj, fx_reference_t& fx_out);
-        bool read_framework_array(web::json::array frameworks);
+        bool read_framework_array(const web::json::array& frameworks);
         static void copy_framework_settings_to(const fx_reference_t& from, fx_reference_t& to);
     };
 } // namespace coreload
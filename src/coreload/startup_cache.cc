@@ -0,0 +1,392 @@
+#include "startup_cache.h"
+#include "deps_image.h"
+#include "utils.h"
+#include "trace.h"
+#include <cstring>
+
+namespace coreload
+{
+    namespace
+    {
+        const char magic[8] = { 'S', 'T', 'A', 'R', 'T', 'U', 'P', '\0' };
+        const uint32_t format_version = 1;
+
+        // Sequential records of fixed size values and length prefixed strings
+        class writer_t
+        {
+        public:
+            template <typename T>
+            void put(T value)
+            {
+                const char* bytes = reinterpret_cast<const char*>(&value);
+                m_data.insert(m_data.end(), bytes, bytes + sizeof(value));
+            }
+
+            void put_bytes(const void* data, size_t size)
+            {
+                const char* bytes = static_cast<const char*>(data);
+                m_data.insert(m_data.end(), bytes, bytes + size);
+            }
+
+            template <typename C>
+            void put_string(const std::basic_string<C>& value)
+            {
+                put(static_cast<uint32_t>(value.length()));
+                put_bytes(value.data(), value.length() * sizeof(C));
+            }
+
+            const std::vector<char>& data() const { return m_data; }
+
+        private:
+            std::vector<char> m_data;
+        };
+
+        class reader_t
+        {
+        public:
+            reader_t(const char* data, size_t size)
+                : m_position(data)
+                , m_end(data + size)
+            {
+            }
+
+            template <typename T>
+            bool get(T* value)
+            {
+                if (static_cast<size_t>(m_end - m_position) < sizeof(T))
+                {
+                    return false;
+                }
+                memcpy(value, m_position, sizeof(T));
+                m_position += sizeof(T);
+                return true;
+            }
+
+            template <typename C>
+            bool get_string(std::basic_string<C>* value)
+            {
+                uint32_t length;
+                if (!get(&length) || static_cast<size_t>(m_end - m_position) / sizeof(C) < length)
+                {
+                    return false;
+                }
+                value->resize(length);
+                if (length > 0)
+                {
+                    memcpy(&(*value)[0], m_position, length * sizeof(C));
+                }
+                m_position += length * sizeof(C);
+                return true;
+            }
+
+            bool at_end() const { return m_position == m_end; }
+
+        private:
+            const char* m_position;
+            const char* m_end;
+        };
+
+        void put_key(writer_t* writer, const startup_cache_t::key_t& key)
+        {
+            writer->put_string(key.app_path);
+            writer->put_string(key.app_root);
+            writer->put_string(key.deps_path);
+            writer->put_string(key.dotnet_root);
+            writer->put(static_cast<uint32_t>(key.mode));
+        }
+
+        bool get_key(reader_t* reader, startup_cache_t::key_t* key)
+        {
+            uint32_t mode;
+            if (!reader->get_string(&key->app_path) ||
+                !reader->get_string(&key->app_root) ||
+                !reader->get_string(&key->deps_path) ||
+                !reader->get_string(&key->dotnet_root) ||
+                !reader->get(&mode))
+            {
+                return false;
+            }
+            key->mode = static_cast<host_mode_t>(mode);
+            return true;
+        }
+
+        bool is_same_stamp(const pal::file_stamp_t& a, const pal::file_stamp_t& b)
+        {
+            return a.size == b.size && a.mtime == b.mtime;
+        }
+
+        // -----------------------------------------------------------------------------
+        // Check that the recorded environment variables and inputs are unchanged.
+        //
+        bool validate_inputs(reader_t* reader, size_t* input_count, const pal::char_t** error)
+        {
+            uint32_t env_count;
+            if (!reader->get(&env_count))
+            {
+                *error = _X("the file is truncated");
+                return false;
+            }
+
+            for (uint32_t i = 0; i < env_count; ++i)
+            {
+                pal::string_t name;
+                pal::string_t recorded;
+                if (!reader->get_string(&name) || !reader->get_string(&recorded))
+                {
+                    *error = _X("the file is truncated");
+                    return false;
+                }
+
+                pal::string_t value;
+                pal::getenv(name.c_str(), &value);
+                if (value != recorded)
+                {
+                    TRACE_VERBOSE(_X("Environment variable [%s] changed from [%s] to [%s]"), name.c_str(), recorded.c_str(), value.c_str());
+                    *error = _X("the environment changed");
+                    return false;
+                }
+            }
+
+            uint32_t count;
+            if (!reader->get(&count))
+            {
+                *error = _X("the file is truncated");
+                return false;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                pal::string_t path;
+                uint32_t kind;
+                uint32_t exists;
+                pal::file_stamp_t recorded;
+                if (!reader->get_string(&path) || !reader->get(&kind) || !reader->get(&exists) ||
+                    !reader->get(&recorded.size) || !reader->get(&recorded.mtime))
+                {
+                    *error = _X("the file is truncated");
+                    return false;
+                }
+
+                pal::file_stamp_t stamp;
+                bool found = pal::get_file_stamp(path, &stamp);
+                bool stamped = kind != static_cast<uint32_t>(startup_inputs_t::kind_t::component);
+                if (found != (exists != 0) || (found && stamped && !is_same_stamp(stamp, recorded)))
+                {
+                    TRACE_VERBOSE(_X("Startup input [%s] changed"), path.c_str());
+                    *error = _X("an input changed");
+                    return false;
+                }
+            }
+
+            *input_count = count;
+            return true;
+        }
+
+        bool read(reader_t* reader, const startup_cache_t::key_t& key, startup_cache_t* result, size_t* input_count, const pal::char_t** error)
+        {
+            char file_magic[sizeof(magic)];
+            uint32_t file_version;
+            uint32_t char_size;
+            if (!reader->get(&file_magic) || memcmp(file_magic, magic, sizeof(magic)) != 0)
+            {
+                *error = _X("not a startup cache");
+                return false;
+            }
+
+            if (!reader->get(&file_version) || file_version != format_version ||
+                !reader->get(&char_size) || char_size != sizeof(pal::char_t))
+            {
+                *error = _X("the format version does not match");
+                return false;
+            }
+
+            startup_cache_t::key_t file_key;
+            if (!get_key(reader, &file_key))
+            {
+                *error = _X("the file is truncated");
+                return false;
+            }
+
+            if (file_key.app_path != key.app_path || file_key.app_root != key.app_root ||
+                file_key.deps_path != key.deps_path || file_key.dotnet_root != key.dotnet_root || file_key.mode != key.mode)
+            {
+                *error = _X("it was saved for another app");
+                return false;
+            }
+
+            if (!validate_inputs(reader, input_count, error))
+            {
+                return false;
+            }
+
+            uint32_t property_count;
+            if (!reader->get_string(&result->clr_path) || !reader->get_string(&result->clr_dir) || !reader->get(&property_count))
+            {
+                *error = _X("the file is truncated");
+                return false;
+            }
+
+            for (uint32_t i = 0; i < property_count; ++i)
+            {
+                std::string property_key;
+                std::string property_value;
+                if (!reader->get_string(&property_key) || !reader->get_string(&property_value))
+                {
+                    *error = _X("the file is truncated");
+                    return false;
+                }
+                result->property_keys.push_back(std::move(property_key));
+                result->property_values.push_back(std::move(property_value));
+            }
+
+            if (!reader->at_end())
+            {
+                *error = _X("the file has trailing data");
+                return false;
+            }
+            return true;
+        }
+    }
+
+    pal::string_t startup_cache_t::get_path(const key_t& key)
+    {
+        pal::string_t cache_dir;
+        if (!pal::getenv(_X("COREHOST_STARTUP_CACHE"), &cache_dir) || cache_dir.empty())
+        {
+            return pal::string_t();
+        }
+
+        uint64_t hash = deps_image::hash_string(key.app_path);
+        hash = deps_image::hash_string(key.app_root, hash);
+        hash = deps_image::hash_string(key.deps_path, hash);
+        hash = deps_image::hash_string(key.dotnet_root, hash);
+        uint32_t mode = static_cast<uint32_t>(key.mode);
+        hash = deps_image::hash_bytes(&mode, sizeof(mode), hash);
+
+        pal::char_t key_hash[17];
+        for (int i = 15; i >= 0; --i)
+        {
+            key_hash[i] = _X("0123456789abcdef")[hash & 0xF];
+            hash >>= 4;
+        }
+        key_hash[16] = 0;
+
+        pal::string_t name = get_filename(key.app_path);
+        name.append(_X(".startup."));
+        name.append(key_hash);
+        name.append(_X(".bin"));
+
+        append_path(&cache_dir, name.c_str());
+        return cache_dir;
+    }
+
+    bool startup_cache_t::load(const pal::string_t& path, const key_t& key)
+    {
+        std::vector<char> contents;
+        if (!pal::file_exists(path) || !read_file(path, &contents))
+        {
+            return false;
+        }
+
+        reader_t reader(contents.data(), contents.size());
+        startup_cache_t result;
+        size_t input_count = 0;
+        const pal::char_t* error = nullptr;
+        if (!read(&reader, key, &result, &input_count, &error))
+        {
+            TRACE_VERBOSE(_X("Ignoring the startup cache [%s]: %s"), path.c_str(), error);
+            return false;
+        }
+
+        *this = std::move(result);
+        TRACE_VERBOSE(_X("Using the startup cache [%s], validated %zu inputs"), path.c_str(), input_count);
+        return true;
+    }
+
+    bool startup_cache_t::save(const pal::string_t& path, const key_t& key, const startup_inputs_t& inputs) const
+    {
+        if (!inputs.is_complete())
+        {
+            TRACE_VERBOSE(_X("Not saving the startup cache [%s]: the resolution used relative paths"), path.c_str());
+            return false;
+        }
+
+        const auto env = inputs.get_env();
+        const auto input_map = inputs.get_inputs();
+
+        writer_t writer;
+        writer.put_bytes(magic, sizeof(magic));
+        writer.put(format_version);
+        writer.put(static_cast<uint32_t>(sizeof(pal::char_t)));
+        put_key(&writer, key);
+
+        writer.put(static_cast<uint32_t>(env.size()));
+        for (const auto& variable : env)
+        {
+            writer.put_string(variable.first);
+            writer.put_string(variable.second);
+        }
+
+        writer.put(static_cast<uint32_t>(input_map.size()));
+        for (const auto& input : input_map)
+        {
+            writer.put_string(input.first);
+            writer.put(static_cast<uint32_t>(input.second.kind));
+            writer.put(static_cast<uint32_t>(input.second.exists ? 1 : 0));
+            writer.put(input.second.stamp.size);
+            writer.put(input.second.stamp.mtime);
+        }
+
+        writer.put_string(clr_path);
+        writer.put_string(clr_dir);
+        writer.put(static_cast<uint32_t>(property_keys.size()));
+        for (size_t i = 0; i < property_keys.size(); ++i)
+        {
+            writer.put_string(property_keys[i]);
+            writer.put_string(property_values[i]);
+        }
+
+        const auto& data = writer.data();
+        pal::string_t temp_path = path + _X(".") + pal::to_string(static_cast<int>(pal::get_pid())) + _X(".tmp");
+        {
+            std::ofstream file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file.write(data.data(), data.size()) || !file.flush())
+            {
+                TRACE_VERBOSE(_X("Could not write the startup cache [%s]"), temp_path.c_str());
+                file.close();
+                pal::remove_file(temp_path);
+                return false;
+            }
+        }
+
+        // An input changed shortly before now may change again without its write time
+        // changing, with coarse file system timestamps. Wait for a later start to save.
+        pal::file_stamp_t now;
+        if (!pal::get_file_stamp(temp_path, &now))
+        {
+            pal::remove_file(temp_path);
+            return false;
+        }
+
+        for (const auto& input : input_map)
+        {
+            if (input.second.exists && input.second.kind != startup_inputs_t::kind_t::component && now.mtime - input.second.stamp.mtime < 2 * pal::mtime_ticks_per_second)
+            {
+                TRACE_VERBOSE(_X("Not saving the startup cache [%s]: [%s] changed too recently"), path.c_str(), input.first.c_str());
+                pal::remove_file(temp_path);
+                return false;
+            }
+        }
+
+        if (!pal::replace_file(temp_path, path))
+        {
+            TRACE_VERBOSE(_X("Could not replace the startup cache [%s]"), path.c_str());
+            pal::remove_file(temp_path);
+            return false;
+        }
+
+        TRACE_VERBOSE(_X("Saved the startup cache [%s] with %zu inputs"), path.c_str(), input_map.size());
+        return true;
+    }
+
+} // namespace coreload
@@ -0,0 +1,54 @@
+#ifndef STARTUP_CACHE_H_
+#define STARTUP_CACHE_H_
+
+#include "pal.h"
+#include "libhost.h"
+#include "startup_inputs.h"
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // Persistent cache of the result of resolving the runtime for an app: the
+    // CoreCLR to bind and the properties to initialize it with.
+    //
+    // The result is determined by the app, the dotnet root and the host mode (the
+    // cache key) and by the files, directories and environment variables the
+    // resolution consults (its inputs). The cache records the stamps of the
+    // inputs, so that a warm start is validated with a stat per input instead of
+    // resolving again.
+    //
+    // The cache is enabled by setting COREHOST_STARTUP_CACHE to a directory, which
+    // should not be one of the directories the app probes.
+    //
+    class startup_cache_t
+    {
+    public:
+        struct key_t
+        {
+            pal::string_t app_path;
+            pal::string_t app_root;
+            pal::string_t deps_path;
+            pal::string_t dotnet_root;
+            host_mode_t mode;
+        };
+
+        // The cache file for a key, or an empty path if the cache is not enabled
+        static pal::string_t get_path(const key_t& key);
+
+        // Loads the result if the file was saved for the key and its inputs have
+        // not changed since.
+        bool load(const pal::string_t& path, const key_t& key);
+
+        bool save(const pal::string_t& path, const key_t& key, const startup_inputs_t& inputs) const;
+
+        pal::string_t clr_path;
+        pal::string_t clr_dir;
+
+        // CoreCLR properties, as passed to coreclr_initialize
+        std::vector<std::string> property_keys;
+        std::vector<std::string> property_values;
+    };
+
+} // namespace coreload
+
+#endif // STARTUP_CACHE_H_
@@ -0,0 +1,79 @@
+#include "startup_task.h"
+#include "trace.h"
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+namespace coreload
+{
+    startup_task_t::startup_task_t()
+        : m_done(false)
+        , m_exit_code(0)
+    {
+    }
+
+    std::shared_ptr<startup_task_t> startup_task_t::run(std::function<int()> start, callback_fn callback, void* context)
+    {
+        std::shared_ptr<startup_task_t> task(new startup_task_t());
+        trace::error_writer_fn error_writer = trace::get_error_writer();
+        try
+        {
+            std::thread([task, start, callback, context, error_writer]()
+            {
+                trace::set_error_writer(error_writer);
+                const int exit_code = start();
+                task->complete(exit_code);
+                if (callback != nullptr)
+                {
+                    callback(exit_code, context);
+                }
+            }).detach();
+        }
+        catch (const std::system_error&)
+        {
+            trace::error(_X("Failed to create the thread to start the runtime on"));
+            return nullptr;
+        }
+        return task;
+    }
+
+    void startup_task_t::complete(int exit_code)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_exit_code = exit_code;
+        m_done = true;
+        m_completed.notify_all();
+    }
+
+    bool startup_task_t::try_get_result(int* exit_code) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_done)
+        {
+            *exit_code = m_exit_code;
+        }
+        return m_done;
+    }
+
+    bool startup_task_t::wait(uint32_t timeout_ms, int* exit_code) const
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        const auto done = [this]() { return m_done; };
+        if (timeout_ms == infinite)
+        {
+            // Built with GCC 12 or later, an untimed wait binds to a GLIBCXX_3.4.30
+            // symbol that older libstdc++ runtimes in host processes do not export
+            while (!m_completed.wait_for(lock, std::chrono::hours(24), done))
+            {
+            }
+        }
+        else if (!m_completed.wait_for(lock, std::chrono::milliseconds(timeout_ms), done))
+        {
+            return false;
+        }
+
+        *exit_code = m_exit_code;
+        return true;
+    }
+
+} // namespace coreload
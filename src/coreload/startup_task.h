@@ -0,0 +1,49 @@
+#ifndef STARTUP_TASK_H_
+#define STARTUP_TASK_H_
+
+#include "pal.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace coreload
+{
+    // -----------------------------------------------------------------------------
+    // A runtime start running on a thread of its own, which can be polled, waited
+    // for with a timeout, or given a callback to run when it finishes.
+    //
+    // The thread keeps the task alive until it finishes, so the caller may release
+    // its reference at any time.
+    //
+    class startup_task_t
+    {
+    public:
+        // Called on the start's thread with its result once it can be waited for
+        typedef void (STDMETHODCALLTYPE *callback_fn)(int exit_code, void* context);
+
+        static const uint32_t infinite = UINT32_MAX;
+
+        // Runs 'start' on a new thread, or returns nullptr if none could be created
+        static std::shared_ptr<startup_task_t> run(std::function<int()> start, callback_fn callback, void* context);
+
+        // Returns true and the result of the start if it finished
+        bool try_get_result(int* exit_code) const;
+
+        // Waits up to 'timeout_ms' milliseconds, or as long as needed for
+        // 'infinite', for the start to finish
+        bool wait(uint32_t timeout_ms, int* exit_code) const;
+
+    private:
+        startup_task_t();
+
+        void complete(int exit_code);
+
+        mutable std::mutex m_lock;
+        mutable std::condition_variable m_completed;
+        bool m_done;
+        int m_exit_code;
+    };
+
+} // namespace coreload
+
+#endif // STARTUP_TASK_H_
@@ -0,0 +1,177 @@
+//
+// tracedump.cc
+// Turns a binary trace capture (COREHOST_TRACE_BINARY=1) back into the text trace
+// it stands for, or into JSON.
+//
+// Usage: coreload-tracedump [--json] <capture file>
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "trace_capture.h"
+
+using namespace coreload;
+
+namespace
+{
+    void write_json_string(const std::string& value, FILE* out)
+    {
+        fputc('"', out);
+        for (unsigned char c : value)
+        {
+            switch (c)
+            {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (c < 0x20)
+                {
+                    fprintf(out, "\\u%04x", c);
+                }
+                else
+                {
+                    fputc(c, out);
+                }
+                break;
+            }
+        }
+        fputc('"', out);
+    }
+
+    void write_json_arg(const trace_capture::arg_t& arg, FILE* out)
+    {
+        switch (arg.type)
+        {
+        case trace_capture::arg_type_t::signed_int:
+            fprintf(out, "%lld", static_cast<long long>(arg.signed_value));
+            break;
+        case trace_capture::arg_type_t::unsigned_int:
+            fprintf(out, "%llu", static_cast<unsigned long long>(arg.unsigned_value));
+            break;
+        case trace_capture::arg_type_t::floating:
+            if (arg.floating_value != arg.floating_value)
+            {
+                fputs("null", out);
+            }
+            else
+            {
+                fprintf(out, "%.17g", arg.floating_value);
+            }
+            break;
+        case trace_capture::arg_type_t::string:
+            write_json_string(arg.string_value, out);
+            break;
+        case trace_capture::arg_type_t::pointer:
+            fprintf(out, "\"0x%llx\"", static_cast<unsigned long long>(arg.unsigned_value));
+            break;
+        }
+    }
+
+    void write_json(const std::vector<trace_capture::capture_t>& captures, const std::vector<trace_capture::event_t>& events, FILE* out)
+    {
+        fputs("[", out);
+        const char* separator = "\n";
+        for (const auto& event : events)
+        {
+            const trace_capture::capture_t& capture = captures[event.capture];
+            const trace_capture::site_t& site = capture.sites.at(event.site_id);
+
+            fprintf(out, "%s  { \"capture\": %zu, \"time_ns\": %llu, \"timestamp_ns\": %llu, \"thread\": %u, \"level\": \"%s\", \"site\": %u, \"format\": ",
+                separator,
+                event.capture,
+                static_cast<unsigned long long>(capture.start_time_ns + event.timestamp_ns),
+                static_cast<unsigned long long>(event.timestamp_ns),
+                event.thread_id,
+                trace_capture::level_name(site.level),
+                event.site_id);
+            write_json_string(site.format, out);
+
+            fputs(", \"args\": [", out);
+            for (size_t i = 0; i < event.args.size(); ++i)
+            {
+                if (i > 0)
+                {
+                    fputs(", ", out);
+                }
+                write_json_arg(event.args[i], out);
+            }
+
+            fputs("], \"message\": ", out);
+            write_json_string(trace_capture::format_message(site, event), out);
+            fputs(" }", out);
+            separator = ",\n";
+        }
+        fputs("\n]\n", out);
+    }
+
+    int usage()
+    {
+        fprintf(stderr, "Usage: coreload-tracedump [--json] <capture file>\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else if (path == nullptr && argv[i][0] != '-')
+        {
+            path = argv[i];
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if (path == nullptr)
+    {
+        return usage();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return 1;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<trace_capture::capture_t> captures;
+    std::vector<trace_capture::event_t> events;
+    std::string error;
+    bool valid = trace_capture::read(data, &captures, &events, &error);
+
+    if (json)
+    {
+        write_json(captures, events, stdout);
+    }
+    else
+    {
+        for (const auto& event : events)
+        {
+            const trace_capture::site_t& site = captures[event.capture].sites.at(event.site_id);
+            fputs(trace_capture::format_message(site, event).c_str(), stdout);
+            fputc('\n', stdout);
+        }
+    }
+
+    if (!valid)
+    {
+        fprintf(stderr, "%s: %s\n", path, error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,26 @@
 #include "pch.h"
+#include <atomic>
+#include <thread>
 #include "coreload.h"
+#include "mock_runtime.h"
 
+// Copies a host string into one of the fixed size argument buffers.
+static void copy_host_string(
+    coreload::pal::char_t* destination,
+    size_t destination_size,
+    const coreload::pal::char_t* source)
+{
+#if defined(_WIN32)
+    wcscpy_s(destination, destination_size, source);
+#else
+    const size_t length = std::min(coreload::pal::strlen(source), destination_size - 1);
+    std::copy(source, source + length, destination);
+    destination[length] = _X('\0');
+#endif
+}
+
+#if defined(_WIN32)
+// Requires the .NET Core SDK and the Calculator.dll test assembly
 TEST(ExecuteDotnetAssemblyTest, CanExecuteDotnetAssembly)
 {
     // Assembly file name for getting base library path 
@@ -130,6 +150,298 @@ TEST(ExecuteDotnetAssemblyTest, CanExecuteDotnetAssembly)
     // Unload the AppDomain and stop the host
     EXPECT_EQ(NOERROR, UnloadRuntime());
 }
+#endif
+
+#if defined(CORECLR_MOCK_PATH)
+static std::string to_utf8(const coreload::pal::string_t& value)
+{
+    std::vector<char> utf8;
+    coreload::pal::pal_utf8string(value, &utf8);
+    return std::string(utf8.data());
+}
+
+// The same calls on the coreclr_mock stand-in, which needs no .NET install
+TEST(ExecuteMockAssemblyTest, CanExecuteMockAssembly)
+{
+    test_utils::mock_runtime_layout_t layout(40);
+    ASSERT_TRUE(layout.is_valid());
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, layout.get_app_path().c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, layout.get_dotnet_root().c_str());
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+
+    test_utils::mock_runtime_t runtime(layout);
+    ASSERT_TRUE(runtime.is_loaded());
+    EXPECT_EQ(1u, runtime.get_calls().initialize);
+
+    // The properties the host resolved for the app and its framework
+    const std::string tpa = runtime.get_property("TRUSTED_PLATFORM_ASSEMBLIES");
+    EXPECT_NE(std::string::npos, tpa.find(to_utf8(layout.get_app_path())));
+    EXPECT_NE(std::string::npos, tpa.find(to_utf8(test_utils::path_combine(layout.get_fx_dir(), _X("Microsoft.NETCore.App.Library39.dll")))));
+    EXPECT_EQ(to_utf8(coreload::get_directory(layout.get_app_path())), runtime.get_property("APP_CONTEXT_BASE_DIRECTORY"));
+    EXPECT_EQ("3.1.0", runtime.get_property("FX_PRODUCT_VERSION"));
+    EXPECT_NE(std::string::npos, runtime.get_property("FX_DEPS_FILE").find("Microsoft.NETCore.App.deps.json"));
+    EXPECT_GE(runtime.get_property_count(), 9);
+
+    typedef int (STDMETHODCALLTYPE calculator_method_fn)(const int a, const int b);
+    calculator_method_fn* calculator_delegate = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate(
+        "Calculator", "Calculator.Calculator", "Add", reinterpret_cast<void**>(&calculator_delegate)));
+    ASSERT_NE(nullptr, calculator_delegate);
+    EXPECT_EQ(3, calculator_delegate(1, 2));
+
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate(
+        "Calculator", "Calculator.Calculator", "Subtract", reinterpret_cast<void**>(&calculator_delegate)));
+    EXPECT_EQ(1, calculator_delegate(1, 2));
+
+    void* missing = nullptr;
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegate(
+        "Calculator", "Calculator.Calculator", "Missing", &missing));
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegate(
+        "Missing", "Calculator.Calculator", "Add", &missing));
+
+    assembly_function_call assembly_function_call = { 0 };
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, _X("Calculator"));
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, _X("Calculator.Calculator"));
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, _X("Load"));
+    EXPECT_EQ(coreload::StatusCode::Success, ExecuteAssemblyFunction(&assembly_function_call));
+    EXPECT_EQ(5u, runtime.get_calls().create_delegate);
+
+    EXPECT_EQ(0, UnloadRuntime());
+    EXPECT_EQ(1u, runtime.get_calls().shutdown);
+
+    // The runtime can be started again once unloaded
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+    EXPECT_EQ(2u, runtime.get_calls().initialize);
+
+    host_startup_metrics metrics = { 0 };
+    metrics.size = sizeof(metrics);
+    ASSERT_EQ(coreload::StatusCode::Success, GetHostStartupMetrics(&metrics));
+    EXPECT_LE(metrics.coreclr_bind.end_time, metrics.coreclr_initialize.start_time);
+    EXPECT_LE(metrics.coreclr_initialize.start_time, metrics.coreclr_initialize.end_time);
+    EXPECT_NE(0u, metrics.coreclr_initialize.end_time);
+    EXPECT_GE(metrics.tpa_entries, 42u);
+
+    EXPECT_EQ(0, UnloadRuntime());
+}
+
+// Delegates are created once per method until the runtime is unloaded
+TEST(ExecuteMockAssemblyTest, CachesDelegates)
+{
+    test_utils::mock_runtime_layout_t layout(10);
+    ASSERT_TRUE(layout.is_valid());
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, layout.get_app_path().c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, layout.get_dotnet_root().c_str());
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+
+    test_utils::mock_runtime_t runtime(layout);
+    ASSERT_TRUE(runtime.is_loaded());
+
+    void* first = nullptr;
+    void* second = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Add", &first));
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Add", &second));
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(1u, runtime.get_calls().create_delegate);
+
+    // Failures are not cached
+    void* missing = nullptr;
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Missing", &missing));
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Missing", &missing));
+    EXPECT_EQ(3u, runtime.get_calls().create_delegate);
+
+    assembly_function_call assembly_function_call = { 0 };
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, _X("Calculator"));
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, _X("Calculator.Calculator"));
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, _X("Load"));
+    EXPECT_EQ(coreload::StatusCode::Success, ExecuteAssemblyFunction(&assembly_function_call));
+    EXPECT_EQ(coreload::StatusCode::Success, ExecuteAssemblyFunction(&assembly_function_call));
+
+    void* handle = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, GetAssemblyFunctionHandle(&assembly_function_call, &handle));
+    ASSERT_NE(nullptr, handle);
+    EXPECT_EQ(coreload::StatusCode::Success, ExecuteAssemblyFunctionHandle(handle, assembly_function_call.arguments));
+    EXPECT_EQ(coreload::StatusCode::Success, ExecuteAssemblyFunctionHandle(handle, nullptr));
+    EXPECT_EQ(4u, runtime.get_calls().create_delegate);
+
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, ExecuteAssemblyFunctionHandle(nullptr, nullptr));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, GetAssemblyFunctionHandle(&assembly_function_call, nullptr));
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, _X("Missing"));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, GetAssemblyFunctionHandle(&assembly_function_call, &handle));
+    EXPECT_EQ(nullptr, handle);
+    EXPECT_EQ(5u, runtime.get_calls().create_delegate);
+
+    // A new runtime creates its delegates again
+    EXPECT_EQ(0, UnloadRuntime());
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate("Calculator", "Calculator.Calculator", "Add", &first));
+    EXPECT_EQ(6u, runtime.get_calls().create_delegate);
+    EXPECT_EQ(0, UnloadRuntime());
+}
+
+TEST(ExecuteMockAssemblyTest, CreatesDelegatesInOneCall)
+{
+    test_utils::mock_runtime_layout_t layout(10);
+    ASSERT_TRUE(layout.is_valid());
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, layout.get_app_path().c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, layout.get_dotnet_root().c_str());
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+
+    test_utils::mock_runtime_t runtime(layout);
+    ASSERT_TRUE(runtime.is_loaded());
+    const unsigned int calls = runtime.get_calls().create_delegate;
+
+    int statuses[9];
+    std::fill(std::begin(statuses), std::end(statuses), -1);
+    const delegate_request requests[] = {
+        { "Calculator", "Calculator.Calculator", "Add", &statuses[0] },
+        { "Missing", "Calculator.Calculator", "Add", &statuses[1] },
+        { "Calculator", "Calculator.Missing", "Add", &statuses[2] },
+        { "Calculator", "Calculator.Calculator", "Subtract", &statuses[3] },
+        { "Calculator", "Calculator.Calculator", nullptr, &statuses[4] },
+        { "Missing", "Calculator.Calculator", "Subtract", &statuses[5] },
+        { "Calculator", "Calculator.Missing", "Subtract", &statuses[6] },
+        { "Calculator", "Calculator.Calculator", "Missing", &statuses[7] },
+        { "Calculator", "Calculator.Calculator", "Add", &statuses[8] },
+        { "Calculator", "Calculator.Calculator", "Multiply", nullptr } };
+    const size_t count = sizeof(requests) / sizeof(requests[0]);
+
+    void* delegates[count];
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegates(requests, count, delegates));
+    EXPECT_EQ(coreload::StatusCode::Success, statuses[0]);
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, statuses[1]);
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, statuses[2]);
+    EXPECT_EQ(coreload::StatusCode::Success, statuses[3]);
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, statuses[4]);
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, statuses[5]);
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, statuses[6]);
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, statuses[7]);
+    EXPECT_EQ(coreload::StatusCode::Success, statuses[8]);
+
+    typedef int (STDMETHODCALLTYPE calculator_method_fn)(const int a, const int b);
+    ASSERT_NE(nullptr, delegates[0]);
+    EXPECT_EQ(3, reinterpret_cast<calculator_method_fn*>(delegates[0])(1, 2));
+    EXPECT_EQ(1, reinterpret_cast<calculator_method_fn*>(delegates[3])(1, 2));
+    EXPECT_EQ(6, reinterpret_cast<calculator_method_fn*>(delegates[9])(2, 3));
+    EXPECT_EQ(delegates[0], delegates[8]);
+    for (size_t i : { 1, 2, 4, 5, 6, 7 })
+    {
+        EXPECT_EQ(nullptr, delegates[i]);
+    }
+
+    // Every method is asked for once, also the other methods of an assembly or
+    // type which failed to load
+    EXPECT_EQ(calls + 8, runtime.get_calls().create_delegate);
+
+    // Only the failures are asked for again
+    EXPECT_EQ(coreload::StatusCode::CoreClrExeFailure, CreateAssemblyDelegates(requests, count, delegates));
+    EXPECT_EQ(calls + 13, runtime.get_calls().create_delegate);
+    EXPECT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegates(requests, 1, delegates));
+    EXPECT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegates(nullptr, 0, nullptr));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, CreateAssemblyDelegates(nullptr, 1, delegates));
+    EXPECT_EQ(calls + 13, runtime.get_calls().create_delegate);
+
+    EXPECT_EQ(0, UnloadRuntime());
+}
+
+namespace
+{
+    struct start_result_t
+    {
+        std::atomic<int> calls;
+        std::atomic<int> exit_code;
+    };
+
+    void STDMETHODCALLTYPE on_start_complete(int exit_code, void* context)
+    {
+        auto result = static_cast<start_result_t*>(context);
+        result->exit_code = exit_code;
+        ++result->calls;
+    }
+}
+
+TEST(ExecuteMockAssemblyTest, StartsTheRuntimeAsynchronously)
+{
+    test_utils::mock_runtime_layout_t layout(10);
+    ASSERT_TRUE(layout.is_valid());
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, layout.get_app_path().c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, layout.get_dotnet_root().c_str());
+
+    start_result_t result;
+    result.calls = 0;
+    result.exit_code = -1;
+    void* handle = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLRAsync(&host_arguments, &on_start_complete, &result, &handle));
+    ASSERT_NE(nullptr, handle);
+
+    // Waits for the runtime to be ready
+    typedef int (STDMETHODCALLTYPE calculator_method_fn)(const int a, const int b);
+    calculator_method_fn* calculator_delegate = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, CreateAssemblyDelegate(
+        "Calculator", "Calculator.Calculator", "Add", reinterpret_cast<void**>(&calculator_delegate)));
+    EXPECT_EQ(3, calculator_delegate(1, 2));
+
+    int completed = 0;
+    int exit_code = -1;
+    ASSERT_EQ(coreload::StatusCode::Success, WaitStartCoreCLR(handle, START_CORECLR_INFINITE, &completed, &exit_code));
+    EXPECT_EQ(1, completed);
+    EXPECT_EQ(coreload::StatusCode::Success, exit_code);
+
+    completed = 0;
+    exit_code = -1;
+    ASSERT_EQ(coreload::StatusCode::Success, PollStartCoreCLR(handle, &completed, &exit_code));
+    EXPECT_EQ(1, completed);
+    EXPECT_EQ(coreload::StatusCode::Success, exit_code);
+    EXPECT_EQ(coreload::StatusCode::Success, CloseStartCoreCLR(handle));
+
+    // The callback runs after the start can be waited for
+    while (result.calls == 0)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(1, result.calls);
+    EXPECT_EQ(coreload::StatusCode::Success, result.exit_code);
+
+    test_utils::mock_runtime_t runtime(layout);
+    ASSERT_TRUE(runtime.is_loaded());
+    EXPECT_EQ(1u, runtime.get_calls().create_delegate);
+    EXPECT_EQ(0, UnloadRuntime());
+}
+
+TEST(ExecuteMockAssemblyTest, ReportsAsynchronousStartFailures)
+{
+    test_utils::mock_runtime_layout_t layout(10);
+    ASSERT_TRUE(layout.is_valid());
+
+    // The app runs on a framework the install does not have
+    const coreload::pal::string_t app_dir = coreload::get_directory(layout.get_app_path());
+    ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("Calculator.runtimeconfig.json")),
+        "{ \"runtimeOptions\": { \"framework\": { \"name\": \"Microsoft.NETCore.App\", \"version\": \"9.0.0\" } } }"));
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, layout.get_app_path().c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, layout.get_dotnet_root().c_str());
+
+    void* handle = nullptr;
+    ASSERT_EQ(coreload::StatusCode::Success, StartCoreCLRAsync(&host_arguments, nullptr, nullptr, &handle));
+
+    int completed = 0;
+    int exit_code = 0;
+    while (!completed)
+    {
+        ASSERT_EQ(coreload::StatusCode::Success, WaitStartCoreCLR(handle, 10, &completed, &exit_code));
+    }
+    EXPECT_EQ(coreload::StatusCode::FrameworkMissingFailure, exit_code);
+    EXPECT_EQ(coreload::StatusCode::Success, CloseStartCoreCLR(handle));
+}
+#endif
 
 TEST(LibraryExportsTest, TestExecuteAssemblyFunctionWithOneEmptyAssemblyName)
 {
@@ -141,9 +453,9 @@ TEST(LibraryExportsTest, TestExecuteAssemblyFunctionWithOneEmptyAssemblyName)
 
     const auto empty_string = _X("");
 
-    wcscpy_s(assembly_function_call.assembly_name, max_function_name_size, empty_string);
-    wcscpy_s(assembly_function_call.class_name, max_function_name_size, _X("ClassName"));
-    wcscpy_s(assembly_function_call.function_name, max_function_name_size, _X("MethodName"));
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, _X("ClassName"));
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, _X("MethodName"));
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, ExecuteAssemblyFunction(&assembly_function_call));
 }
@@ -158,9 +470,9 @@ TEST(LibraryExportsTest, TestExecuteAssemblyFunctionWithOneEmptyClassName)
 
     const auto empty_string = _X("");
 
-    wcscpy_s(assembly_function_call.assembly_name, max_function_name_size, _X("AssemblyName"));
-    wcscpy_s(assembly_function_call.class_name, max_function_name_size, empty_string);
-    wcscpy_s(assembly_function_call.function_name, max_function_name_size, _X("MethodName"));
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, _X("AssemblyName"));
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, _X("MethodName"));
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, ExecuteAssemblyFunction(&assembly_function_call));
 }
@@ -175,9 +487,9 @@ TEST(LibraryExportsTest, TestExecuteAssemblyFunctionWithOneEmptyClassMethodName)
 
     const auto empty_string = _X("");
 
-    wcscpy_s(assembly_function_call.assembly_name, max_function_name_size, _X("AssemblyName"));
-    wcscpy_s(assembly_function_call.class_name, max_function_name_size, _X("ClassName"));
-    wcscpy_s(assembly_function_call.function_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, _X("AssemblyName"));
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, _X("ClassName"));
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, empty_string);
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, ExecuteAssemblyFunction(&assembly_function_call));
 }
@@ -192,9 +504,9 @@ TEST(LibraryExportsTest, TestExecuteAssemblyFunctionWithEmptyArguments)
 
     const auto empty_string = _X("");
 
-    wcscpy_s(assembly_function_call.assembly_name, max_function_name_size, empty_string);
-    wcscpy_s(assembly_function_call.class_name, max_function_name_size, empty_string);
-    wcscpy_s(assembly_function_call.function_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.assembly_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.class_name, max_function_name_size, empty_string);
+    copy_host_string(assembly_function_call.function_name, max_function_name_size, empty_string);
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, ExecuteAssemblyFunction(&assembly_function_call));
 }
@@ -204,8 +516,8 @@ TEST(LibraryExportsTest, TestStartCoreCLRWithEmptyArguments)
     core_host_arguments host_arguments = { 0 };
 
     const auto empty_string = _X("");
-    wcscpy_s(host_arguments.assembly_file_path, MAX_PATH, empty_string);
-    wcscpy_s(host_arguments.core_root_path, MAX_PATH, empty_string);
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, empty_string);
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, empty_string);
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLR(&host_arguments));
 }
@@ -215,8 +527,8 @@ TEST(TestLibraryExports, TestStartCoreCLRWithEmptyAssemblyPath)
     core_host_arguments host_arguments = { 0 };
 
     const auto empty_string = _X("");
-    wcscpy_s(host_arguments.assembly_file_path, MAX_PATH, empty_string);
-    wcscpy_s(host_arguments.core_root_path, MAX_PATH, _X("C:\\"));
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, empty_string);
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, _X("C:\\"));
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLR(&host_arguments));
 }
@@ -226,8 +538,8 @@ TEST(TestLibraryExports, TestStartCoreCLRWithEmptyCoreRootPath)
     core_host_arguments host_arguments = { 0 };
 
     const auto empty_string = _X("");
-    wcscpy_s(host_arguments.assembly_file_path, MAX_PATH, _X("C:\\"));
-    wcscpy_s(host_arguments.core_root_path, MAX_PATH, empty_string);
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, _X("C:\\"));
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, empty_string);
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLR(&host_arguments));
 }
@@ -247,8 +559,76 @@ TEST(TestLibraryExports, TestStartCoreCLRWithInvalidAssemblyPath)
     core_host_arguments host_arguments = { 0 };
 
     const auto invalid_file_path = _X("^-.3this_is_not_a_file_path");
-    wcscpy_s(host_arguments.assembly_file_path, MAX_PATH, invalid_file_path);
-    wcscpy_s(host_arguments.core_root_path, MAX_PATH, _X("C:\\"));
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, invalid_file_path);
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, _X("C:\\"));
 
     EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLR(&host_arguments));
 }
+
+TEST(TestLibraryExports, TestGetHostStartupMetricsWithNullArguments)
+{
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, GetHostStartupMetrics(nullptr));
+
+    host_startup_metrics metrics = { 0 };
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, GetHostStartupMetrics(&metrics));
+}
+
+TEST(TestLibraryExports, TestGetHostStartupMetricsAfterStartCoreCLR)
+{
+    const auto root = test_utils::make_temp_directory(_X("startup_metrics_export_test"));
+    ASSERT_FALSE(root.empty());
+
+    const std::string runtime_config = "{ \"runtimeOptions\": {} }";
+    const auto app_path = test_utils::path_combine(root, _X("app.dll"));
+    ASSERT_TRUE(test_utils::write_file(app_path, "app"));
+    ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(root, _X("app.runtimeconfig.json")), runtime_config));
+
+    core_host_arguments host_arguments = { 0 };
+    copy_host_string(host_arguments.assembly_file_path, MAX_PATH, app_path.c_str());
+    copy_host_string(host_arguments.core_root_path, MAX_PATH, root.c_str());
+
+    // There is no runtime to start, but the resolution runs up to where it is missing.
+    EXPECT_NE(coreload::StatusCode::Success, StartCoreCLR(&host_arguments));
+
+    host_startup_metrics metrics = { 0 };
+    metrics.size = sizeof(metrics);
+    ASSERT_EQ(coreload::StatusCode::Success, GetHostStartupMetrics(&metrics));
+    EXPECT_EQ(sizeof(metrics), metrics.size);
+    EXPECT_NE(0u, metrics.start_time);
+    EXPECT_LE(metrics.start_time, metrics.runtime_config.start_time);
+    EXPECT_LE(metrics.runtime_config.start_time, metrics.runtime_config.end_time);
+    EXPECT_LE(metrics.runtime_config.end_time, metrics.end_time);
+    EXPECT_EQ(runtime_config.size(), metrics.json_bytes_parsed);
+    EXPECT_EQ(0u, metrics.coreclr_initialize.start_time);
+    EXPECT_EQ(0u, metrics.startup_cache_hit);
+    if (metrics.allocations_tracked)
+    {
+        EXPECT_NE(0u, metrics.allocations.allocations);
+        EXPECT_NE(0u, metrics.runtime_config_allocations.allocations);
+        EXPECT_LE(metrics.runtime_config_allocations.bytes, metrics.allocations.bytes);
+    }
+
+    // A caller built against a smaller structure only gets the fields it knows.
+    host_startup_metrics partial;
+    memset(&partial, 0xFF, sizeof(partial));
+    partial.size = offsetof(host_startup_metrics, runtime_config);
+    ASSERT_EQ(coreload::StatusCode::Success, GetHostStartupMetrics(&partial));
+    EXPECT_EQ(metrics.start_time, partial.start_time);
+    EXPECT_EQ(UINT64_MAX, partial.runtime_config.start_time);
+
+    test_utils::remove_directory_tree(root);
+}
+
+TEST(LibraryExportsTest, TestStartCoreCLRAsyncWithInvalidArguments)
+{
+    core_host_arguments host_arguments = { 0 };
+    void* handle = nullptr;
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLRAsync(nullptr, nullptr, nullptr, &handle));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, StartCoreCLRAsync(&host_arguments, nullptr, nullptr, &handle));
+
+    int completed = 0;
+    int exit_code = 0;
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, PollStartCoreCLR(nullptr, &completed, &exit_code));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, WaitStartCoreCLR(nullptr, 0, &completed, &exit_code));
+    EXPECT_EQ(coreload::StatusCode::InvalidArgFailure, CloseStartCoreCLR(nullptr));
+}
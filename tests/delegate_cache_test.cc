@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "delegate_cache.h"
+#include <atomic>
+#include <thread>
+
+using coreload::delegate_cache_t;
+
+namespace
+{
+    void* make_delegate(size_t value)
+    {
+        return reinterpret_cast<void*>(value + 1);
+    }
+}
+
+TEST(DelegateCacheTest, FindsTheDelegateInsertedForTheNames)
+{
+    delegate_cache_t cache;
+    EXPECT_EQ(nullptr, cache.find("Calculator", "Calculator.Calculator", "Add"));
+
+    const auto entry = cache.insert("Calculator", "Calculator.Calculator", "Add", make_delegate(1));
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(make_delegate(1), entry->delegate);
+    EXPECT_EQ("Calculator", entry->assembly_name);
+    EXPECT_EQ("Calculator.Calculator", entry->type_name);
+    EXPECT_EQ("Add", entry->method_name);
+
+    EXPECT_EQ(entry, cache.find("Calculator", "Calculator.Calculator", "Add"));
+    EXPECT_EQ(nullptr, cache.find("Calculator", "Calculator.Calculator", "Subtract"));
+    EXPECT_EQ(nullptr, cache.find("calculator", "Calculator.Calculator", "Add"));
+    EXPECT_EQ(1u, cache.size());
+}
+
+TEST(DelegateCacheTest, KeepsTheNamesApart)
+{
+    // The same characters split differently between the names
+    delegate_cache_t cache;
+    const auto first = cache.insert("ab", "c", "d", make_delegate(1));
+    const auto second = cache.insert("a", "bc", "d", make_delegate(2));
+    const auto third = cache.insert("a", "b", "cd", make_delegate(3));
+
+    EXPECT_EQ(first, cache.find("ab", "c", "d"));
+    EXPECT_EQ(second, cache.find("a", "bc", "d"));
+    EXPECT_EQ(third, cache.find("a", "b", "cd"));
+    EXPECT_EQ(3u, cache.size());
+}
+
+TEST(DelegateCacheTest, KeepsTheFirstDelegateInserted)
+{
+    delegate_cache_t cache;
+    const auto first = cache.insert("Calculator", "Calculator.Calculator", "Add", make_delegate(1));
+    const auto second = cache.insert("Calculator", "Calculator.Calculator", "Add", make_delegate(2));
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(make_delegate(1), second->delegate);
+    EXPECT_EQ(1u, cache.size());
+}
+
+TEST(DelegateCacheTest, EntriesKeepTheirAddressWhenTheTableGrows)
+{
+    delegate_cache_t cache;
+    std::vector<const delegate_cache_t::entry_t*> entries;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const std::string method = "Method" + std::to_string(i);
+        entries.push_back(cache.insert("Assembly", "Type", method.c_str(), make_delegate(i)));
+    }
+
+    EXPECT_EQ(1000u, cache.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const std::string method = "Method" + std::to_string(i);
+        EXPECT_EQ(entries[i], cache.find("Assembly", "Type", method.c_str()));
+        EXPECT_EQ(make_delegate(i), entries[i]->delegate);
+    }
+}
+
+TEST(DelegateCacheTest, ClearRemovesTheDelegates)
+{
+    delegate_cache_t cache;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        cache.insert("Assembly", "Type", ("Method" + std::to_string(i)).c_str(), make_delegate(i));
+    }
+
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(nullptr, cache.find("Assembly", "Type", "Method0"));
+
+    const auto entry = cache.insert("Assembly", "Type", "Method0", make_delegate(7));
+    EXPECT_EQ(entry, cache.find("Assembly", "Type", "Method0"));
+}
+
+TEST(DelegateCacheTest, ReadersSeeEveryEntryAWriterPublished)
+{
+    const size_t method_count = 2000;
+    std::vector<std::string> methods;
+    for (size_t i = 0; i < method_count; ++i)
+    {
+        methods.push_back("Method" + std::to_string(i));
+    }
+
+    // Readers check that anything they find is complete while the table grows
+    delegate_cache_t cache;
+    std::atomic<size_t> published(0);
+    std::atomic<bool> failed(false);
+    std::atomic<size_t> started(0);
+    std::vector<std::thread> readers;
+    for (size_t reader = 0; reader < 4; ++reader)
+    {
+        readers.emplace_back([&]()
+        {
+            ++started;
+            while (published.load() < method_count)
+            {
+                // The newest entry, and an older one which may have moved to a larger table
+                const size_t count = published.load();
+                for (size_t i : { count / 2, count - 1 })
+                {
+                    if (i >= count)
+                    {
+                        continue;
+                    }
+                    const auto entry = cache.find("Assembly", "Type", methods[i].c_str());
+                    if (entry != nullptr && (entry->method_name != methods[i] || entry->delegate != make_delegate(i)))
+                    {
+                        failed = true;
+                    }
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    while (started.load() < readers.size())
+    {
+        std::this_thread::yield();
+    }
+
+    for (size_t i = 0; i < method_count; ++i)
+    {
+        cache.insert("Assembly", "Type", methods[i].c_str(), make_delegate(i));
+        published = i + 1;
+        std::this_thread::yield();
+    }
+
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_FALSE(failed.load());
+    for (size_t i = 0; i < method_count; ++i)
+    {
+        const auto entry = cache.find("Assembly", "Type", methods[i].c_str());
+        ASSERT_NE(nullptr, entry);
+        EXPECT_EQ(make_delegate(i), entry->delegate);
+    }
+}
@@ -0,0 +1,573 @@
+#include "pch.h"
+#include "deps_format.h"
+#include "deps_image.h"
+#include "test_utils.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+using coreload::deps_entry_t;
+using coreload::deps_json_t;
+using coreload::pal::string_t;
+
+namespace
+{
+    // Shaped after the Microsoft.NETCore.App framework deps file: runtime target
+    // with a signature, rid specific native assets and a native image.
+    const char framework_deps[] = R"json({
+  "runtimeTarget": {
+    "name": ".NETCoreApp,Version=v2.2",
+    "signature": "7e5fcf2a1dd5e4d4a5f2cd1e5e0e8a3b9d1dd2a4"
+  },
+  "compilationOptions": {},
+  "targets": {
+    ".NETCoreApp,Version=v2.2": {
+      "Microsoft.NETCore.App/2.2.1": {
+        "dependencies": {
+          "Microsoft.NETCore.Platforms": "2.2.1",
+          "runtime.linux-x64.Microsoft.NETCore.App": "2.2.1"
+        },
+        "runtime": {
+          "System.Runtime.dll": { "assemblyVersion": "4.2.1.0", "fileVersion": "4.6.27207.3" },
+          "System.Collections.dll": { "assemblyVersion": "4.1.1.0", "fileVersion": "4.6.27207.3" },
+          "Microsoft.CSharp.dll": { "assemblyVersion": "4.0.5.0", "fileVersion": "4.6.27207.3" },
+          "System.Private.CoreLib.ni.dll": { "assemblyVersion": "4.0.0.0", "fileVersion": "4.6.27207.3" }
+        },
+        "native": {
+          "System.Native.so": { "fileVersion": "0.0.0.0" },
+          "libclrjit.so": { "fileVersion": "0.0.0.0" }
+        },
+        "runtimeTargets": {
+          "runtimes/linux-x64/native/libcoreclr.so": { "rid": "linux-x64", "assetType": "native", "fileVersion": "0.0.0.0" },
+          "runtimes/win-x64/native/coreclr.dll": { "rid": "win-x64", "assetType": "native", "fileVersion": "4.6.27207.3" },
+          "runtimes/osx-x64/native/libcoreclr.dylib": { "rid": "osx-x64", "assetType": "native", "fileVersion": "0.0.0.0" },
+          "runtimes/unix/lib/netcoreapp2.0/System.IO.Pipes.dll": { "rid": "unix", "assetType": "runtime", "assemblyVersion": "4.1.1.0", "fileVersion": "4.6.27207.3" },
+          "runtimes/win/lib/netcoreapp2.0/System.IO.Pipes.dll": { "rid": "win", "assetType": "runtime", "assemblyVersion": "4.1.1.0", "fileVersion": "4.6.27207.3" },
+          "runtimes/any/unknown/readme.txt": { "rid": "any", "assetType": "documentation" }
+        }
+      },
+      "Microsoft.NETCore.Platforms/2.2.1": {},
+      "Microsoft.Win32.Registry/4.5.0": {
+        "runtime": {
+          "lib/netstandard2.0/Microsoft.Win32.Registry.dll": { "assemblyVersion": "4.1.1.0", "fileVersion": "4.6.26515.6" }
+        },
+        "runtimeTargets": {
+          "runtimes/win/lib/netstandard2.0/Microsoft.Win32.Registry.dll": { "rid": "win", "assetType": "runtime", "assemblyVersion": "4.1.1.0", "fileVersion": "4.6.26515.6" }
+        }
+      },
+      "System.Resources.Extensions/4.6.0": {
+        "runtime": {
+          "lib/netstandard2.0/System.Resources.Extensions.dll": {}
+        },
+        "resources": {
+          "lib/netstandard2.0/de/System.Resources.Extensions.resources.dll": { "locale": "de" },
+          "lib/netstandard2.0/cs/System.Resources.Extensions.resources.dll": { "locale": "cs" }
+        }
+      }
+    }
+  },
+  "libraries": {
+    "Microsoft.NETCore.App/2.2.1": {
+      "type": "project",
+      "serviceable": false,
+      "sha512": ""
+    },
+    "Microsoft.NETCore.Platforms/2.2.1": {
+      "type": "package",
+      "serviceable": true,
+      "sha512": "sha512-X6AF8n1ORrmgzUUwn3Ke==",
+      "path": "microsoft.netcore.platforms/2.2.1",
+      "hashPath": "microsoft.netcore.platforms.2.2.1.nupkg.sha512"
+    },
+    "Microsoft.Win32.Registry/4.5.0": {
+      "type": "Package",
+      "serviceable": true,
+      "sha512": "sha512-+FWlwd//+Tt56316p00hVePBCouXyEzT86Jb3+AuRotTND0IYn0OO3obs1gnQEs/txEnt+rF2JBGLItTG+Be6A==",
+      "path": "microsoft.win32.registry/4.5.0",
+      "hashPath": "microsoft.win32.registry.4.5.0.nupkg.sha512"
+    },
+    "System.Resources.Extensions/4.6.0": {
+      "type": "package",
+      "serviceable": true,
+      "sha512": "sha512-6aVCk8oTFZNT2Tl27Xy/fO==",
+      "path": "system.resources.extensions/4.6.0",
+      "hashPath": "system.resources.extensions.4.6.0.nupkg.sha512",
+      "runtimeStoreManifestName": "manifests/netcoreapp.xml"
+    },
+    "Unreferenced.Package/1.0.0": {
+      "type": "package",
+      "serviceable": false
+    }
+  }
+})json";
+
+    // An application deps file written by hand: targets listed before the
+    // runtime target, members out of order and Windows style separators.
+    const char app_deps[] = "\xEF\xBB\xBF" R"json({
+  "targets": {
+    ".NETCoreApp,Version=v2.2/linux-x64": {
+      "App/1.0.0": {
+        "runtime": { "App.dll": {} }
+      }
+    },
+    ".NETCoreApp,Version=v2.2": {
+      "Zeta.Library/2.0.0": {
+        "runtime": {
+          "lib\\netstandard2.0\\Zeta.Library.dll": { "fileVersion": "2.0.0.0", "assemblyVersion": "2.0.0.0" }
+        }
+      },
+      "App/1.0.0": {
+        "dependencies": { "Zeta.Library": "2.0.0" },
+        "runtime": { "App.dll": {} },
+        "compile": { "App.dll": {} }
+      },
+      "Alpha.Native/1.1.0": {
+        "runtimeTargets": {
+          "runtimes/linux/native/libalpha.so": { "assetType": "NATIVE", "rid": "linux" },
+          "runtimes/win/native/alpha.dll": { "assetType": "native", "rid": "win" }
+        },
+        "runtime": {
+          "lib/netstandard2.0/Alpha.dll": { "assemblyVersion": "1.1.0.0" }
+        }
+      }
+    }
+  },
+  "libraries": {
+    "Zeta.Library/2.0.0": {
+      "sha512": "sha512-zeta",
+      "type": "package",
+      "path": "zeta.library/2.0.0",
+      "serviceable": false
+    },
+    "App/1.0.0": { "serviceable": false, "sha512": "", "type": "project" },
+    "Alpha.Native/1.1.0": {
+      "type": "package",
+      "serviceable": true,
+      "sha512": "sha512-alpha",
+      "path": "alpha.native/1.1.0",
+      "hashPath": "alpha.native.1.1.0.nupkg.sha512"
+    }
+  },
+  "runtimeTarget": { "signature": "", "name": ".NETCoreApp,Version=v2.2" }
+})json";
+
+    // A self-contained application with its rid fallback graph.
+    const char self_contained_deps[] = R"json({
+  "runtimeTarget": ".NETCoreApp,Version=v2.2/linux-x64",
+  "targets": {
+    ".NETCoreApp,Version=v2.2": {},
+    ".NETCoreApp,Version=v2.2/linux-x64": {
+      "SelfContained/1.0.0": {
+        "dependencies": { "runtimepack.Microsoft.NETCore.App.Runtime.linux-x64": "2.2.1" },
+        "runtime": { "SelfContained.dll": {} }
+      },
+      "runtimepack.Microsoft.NETCore.App.Runtime.linux-x64/2.2.1": {
+        "runtime": {
+          "System.Runtime.dll": { "assemblyVersion": "4.2.1.0", "fileVersion": "4.6.27207.3" },
+          "System.Private.CoreLib.dll": { "assemblyVersion": "4.0.0.0", "fileVersion": "4.6.27207.3" }
+        },
+        "native": {
+          "libcoreclr.so": { "fileVersion": "0.0.0.0" },
+          "libhostpolicy.so": { "fileVersion": "0.0.0.0" }
+        },
+        "runtimeTargets": {
+          "runtimes/linux-x64/native/ignored.so": { "rid": "linux-x64", "assetType": "native" }
+        }
+      }
+    }
+  },
+  "libraries": {
+    "SelfContained/1.0.0": { "type": "project", "serviceable": false, "sha512": "" },
+    "runtimepack.Microsoft.NETCore.App.Runtime.linux-x64/2.2.1": { "type": "runtimepack", "serviceable": false, "sha512": "" }
+  },
+  "runtimes": {
+    "linux-x64": [ "linux", "unix-x64", "unix", "any", "base" ],
+    "win-x64": [ "win", "any", "base" ],
+    "osx-x64": [ "osx", "unix-x64", "unix", "any", "base" ]
+  }
+})json";
+
+    void expect_same_entries(const deps_json_t& expected, const deps_json_t& actual)
+    {
+        ASSERT_EQ(expected.is_valid(), actual.is_valid());
+        EXPECT_EQ(expected.exists(), actual.exists());
+        EXPECT_EQ(expected.get_rid_fallback_graph(), actual.get_rid_fallback_graph());
+
+        for (int i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            auto type = static_cast<deps_entry_t::asset_types>(i);
+            const auto& expected_entries = expected.get_entries(type);
+            const auto& actual_entries = actual.get_entries(type);
+            ASSERT_EQ(expected_entries.size(), actual_entries.size());
+
+            for (size_t j = 0; j < expected_entries.size(); ++j)
+            {
+                const deps_entry_t& e = expected_entries[j];
+                const deps_entry_t& a = actual_entries[j];
+                SCOPED_TRACE(e.asset.relative_path);
+
+                EXPECT_EQ(e.deps_file, a.deps_file);
+                EXPECT_EQ(e.library_type, a.library_type);
+                EXPECT_EQ(e.library_name, a.library_name);
+                EXPECT_EQ(e.library_version, a.library_version);
+                EXPECT_EQ(e.library_hash, a.library_hash);
+                EXPECT_EQ(e.library_path, a.library_path);
+                EXPECT_EQ(e.library_hash_path, a.library_hash_path);
+                EXPECT_EQ(e.runtime_store_manifest_list, a.runtime_store_manifest_list);
+                EXPECT_EQ(e.asset_type, a.asset_type);
+                EXPECT_EQ(e.asset.name, a.asset.name);
+                EXPECT_EQ(e.asset.relative_path, a.asset.relative_path);
+                EXPECT_EQ(e.asset.assembly_version.as_str(), a.asset.assembly_version.as_str());
+                EXPECT_EQ(e.asset.file_version.as_str(), a.asset.file_version.as_str());
+                EXPECT_EQ(e.is_serviceable, a.is_serviceable);
+                EXPECT_EQ(e.is_rid_specific, a.is_rid_specific);
+                EXPECT_EQ(expected.try_ni(e).asset.relative_path, actual.try_ni(a).asset.relative_path);
+                EXPECT_EQ(expected.has_package(e.library_name, e.library_version), actual.has_package(a.library_name, a.library_version));
+            }
+        }
+    }
+}
+
+class DepsFormatTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("deps_format_test"));
+        ASSERT_FALSE(root.empty());
+
+        // A graph which knows the host RID, so that both parsers take the same fallback path
+        deps_json_t graph_source;
+        graph_source.parse(false, write_deps(_X("graph.deps.json"), self_contained_deps));
+        ASSERT_TRUE(graph_source.is_valid());
+        graph = graph_source.get_rid_fallback_graph();
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    string_t write_deps(const string_t& name, const std::string& contents)
+    {
+        string_t path = test_utils::path_combine(root, name);
+        EXPECT_TRUE(test_utils::write_file(path, contents));
+        return path;
+    }
+
+    void parse_both_ways(const string_t& path, bool is_framework_dependent)
+    {
+        SCOPED_TRACE(is_framework_dependent ? "framework dependent" : "self-contained");
+
+        deps_json_t dom;
+        dom.set_parse_mode(deps_json_t::parse_mode_t::dom);
+        dom.parse(is_framework_dependent, path, graph);
+
+        deps_json_t stream;
+        stream.set_parse_mode(deps_json_t::parse_mode_t::stream);
+        stream.parse(is_framework_dependent, path, graph);
+
+        expect_same_entries(dom, stream);
+    }
+
+    void expect_both_invalid(const std::string& contents)
+    {
+        string_t path = write_deps(_X("invalid.deps.json"), contents);
+
+        deps_json_t dom;
+        dom.set_parse_mode(deps_json_t::parse_mode_t::dom);
+        dom.parse(true, path, graph);
+        EXPECT_FALSE(dom.is_valid());
+
+        deps_json_t stream;
+        stream.parse(true, path, graph);
+        EXPECT_FALSE(stream.is_valid());
+    }
+
+    string_t root;
+    deps_json_t::rid_fallback_graph_t graph;
+};
+
+TEST_F(DepsFormatTest, StreamMatchesDomForFrameworkDeps)
+{
+    string_t path = write_deps(_X("Microsoft.NETCore.App.deps.json"), framework_deps);
+    parse_both_ways(path, true);
+    parse_both_ways(path, false);
+
+    deps_json_t stream;
+    stream.parse(true, path, graph);
+    ASSERT_TRUE(stream.is_valid());
+    EXPECT_FALSE(stream.get_entries(deps_entry_t::asset_types::runtime).empty());
+    EXPECT_FALSE(stream.get_entries(deps_entry_t::asset_types::native).empty());
+    EXPECT_EQ(2u, stream.get_entries(deps_entry_t::asset_types::resources).size());
+}
+
+TEST_F(DepsFormatTest, StreamMatchesDomForOutOfOrderAppDeps)
+{
+    string_t path = write_deps(_X("App.deps.json"), app_deps);
+    parse_both_ways(path, true);
+    parse_both_ways(path, false);
+
+    deps_json_t stream;
+    stream.parse(true, path, graph);
+    ASSERT_TRUE(stream.is_valid());
+
+    // Libraries are visited in key order, as the DOM sorts object members.
+    const auto& runtime = stream.get_entries(deps_entry_t::asset_types::runtime);
+    ASSERT_EQ(3u, runtime.size());
+    EXPECT_EQ(_X("Alpha.Native"), runtime[0].library_name);
+    EXPECT_EQ(_X("App"), runtime[1].library_name);
+    EXPECT_EQ(_X("Zeta.Library"), runtime[2].library_name);
+    EXPECT_EQ(_X("lib/netstandard2.0/Zeta.Library.dll"), runtime[2].asset.relative_path);
+}
+
+TEST_F(DepsFormatTest, StreamMatchesDomForSelfContainedDeps)
+{
+    string_t path = write_deps(_X("SelfContained.deps.json"), self_contained_deps);
+    parse_both_ways(path, false);
+    parse_both_ways(path, true);
+
+    deps_json_t stream;
+    stream.parse(false, path);
+    ASSERT_TRUE(stream.is_valid());
+    EXPECT_EQ(3u, stream.get_rid_fallback_graph().size());
+    EXPECT_EQ(5u, stream.get_rid_fallback_graph().at(_X("linux-x64")).size());
+}
+
+TEST_F(DepsFormatTest, StreamMatchesDomForInstalledFrameworks)
+{
+    // Compare against real framework deps files when a .NET Core installation is available.
+    string_t dotnet_root;
+    if (!coreload::pal::getenv(_X("DOTNET_ROOT"), &dotnet_root))
+    {
+        return;
+    }
+
+    std::vector<string_t> frameworks;
+    string_t shared = test_utils::path_combine(dotnet_root, _X("shared"));
+    coreload::pal::readdir_onlydirectories(shared, &frameworks);
+    for (const auto& framework : frameworks)
+    {
+        std::vector<string_t> versions;
+        string_t framework_dir = test_utils::path_combine(shared, framework);
+        coreload::pal::readdir_onlydirectories(framework_dir, &versions);
+        for (const auto& version : versions)
+        {
+            string_t path = test_utils::path_combine(test_utils::path_combine(framework_dir, version), framework + _X(".deps.json"));
+            if (coreload::pal::file_exists(path))
+            {
+                SCOPED_TRACE(path);
+                parse_both_ways(path, true);
+
+                deps_json_t stream;
+                stream.parse(true, path, graph);
+                EXPECT_TRUE(stream.is_valid());
+            }
+        }
+    }
+}
+
+TEST_F(DepsFormatTest, StreamAndDomRejectTheSameErrors)
+{
+    // Referenced library without a hash
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": { "A/1.0": { "runtime": { "a.dll": {} } } } },
+        "libraries": { "A/1.0": { "type": "package", "serviceable": false } } })");
+
+    // Runtime target which is not in the targets
+    expect_both_invalid(R"({ "runtimeTarget": "missing", "targets": { "t": {} }, "libraries": {} })");
+
+    // No libraries
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": {} } })");
+
+    // Asset properties of the wrong type
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": { "A/1.0": { "runtime": { "a.dll": { "fileVersion": 1 } } } } },
+        "libraries": { "A/1.0": { "type": "package", "serviceable": false, "sha512": "" } } })");
+
+    // Runtime target without an asset type
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": { "A/1.0": { "runtimeTargets": { "a.dll": { "rid": "win" } } } } },
+        "libraries": {} })");
+
+    // Malformed JSON
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": {} }, "libraries": { } )");
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": {} }, "libraries": { }, })");
+    expect_both_invalid(R"({ "runtimeTarget": "t", "targets": { "t": {} }, "libraries": { } } [])");
+}
+
+TEST_F(DepsFormatTest, UnreferencedLibrariesAreNotValidated)
+{
+    string_t path = write_deps(_X("unreferenced.deps.json"), R"({ "runtimeTarget": "t",
+        "targets": { "t": { "A/1.0": { "runtime": { "a.dll": {} } } } },
+        "libraries": { "A/1.0": { "type": "package", "serviceable": false, "sha512": "" }, "B/1.0": 42 } })");
+
+    parse_both_ways(path, true);
+
+    deps_json_t stream;
+    stream.parse(true, path, graph);
+    EXPECT_TRUE(stream.is_valid());
+}
+
+class DepsImageTest : public DepsFormatTest
+{
+protected:
+    void SetUp() override
+    {
+        DepsFormatTest::SetUp();
+        cache_dir = test_utils::path_combine(root, _X("cache"));
+        ASSERT_TRUE(test_utils::make_directory(cache_dir));
+    }
+
+    // Loads a deps file with the cache enabled and checks it against the DOM parser.
+    void load_and_compare(const string_t& path, bool is_framework_dependent, deps_json_t* loaded)
+    {
+        test_utils::env_scope cache(_X("COREHOST_DEPS_CACHE"), cache_dir);
+        loaded->parse(is_framework_dependent, path, graph);
+        ASSERT_TRUE(loaded->is_valid());
+
+        deps_json_t dom;
+        dom.set_parse_mode(deps_json_t::parse_mode_t::dom);
+        dom.parse(is_framework_dependent, path, graph);
+        expect_same_entries(dom, *loaded);
+    }
+
+    string_t get_cache_path(const string_t& path)
+    {
+        test_utils::env_scope cache(_X("COREHOST_DEPS_CACHE"), cache_dir);
+        return coreload::deps_image::get_cache_path(path);
+    }
+
+    string_t cache_dir;
+};
+
+TEST_F(DepsImageTest, CachedImageMatchesJson)
+{
+    string_t path = write_deps(_X("Microsoft.NETCore.App.deps.json"), framework_deps);
+    string_t self_contained_path = write_deps(_X("SelfContained.deps.json"), self_contained_deps);
+
+    for (bool is_framework_dependent : { true, false })
+    {
+        SCOPED_TRACE(is_framework_dependent ? "framework dependent" : "self-contained");
+        for (const auto& deps_path : { path, self_contained_path })
+        {
+            // The first load writes the image, the second one reads it.
+            deps_json_t from_json;
+            load_and_compare(deps_path, is_framework_dependent, &from_json);
+            ASSERT_TRUE(coreload::pal::file_exists(get_cache_path(deps_path)));
+
+            deps_json_t from_image;
+            load_and_compare(deps_path, is_framework_dependent, &from_image);
+            expect_same_entries(from_json, from_image);
+        }
+    }
+}
+
+TEST_F(DepsImageTest, SiblingImageMatchesJson)
+{
+    string_t path = write_deps(_X("App.deps.json"), app_deps);
+
+    deps_json_t from_json;
+    from_json.parse(true, path, graph);
+    ASSERT_TRUE(from_json.is_valid());
+    ASSERT_TRUE(from_json.save_image(test_utils::path_combine(root, _X("App.deps.bin"))));
+
+    deps_json_t from_image;
+    from_image.parse(true, path, graph);
+    ASSERT_TRUE(from_image.is_valid());
+    expect_same_entries(from_json, from_image);
+}
+
+TEST_F(DepsImageTest, StaleImageIsIgnored)
+{
+    string_t path = write_deps(_X("App.deps.json"), app_deps);
+
+    deps_json_t first;
+    load_and_compare(path, true, &first);
+
+    // Same size, different contents
+    std::string changed = app_deps;
+    size_t pos = changed.find("Zeta.Library.dll");
+    ASSERT_NE(std::string::npos, pos);
+    changed[pos] = 'Y';
+    write_deps(_X("App.deps.json"), changed);
+
+    deps_json_t second;
+    load_and_compare(path, true, &second);
+    const auto& runtime = second.get_entries(deps_entry_t::asset_types::runtime);
+    ASSERT_EQ(3u, runtime.size());
+    EXPECT_EQ(_X("lib/netstandard2.0/Yeta.Library.dll"), runtime[2].asset.relative_path);
+}
+
+TEST_F(DepsImageTest, ImageForAnotherGraphIsIgnored)
+{
+    string_t path = write_deps(_X("Microsoft.NETCore.App.deps.json"), framework_deps);
+
+    deps_json_t first;
+    load_and_compare(path, true, &first);
+
+    // Without the host rid in the graph, rid specific assets fall back differently.
+    graph.clear();
+    deps_json_t second;
+    load_and_compare(path, true, &second);
+}
+
+TEST_F(DepsImageTest, CorruptImageIsIgnored)
+{
+    string_t path = write_deps(_X("App.deps.json"), app_deps);
+
+    deps_json_t first;
+    load_and_compare(path, true, &first);
+
+    string_t image_path = get_cache_path(path);
+    std::string image = test_utils::read_file(image_path);
+    ASSERT_GT(image.size(), sizeof(coreload::deps_image::header_t));
+
+    // Truncated
+    ASSERT_TRUE(test_utils::write_file(image_path, image.substr(0, image.size() / 2)));
+    deps_json_t truncated;
+    load_and_compare(path, true, &truncated);
+
+    // String references out of bounds, the header is intact
+    for (size_t i = sizeof(coreload::deps_image::header_t); i < image.size(); ++i)
+    {
+        image[i] = static_cast<char>(0xFF);
+    }
+    ASSERT_TRUE(test_utils::write_file(image_path, image));
+    deps_json_t corrupt;
+    load_and_compare(path, true, &corrupt);
+}
+
+#if !defined(_WIN32)
+TEST_F(DepsImageTest, ImageIsUsedWhenOnlyTheWriteTimeChanged)
+{
+    string_t path = write_deps(_X("App.deps.json"), app_deps);
+
+    deps_json_t first;
+    load_and_compare(path, true, &first);
+
+    struct stat original;
+    ASSERT_EQ(0, ::stat(path.c_str(), &original));
+
+    // Rewrite the same contents with an older write time: the image is still valid.
+    // Images of recently written deps files always check the contents, so go back.
+    ASSERT_TRUE(test_utils::write_file(path, app_deps));
+    struct timespec times[2] = { original.st_atim, original.st_mtim };
+    times[1].tv_sec -= 10;
+    ASSERT_EQ(0, ::utimensat(AT_FDCWD, path.c_str(), times, 0));
+
+    deps_json_t second;
+    load_and_compare(path, true, &second);
+
+    // Change the contents but keep the size and write time: only the image can
+    // account for the old contents, which shows it was used.
+    std::string changed = app_deps;
+    changed[changed.find("Zeta.Library.dll")] = 'Y';
+    ASSERT_TRUE(test_utils::write_file(path, changed));
+    ASSERT_EQ(0, ::utimensat(AT_FDCWD, path.c_str(), times, 0));
+
+    test_utils::env_scope cache(_X("COREHOST_DEPS_CACHE"), cache_dir);
+    deps_json_t third;
+    third.parse(true, path, graph);
+    ASSERT_TRUE(third.is_valid());
+    EXPECT_EQ(_X("lib/netstandard2.0/Zeta.Library.dll"), third.get_entries(deps_entry_t::asset_types::runtime)[2].asset.relative_path);
+}
+#endif
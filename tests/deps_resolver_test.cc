@@ -0,0 +1,412 @@
+#include "pch.h"
+#include "deps_resolver.h"
+#include "probe_index.h"
+#include "thread_pool.h"
+#include "test_utils.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+using coreload::deps_resolver_t;
+using coreload::fx_definition_t;
+using coreload::probe_index_t;
+using coreload::thread_pool_t;
+using coreload::pal::string_t;
+
+namespace
+{
+    std::atomic<int> g_errors_written(0);
+
+    void count_errors(const coreload::pal::char_t* message)
+    {
+        g_errors_written++;
+    }
+
+    // A pool which can only create 'limit' workers, as in a process out of threads
+    class limited_thread_pool_t : public thread_pool_t
+    {
+    public:
+        limited_thread_pool_t(size_t thread_count, size_t limit)
+            : thread_pool_t(thread_count)
+            , started(0)
+            , m_limit(limit)
+        {
+        }
+
+        size_t started;
+
+    protected:
+        std::thread start_worker(std::function<void()> work) override
+        {
+            if (started == m_limit)
+            {
+                throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again));
+            }
+            started++;
+            return thread_pool_t::start_worker(std::move(work));
+        }
+
+    private:
+        size_t m_limit;
+    };
+
+    std::string make_app_deps(const std::string& name)
+    {
+        return "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\" },\n"
+            "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+            "      \"" + name + "/1.0.0\": { \"runtime\": { \"" + name + ".dll\": {} } }\n    }\n  },\n"
+            "  \"libraries\": {\n    \"" + name + "/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" }\n  }\n}\n";
+    }
+}
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce)
+{
+    thread_pool_t pool(4);
+    std::vector<std::atomic<int>> runs(100);
+    std::vector<thread_pool_t::task_t> tasks;
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        runs[i] = 0;
+        tasks.push_back([&runs, i]() { runs[i]++; });
+    }
+
+    // A pool runs any number of batches.
+    pool.run(tasks);
+    pool.run(tasks);
+
+    for (const auto& count : runs)
+    {
+        EXPECT_EQ(2, count.load());
+    }
+}
+
+TEST(ThreadPoolTest, SingleThreadRunsOnTheCaller)
+{
+    thread_pool_t pool(1);
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> elsewhere(0);
+    std::vector<thread_pool_t::task_t> tasks(10, [&]() { if (std::this_thread::get_id() != caller) elsewhere++; });
+    pool.run(tasks);
+    EXPECT_EQ(0, elsewhere.load());
+}
+
+TEST(ThreadPoolTest, IdleThreadsStealQueuedTasks)
+{
+    // The first task is in the calling thread's share and only completes once every
+    // other task did, which takes the second thread stealing the rest of that share.
+    thread_pool_t pool(2);
+    std::atomic<int> completed(0);
+    bool others_completed = false;
+    pool.run(10, [&](size_t i)
+    {
+        if (i == 0)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (completed.load() < 9 && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            others_completed = completed.load() == 9;
+        }
+        completed++;
+    });
+    EXPECT_TRUE(others_completed);
+    EXPECT_EQ(10, completed.load());
+}
+
+TEST(ThreadPoolTest, RethrowsAfterTheOtherTasksCompleted)
+{
+    thread_pool_t pool(3);
+    std::atomic<int> completed(0);
+    std::vector<thread_pool_t::task_t> tasks(20, [&]() { completed++; });
+    tasks[5] = []() { throw std::runtime_error("task failed"); };
+
+    EXPECT_THROW(pool.run(tasks), std::runtime_error);
+    EXPECT_EQ(19, completed.load());
+
+    // A failed batch does not affect the next one.
+    tasks[5] = [&]() { completed++; };
+    pool.run(tasks);
+    EXPECT_EQ(39, completed.load());
+}
+
+TEST(ThreadPoolTest, WorkersUseTheCallersErrorWriter)
+{
+    thread_pool_t pool(4);
+    g_errors_written = 0;
+    auto previous = coreload::trace::set_error_writer(count_errors);
+
+    std::vector<thread_pool_t::task_t> tasks(16, []() { coreload::trace::error(_X("Error from a task")); });
+    pool.run(tasks);
+
+    coreload::trace::set_error_writer(previous);
+    EXPECT_EQ(16, g_errors_written.load());
+}
+
+TEST(ThreadPoolTest, RunsOnTheThreadsItCouldCreate)
+{
+    for (size_t limit : { 0, 1, 2 })
+    {
+        limited_thread_pool_t pool(4, limit);
+        std::vector<std::atomic<int>> runs(50);
+        for (auto& count : runs)
+        {
+            count = 0;
+        }
+
+        pool.run(runs.size(), [&runs](size_t i) { runs[i]++; });
+
+        EXPECT_EQ(limit, pool.started);
+        for (const auto& count : runs)
+        {
+            EXPECT_EQ(1, count.load());
+        }
+    }
+}
+
+TEST(ThreadPoolTest, ThreadCountIsReadFromTheEnvironment)
+{
+    test_utils::env_scope env(_X("COREHOST_THREADS"), _X("3"));
+    EXPECT_EQ(3u, thread_pool_t::default_thread_count());
+    EXPECT_EQ(3u, thread_pool_t().get_thread_count());
+}
+
+TEST(ProbeIndexTest, KeepsThePackageDirectoryOfEachEntry)
+{
+    // The app's deps file places the package under a path of its own, an additional
+    // deps file lists the same asset without one.
+    string_t root = test_utils::make_temp_directory(_X("probe_index_test"));
+    ASSERT_FALSE(root.empty());
+    string_t first_probe = test_utils::path_combine(root, _X("probe1"));
+    string_t second_probe = test_utils::path_combine(root, _X("probe2"));
+    ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(first_probe, _X("packages/contoso.probed/2.0.0/lib/Contoso.Probed.dll")), "placed"));
+    ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(second_probe, _X("Contoso.Probed/2.0.0/lib/Contoso.Probed.dll")), "default"));
+
+    coreload::deps_entry_t placed;
+    placed.library_type = _X("package");
+    placed.library_name = _X("Contoso.Probed");
+    placed.library_version = _X("2.0.0");
+    placed.library_path = _X("packages/contoso.probed/2.0.0");
+    placed.asset_type = coreload::deps_entry_t::asset_types::runtime;
+    placed.asset = coreload::deps_asset_t(_X("Contoso.Probed"), _X("lib/Contoso.Probed.dll"), coreload::version_t(), coreload::version_t());
+    placed.is_serviceable = false;
+    placed.is_rid_specific = false;
+    coreload::deps_entry_t unplaced = placed;
+    unplaced.library_path.clear();
+
+    std::vector<coreload::probe_config_t> probes = { coreload::probe_config_t::lookup(first_probe), coreload::probe_config_t::lookup(second_probe) };
+    thread_pool_t pool(1);
+    probe_index_t index;
+    index.build(probes, { &placed, &unplaced }, &pool);
+
+    const probe_index_t::matches_t* matches = nullptr;
+    ASSERT_TRUE(index.find(placed, &matches));
+    ASSERT_EQ(1u, matches->size());
+    EXPECT_EQ(0u, (*matches)[0].first);
+
+    ASSERT_TRUE(index.find(unplaced, &matches));
+    ASSERT_EQ(1u, matches->size());
+    EXPECT_EQ(1u, (*matches)[0].first);
+    EXPECT_EQ(test_utils::path_combine(second_probe, _X("Contoso.Probed/2.0.0/lib/Contoso.Probed.dll")), (*matches)[0].second);
+
+    test_utils::remove_directory_tree(root);
+}
+
+// An app on three shared frameworks with an additional deps file, shaped like an
+// ASP.NET Core app on an internal framework.
+class DepsResolverTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("deps_resolver_test"));
+        ASSERT_FALSE(root.empty());
+
+        string_t shared = test_utils::path_combine(root, _X("dotnet/shared"));
+        netcore_dir = test_utils::path_combine(shared, _X("Microsoft.NETCore.App/3.1.0"));
+        aspnetcore_dir = test_utils::path_combine(shared, _X("Microsoft.AspNetCore.App/3.1.0"));
+        internal_dir = test_utils::path_combine(shared, _X("Contoso.Internal.App/3.1.0"));
+        ASSERT_TRUE(test_utils::write_framework(netcore_dir, "Microsoft.NETCore.App", "3.1.0", 40, true));
+        ASSERT_TRUE(test_utils::write_framework(aspnetcore_dir, "Microsoft.AspNetCore.App", "3.1.0", 20, false));
+        ASSERT_TRUE(test_utils::write_framework(internal_dir, "Contoso.Internal.App", "3.1.0", 10, false));
+
+        app_dir = test_utils::path_combine(root, _X("app"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.deps.json")), make_app_deps("app")));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.dll")), "app"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("Contoso.Plugin.dll")), "plugin"));
+
+        additional_deps = test_utils::path_combine(root, _X("additional/Contoso.Plugin.deps.json"));
+        ASSERT_TRUE(test_utils::write_file(additional_deps, make_app_deps("Contoso.Plugin")));
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    // Adds app local copies of framework assemblies to the app's deps file: one newer
+    // and one older than the framework's.
+    void add_app_local_copies()
+    {
+        std::string json = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\" },\n"
+            "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+            "      \"app/1.0.0\": { \"runtime\": { \"app.dll\": {} } },\n"
+            "      \"Microsoft.AspNetCore.App.Library0/3.1.1\": { \"runtime\": { \"lib/netcoreapp3.1/Microsoft.AspNetCore.App.Library0.dll\": { \"assemblyVersion\": \"3.1.1.0\", \"fileVersion\": \"3.1.1.0\" } } },\n"
+            "      \"Microsoft.NETCore.App.Library1/3.0.0\": { \"runtime\": { \"lib/netcoreapp3.0/Microsoft.NETCore.App.Library1.dll\": { \"assemblyVersion\": \"3.0.0.0\", \"fileVersion\": \"3.0.0.0\" } } }\n"
+            "    }\n  },\n"
+            "  \"libraries\": {\n"
+            "    \"app/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" },\n"
+            "    \"Microsoft.AspNetCore.App.Library0/3.1.1\": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\" },\n"
+            "    \"Microsoft.NETCore.App.Library1/3.0.0\": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\" }\n"
+            "  }\n}\n";
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.deps.json")), json));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("Microsoft.AspNetCore.App.Library0.dll")), "newer"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("Microsoft.NETCore.App.Library1.dll")), "older"));
+    }
+
+    // Adds packages to the app's deps file which are not in the app directory but in
+    // package layout probes: a serviceable one and one which is not.
+    void add_probed_packages()
+    {
+        std::string json = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\" },\n"
+            "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+            "      \"app/1.0.0\": { \"runtime\": { \"app.dll\": {} } },\n"
+            "      \"Contoso.Serviced/1.0.0\": { \"runtime\": { \"lib/netstandard2.0/Contoso.Serviced.dll\": {} } },\n"
+            "      \"Contoso.Probed/2.0.0\": { \"runtime\": { \"lib/netstandard2.0/Contoso.Probed.dll\": {} } }\n"
+            "    }\n  },\n"
+            "  \"libraries\": {\n"
+            "    \"app/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" },\n"
+            "    \"Contoso.Serviced/1.0.0\": { \"type\": \"package\", \"serviceable\": true, \"sha512\": \"\", \"path\": \"contoso.serviced/1.0.0\" },\n"
+            "    \"Contoso.Probed/2.0.0\": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\", \"path\": \"contoso.probed/2.0.0\" }\n"
+            "  }\n}\n";
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.deps.json")), json));
+
+        // Servicing has both packages; the first probe directory only the one which is
+        // not serviceable, the second one both.
+        core_servicing = test_utils::path_combine(root, _X("servicing"));
+        probe_paths = { test_utils::path_combine(root, _X("probe1")), test_utils::path_combine(root, _X("probe2")) };
+        for (const auto& dir : { test_utils::path_combine(core_servicing, _X("pkgs")), probe_paths[1] })
+        {
+            ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(dir, _X("contoso.serviced/1.0.0/lib/netstandard2.0/Contoso.Serviced.dll")), "serviced"));
+        }
+        for (const auto& dir : { test_utils::path_combine(core_servicing, _X("pkgs")), probe_paths[0], probe_paths[1] })
+        {
+            ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(dir, _X("contoso.probed/2.0.0/lib/netstandard2.0/Contoso.Probed.dll")), "probed"));
+        }
+    }
+
+    // Resolves the app with the given number of threads, also returning how many
+    // native assets each framework selected.
+    void resolve(const string_t& threads, coreload::probe_paths_t* resolved, std::vector<size_t>* native_assets)
+    {
+        test_utils::env_scope env(_X("COREHOST_THREADS"), threads);
+
+        coreload::hostpolicy_init_t init;
+        init.is_framework_dependent = true;
+        init.additional_deps_serialized = additional_deps;
+        init.fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t()));
+        init.fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t(_X("Contoso.Internal.App"), internal_dir, _X("3.1.0"), _X("3.1.0"))));
+        init.fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t(_X("Microsoft.AspNetCore.App"), aspnetcore_dir, _X("3.1.0"), _X("3.1.0"))));
+        init.fx_definitions.push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t(_X("Microsoft.NETCore.App"), netcore_dir, _X("3.1.0"), _X("3.1.0"))));
+
+        coreload::arguments_t args;
+        args.app_root = app_dir;
+        args.deps_path = test_utils::path_combine(app_dir, _X("app.deps.json"));
+        args.managed_application = test_utils::path_combine(app_dir, _X("app.dll"));
+        args.probe_paths = probe_paths;
+        args.core_servicing = core_servicing;
+
+        deps_resolver_t resolver(init, args);
+        string_t errors;
+        ASSERT_TRUE(resolver.valid(&errors)) << errors;
+        ASSERT_TRUE(resolver.resolve_probe_paths(resolved, nullptr));
+
+        for (const auto& fx : resolver.get_fx_definitions())
+        {
+            native_assets->push_back(fx->get_deps().get_entries(coreload::deps_entry_t::asset_types::native).size());
+        }
+    }
+
+    string_t root;
+    string_t netcore_dir;
+    string_t aspnetcore_dir;
+    string_t internal_dir;
+    string_t app_dir;
+    string_t additional_deps;
+    std::vector<string_t> probe_paths;
+    string_t core_servicing;
+};
+
+TEST_F(DepsResolverTest, ConcurrentParsingMatchesSerialParsing)
+{
+    coreload::probe_paths_t serial;
+    std::vector<size_t> serial_native;
+    resolve(_X("1"), &serial, &serial_native);
+
+    coreload::probe_paths_t concurrent;
+    std::vector<size_t> concurrent_native;
+    resolve(_X("4"), &concurrent, &concurrent_native);
+
+    EXPECT_EQ(serial.tpa, concurrent.tpa);
+    EXPECT_EQ(serial.native, concurrent.native);
+    EXPECT_EQ(serial.resources, concurrent.resources);
+
+    // Every framework, the app and the additional deps file contributed
+    for (const auto* assembly : { _X("app.dll"), _X("Contoso.Plugin.dll"), _X("Microsoft.NETCore.App.Library39.dll"),
+        _X("Microsoft.AspNetCore.App.Library19.dll"), _X("Contoso.Internal.App.Library9.dll") })
+    {
+        EXPECT_NE(string_t::npos, concurrent.tpa.find(assembly)) << assembly;
+    }
+
+    // One of the two rid specific native assets of each package was selected with
+    // the root framework's graph.
+    EXPECT_EQ(serial_native, concurrent_native);
+    EXPECT_EQ((std::vector<size_t>{ 0, 10, 20, 40 }), concurrent_native);
+}
+
+TEST_F(DepsResolverTest, ConcurrentProbingKeepsVersionPrecedence)
+{
+    add_app_local_copies();
+
+    coreload::probe_paths_t serial;
+    std::vector<size_t> serial_native;
+    resolve(_X("1"), &serial, &serial_native);
+
+    coreload::probe_paths_t concurrent;
+    std::vector<size_t> concurrent_native;
+    resolve(_X("4"), &concurrent, &concurrent_native);
+
+    EXPECT_EQ(serial.tpa, concurrent.tpa);
+
+    // The newer copy in the app wins over the framework's, the older one loses to it.
+    string_t newer = test_utils::path_combine(app_dir, _X("Microsoft.AspNetCore.App.Library0.dll"));
+    string_t older = test_utils::path_combine(netcore_dir, _X("Microsoft.NETCore.App.Library1.dll"));
+    EXPECT_NE(string_t::npos, concurrent.tpa.find(newer + PATH_SEPARATOR));
+    EXPECT_EQ(string_t::npos, concurrent.tpa.find(test_utils::path_combine(aspnetcore_dir, _X("Microsoft.AspNetCore.App.Library0.dll"))));
+    EXPECT_NE(string_t::npos, concurrent.tpa.find(older + PATH_SEPARATOR));
+    EXPECT_EQ(string_t::npos, concurrent.tpa.find(test_utils::path_combine(app_dir, _X("Microsoft.NETCore.App.Library1.dll"))));
+}
+
+TEST_F(DepsResolverTest, PackageLayoutProbesKeepTheirOrderAndFilters)
+{
+    add_probed_packages();
+
+    coreload::probe_paths_t serial;
+    std::vector<size_t> serial_native;
+    resolve(_X("1"), &serial, &serial_native);
+
+    coreload::probe_paths_t concurrent;
+    std::vector<size_t> concurrent_native;
+    resolve(_X("4"), &concurrent, &concurrent_native);
+
+    EXPECT_EQ(serial.tpa, concurrent.tpa);
+
+    // Servicing comes first but only serves serviceable packages, then the probe
+    // directories are used in order.
+    string_t serviced = test_utils::path_combine(core_servicing, _X("pkgs/contoso.serviced/1.0.0/lib/netstandard2.0/Contoso.Serviced.dll"));
+    string_t probed = test_utils::path_combine(probe_paths[0], _X("contoso.probed/2.0.0/lib/netstandard2.0/Contoso.Probed.dll"));
+    EXPECT_NE(string_t::npos, concurrent.tpa.find(serviced + PATH_SEPARATOR)) << concurrent.tpa;
+    EXPECT_NE(string_t::npos, concurrent.tpa.find(probed + PATH_SEPARATOR)) << concurrent.tpa;
+}
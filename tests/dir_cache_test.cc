@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "dir_cache.h"
+#include "test_utils.h"
+
+using coreload::dir_cache_t;
+using coreload::dir_cache_scope_t;
+using coreload::pal::string_t;
+
+class DirCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("dir_cache_test"));
+        ASSERT_FALSE(root.empty());
+
+        lib_dir = test_utils::path_combine(root, _X("lib"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(lib_dir, _X("a.dll")), "a"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(lib_dir, _X("b.dll")), "b"));
+        ASSERT_TRUE(test_utils::make_directories(test_utils::path_combine(lib_dir, _X("en"))));
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    string_t root;
+    string_t lib_dir;
+};
+
+TEST_F(DirCacheTest, AnswersExistenceQueriesFromOneListing)
+{
+    dir_cache_t cache;
+    bool exists = false;
+
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(lib_dir, _X("a.dll")), &exists));
+    EXPECT_TRUE(exists);
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(lib_dir, _X("b.dll")), &exists));
+    EXPECT_TRUE(exists);
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(lib_dir, _X("en")), &exists));
+    EXPECT_TRUE(exists);
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(lib_dir, _X("missing.dll")), &exists));
+    EXPECT_FALSE(exists);
+
+    auto stats = cache.get_stats();
+    EXPECT_EQ(4u, stats.queries);
+    EXPECT_EQ(1u, stats.directories_read);
+    EXPECT_EQ(3u, stats.syscalls_saved());
+}
+
+TEST_F(DirCacheTest, CachesMissingDirectories)
+{
+    dir_cache_t cache;
+    bool exists = true;
+    string_t missing_dir = test_utils::path_combine(root, _X("missing"));
+
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(missing_dir, _X("a.dll")), &exists));
+    EXPECT_FALSE(exists);
+    ASSERT_TRUE(cache.try_file_exists(test_utils::path_combine(missing_dir, _X("b.dll")), &exists));
+    EXPECT_FALSE(exists);
+
+    EXPECT_EQ(1u, cache.get_stats().directories_read);
+}
+
+TEST_F(DirCacheTest, DeclinesPathsItCannotResolveLexically)
+{
+    dir_cache_t cache;
+    bool exists = false;
+
+    EXPECT_FALSE(cache.try_file_exists(_X("relative.dll"), &exists));
+    EXPECT_FALSE(cache.try_file_exists(test_utils::path_combine(lib_dir, _X("..")), &exists));
+    EXPECT_FALSE(cache.try_file_exists(lib_dir + DIR_SEPARATOR, &exists));
+    EXPECT_EQ(0u, cache.get_stats().queries);
+}
+
+TEST_F(DirCacheTest, ScopeRoutesPalFileExists)
+{
+    string_t a_dll = test_utils::path_combine(lib_dir, _X("a.dll"));
+    string_t c_dll = test_utils::path_combine(lib_dir, _X("c.dll"));
+
+    dir_cache_t cache;
+    {
+        dir_cache_scope_t scope(&cache);
+        EXPECT_EQ(&cache, dir_cache_t::active());
+        EXPECT_TRUE(coreload::pal::file_exists(a_dll));
+        EXPECT_TRUE(coreload::pal::directory_exists(lib_dir));
+
+        // The snapshot does not see files created while it is active.
+        ASSERT_TRUE(test_utils::write_file(c_dll, "c"));
+        EXPECT_FALSE(coreload::pal::file_exists(c_dll));
+    }
+
+    EXPECT_EQ(nullptr, dir_cache_t::active());
+    EXPECT_TRUE(coreload::pal::file_exists(c_dll));
+    EXPECT_EQ(3u, cache.get_stats().queries);
+}
+
+TEST_F(DirCacheTest, RealpathMatchesPalRealpath)
+{
+    dir_cache_t cache;
+
+    string_t a_dll = test_utils::path_combine(lib_dir, _X("a.dll"));
+    string_t expected = a_dll;
+    ASSERT_TRUE(coreload::pal::realpath(&expected));
+
+    string_t actual = a_dll;
+    ASSERT_TRUE(cache.realpath(&actual));
+    EXPECT_EQ(expected, actual);
+
+    string_t missing = test_utils::path_combine(lib_dir, _X("missing.dll"));
+    EXPECT_FALSE(cache.realpath(&missing));
+
+    // Siblings reuse the canonical parent directory.
+    auto before = cache.get_stats();
+    string_t b_dll = test_utils::path_combine(lib_dir, _X("b.dll"));
+    ASSERT_TRUE(cache.realpath(&b_dll));
+    auto after = cache.get_stats();
+    EXPECT_EQ(before.realpath_calls, after.realpath_calls);
+    EXPECT_EQ(before.directories_read, after.directories_read);
+}
+
+#if !defined(_WIN32)
+TEST_F(DirCacheTest, RealpathResolvesSymlinks)
+{
+    string_t link_dir = test_utils::path_combine(root, _X("link"));
+    ASSERT_EQ(0, ::symlink(lib_dir.c_str(), link_dir.c_str()));
+
+    string_t a_link = test_utils::path_combine(link_dir, _X("a.dll"));
+    ASSERT_EQ(0, ::symlink(test_utils::path_combine(lib_dir, _X("b.dll")).c_str(), test_utils::path_combine(lib_dir, _X("b_link.dll")).c_str()));
+
+    dir_cache_t cache;
+
+    string_t via_dir_link = a_link;
+    ASSERT_TRUE(cache.realpath(&via_dir_link));
+    EXPECT_EQ(test_utils::path_combine(lib_dir, _X("a.dll")), via_dir_link);
+
+    string_t via_file_link = test_utils::path_combine(lib_dir, _X("b_link.dll"));
+    ASSERT_TRUE(cache.realpath(&via_file_link));
+    EXPECT_EQ(test_utils::path_combine(lib_dir, _X("b.dll")), via_file_link);
+
+    string_t dir_with_separator = link_dir + DIR_SEPARATOR;
+    ASSERT_TRUE(cache.realpath(&dir_with_separator));
+    EXPECT_EQ(lib_dir, dir_with_separator);
+}
+#endif
@@ -0,0 +1,256 @@
+#include "pch.h"
+#include <algorithm>
+#include "cpprest/json.h"
+#include "cpprest/details/json_scan.h"
+#include <sstream>
+
+namespace
+{
+    web::json::value parse_stream(const std::string& text)
+    {
+        std::istringstream input(text);
+#if defined(_WIN32)
+        return web::json::value::parse(static_cast<std::istream&>(input));
+#else
+        return web::json::value::parse(input);
+#endif
+    }
+
+    web::json::value parse_buffer(const std::string& text)
+    {
+        return web::json::value::parse(text.data(), text.data() + text.size());
+    }
+
+    std::string parse_error(web::json::value (*parse)(const std::string&), const std::string& text)
+    {
+        try
+        {
+            parse(text);
+        }
+        catch (const web::json::json_exception& e)
+        {
+            return e.what();
+        }
+        return std::string();
+    }
+}
+
+TEST(JsonBufferParserTest, MatchesStreamParser)
+{
+    const char* documents[] = {
+        R"({ "a": "plain", "b": "esc\"aped\\ \/ \b\f\n\r\t \u00e9\u4e2d", "c": "" })",
+        "{\"utf8\": \"\xC3\xA9t\xC3\xA9\", \"nested\": [ [], {}, [ { \"x\": null } ] ]}",
+        R"([0, -0, 1, -1, 42, 18446744073709551615, 18446744073709551616, -9223372036854775808, -9223372036854775809])",
+        R"([1.5, -2.25e3, 1E-2, 0.0, 123456789012345678901234567890])",
+        "\t\r\n { \"ws\" \n:\r\n true , \"f\":false\f}\n\v ",
+        R"({ /* block */ "c": 1 // line
+           })",
+    };
+
+    for (const char* document : documents)
+    {
+        SCOPED_TRACE(document);
+        EXPECT_EQ(parse_stream(document).serialize(), parse_buffer(document).serialize());
+    }
+}
+
+TEST(JsonBufferParserTest, ReportsTheSameErrors)
+{
+    const char* documents[] = {
+        "{ \"a\": \"unterminated }",
+        "{ \"a\": \"control\x01\" }",
+        "[ 00 ]",
+        "[ -a ]",
+        "[ 1. ]",
+        "[ 1e ]",
+        "[ -",
+        "{ \"a\": 1,\n  \"b\": tru }",
+        "{ } trailing",
+    };
+
+    for (const char* document : documents)
+    {
+        SCOPED_TRACE(document);
+        std::string expected = parse_error(parse_stream, document);
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(expected, parse_error(parse_buffer, document));
+    }
+
+    // Like the string parser, and unlike the stream parser, invalid escapes are rejected.
+    EXPECT_FALSE(parse_error(parse_buffer, "{ \"a\": \"bad \\x escape\" }").empty());
+    EXPECT_FALSE(parse_error(parse_buffer, "").empty());
+}
+
+TEST(JsonDocumentTest, MatchesValue)
+{
+    const char* documents[] = {
+        R"({ "b": [ 1, 2.5, "three", { "four": null } ], "a": { "nested": { "deeper": [ [], {} ] } }, "c": true })",
+        R"([ "a long string which does not fit in the small string buffer", -1, false ])",
+        "\"plain\"",
+    };
+
+    for (const char* document : documents)
+    {
+        SCOPED_TRACE(document);
+        auto parsed = web::json::document::parse(document, document + strlen(document));
+        EXPECT_EQ(parse_buffer(document).serialize(), parsed.root().serialize());
+    }
+}
+
+TEST(JsonDocumentTest, AllocatesValuesFromItsArena)
+{
+    std::string text = "{ \"items\": [";
+    for (int i = 0; i < 1000; ++i)
+    {
+        text += (i == 0 ? "" : ", ");
+        text += "{ \"name\": \"item" + std::to_string(i) + "\", \"value\": " + std::to_string(i) + " }";
+    }
+    text += "] }";
+
+    auto document = web::json::document::parse(text.data(), text.data() + text.size());
+    auto stats = document.get_memory_stats();
+    EXPECT_GT(stats.allocations, 3000u);
+    EXPECT_GT(stats.bytes_allocated, 0u);
+    EXPECT_GE(stats.bytes_reserved, stats.bytes_allocated);
+    EXPECT_GE(stats.peak_bytes_reserved, stats.bytes_reserved);
+
+    // Values copied out of the document own their memory.
+    web::json::value copy = document.root().at(_XPLATSTR("items")).at(999);
+    web::json::document moved = std::move(document);
+    moved = web::json::document::parse("[]", "[]" + 2);
+    EXPECT_EQ(999, copy.at(_XPLATSTR("value")).as_integer());
+    EXPECT_EQ(_XPLATSTR("item999"), copy.at(_XPLATSTR("name")).as_string());
+}
+
+TEST(JsonDocumentTest, ReportsErrors)
+{
+    const char text[] = "{ \"a\": [ 1, 2 }";
+    EXPECT_THROW(web::json::document::parse(text, text + sizeof(text) - 1), web::json::json_exception);
+}
+
+TEST(JsonScanTest, InstructionSetsAgreeWithScalar)
+{
+    using web::json::details::scan_isa;
+
+    scan_isa previous = web::json::details::get_scan_isa();
+    scan_isa isas[] = { scan_isa::scalar, scan_isa::sse2, scan_isa::avx2 };
+    const char specials[] = { '"', '\\', '\x01', '\x1F', 'x' };
+
+    // Place one stop character at every offset of buffers spanning several blocks.
+    for (size_t length = 0; length <= 80; ++length)
+    {
+        for (size_t offset = 0; offset <= length; ++offset)
+        {
+            for (char special : specials)
+            {
+                std::string text(length, 'a');
+                std::string space(length, ' ');
+                for (size_t i = 0; i < length; i += 7)
+                {
+                    text[i] = '\xC3';
+                    space[i] = (i % 2) ? '\n' : '\t';
+                }
+                if (offset < length)
+                {
+                    text[offset] = special;
+                    space[offset] = special;
+                }
+
+                const char* expected_string = nullptr;
+                const char* expected_space = nullptr;
+                size_t expected_newlines = 0;
+                const char* expected_line = nullptr;
+                for (scan_isa isa : isas)
+                {
+                    web::json::details::set_scan_isa(isa);
+                    const char* end = text.data() + length;
+                    const char* string_end = web::json::details::scan_string(text.data(), end);
+
+                    size_t newlines = 0;
+                    const char* line_start = space.data();
+                    const char* space_end = web::json::details::scan_whitespace(space.data(), space.data() + length, &newlines, &line_start);
+
+                    if (isa == scan_isa::scalar)
+                    {
+                        expected_string = string_end;
+                        expected_space = space_end;
+                        expected_newlines = newlines;
+                        expected_line = line_start;
+                        continue;
+                    }
+
+                    SCOPED_TRACE(testing::Message() << "length " << length << " offset " << offset << " isa " << static_cast<int>(isa));
+                    EXPECT_EQ(expected_string, string_end);
+                    EXPECT_EQ(expected_space, space_end);
+                    EXPECT_EQ(expected_newlines, newlines);
+                    EXPECT_EQ(expected_line, line_start);
+                }
+            }
+        }
+    }
+
+    web::json::details::set_scan_isa(previous);
+}
+
+TEST(JsonReaderTest, ReportsTokensInDocumentOrder)
+{
+    std::istringstream input(R"({ "b": [1, 2.5, true, null], "a": { "s": "x\ty" }, "e": {} })");
+    web::json::reader reader(input);
+
+    typedef web::json::reader r;
+    EXPECT_EQ(r::BeginObject, reader.read());
+    EXPECT_EQ(r::PropertyName, reader.read());
+    EXPECT_EQ(_XPLATSTR("b"), reader.as_string());
+    EXPECT_EQ(r::BeginArray, reader.read());
+    EXPECT_EQ(r::Number, reader.read());
+    EXPECT_EQ(1.0, reader.as_double());
+    EXPECT_EQ(r::Number, reader.read());
+    EXPECT_EQ(2.5, reader.as_double());
+    EXPECT_EQ(r::Boolean, reader.read());
+    EXPECT_TRUE(reader.as_bool());
+    EXPECT_EQ(r::Null, reader.read());
+    EXPECT_EQ(r::EndArray, reader.read());
+    EXPECT_EQ(r::PropertyName, reader.read());
+    EXPECT_EQ(_XPLATSTR("a"), reader.as_string());
+    EXPECT_EQ(r::BeginObject, reader.read());
+    EXPECT_EQ(r::PropertyName, reader.read());
+    EXPECT_EQ(r::String, reader.read());
+    EXPECT_EQ(_XPLATSTR("x\ty"), reader.as_string());
+    EXPECT_EQ(r::EndObject, reader.read());
+    EXPECT_EQ(r::PropertyName, reader.read());
+    EXPECT_EQ(r::BeginObject, reader.read());
+    EXPECT_EQ(r::EndObject, reader.read());
+    EXPECT_EQ(r::EndObject, reader.read());
+    EXPECT_EQ(r::EndOfInput, reader.read());
+    EXPECT_THROW(reader.as_string(), web::json::json_exception);
+}
+
+TEST(JsonReaderTest, SkipsNestedValues)
+{
+    std::istringstream input(R"({ "skip": { "a": [ { "b": [] } ], "c": 1 }, "keep": "yes" })");
+    web::json::reader reader(input);
+
+    reader.read();
+    ASSERT_EQ(web::json::reader::PropertyName, reader.read());
+    reader.skip();
+    ASSERT_EQ(web::json::reader::PropertyName, reader.read());
+    EXPECT_EQ(_XPLATSTR("keep"), reader.as_string());
+    ASSERT_EQ(web::json::reader::String, reader.read());
+    EXPECT_EQ(_XPLATSTR("yes"), reader.as_string());
+}
+
+TEST(JsonReaderTest, ReadsFromBuffer)
+{
+    const std::string text = R"([ "a", 12, { "k": false } ])";
+    web::json::reader reader(text.data(), text.data() + text.size());
+
+    ASSERT_EQ(web::json::reader::BeginArray, reader.read());
+    ASSERT_EQ(web::json::reader::String, reader.read());
+    EXPECT_EQ(_XPLATSTR("a"), reader.as_string());
+    ASSERT_EQ(web::json::reader::Number, reader.read());
+    EXPECT_EQ(12.0, reader.as_double());
+    ASSERT_EQ(web::json::reader::BeginObject, reader.read());
+    reader.skip();
+    EXPECT_EQ(web::json::reader::EndArray, reader.read());
+    EXPECT_EQ(web::json::reader::EndOfInput, reader.read());
+}
@@ -0,0 +1,155 @@
+//
+// layout_generator.h
+// Writes .NET installs of a chosen size for scaling tests: a chain of shared
+// frameworks with several installed versions each, a NuGet style package cache
+// and an app on the highest framework which takes its packages from the cache.
+//
+
+#pragma once
+
+#include "test_utils.h"
+
+namespace test_utils
+{
+    struct layout_spec_t
+    {
+        // Frameworks each referencing the one before: Microsoft.NETCore.App,
+        // Microsoft.AspNetCore.App, then Contoso.Framework2, Contoso.Framework3...
+        int framework_count = 1;
+
+        // Versions 3.1.0 to 3.1.<n-1> of each framework. References to 3.1.0 roll
+        // forward to the last, the only one with its assets on disk.
+        int versions_per_framework = 1;
+
+        // Packages in the deps file of each framework, with an assembly and a
+        // native library each
+        int libraries_per_framework = 160;
+
+        // Packages the app references, found in the package cache
+        int app_package_count = 0;
+
+        // Package directories in the cache which the app does not reference
+        int cache_package_count = 0;
+    };
+
+    struct layout_paths_t
+    {
+        string_t dotnet_root;
+        string_t package_cache;
+        string_t app_path;
+    };
+
+    inline std::string get_layout_framework_name(int index)
+    {
+        switch (index)
+        {
+        case 0:
+            return "Microsoft.NETCore.App";
+        case 1:
+            return "Microsoft.AspNetCore.App";
+        default:
+            return "Contoso.Framework" + std::to_string(index);
+        }
+    }
+
+    inline std::string make_runtime_config(const std::string& fx_name, const std::string& probe_path = std::string())
+    {
+        std::string json = "{\n  \"runtimeOptions\": {\n    \"tfm\": \"netcoreapp3.1\",\n"
+            "    \"framework\": { \"name\": \"" + fx_name + "\", \"version\": \"3.1.0\" }";
+        if (!probe_path.empty())
+        {
+            json += ",\n    \"additionalProbingPaths\": [ \"" + probe_path + "\" ]";
+        }
+        return json + "\n  }\n}\n";
+    }
+
+    // Writes the layout described by 'spec' under 'root'. The root framework's
+    // runtime library is a copy of 'runtime_library', such as the coreclr_mock
+    // stand-in, and hostpolicy is an empty placeholder.
+    inline bool write_layout(const string_t& root, const layout_spec_t& spec, const string_t& runtime_library, layout_paths_t* paths)
+    {
+        if (spec.framework_count < 1 || spec.versions_per_framework < 1)
+        {
+            return false;
+        }
+
+        paths->dotnet_root = path_combine(root, _X("dotnet"));
+        paths->package_cache = path_combine(root, _X("packages"));
+        paths->app_path = path_combine(path_combine(root, _X("app")), _X("app.dll"));
+
+        const string_t shared = path_combine(paths->dotnet_root, _X("shared"));
+        const std::string latest = "3.1." + std::to_string(spec.versions_per_framework - 1);
+        for (int fx = 0; fx < spec.framework_count; ++fx)
+        {
+            const std::string name = get_layout_framework_name(fx);
+            const string_t fx_dir = path_combine(shared, to_palstring(name));
+            const string_t latest_dir = path_combine(fx_dir, to_palstring(latest));
+            const string_t deps_name = to_palstring(name + ".deps.json");
+            const string_t config_name = to_palstring(name + ".runtimeconfig.json");
+
+            const bool is_root = fx == 0;
+            if (!write_framework(latest_dir, name, latest, spec.libraries_per_framework, is_root, is_root ? runtime_library : string_t()) ||
+                (is_root && !write_file(path_combine(latest_dir, LIBHOSTPOLICY_NAME), "native")) ||
+                (!is_root && !write_file(path_combine(latest_dir, config_name), make_runtime_config(get_layout_framework_name(fx - 1)))))
+            {
+                return false;
+            }
+
+            // The older versions only need what framework resolution reads
+            const std::string deps = read_file(path_combine(latest_dir, deps_name));
+            for (int ver = 0; ver < spec.versions_per_framework - 1; ++ver)
+            {
+                const string_t dir = path_combine(fx_dir, to_palstring("3.1." + std::to_string(ver)));
+                if (!write_file(path_combine(dir, deps_name), deps) ||
+                    (!is_root && !write_file(path_combine(dir, config_name), make_runtime_config(get_layout_framework_name(fx - 1)))))
+                {
+                    return false;
+                }
+            }
+        }
+
+        // The app's packages with their assembly, then the directories of the others
+        std::string targets;
+        std::string libraries;
+        for (int i = 0; i < spec.app_package_count; ++i)
+        {
+            const std::string name = "Contoso.Package" + std::to_string(i);
+            const std::string lower = "contoso.package" + std::to_string(i);
+            targets += ",\n      \"" + name + "/1.0.0\": { \"runtime\": { \"lib/netstandard2.0/" + name + ".dll\": {} } }";
+            libraries += ",\n    \"" + name + "/1.0.0\": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\", \"path\": \"" + lower + "/1.0.0\" }";
+            if (!write_file(path_combine(paths->package_cache, to_palstring(lower + "/1.0.0/lib/netstandard2.0/" + name + ".dll")), "package"))
+            {
+                return false;
+            }
+        }
+
+        make_directories(paths->package_cache);
+        for (int i = 0; i < spec.cache_package_count; ++i)
+        {
+            const string_t package_dir = path_combine(paths->package_cache, to_palstring("fabrikam.package" + std::to_string(i)));
+            if (!make_directory(package_dir) || !make_directory(path_combine(package_dir, _X("1.0.0"))))
+            {
+                return false;
+            }
+        }
+
+        std::vector<char> cache_utf8;
+        coreload::pal::pal_utf8string(paths->package_cache, &cache_utf8);
+        std::string probe_path;
+        for (const char* c = cache_utf8.data(); *c != '\0'; ++c)
+        {
+            probe_path += (*c == '\\') ? "\\\\" : std::string(1, *c);
+        }
+        const string_t app_dir = coreload::get_directory(paths->app_path);
+        const std::string deps = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\", \"signature\": \"\" },\n"
+            "  \"compilationOptions\": {},\n"
+            "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+            "      \"app/1.0.0\": { \"runtime\": { \"app.dll\": {} } }" + targets + "\n    }\n  },\n"
+            "  \"libraries\": {\n"
+            "    \"app/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" }" + libraries + "\n  }\n}\n";
+        return write_file(paths->app_path, "app") &&
+            write_file(path_combine(app_dir, _X("app.deps.json")), deps) &&
+            write_file(path_combine(app_dir, _X("app.runtimeconfig.json")),
+                make_runtime_config(get_layout_framework_name(spec.framework_count - 1), probe_path));
+    }
+}
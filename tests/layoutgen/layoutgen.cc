@@ -0,0 +1,106 @@
+//
+// layoutgen.cc
+// Writes a synthetic .NET install, package cache and app of a chosen size (see
+// layout_generator.h), for scaling tests and for profiling the host on them.
+//
+// Usage: coreload-layoutgen [--frameworks N] [--versions N] [--libraries N]
+//                           [--app-packages N] [--cache-packages N]
+//                           [--runtime <libcoreclr>] <directory>
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "layout_generator.h"
+
+namespace
+{
+    int usage()
+    {
+        fprintf(stderr,
+            "Usage: coreload-layoutgen [--frameworks N] [--versions N] [--libraries N]\n"
+            "                          [--app-packages N] [--cache-packages N]\n"
+            "                          [--runtime <libcoreclr>] <directory>\n");
+        return 2;
+    }
+
+    bool parse_count(const char* value, int* count)
+    {
+        char* end = nullptr;
+        long parsed = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || parsed < 0 || parsed > 10000000)
+        {
+            return false;
+        }
+        *count = static_cast<int>(parsed);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    test_utils::layout_spec_t spec;
+    std::string runtime;
+    const char* dir = nullptr;
+
+#if defined(CORECLR_MOCK_PATH)
+    runtime = CORECLR_MOCK_PATH;
+#endif
+
+    const std::pair<const char*, int*> counts[] = {
+        { "--frameworks", &spec.framework_count },
+        { "--versions", &spec.versions_per_framework },
+        { "--libraries", &spec.libraries_per_framework },
+        { "--app-packages", &spec.app_package_count },
+        { "--cache-packages", &spec.cache_package_count } };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::pair<const char*, int*>* count = nullptr;
+        for (const auto& option : counts)
+        {
+            if (strcmp(argv[i], option.first) == 0)
+            {
+                count = &option;
+            }
+        }
+
+        if (count != nullptr)
+        {
+            if (i + 1 == argc || !parse_count(argv[++i], count->second))
+            {
+                return usage();
+            }
+        }
+        else if (strcmp(argv[i], "--runtime") == 0 && i + 1 < argc)
+        {
+            runtime = argv[++i];
+        }
+        else if (dir == nullptr && argv[i][0] != '-')
+        {
+            dir = argv[i];
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if (dir == nullptr || spec.framework_count < 1 || spec.versions_per_framework < 1)
+    {
+        return usage();
+    }
+
+    test_utils::layout_paths_t paths;
+    if (!test_utils::write_layout(test_utils::to_palstring(dir), spec, test_utils::to_palstring(runtime), &paths))
+    {
+        fprintf(stderr, "Unable to write the layout to %s\n", dir);
+        return 1;
+    }
+
+    std::vector<char> dotnet_root, app_path;
+    coreload::pal::pal_utf8string(paths.dotnet_root, &dotnet_root);
+    coreload::pal::pal_utf8string(paths.app_path, &app_path);
+    printf("dotnet root: %s\napp: %s\n", dotnet_root.data(), app_path.data());
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+// mock_runtime.h
+// A .NET install and app laid out in a temp directory around the coreclr_mock
+// stand-in, for starting the host end to end without a runtime.
+//
+
+#pragma once
+
+#include "coreclr_mock.h"
+#include "test_utils.h"
+
+namespace test_utils
+{
+    // The Calculator test app (tests/dotnet/Calculator.cs) on a synthetic
+    // Microsoft.NETCore.App of 'library_count' packages, whose runtime library is a
+    // copy of the mock built with the tests (CORECLR_MOCK_PATH).
+    class mock_runtime_layout_t
+    {
+    public:
+        explicit mock_runtime_layout_t(int library_count = 160, const std::string& version = "3.1.0")
+        {
+#if defined(CORECLR_MOCK_PATH)
+            m_root = make_temp_directory(_X("mock_runtime"));
+            if (m_root.empty())
+            {
+                return;
+            }
+
+            m_dotnet_root = path_combine(m_root, _X("dotnet"));
+            m_fx_dir = path_combine(path_combine(path_combine(m_dotnet_root, _X("shared")), _X("Microsoft.NETCore.App")), to_palstring(version));
+            // The host only checks that hostpolicy is next to the runtime, it does not load it
+            if (!write_framework(m_fx_dir, "Microsoft.NETCore.App", version, library_count, true, _X(CORECLR_MOCK_PATH)) ||
+                !write_file(path_combine(m_fx_dir, LIBHOSTPOLICY_NAME), "native"))
+            {
+                return;
+            }
+
+            const string_t app_dir = path_combine(m_root, _X("app"));
+            const std::string runtime_config = "{\n  \"runtimeOptions\": {\n    \"tfm\": \"netcoreapp3.1\",\n"
+                "    \"framework\": { \"name\": \"Microsoft.NETCore.App\", \"version\": \"" + version + "\" }\n  }\n}\n";
+            const std::string deps = "{\n  \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.1\", \"signature\": \"\" },\n"
+                "  \"compilationOptions\": {},\n"
+                "  \"targets\": {\n    \".NETCoreApp,Version=v3.1\": {\n"
+                "      \"Calculator/1.0.0\": { \"runtime\": { \"Calculator.dll\": {} } }\n    }\n  },\n"
+                "  \"libraries\": {\n    \"Calculator/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" }\n  }\n}\n";
+
+            m_app_path = path_combine(app_dir, _X("Calculator.dll"));
+            m_valid = write_file(m_app_path, "managed") &&
+                write_file(path_combine(app_dir, _X("Calculator.runtimeconfig.json")), runtime_config) &&
+                write_file(path_combine(app_dir, _X("Calculator.deps.json")), deps);
+#else
+            (void)library_count;
+            (void)version;
+#endif
+        }
+
+        ~mock_runtime_layout_t()
+        {
+            if (!m_root.empty())
+            {
+                remove_directory_tree(m_root);
+            }
+        }
+
+        bool is_valid() const { return m_valid; }
+        const string_t& get_dotnet_root() const { return m_dotnet_root; }
+        const string_t& get_fx_dir() const { return m_fx_dir; }
+        const string_t& get_app_path() const { return m_app_path; }
+
+    private:
+        mock_runtime_layout_t(const mock_runtime_layout_t&) = delete;
+        mock_runtime_layout_t& operator=(const mock_runtime_layout_t&) = delete;
+
+        string_t m_root;
+        string_t m_dotnet_root;
+        string_t m_fx_dir;
+        string_t m_app_path;
+        bool m_valid = false;
+    };
+
+    // The state of the mock the host loaded from a layout, read through its
+    // coreclr_mock_* exports.
+    class mock_runtime_t
+    {
+    public:
+        explicit mock_runtime_t(const mock_runtime_layout_t& layout)
+            : m_library(nullptr)
+            , m_get_calls(nullptr)
+            , m_get_property_count(nullptr)
+            , m_get_property(nullptr)
+        {
+            string_t path = path_combine(layout.get_fx_dir(), LIBCORECLR_NAME);
+            if (coreload::pal::realpath(&path) && coreload::pal::load_library(&path, &m_library))
+            {
+                m_get_calls = reinterpret_cast<coreclr_mock_get_calls_fn>(coreload::pal::get_symbol(m_library, "coreclr_mock_get_calls"));
+                m_get_property_count = reinterpret_cast<coreclr_mock_get_property_count_fn>(coreload::pal::get_symbol(m_library, "coreclr_mock_get_property_count"));
+                m_get_property = reinterpret_cast<coreclr_mock_get_property_fn>(coreload::pal::get_symbol(m_library, "coreclr_mock_get_property"));
+            }
+        }
+
+        ~mock_runtime_t()
+        {
+            if (m_library != nullptr)
+            {
+                coreload::pal::unload_library(m_library);
+            }
+        }
+
+        bool is_loaded() const { return m_get_calls != nullptr && m_get_property_count != nullptr && m_get_property != nullptr; }
+
+        coreclr_mock_calls get_calls() const
+        {
+            coreclr_mock_calls calls = coreclr_mock_calls();
+            m_get_calls(&calls);
+            return calls;
+        }
+
+        int get_property_count() const { return m_get_property_count(); }
+
+        // The value the host gave the property, or an empty string
+        std::string get_property(const char* key) const
+        {
+            const char* value = m_get_property(key);
+            return value == nullptr ? std::string() : std::string(value);
+        }
+
+    private:
+        mock_runtime_t(const mock_runtime_t&) = delete;
+        mock_runtime_t& operator=(const mock_runtime_t&) = delete;
+
+        coreload::pal::dll_t m_library;
+        coreclr_mock_get_calls_fn m_get_calls;
+        coreclr_mock_get_property_count_fn m_get_property_count;
+        coreclr_mock_get_property_fn m_get_property;
+    };
+}
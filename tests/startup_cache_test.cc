@@ -0,0 +1,280 @@
+#include "pch.h"
+#include "dir_cache.h"
+#include "startup_cache.h"
+#include "startup_inputs.h"
+#include "test_utils.h"
+
+using coreload::startup_cache_t;
+using coreload::startup_inputs_t;
+using coreload::startup_inputs_scope_t;
+using coreload::pal::string_t;
+
+class StartupCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("startup_cache_test"));
+        ASSERT_FALSE(root.empty());
+
+        app_dir = test_utils::path_combine(root, _X("app"));
+        config_path = test_utils::path_combine(app_dir, _X("app.runtimeconfig.json"));
+        ASSERT_TRUE(test_utils::write_file(config_path, "{}"));
+        ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.dll")), "app"));
+
+        cache_dir = test_utils::path_combine(root, _X("cache"));
+        ASSERT_TRUE(test_utils::make_directories(cache_dir));
+
+        key.app_path = test_utils::path_combine(app_dir, _X("app.dll"));
+        key.app_root = app_dir;
+        key.dotnet_root = test_utils::path_combine(root, _X("dotnet"));
+        key.mode = coreload::host_mode_t::muxer;
+
+        result.clr_dir = test_utils::path_combine(key.dotnet_root, _X("shared"));
+        result.clr_path = test_utils::path_combine(result.clr_dir, _X("libcoreclr.so"));
+        result.property_keys = { "TRUSTED_PLATFORM_ASSEMBLIES", "FX_PRODUCT_VERSION" };
+        result.property_values = { "/a.dll:/b.dll:", "8.0.0" };
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    // Resolve the way the host does: read the config, look into the app directory
+    // and consult the environment.
+    void record(startup_inputs_t* inputs)
+    {
+        startup_inputs_scope_t scope(inputs);
+
+        std::vector<char> contents;
+        ASSERT_TRUE(coreload::read_file(config_path, &contents));
+
+        std::vector<string_t> files;
+        coreload::pal::readdir(app_dir, &files);
+
+        string_t value;
+        coreload::pal::getenv(_X("COREHOST_TEST_STARTUP_VARIABLE"), &value);
+    }
+
+    // Inputs written just before the cache are not trusted, make them older.
+    void age_inputs()
+    {
+        ASSERT_TRUE(test_utils::age_file(config_path, 10));
+        ASSERT_TRUE(test_utils::age_file(test_utils::path_combine(app_dir, _X("app.dll")), 10));
+        ASSERT_TRUE(test_utils::age_file(app_dir, 10));
+    }
+
+    string_t get_cache_path()
+    {
+        test_utils::env_scope env(_X("COREHOST_STARTUP_CACHE"), cache_dir);
+        return startup_cache_t::get_path(key);
+    }
+
+    string_t root;
+    string_t app_dir;
+    string_t config_path;
+    string_t cache_dir;
+    startup_cache_t::key_t key;
+    startup_cache_t result;
+};
+
+TEST_F(StartupCacheTest, RecordsWhatTheResolutionReads)
+{
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    // Nothing is recorded outside of the scope.
+    std::vector<char> contents;
+    ASSERT_TRUE(coreload::read_file(test_utils::path_combine(app_dir, _X("app.dll")), &contents));
+
+    auto recorded = inputs.get_inputs();
+    ASSERT_EQ(2u, recorded.size());
+    EXPECT_EQ(startup_inputs_t::kind_t::file, recorded.at(config_path).kind);
+    EXPECT_TRUE(recorded.at(config_path).exists);
+    EXPECT_EQ(2u, recorded.at(config_path).stamp.size);
+    EXPECT_EQ(startup_inputs_t::kind_t::directory, recorded.at(app_dir).kind);
+
+    auto env = inputs.get_env();
+    ASSERT_EQ(1u, env.size());
+    EXPECT_EQ(_X(""), env.at(_X("COREHOST_TEST_STARTUP_VARIABLE")));
+    EXPECT_TRUE(inputs.is_complete());
+}
+
+TEST_F(StartupCacheTest, RecordsTheDirectoryOfExistenceQueries)
+{
+    startup_inputs_t inputs;
+    {
+        startup_inputs_scope_t scope(&inputs);
+        EXPECT_FALSE(coreload::pal::file_exists(test_utils::path_combine(root, _X("missing/app.deps.json"))));
+    }
+
+    auto recorded = inputs.get_inputs();
+    ASSERT_EQ(1u, recorded.size());
+    const auto& missing = recorded.at(test_utils::path_combine(root, _X("missing")));
+    EXPECT_EQ(startup_inputs_t::kind_t::directory, missing.kind);
+    EXPECT_FALSE(missing.exists);
+}
+
+TEST_F(StartupCacheTest, RecordsCanonicalizedPathsAsComponents)
+{
+    startup_inputs_t inputs;
+    {
+        startup_inputs_scope_t scope(&inputs);
+        coreload::dir_cache_t cache;
+        coreload::dir_cache_scope_t cache_scope(&cache);
+
+        string_t config = config_path;
+        ASSERT_TRUE(coreload::cached_realpath(&config));
+        EXPECT_TRUE(coreload::pal::file_exists(test_utils::path_combine(app_dir, _X("app.dll"))));
+    }
+
+    // The app directory is listed for the existence query, which covers the config
+    // file; its parent only needs to still exist.
+    auto recorded = inputs.get_inputs();
+    EXPECT_EQ(0u, recorded.count(config_path));
+    EXPECT_EQ(startup_inputs_t::kind_t::directory, recorded.at(app_dir).kind);
+    EXPECT_EQ(startup_inputs_t::kind_t::component, recorded.at(root).kind);
+    EXPECT_EQ(0u, recorded.at(root).stamp.mtime);
+}
+
+TEST_F(StartupCacheTest, SavedResultIsLoaded)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    ASSERT_FALSE(path.empty());
+    ASSERT_TRUE(result.save(path, key, inputs));
+
+    startup_cache_t loaded;
+    ASSERT_TRUE(loaded.load(path, key));
+    EXPECT_EQ(result.clr_path, loaded.clr_path);
+    EXPECT_EQ(result.clr_dir, loaded.clr_dir);
+    EXPECT_EQ(result.property_keys, loaded.property_keys);
+    EXPECT_EQ(result.property_values, loaded.property_values);
+}
+
+TEST_F(StartupCacheTest, ChangedInputsInvalidateTheCache)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    ASSERT_TRUE(result.save(path, key, inputs));
+
+    // A new file in a directory which was listed
+    ASSERT_TRUE(test_utils::write_file(test_utils::path_combine(app_dir, _X("app.runtimeconfig.dev.json")), "{}"));
+    startup_cache_t loaded;
+    EXPECT_FALSE(loaded.load(path, key));
+
+    // A file which was read
+    ASSERT_TRUE(test_utils::age_file(app_dir, 10));
+    startup_inputs_t again;
+    record(&again);
+    ASSERT_TRUE(result.save(path, key, again));
+    ASSERT_TRUE(loaded.load(path, key));
+
+    ASSERT_TRUE(test_utils::write_file(config_path, "{ }"));
+    EXPECT_FALSE(loaded.load(path, key));
+}
+
+TEST_F(StartupCacheTest, ChangedEnvironmentInvalidatesTheCache)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    ASSERT_TRUE(result.save(path, key, inputs));
+
+    test_utils::env_scope env(_X("COREHOST_TEST_STARTUP_VARIABLE"), _X("1"));
+    startup_cache_t loaded;
+    EXPECT_FALSE(loaded.load(path, key));
+}
+
+#if !defined(_WIN32)
+TEST_F(StartupCacheTest, ChangedOsReleaseInvalidatesTheCache)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+    {
+        startup_inputs_scope_t scope(&inputs);
+        coreload::pal::get_current_os_rid_platform();
+    }
+
+    const std::string os_release = "/etc/os-release";
+    ASSERT_EQ(1u, inputs.get_inputs().count(_X("/etc/os-release")));
+
+    string_t path = get_cache_path();
+    ASSERT_TRUE(result.save(path, key, inputs));
+    startup_cache_t loaded;
+    ASSERT_TRUE(loaded.load(path, key));
+
+    // As after an OS upgrade, the file no longer has the recorded stamp. The path
+    // is followed by its kind, whether it exists, its size and its write time.
+    std::string contents = test_utils::read_file(path);
+    size_t recorded = contents.find(os_release);
+    ASSERT_NE(std::string::npos, recorded);
+    size_t exists = recorded + os_release.size() + sizeof(uint32_t);
+    if (contents[exists] != 0)
+    {
+        contents[exists + sizeof(uint32_t) + sizeof(uint64_t)] ^= 1;
+    }
+    else
+    {
+        contents[exists] = 1;
+    }
+    ASSERT_TRUE(test_utils::write_file(path, contents));
+    EXPECT_FALSE(loaded.load(path, key));
+}
+#endif
+
+TEST_F(StartupCacheTest, CacheForAnotherAppIsIgnored)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    ASSERT_TRUE(result.save(path, key, inputs));
+
+    startup_cache_t::key_t other = key;
+    other.dotnet_root = test_utils::path_combine(root, _X("other"));
+    startup_cache_t loaded;
+    EXPECT_FALSE(loaded.load(path, other));
+
+    test_utils::env_scope env(_X("COREHOST_STARTUP_CACHE"), cache_dir);
+    EXPECT_NE(path, startup_cache_t::get_path(other));
+}
+
+TEST_F(StartupCacheTest, RecentInputsAreNotSaved)
+{
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    EXPECT_FALSE(result.save(path, key, inputs));
+    EXPECT_FALSE(coreload::pal::file_exists(path));
+}
+
+TEST_F(StartupCacheTest, CorruptCacheIsIgnored)
+{
+    age_inputs();
+    startup_inputs_t inputs;
+    record(&inputs);
+
+    string_t path = get_cache_path();
+    ASSERT_TRUE(result.save(path, key, inputs));
+
+    std::string contents = test_utils::read_file(path);
+    ASSERT_TRUE(test_utils::write_file(path, contents.substr(0, contents.size() - 3)));
+    startup_cache_t loaded;
+    EXPECT_FALSE(loaded.load(path, key));
+
+    ASSERT_TRUE(test_utils::write_file(path, "not a startup cache"));
+    EXPECT_FALSE(loaded.load(path, key));
+}
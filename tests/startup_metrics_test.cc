@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "deps_format.h"
+#include "startup_metrics.h"
+#include "test_utils.h"
+
+using coreload::startup_metrics_t;
+using coreload::startup_metrics_scope_t;
+using coreload::pal::string_t;
+
+class StartupMetricsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("startup_metrics_test"));
+        ASSERT_FALSE(root.empty());
+
+        deps_path = test_utils::path_combine(root, _X("app.deps.json"));
+        ASSERT_TRUE(test_utils::write_file(deps_path, deps_json));
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    const std::string deps_json =
+        "{ \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v2.2\" },"
+        "  \"targets\": { \".NETCoreApp,Version=v2.2\": {} },"
+        "  \"libraries\": {} }";
+
+    string_t root;
+    string_t deps_path;
+};
+
+TEST_F(StartupMetricsTest, CountsTheFileSystemCallsInsideTheScope)
+{
+    startup_metrics_t metrics;
+    metrics.start();
+    {
+        startup_metrics_scope_t scope(&metrics);
+        EXPECT_TRUE(coreload::pal::file_exists(deps_path));
+        EXPECT_FALSE(coreload::pal::file_exists(test_utils::path_combine(root, _X("missing.dll"))));
+
+        std::vector<string_t> files;
+        coreload::pal::readdir(root, &files);
+
+        coreload::deps_json_t deps;
+        deps.parse(false, deps_path);
+        EXPECT_TRUE(deps.is_valid());
+    }
+
+    // Nothing is counted outside of the scope.
+    EXPECT_TRUE(coreload::pal::file_exists(deps_path));
+
+    auto snapshot = metrics.get_snapshot();
+    EXPECT_GE(snapshot.files_checked, 2u);
+    EXPECT_EQ(1u, snapshot.directories_read);
+    EXPECT_EQ(deps_json.size(), snapshot.json_bytes_parsed);
+}
+
+TEST_F(StartupMetricsTest, RecordsThePhaseBoundaries)
+{
+    typedef startup_metrics_t::phase_t phase_t;
+
+    startup_metrics_t metrics;
+    EXPECT_EQ(0u, metrics.get_snapshot().start_ns);
+
+    metrics.start();
+    {
+        startup_metrics_scope_t scope(&metrics);
+        startup_metrics_t::begin_active_phase(phase_t::runtime_config);
+        startup_metrics_t::end_active_phase(phase_t::runtime_config);
+        startup_metrics_t::begin_active_phase(phase_t::framework_resolution);
+    }
+    metrics.stop();
+
+    auto snapshot = metrics.get_snapshot();
+    const auto& runtime_config = snapshot.phases[static_cast<size_t>(phase_t::runtime_config)];
+    const auto& framework_resolution = snapshot.phases[static_cast<size_t>(phase_t::framework_resolution)];
+    EXPECT_NE(0u, snapshot.start_ns);
+    EXPECT_LE(snapshot.start_ns, runtime_config.start_ns);
+    EXPECT_LE(runtime_config.start_ns, runtime_config.end_ns);
+    EXPECT_LE(runtime_config.end_ns, framework_resolution.start_ns);
+    EXPECT_LE(framework_resolution.start_ns, snapshot.end_ns);
+
+    // A phase which did not finish has no end, one which did not run has no start.
+    EXPECT_EQ(0u, framework_resolution.end_ns);
+    EXPECT_EQ(0u, snapshot.phases[static_cast<size_t>(phase_t::coreclr_bind)].start_ns);
+
+    // Starting again clears the previous start.
+    metrics.start();
+    snapshot = metrics.get_snapshot();
+    EXPECT_EQ(0u, snapshot.phases[static_cast<size_t>(phase_t::runtime_config)].start_ns);
+    EXPECT_EQ(0u, snapshot.end_ns);
+}
+
+TEST_F(StartupMetricsTest, CountsTheAllocationsOfEachPhase)
+{
+    typedef startup_metrics_t::phase_t phase_t;
+
+    startup_metrics_t metrics;
+    metrics.start();
+    metrics.begin_phase(phase_t::deps_resolution);
+
+    // As the replacement operator new and delete report them
+    coreload::allocation_tracker_t::on_allocate(1000);
+    coreload::allocation_tracker_t::on_allocate(3000);
+    coreload::allocation_tracker_t::on_free(3000);
+    coreload::allocation_tracker_t::on_allocate(500);
+
+    metrics.end_phase(phase_t::deps_resolution);
+    coreload::allocation_tracker_t::on_free(1000);
+    coreload::allocation_tracker_t::on_free(500);
+    metrics.stop();
+
+    // Builds with the replacement count the test's own allocations too.
+    auto snapshot = metrics.get_snapshot();
+    const auto& deps_resolution = snapshot.phase_allocations[static_cast<size_t>(phase_t::deps_resolution)];
+    EXPECT_GE(deps_resolution.allocations, 3u);
+    EXPECT_GE(deps_resolution.bytes, 4500u);
+    EXPECT_GE(deps_resolution.peak_live_bytes, 4000u);
+    EXPECT_GE(snapshot.allocations.allocations, deps_resolution.allocations);
+    EXPECT_GE(snapshot.allocations.peak_live_bytes, deps_resolution.peak_live_bytes);
+    EXPECT_EQ(0u, snapshot.phase_allocations[static_cast<size_t>(phase_t::runtime_config)].allocations);
+    EXPECT_EQ(coreload::allocation_tracker_t::is_enabled(), snapshot.allocations_tracked);
+}
@@ -0,0 +1,307 @@
+//
+// test_utils.h
+// Helpers for tests which need files on disk.
+//
+
+#pragma once
+
+#include "pal.h"
+#include "utils.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace test_utils
+{
+    using coreload::pal::string_t;
+
+    inline bool make_directory(const string_t& path)
+    {
+#if defined(_WIN32)
+        return ::CreateDirectoryW(path.c_str(), nullptr) != 0 || ::GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+        return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+    // Create all the directories in the path
+    inline bool make_directories(const string_t& path)
+    {
+        for (size_t pos = path.find(DIR_SEPARATOR, 1); pos != string_t::npos; pos = path.find(DIR_SEPARATOR, pos + 1))
+        {
+            make_directory(path.substr(0, pos));
+        }
+        return make_directory(path);
+    }
+
+    inline bool write_file(const string_t& path, const std::string& contents)
+    {
+        make_directories(coreload::get_directory(path));
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+        return file.good();
+    }
+
+    inline std::string read_file(const string_t& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Creates a new empty directory under the system temp directory
+    inline string_t make_temp_directory(const string_t& prefix)
+    {
+        string_t dir;
+#if defined(_WIN32)
+        wchar_t temp[MAX_PATH];
+        ::GetTempPathW(MAX_PATH, temp);
+        dir = temp;
+        dir.append(prefix);
+        dir.append(std::to_wstring(::GetCurrentProcessId()));
+        dir.append(_X("_"));
+        dir.append(std::to_wstring(::GetTickCount()));
+        make_directories(dir);
+#else
+        string_t pattern = _X("/tmp/");
+        const char* tmpdir = ::getenv("TMPDIR");
+        if (tmpdir != nullptr && tmpdir[0] != '\0')
+        {
+            pattern = tmpdir;
+            pattern.push_back('/');
+        }
+        pattern.append(prefix);
+        pattern.append(_X("XXXXXX"));
+        std::vector<char> buffer(pattern.begin(), pattern.end());
+        buffer.push_back('\0');
+        if (::mkdtemp(buffer.data()) != nullptr)
+        {
+            dir = buffer.data();
+        }
+#endif
+        coreload::pal::realpath(&dir);
+        return dir;
+    }
+
+    // Removes the directory with all its contents
+    inline void remove_directory_tree(const string_t& path)
+    {
+        if (path.empty())
+        {
+            return;
+        }
+
+        std::vector<string_t> dirs;
+        coreload::pal::readdir_onlydirectories(path, &dirs);
+        std::unordered_set<string_t> dir_set(dirs.begin(), dirs.end());
+
+        std::vector<coreload::pal::file_entry_t> entries;
+        coreload::pal::readdir(path, &entries);
+        for (const auto& entry : entries)
+        {
+            string_t child = path;
+            coreload::append_path(&child, entry.name.c_str());
+
+            // Do not follow symlinks out of the tree
+            if (!entry.is_symlink && dir_set.count(entry.name))
+            {
+                remove_directory_tree(child);
+                continue;
+            }
+
+#if defined(_WIN32)
+            if (!::DeleteFileW(child.c_str()))
+            {
+                ::RemoveDirectoryW(child.c_str());
+            }
+#else
+            ::unlink(child.c_str());
+#endif
+        }
+
+#if defined(_WIN32)
+        ::RemoveDirectoryW(path.c_str());
+#else
+        ::rmdir(path.c_str());
+#endif
+    }
+
+    // Moves the last write time of a file or directory into the past
+    inline bool age_file(const string_t& path, int seconds)
+    {
+#if defined(_WIN32)
+        HANDLE file = ::CreateFileW(path.c_str(), FILE_WRITE_ATTRIBUTES | FILE_READ_ATTRIBUTES,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        FILETIME write_time;
+        bool result = ::GetFileTime(file, nullptr, nullptr, &write_time) != 0;
+        if (result)
+        {
+            ULARGE_INTEGER ticks;
+            ticks.LowPart = write_time.dwLowDateTime;
+            ticks.HighPart = write_time.dwHighDateTime;
+            ticks.QuadPart -= static_cast<ULONGLONG>(seconds) * 10000000;
+            write_time.dwLowDateTime = ticks.LowPart;
+            write_time.dwHighDateTime = ticks.HighPart;
+            result = ::SetFileTime(file, nullptr, nullptr, &write_time) != 0;
+        }
+        ::CloseHandle(file);
+        return result;
+#else
+        struct stat buffer;
+        if (::stat(path.c_str(), &buffer) != 0)
+        {
+            return false;
+        }
+
+#if defined(__APPLE__)
+        struct timespec times[2] = { buffer.st_atimespec, buffer.st_mtimespec };
+#else
+        struct timespec times[2] = { buffer.st_atim, buffer.st_mtim };
+#endif
+        times[1].tv_sec -= seconds;
+        return ::utimensat(AT_FDCWD, path.c_str(), times, 0) == 0;
+#endif
+    }
+
+    // Sets an environment variable for the lifetime of the scope
+    class env_scope
+    {
+    public:
+        env_scope(const string_t& name, const string_t& value)
+            : m_name(name)
+        {
+            m_had_value = coreload::pal::getenv(name.c_str(), &m_previous);
+            set(value.c_str());
+        }
+
+        ~env_scope()
+        {
+            set(m_had_value ? m_previous.c_str() : nullptr);
+        }
+
+    private:
+        void set(const coreload::pal::char_t* value)
+        {
+#if defined(_WIN32)
+            ::SetEnvironmentVariableW(m_name.c_str(), value);
+#else
+            if (value == nullptr)
+            {
+                ::unsetenv(m_name.c_str());
+            }
+            else
+            {
+                ::setenv(m_name.c_str(), value, 1);
+            }
+#endif
+        }
+
+        string_t m_name;
+        string_t m_previous;
+        bool m_had_value;
+    };
+
+    inline string_t path_combine(string_t base, const string_t& relative)
+    {
+        coreload::append_path(&base, relative.c_str());
+        return base;
+    }
+
+    inline string_t to_palstring(const std::string& value)
+    {
+        string_t result;
+        coreload::pal::utf8_palstring(value, &result);
+        return result;
+    }
+
+    // Writes '<name>.deps.json' for a shared framework into 'dir', shaped like the
+    // installed ones: 'library_count' packages, each with a managed assembly and a
+    // native library, created in 'dir' where the framework probe looks for them.
+    // The root framework's deps file is built for the current platform and carries
+    // the rid fallback graph; the others list a native library for unix and one for
+    // win, to be selected with that graph.
+    // A root framework given a 'runtime_library' also lists a runtime pack with a
+    // copy of that file as its libcoreclr, such as the coreclr_mock stand-in.
+    inline bool write_framework(const string_t& dir, const std::string& name, const std::string& version, int library_count, bool is_root,
+        const string_t& runtime_library = string_t())
+    {
+        std::string target = ".NETCoreApp,Version=v3.1";
+        std::string targets;
+        std::string libraries;
+        for (int i = 0; i < library_count; ++i)
+        {
+            std::string library = name + ".Library" + std::to_string(i);
+            std::string package = library + "/" + version;
+            if (i > 0)
+            {
+                targets += ",\n";
+                libraries += ",\n";
+            }
+
+            targets += "      \"" + package + "\": {\n"
+                "        \"runtime\": {\n"
+                "          \"lib/netcoreapp3.1/" + library + ".dll\": { \"assemblyVersion\": \"" + version + ".0\", \"fileVersion\": \"" + version + ".0\" }\n"
+                "        },\n";
+            if (is_root)
+            {
+                targets += "        \"native\": {\n"
+                    "          \"lib" + library + ".so\": { \"fileVersion\": \"0.0.0.0\" }\n"
+                    "        }\n";
+            }
+            else
+            {
+                targets += "        \"runtimeTargets\": {\n"
+                    "          \"runtimes/unix/native/lib" + library + ".so\": { \"rid\": \"unix\", \"assetType\": \"native\", \"fileVersion\": \"0.0.0.0\" },\n"
+                    "          \"runtimes/win/native/lib" + library + ".so\": { \"rid\": \"win\", \"assetType\": \"native\", \"fileVersion\": \"0.0.0.0\" }\n"
+                    "        }\n";
+            }
+            targets += "      }";
+            libraries += "    \"" + package + "\": { \"type\": \"package\", \"serviceable\": true, \"sha512\": \"\" }";
+
+            if (!write_file(path_combine(dir, to_palstring(library + ".dll")), "managed") ||
+                !write_file(path_combine(dir, to_palstring("lib" + library + ".so")), "native"))
+            {
+                return false;
+            }
+        }
+
+        if (is_root && !runtime_library.empty())
+        {
+            std::vector<char> coreclr_name;
+            coreload::pal::pal_utf8string(LIBCORECLR_NAME, &coreclr_name);
+            std::string package = "runtime.any." + name + "/" + version;
+            targets += ",\n      \"" + package + "\": {\n"
+                "        \"native\": {\n"
+                "          \"runtimes/any/native/" + std::string(coreclr_name.data()) + "\": { \"fileVersion\": \"0.0.0.0\" }\n"
+                "        }\n      }";
+            libraries += ",\n    \"" + package + "\": { \"type\": \"package\", \"serviceable\": true, \"sha512\": \"\" }";
+
+            std::string contents = read_file(runtime_library);
+            if (contents.empty() || !write_file(path_combine(dir, LIBCORECLR_NAME), contents))
+            {
+                return false;
+            }
+        }
+
+        std::string json = "{\n  \"runtimeTarget\": { \"name\": \"" + target + "\", \"signature\": \"\" },\n"
+            "  \"compilationOptions\": {},\n"
+            "  \"targets\": {\n    \"" + target + "\": {\n" + targets + "\n    }\n  },\n"
+            "  \"libraries\": {\n" + libraries + "\n  }";
+        if (is_root)
+        {
+            json += ",\n  \"runtimes\": {\n"
+                "    \"linux-x64\": [ \"linux\", \"unix-x64\", \"unix\", \"any\", \"base\" ],\n"
+                "    \"osx-x64\": [ \"osx\", \"unix-x64\", \"unix\", \"any\", \"base\" ],\n"
+                "    \"win-x64\": [ \"win\", \"any\", \"base\" ]\n"
+                "  }";
+        }
+        json += "\n}\n";
+        return write_file(path_combine(dir, to_palstring(name + ".deps.json")), json);
+    }
+}
@@ -0,0 +1,400 @@
+#include "pch.h"
+#include "trace.h"
+#include "trace_capture.h"
+#include "trace_events.h"
+#include "trace_sink.h"
+#include "test_utils.h"
+#include "cpprest/json.h"
+#include <cstdarg>
+#include <sstream>
+#include <thread>
+
+using coreload::pal::char_t;
+using coreload::pal::string_t;
+using coreload::trace_sink_t;
+using coreload::trace_capture_writer_t;
+namespace trace_capture = coreload::trace_capture;
+
+TEST(TraceTest, MacrosEvaluateArgumentsOnlyIfTheLevelIsEnabled)
+{
+    int evaluated = 0;
+    auto argument = [&evaluated]() -> const char_t*
+    {
+        evaluated++;
+        return _X("argument");
+    };
+
+    TRACE_VERBOSE(_X("Verbose trace of [%s]"), argument());
+    TRACE_INFO(_X("Info trace of [%s]"), argument());
+
+#if defined(CORELOAD_STRIP_TRACE)
+    EXPECT_EQ(0, evaluated);
+#else
+    int expected = (coreload::trace::is_verbose_enabled() ? 1 : 0) + (coreload::trace::is_info_enabled() ? 1 : 0);
+    EXPECT_EQ(expected, evaluated);
+#endif
+}
+
+TEST(TraceTest, MacrosAreSingleStatements)
+{
+    bool traced = false;
+    if (traced)
+        TRACE_VERBOSE(_X("Not reached"));
+    else
+        traced = true;
+
+    EXPECT_TRUE(traced);
+}
+
+TEST(TraceTest, DisableTurnsTracingOffAgain)
+{
+    string_t root = test_utils::make_temp_directory(_X("trace_test"));
+    ASSERT_FALSE(root.empty());
+    string_t path = test_utils::path_combine(root, _X("trace.txt"));
+    {
+        test_utils::env_scope trace_file(_X("COREHOST_TRACEFILE"), path);
+        ASSERT_TRUE(coreload::trace::enable());
+    }
+
+    EXPECT_TRUE(coreload::trace::is_verbose_enabled());
+    coreload::trace::verbose(_X("While enabled"));
+    coreload::trace::disable();
+    coreload::trace::verbose(_X("While disabled"));
+
+    EXPECT_FALSE(coreload::trace::is_enabled());
+    std::string contents = test_utils::read_file(path);
+    EXPECT_NE(std::string::npos, contents.find("While enabled"));
+    EXPECT_EQ(std::string::npos, contents.find("While disabled"));
+    test_utils::remove_directory_tree(root);
+}
+
+class TraceSinkTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("trace_sink_test"));
+        ASSERT_FALSE(root.empty());
+
+        path = test_utils::path_combine(root, _X("trace.txt"));
+        file = coreload::pal::file_open(path, _X("w"));
+        ASSERT_NE(nullptr, file);
+    }
+
+    void TearDown() override
+    {
+        if (file != nullptr)
+        {
+            fclose(file);
+        }
+        test_utils::remove_directory_tree(root);
+    }
+
+    static void write(trace_sink_t* sink, const char_t* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        sink->write(format, args);
+        va_end(args);
+    }
+
+    std::vector<std::string> read_lines() const
+    {
+        std::vector<std::string> lines;
+        std::istringstream contents(test_utils::read_file(path));
+        std::string line;
+        while (std::getline(contents, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    string_t root;
+    string_t path;
+    FILE* file = nullptr;
+};
+
+TEST_F(TraceSinkTest, KeepsTheOrderOfEachThreadWhenTheRingIsFull)
+{
+    const int thread_count = 4;
+    const int record_count = 500;
+    {
+        trace_sink_t sink(file, 8);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&sink, t]()
+            {
+                for (int i = 0; i < record_count; ++i)
+                {
+                    write(&sink, _X("thread %d record %d"), t, i);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        sink.flush();
+
+        std::vector<std::string> lines = read_lines();
+        ASSERT_EQ(static_cast<size_t>(thread_count * record_count), lines.size());
+
+        std::vector<int> next(thread_count, 0);
+        for (const auto& line : lines)
+        {
+            int t = -1;
+            int i = -1;
+            ASSERT_EQ(2, sscanf(line.c_str(), "thread %d record %d", &t, &i)) << line;
+            ASSERT_TRUE(t >= 0 && t < thread_count) << line;
+            EXPECT_EQ(next[t], i) << line;
+            next[t] = i + 1;
+        }
+    }
+}
+
+TEST_F(TraceSinkTest, FlushWritesThePublishedRecords)
+{
+    trace_sink_t sink(file);
+    write(&sink, _X("first %s"), _X("record"));
+    write(&sink, _X("second %s"), _X("record"));
+    sink.flush();
+
+    std::vector<std::string> lines = read_lines();
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_EQ("first record", lines[0]);
+    EXPECT_EQ("second record", lines[1]);
+}
+
+TEST_F(TraceSinkTest, StopWritesTheRemainingRecords)
+{
+    trace_sink_t sink(file);
+    for (int i = 0; i < 100; ++i)
+    {
+        write(&sink, _X("record %d"), i);
+    }
+    sink.stop();
+
+    // Written directly once stopped
+    write(&sink, _X("after stop"));
+    fflush(file);
+
+    std::vector<std::string> lines = read_lines();
+    ASSERT_EQ(101u, lines.size());
+    EXPECT_EQ("record 0", lines[0]);
+    EXPECT_EQ("record 99", lines[99]);
+    EXPECT_EQ("after stop", lines[100]);
+}
+
+class TraceCaptureTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        root = test_utils::make_temp_directory(_X("trace_capture_test"));
+        ASSERT_FALSE(root.empty());
+        path = test_utils::path_combine(root, _X("trace.bin"));
+    }
+
+    void TearDown() override
+    {
+        test_utils::remove_directory_tree(root);
+    }
+
+    // Writes the record and adds its text, as a text trace has it, to 'expected'
+    void write(trace_capture_writer_t* writer, trace_capture::level_t level, const char_t* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        va_list text_args;
+        va_copy(text_args, args);
+        writer->write(level, format, args);
+        va_end(args);
+
+        char_t text[512];
+        coreload::pal::str_vprintf(text, 512, 511, format, text_args);
+        va_end(text_args);
+
+        std::vector<char> utf8;
+        coreload::pal::pal_utf8string(text, &utf8);
+        expected.push_back(utf8.data());
+    }
+
+    bool read(std::vector<trace_capture::capture_t>* captures, std::vector<trace_capture::event_t>* events, std::string* error) const
+    {
+        std::string contents = test_utils::read_file(path);
+        return trace_capture::read(std::vector<char>(contents.begin(), contents.end()), captures, events, error);
+    }
+
+    string_t root;
+    string_t path;
+    std::vector<std::string> expected;
+};
+
+TEST_F(TraceCaptureTest, DecodesToTheTextOfTheRecords)
+{
+    FILE* file = coreload::pal::file_open(path, _X("wb"));
+    ASSERT_NE(nullptr, file);
+    {
+        trace_capture_writer_t writer(file);
+        write(&writer, trace_capture::level_t::info, _X("Tracing enabled @ %s"), _X("Fri Oct 16 08:00:00 2026 GMT"));
+        write(&writer, trace_capture::level_t::verbose, _X("Parsed %s deps entry %d for asset name: %s"), _X("runtime"), 12, _X("System.Text.Json"));
+        write(&writer, trace_capture::level_t::verbose, _X("Indexed %zu deps entries, [0x%04x:%d] %X %c %%"), static_cast<size_t>(1234), 0x1f, -5, 48879u, _X('x'));
+        write(&writer, trace_capture::level_t::warning, _X("[%-8s] [%*d] [%.*s] %5.2f"), _X("left"), 6, 42, 3, _X("abcdef"), 3.14159);
+        write(&writer, trace_capture::level_t::error, _X("Error: %s"), _X("An assembly specified in the application dependencies manifest was not found"));
+        write(&writer, trace_capture::level_t::verbose, _X("Parsed %s deps entry %d for asset name: %s"), _X("native"), 13, _X("libclrjit.so"));
+    }
+    fclose(file);
+
+    std::vector<trace_capture::capture_t> captures;
+    std::vector<trace_capture::event_t> events;
+    std::string error;
+    ASSERT_TRUE(read(&captures, &events, &error)) << error;
+    ASSERT_EQ(1u, captures.size());
+    ASSERT_EQ(expected.size(), events.size());
+
+    // A site per format, written once
+    EXPECT_EQ(5u, captures[0].sites.size());
+    EXPECT_EQ(events[1].site_id, events[5].site_id);
+
+    uint64_t previous = 0;
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const trace_capture::site_t& site = captures[0].sites.at(events[i].site_id);
+        EXPECT_EQ(expected[i], trace_capture::format_message(site, events[i]));
+        EXPECT_LE(previous, events[i].timestamp_ns);
+        previous = events[i].timestamp_ns;
+    }
+    EXPECT_EQ(trace_capture::level_t::warning, captures[0].sites.at(events[3].site_id).level);
+    EXPECT_STREQ("error", trace_capture::level_name(captures[0].sites.at(events[4].site_id).level));
+}
+
+TEST_F(TraceCaptureTest, KeepsTheLevelOfEachEventOfAFormat)
+{
+    // As the resolver traces a missing assembly as info or as an error
+    const char_t* format = _X("%s:\n  package: '%s', version: '%s'\n  path: '%s'");
+    FILE* file = coreload::pal::file_open(path, _X("wb"));
+    ASSERT_NE(nullptr, file);
+    {
+        trace_capture_writer_t writer(file);
+        write(&writer, trace_capture::level_t::info, format, _X("Probing"), _X("Contoso"), _X("1.0.0"), _X("lib/Contoso.dll"));
+        write(&writer, trace_capture::level_t::error, format, _X("Missing"), _X("Contoso"), _X("1.0.0"), _X("lib/Contoso.dll"));
+        write(&writer, trace_capture::level_t::info, format, _X("Probing"), _X("Fabrikam"), _X("2.0.0"), _X("lib/Fabrikam.dll"));
+    }
+    fclose(file);
+
+    std::vector<trace_capture::capture_t> captures;
+    std::vector<trace_capture::event_t> events;
+    std::string error;
+    ASSERT_TRUE(read(&captures, &events, &error)) << error;
+    ASSERT_EQ(3u, events.size());
+
+    // A site per format and level
+    EXPECT_EQ(2u, captures[0].sites.size());
+    EXPECT_EQ(events[0].site_id, events[2].site_id);
+    EXPECT_NE(events[0].site_id, events[1].site_id);
+
+    const trace_capture::level_t levels[] = { trace_capture::level_t::info, trace_capture::level_t::error, trace_capture::level_t::info };
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const trace_capture::site_t& site = captures[0].sites.at(events[i].site_id);
+        EXPECT_EQ(levels[i], site.level);
+        EXPECT_EQ(expected[i], trace_capture::format_message(site, events[i]));
+    }
+}
+
+TEST_F(TraceCaptureTest, ReadsCapturesAppendedToTheSameFile)
+{
+    for (int run = 0; run < 2; ++run)
+    {
+        FILE* file = coreload::pal::file_open(path, _X("ab"));
+        ASSERT_NE(nullptr, file);
+        {
+            trace_capture_writer_t writer(file);
+            write(&writer, trace_capture::level_t::info, _X("Run %d"), run);
+        }
+        fclose(file);
+    }
+
+    std::vector<trace_capture::capture_t> captures;
+    std::vector<trace_capture::event_t> events;
+    std::string error;
+    ASSERT_TRUE(read(&captures, &events, &error)) << error;
+    ASSERT_EQ(2u, captures.size());
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(0u, events[0].capture);
+    EXPECT_EQ(1u, events[1].capture);
+    EXPECT_EQ("Run 1", trace_capture::format_message(captures[1].sites.at(events[1].site_id), events[1]));
+}
+
+TEST_F(TraceCaptureTest, KeepsTheEventsBeforeATruncatedRecord)
+{
+    FILE* file = coreload::pal::file_open(path, _X("wb"));
+    ASSERT_NE(nullptr, file);
+    {
+        trace_capture_writer_t writer(file);
+        write(&writer, trace_capture::level_t::info, _X("First %s"), _X("record"));
+        write(&writer, trace_capture::level_t::info, _X("Second %s"), _X("record"));
+    }
+    fclose(file);
+
+    std::string contents = test_utils::read_file(path);
+    std::vector<char> truncated(contents.begin(), contents.end() - 3);
+
+    std::vector<trace_capture::capture_t> captures;
+    std::vector<trace_capture::event_t> events;
+    std::string error;
+    EXPECT_FALSE(trace_capture::read(truncated, &captures, &events, &error));
+    EXPECT_FALSE(error.empty());
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ("First record", trace_capture::format_message(captures[0].sites.at(events[0].site_id), events[0]));
+}
+
+TEST(TraceEventsTest, WritesNestedDurationsOfEachThread)
+{
+    const string_t root = test_utils::make_temp_directory(_X("trace_events_test"));
+    ASSERT_FALSE(root.empty());
+    const string_t path = test_utils::path_combine(root, _X("events.json"));
+
+    coreload::trace_events_t events;
+    {
+        // Not recorded, no events are active yet.
+        coreload::trace_duration_t ignored("ignored");
+    }
+    {
+        coreload::trace_events_scope_t scope(&events);
+        coreload::trace_duration_t outer("outer", _X("C:\\app \"1\".dll"));
+        {
+            coreload::trace_duration_t inner("inner");
+        }
+        std::thread([]() { coreload::trace_duration_t worker("worker"); }).join();
+    }
+    ASSERT_EQ(3u, events.get_events().size());
+    ASSERT_TRUE(events.write(path));
+
+    const std::string text = test_utils::read_file(path);
+    const auto json = web::json::value::parse(text.data(), text.data() + text.size());
+    const auto& trace_events = json.at(_XPLATSTR("traceEvents")).as_array();
+
+    // The process name, then the events in the order the viewers nest them.
+    ASSERT_EQ(4u, trace_events.size());
+    EXPECT_EQ(_XPLATSTR("M"), trace_events.at(0).at(_XPLATSTR("ph")).as_string());
+
+    const auto& outer = trace_events.at(1);
+    EXPECT_EQ(_XPLATSTR("outer"), outer.at(_XPLATSTR("name")).as_string());
+    EXPECT_EQ(_XPLATSTR("X"), outer.at(_XPLATSTR("ph")).as_string());
+    EXPECT_EQ(0.0, outer.at(_XPLATSTR("ts")).as_double());
+    EXPECT_EQ(_XPLATSTR("C:\\app \"1\".dll"), outer.at(_XPLATSTR("args")).at(_XPLATSTR("detail")).as_string());
+
+    const auto& inner = trace_events.at(2);
+    const auto& worker = trace_events.at(3);
+    EXPECT_EQ(_XPLATSTR("inner"), inner.at(_XPLATSTR("name")).as_string());
+    EXPECT_EQ(_XPLATSTR("worker"), worker.at(_XPLATSTR("name")).as_string());
+    EXPECT_LE(inner.at(_XPLATSTR("ts")).as_double() + inner.at(_XPLATSTR("dur")).as_double(), outer.at(_XPLATSTR("dur")).as_double());
+    EXPECT_EQ(outer.at(_XPLATSTR("tid")).as_integer(), inner.at(_XPLATSTR("tid")).as_integer());
+    EXPECT_NE(outer.at(_XPLATSTR("tid")).as_integer(), worker.at(_XPLATSTR("tid")).as_integer());
+
+    test_utils::remove_directory_tree(root);
+}